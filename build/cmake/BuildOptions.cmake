@@ -21,12 +21,18 @@ IF( USE_ASSERTS_IN_RELEASE_BUILDS )
   ADD_DEFINITIONS( -DTINY_ASSERT )
 ENDIF()
 
+OPTION( USE_ALLOCATION_COUNTER "Count heap allocations, and report filters that allocate memory while processing" OFF )
+IF( USE_ALLOCATION_COUNTER )
+  ADD_DEFINITIONS( -DTINY_COUNT_ALLOCATIONS )
+ENDIF()
+
 SET( BUILD_OPTIONS
   ${BUILD_OPTIONS}
   USE_DYNAMIC_CRT
   USE_OPENMP
   USE_PRECOMPILED_HEADERS
   USE_ASSERTS_IN_RELEASE_BUILDS
+  USE_ALLOCATION_COUNTER
 )  
 
 IF( CMAKE_SYSTEM_PROCESSOR MATCHES ".*86" AND CMAKE_SIZEOF_VOID_P EQUAL 4 )
@@ -0,0 +1,26 @@
+###########################################################################
+## $Id$
+## Authors: BCI2000 team
+## Description: Contains a macro for creating a fused core module, i.e. a
+##   single executable that contains source, signal processing, and
+##   application filters. SOURCES must list the sources of all three
+##   filter chains. At runtime, the Operator treats the fused module as
+##   a system consisting of a single module:
+##     Startup system localhost Fused:4000
+
+macro( bci2000_add_fused_module )
+  utils_parse_args( "NAME;SOURCES" ${ARGV} )
+
+  utils_include( frameworks/SigSrcModule )
+  utils_include( frameworks/SigProcModule )
+  utils_include( frameworks/AppModule )
+  add_definitions( -DMODTYPE=4 )
+  utils_set_appicon( signal-screen )
+  bci2000_add_core_main( ${NAME} ${SOURCES} )
+  bci2000_add_target(
+    INFO "Fused core module"
+    EXECUTABLE ${NAME}
+    ${SOURCES}
+  )
+
+endmacro()
@@ -6,6 +6,7 @@
 UTILS_INCLUDE( SignalProcessingMacro )
 UTILS_INCLUDE( SignalSourceMacro )
 UTILS_INCLUDE( ApplicationMacro )
+UTILS_INCLUDE( FusedModuleMacro )
 UTILS_INCLUDE( SetupExtlibDependencies )
 UTILS_INCLUDE( ToolsCmdlineMacro )
 UTILS_INCLUDE( ToolsMexfileMacro )
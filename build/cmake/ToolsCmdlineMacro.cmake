@@ -16,6 +16,7 @@ MACRO( BCI2000_ADD_TOOLS_CMDLINE ) # NAME SOURCES [HEADERS] REQUESTQT
     CONSOLEAPP ${NAME}
     ${SOURCES}
     ${PROJECT_SRC_DIR}/core/Tools/cmdline/bci_tool.cpp
+    ${PROJECT_SRC_DIR}/core/Tools/cmdline/bci_convert.cpp
     ${PROJECT_SRC_DIR}/shared/bcistream/BCIStream_tool.cpp
     OUTPUT_DIRECTORY "${PROJECT_BUILD_ROOT}/tools/cmdline"
   )
@@ -118,3 +119,18 @@ MACRO( BCI2000_ADD_CMDLINE_FILTER )
 ENDMACRO( BCI2000_ADD_CMDLINE_FILTER )
 
 ################################################################################################
+
+MACRO( BCI2000_ADD_CMDLINE_BENCHMARK ) # NAME SOURCES
+
+ OPTION( BUILD_BENCHMARKS "Build ${PROJECT_NAME} filter chain benchmarks" OFF )
+ IF( BUILD_BENCHMARKS )
+
+  UTILS_PARSE_ARGS( "NAME;SOURCES" ${ARGV} )
+  UTILS_INCLUDE( frameworks/SigProcModule )
+  BCI2000_ADD_TOOLS_CMDLINE( ${NAME} ${SOURCES} ${PROJECT_SRC_DIR}/core/Tools/cmdline/bci_benchmark.cpp FALSE )
+
+ ENDIF()
+
+ENDMACRO( BCI2000_ADD_CMDLINE_BENCHMARK )
+
+################################################################################################
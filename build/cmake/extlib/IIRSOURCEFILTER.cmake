@@ -21,6 +21,7 @@ SET( HDR_EXTLIB
   ${PROJECT_SRC_DIR}/shared/modules/signalprocessing/IIRFilterBase.h
   ${PROJECT_SRC_DIR}/extlib/math/FilterDesign.h
   ${PROJECT_SRC_DIR}/extlib/math/IIRFilter.h
+  ${PROJECT_SRC_DIR}/extlib/math/PolyphaseDecimator.h
 )
 
 SET( INC_EXTLIB
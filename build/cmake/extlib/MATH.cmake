@@ -20,6 +20,8 @@ SET( HDR_EXTLIB
   ${PROJECT_SRC_DIR}/extlib/math/LinearPredictor.h
   ${PROJECT_SRC_DIR}/extlib/math/MEMPredictor.h
   ${PROJECT_SRC_DIR}/extlib/math/Polynomials.h
+  ${PROJECT_SRC_DIR}/extlib/math/PolyphaseDecimator.h
+  ${PROJECT_SRC_DIR}/extlib/math/SignalSynthesizer.h
   ${PROJECT_SRC_DIR}/extlib/math/TransferSpectrum.h
 )
 
@@ -31,6 +31,7 @@ SET( SRC_BCI2000_FRAMEWORK
   ${PROJECT_SRC_DIR}/shared/utils/AV/AudioSink.cpp
   ${PROJECT_SRC_DIR}/shared/utils/AV/AVUtils.cpp
   ${PROJECT_SRC_DIR}/shared/utils/AV/AVDecoder.cpp
+  ${PROJECT_SRC_DIR}/shared/utils/AV/MediaCache.cpp
   ${PROJECT_SRC_DIR}/shared/utils/AV/AVPlayer.cpp
   ${PROJECT_SRC_DIR}/shared/utils/AV/VideoPlayer.cpp
   ${PROJECT_SRC_DIR}/shared/utils/AV/AudioPlayer.cpp
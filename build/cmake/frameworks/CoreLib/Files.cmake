@@ -72,6 +72,7 @@ SET( SRC_LIBCORE
   ${PROJECT_SRC_DIR}/shared/fileio/RunManager.cpp
   ${PROJECT_SRC_DIR}/shared/fileio/RequiredParameters.cpp
   ${PROJECT_SRC_DIR}/shared/fileio/dat/BCI2000FileReader.cpp
+  ${PROJECT_SRC_DIR}/shared/fileio/dat/BCI2000FileOverview.cpp
   ${PROJECT_SRC_DIR}/extlib/math/FastConv.h
 )
 
@@ -13,12 +13,14 @@ SET( SRC_LIBTINY
   ${TINY_DIR}/Lockable.h
   ${TINY_DIR}/Runnable.h
   ${TINY_DIR}/ObjectPool.h
+  ${TINY_DIR}/Arena.cpp
   ${TINY_DIR}/LazyArray.h
   ${TINY_DIR}/Broadcaster.cpp
 
   ${TINY_DIR}/SynchronizedObject.h
   ${TINY_DIR}/SynchronizedQueue.h
   ${TINY_DIR}/SelfPipeQueue.h
+  ${TINY_DIR}/LockFreeQueue.h
 
   ${TINY_DIR}/Waitable.cpp
   ${TINY_DIR}/WaitableEvent.cpp
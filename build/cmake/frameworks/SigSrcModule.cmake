@@ -13,6 +13,7 @@ INCLUDE_DIRECTORIES(
   ${PROJECT_SRC_DIR}/shared/fileio/dat
   ${PROJECT_SRC_DIR}/shared/fileio/edf_gdf
   ${PROJECT_SRC_DIR}/shared/modules/signalsource
+  ${PROJECT_SRC_DIR}/extlib/math
 )
 
 SET( REGISTRY_NAME SigSrcRegistry )
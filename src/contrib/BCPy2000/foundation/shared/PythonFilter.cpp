@@ -106,6 +106,12 @@ FILTER_NAME::FILTER_NAME():
 		bci2000_instance = 0;
 		stay_open = 0;
 		use_console = 0;
+		shared_buffers = false;
+		py_signal_in = py_signal_out = py_states = py_states_dirty = 0;
+		signal_in = signal_out = 0;
+		state_values = 0;
+		state_dirty = 0;
+		shared_samples = 0;
 
 #if MODTYPE == 3
 		BEGIN_STATE_DEFINITIONS
@@ -286,6 +292,7 @@ FILTER_NAME::~FILTER_NAME()
 		try {
 			BlockThreads();
 			CallHook("_Destruct");
+			ReleaseSharedBuffers();
 			UnblockThreads();
 		}
 		catch (EndUserError& e) {
@@ -356,6 +363,7 @@ FILTER_NAME::Initialize(const SignalProperties& inSignalProperties,
 		ReceiveStatesFromPython();
 		CallHook("_Initialize", pyInSignalProperties, pyOutSignalProperties);
 		ReceiveStatesFromPython();
+		CreateSharedBuffers(inSignalProperties, outSignalProperties);
 		UnblockThreads();
 	}
 	catch (EndUserError& e) {
@@ -374,17 +382,30 @@ FILTER_NAME::Process(const GenericSignal& input, GenericSignal& output)
 #endif
 	try {
 		BlockThreads();
-		SendStatesToPython();
-		// Watch out for the memory leaks. They come when you least expect them.
-		// http://www-cgi.uni-regensburg.de/WWW_Server/Dokumentation/Python/ext.pdf
-		PyObject* py_input = ConvertSignalToPyObject(input);
-		StateMap before;
-		// unlike StartRun and Initialize, here we do not call before = ReceiveStatesFromPython();
-		// Python may have other threads that update states asynchronously. They are passed on here.
-		PyObject* py_output = CallHook("_Process", py_input);
-		Py_DecRef(py_input);
-		ReceiveStatesFromPython();
-		Py_DecRef(py_output);
+		if (shared_buffers) {
+			// Python reads and writes signals and states in place; we copy
+			// whole blocks rather than converting individual values.
+			SendStatesToSharedBuffer();
+			const GenericSignal::ValueType* in = input.ConstData();
+			std::copy(in, in + input.Channels() * input.Elements(), signal_in);
+			PyObject* py_output = CallHook("_Process", py_signal_in);
+			Py_DecRef(py_output);
+			std::copy(signal_out, signal_out + output.Channels() * output.Elements(), output.MutableData());
+			ReceiveStatesFromSharedBuffer();
+		}
+		else {
+			SendStatesToPython();
+			// Watch out for the memory leaks. They come when you least expect them.
+			// http://www-cgi.uni-regensburg.de/WWW_Server/Dokumentation/Python/ext.pdf
+			PyObject* py_input = ConvertSignalToPyObject(input);
+			StateMap before;
+			// unlike StartRun and Initialize, here we do not call before = ReceiveStatesFromPython();
+			// Python may have other threads that update states asynchronously. They are passed on here.
+			PyObject* py_output = CallHook("_Process", py_input);
+			Py_DecRef(py_input);
+			ReceiveStatesFromPython();
+			Py_DecRef(py_output);
+		}
 		UnblockThreads();
 	}
 	catch (EndUserError& e) {
@@ -738,6 +759,141 @@ FILTER_NAME::SendStatePrecisionsToPython() const
 	CallMethod("_set_state_precisions", bits);
 }
 
+////////////////////////////////////////////////////////////////////////////////
+// Buffers shared with Python
+////////////////////////////////////////////////////////////////////////////////
+// If the Python instance has a _set_shared_buffers() method, it is called
+// after _Initialize with a dictionary of persistent buffer objects:
+//   signal_in     float64, shape (channels, elements) of the input signal,
+//   signal_out    float64, shape (channels, elements) of the output signal,
+//   states        uint32, shape (states, SampleBlockSize), one row per state,
+//   states_dirty  uint8, shape (states,),
+//   state_names   list of state names, in the order of rows in "states".
+// The buffers support the buffer protocol, so numpy.asarray() wraps them
+// without copying. They remain valid until the next call to _set_shared_buffers().
+// During Process(), _Process() receives signal_in as its argument, and is
+// expected to write its output into signal_out. States are written into
+// "states" before _Process() is called; only rows for which Python has set
+// the corresponding states_dirty entry to nonzero are copied back.
+// Without a _set_shared_buffers() method, signals and states are converted
+// into bytes objects for each block.
+
+#if PYVERSION != 2
+PyObject*
+FILTER_NAME::CreateSharedBuffer(const char* format, size_t itemSize, size_t rows, size_t cols, void** outData) const
+{
+	size_t numCols = cols ? cols : 1;
+	PyObject* bytes = PyByteArray_FromStringAndSize(NULL, rows * numCols * itemSize);
+	if (!bytes) FAIL("failed to allocate memory for shared buffer");
+	*outData = PyByteArray_AsString(bytes);
+	::memset(*outData, 0, rows * numCols * itemSize);
+	// The memoryview keeps the bytearray alive, and prevents it from being resized.
+	PyObject* flat = PyMemoryView_FromObject(bytes);
+	Py_DecRef(bytes);
+	HandlePythonError("creating shared buffer");
+	PyObject* shaped = cols
+		? PyObject_CallMethod(flat, (char*)"cast", (char*)"s(nn)", format, (Py_ssize_t)rows, (Py_ssize_t)cols)
+		: PyObject_CallMethod(flat, (char*)"cast", (char*)"s(n)", format, (Py_ssize_t)rows);
+	Py_DecRef(flat);
+	HandlePythonError("creating shared buffer");
+	if (!shaped) FAIL("failed to create shared buffer");
+	return shaped;
+}
+#endif // PYVERSION
+
+void
+FILTER_NAME::CreateSharedBuffers(const SignalProperties& inSignalProperties, const SignalProperties& outSignalProperties)
+{
+	ReleaseSharedBuffers();
+#if PYVERSION != 2
+	PyObject* py_method = PyObject_GetAttrString(bci2000_instance, (char*)"_set_shared_buffers");
+	if (!py_method) { // Python framework only supports the conversion interface
+		PyErr_Clear();
+		return;
+	}
+	Py_DecRef(py_method);
+
+	if (sizeof(GenericSignal::ValueType) != 8) FAIL("internal error: unsupported architecture - signal values are not 8 bytes");
+	if (sizeof(::State::ValueType) != 4) FAIL("internal error: unsupported architecture - state values are not 4 bytes");
+	shared_samples = Parameter("SampleBlockSize");
+	shared_states.clear();
+	shared_state_plan.Clear();
+	for (const auto& s : *States) {
+		shared_states.push_back(s);
+		shared_state_plan.Add(s);
+	}
+
+	void* data = 0;
+	py_signal_in = CreateSharedBuffer("d", 8, inSignalProperties.Channels(), inSignalProperties.Elements(), &data);
+	signal_in = static_cast<double*>(data);
+	py_signal_out = CreateSharedBuffer("d", 8, outSignalProperties.Channels(), outSignalProperties.Elements(), &data);
+	signal_out = static_cast<double*>(data);
+	py_states = CreateSharedBuffer("I", 4, shared_states.size(), shared_samples, &data);
+	state_values = static_cast< ::State::ValueType*>(data);
+	py_states_dirty = CreateSharedBuffer("B", 1, shared_states.size(), 0, &data);
+	state_dirty = static_cast<unsigned char*>(data);
+
+	PyObject* py_names = PyList_New(shared_states.size());
+	for (size_t i = 0; i < shared_states.size(); ++i)
+		PyList_SetItem(py_names, i, PyString_FromString(shared_states[i].Name().c_str())); // steals reference
+	PyObject* py_buffers = PyDict_New();
+	PyDict_SetItemString(py_buffers, "signal_in", py_signal_in);
+	PyDict_SetItemString(py_buffers, "signal_out", py_signal_out);
+	PyDict_SetItemString(py_buffers, "states", py_states);
+	PyDict_SetItemString(py_buffers, "states_dirty", py_states_dirty);
+	PyDict_SetItemString(py_buffers, "state_names", py_names);
+	Py_DecRef(py_names);
+	PyObject* py_result = CallMethod("_set_shared_buffers", py_buffers);
+	Py_DecRef(py_result);
+	Py_DecRef(py_buffers);
+	shared_buffers = true;
+#endif // PYVERSION
+}
+
+void
+FILTER_NAME::ReleaseSharedBuffers()
+{
+	shared_buffers = false;
+	PyObject** buffers[] = { &py_signal_in, &py_signal_out, &py_states, &py_states_dirty };
+	for (size_t i = 0; i < sizeof(buffers) / sizeof(*buffers); ++i) {
+		if (*buffers[i])
+			Py_DecRef(*buffers[i]);
+		*buffers[i] = 0;
+	}
+	signal_in = signal_out = 0;
+	state_values = 0;
+	state_dirty = 0;
+}
+
+void
+FILTER_NAME::SendStatesToSharedBuffer() const
+{
+	Statevector->ExtractColumns(shared_state_plan, 0, shared_samples, state_values);
+	::memset(state_dirty, 0, shared_states.size());
+}
+
+void
+FILTER_NAME::ReceiveStatesFromSharedBuffer() const
+{
+	for (size_t i = 0; i < shared_states.size(); ++i) {
+		if (!state_dirty[i]) continue;
+		const ::State& s = shared_states[i];
+		const char* name = s.Name().c_str();
+		if (strcmp(name, "SourceTime") == 0) continue;
+		if (strcmp(name, "StimulusTime") == 0) continue;
+		if (strcmp(name, "AppStartTime") == 0) continue;
+		if (shared_samples == 0) continue;
+		const ::State::ValueType* values = state_values + i * shared_samples;
+		::State::ValueType mask = ~::State::ValueType(0) >> (8 * sizeof(::State::ValueType) - s.Length());
+		for (size_t el = 0; el < shared_samples; ++el)
+			if ((values[el] & mask) != values[el])
+				FAIL("illegal value " << values[el] << " for " << s.Length() << "-bit state '" << name << "'");
+		Statevector->SetSampleValues(s.Location(), s.Length(), 0, shared_samples - 1, values);
+		// The last value is written through SetStateValue(), which carries it over into the next block.
+		Statevector->SetStateValue(s.Location(), s.Length(), shared_samples - 1, values[shared_samples - 1]);
+	}
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // Converters between BCI2000 classes and Python objects
 ////////////////////////////////////////////////////////////////////////////////
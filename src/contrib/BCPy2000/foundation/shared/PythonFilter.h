@@ -28,6 +28,8 @@
 
 #include "BCIException.h"
 #include "PrecisionTime.h"
+#include "StateVector.h"
+#include <vector>
 
 #define PYTHON_CONSOLE              "EmbeddedPythonConsole"
 #define PYTHON_CONSOLE_INSTALLED    "BCPy2000.EmbeddedPythonConsole"
@@ -107,6 +109,17 @@ class FILTER_NAME : public FILTER_SUPERCLASS
     PyObject*      bci2000_instance;
     bool           use_console;
 
+    // Persistent buffers shared with Python during Process(), if the Python
+    // instance provides a _set_shared_buffers() method (see CreateSharedBuffers()).
+    bool                    shared_buffers;
+    PyObject               *py_signal_in, *py_signal_out, *py_states, *py_states_dirty;
+    double                 *signal_in, *signal_out;
+    ::State::ValueType     *state_values;
+    unsigned char          *state_dirty;
+    size_t                  shared_samples;
+    std::vector< ::State>   shared_states;
+    StateVector::ColumnPlan shared_state_plan;
+
     mutable bool           stay_open;
     mutable PyThreadState* _save;
 
@@ -118,6 +131,12 @@ class FILTER_NAME : public FILTER_SUPERCLASS
     void        UpdateStateChangesFromPython(StateMap& before, StateMap& after) const;
     void        SendStatePrecisionsToPython() const;
 
+    void        CreateSharedBuffers(const SignalProperties& inSignalProperties, const SignalProperties& outSignalProperties);
+    void        ReleaseSharedBuffers();
+    PyObject*   CreateSharedBuffer(const char* format, size_t itemSize, size_t rows, size_t cols, void** outData) const;
+    void        SendStatesToSharedBuffer() const;
+    void        ReceiveStatesFromSharedBuffer() const;
+
     PyObject*   ConvertSignalToPyObject(const GenericSignal& inSignal, PyObject* pyInSignal=NULL) const;
     void        ConvertPyObjectToSignal(PyObject* pyOutSignal, GenericSignal& outSignal) const;
 
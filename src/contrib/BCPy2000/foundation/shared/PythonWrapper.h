@@ -210,6 +210,9 @@ else if ((externalname=(type(*)args)  GetProcAddress(dll,#externalname)) == 0)
 	PYTHON_LINK(    PyObject*      ,   PyBytes_FromString  				, (const char*)											  )
 	PYTHON_LINK(    PyObject*      ,   PyBytes_FromStringAndSize		, (const char*,Py_ssize_t)					  )
 	PYTHON_LINK(    Py_ssize_t     ,   PyBytes_Size  							, (PyObject*)												  )
+	PYTHON_LINK(    PyObject*      ,   PyByteArray_FromStringAndSize	, (const char*,Py_ssize_t)					  )
+	PYTHON_LINK(    char*          ,   PyByteArray_AsString				,	(PyObject*)												  )
+	PYTHON_LINK(    PyObject*      ,   PyMemoryView_FromObject			,	(PyObject*)												  )
 		int PyBytes_Check(PyObject* a);
 	//Py_ssize_t PyString_Size(PyObject*);
 #endif
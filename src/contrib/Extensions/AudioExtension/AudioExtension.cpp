@@ -36,6 +36,7 @@
 #include "FilterDesign.h"
 #include "Rectify.h"
 #include "RootMeanSquare.h"
+#include "ThreadUtils.h"
 
 #include <iomanip>
 #include <iostream>
@@ -43,6 +44,7 @@
 #include <cmath>
 #include <set>
 #include <cstring>
+#include <algorithm>
 
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
@@ -62,7 +64,7 @@ std::string HOST_APIS[] =
   "ASIO",           // 3
   "SoundManager",   // 4
   "CoreAudio",      // 5
-  "Disabled",       // 6
+  "Null",           // 6: no audio device, for testing
   "OSS",            // 7
   "ALSA",           // 8
   "AL",             // 9
@@ -76,6 +78,14 @@ std::string HOST_APIS[] =
 // Audio Defaults
 #define SAMPLE_RATE 44100
 
+// PortAudio does not use host API type 6, so it selects the null device
+#define HOSTAPI_NULL 6
+
+// Number of buffers the worker thread may lag behind the audio callback,
+// and number of buffers read ahead from the audio input file
+#define AUDIO_BLOCKS 16
+#define FILE_READ_AHEAD 4
+
 // Channel Types
 #define CHANNELTYPE_INPUT "INPUT" // Input Channel: INPUT[1] is Live (Mic) Channel 1
 #define CHANNELTYPE_FILE  "FILE" // File Channel: from AudioInputFile.  FILE[1] is File Channel 1
@@ -99,7 +109,13 @@ typedef Ratpoly< FilterDesign::Complex > TransferFunction;
 // Returns:    N/A
 // **************************************************************************
 AudioExtension::AudioExtension() :
+  mGainsPending( 1 ),
+  mGainsWrite( 0 ),
+  mGainsRead( 2 ),
+  mStatusFlags( 0 ),
+  mFrameMismatches( 0 ),
   mpAudioStream( NULL ),
+  mNullStream( this ),
   mpAudioInputFile( NULL ),
   mpAudioRecInputFile( NULL ),
   mpAudioRecOutputFile( NULL )
@@ -151,7 +167,6 @@ AudioExtension::~AudioExtension()
 void AudioExtension::Publish()
 {
   int hostApi = OptionalParameter( "EnableAudioExtension", 0 );
-  if( hostApi == 6 ) hostApi = 0;
   if( !hostApi ) return;
   else bciwarn << "Audio Extension Enabled";
 
@@ -171,6 +186,7 @@ void AudioExtension::Publish()
 										<< " devices." << std::endl;
     mSupportedAPIs.insert( Pa_GetHostApiInfo( i )->type );
   }
+  mSupportedAPIs.insert( HOSTAPI_NULL );
   mMaxInputEnvelopes = OptionalParameter( "MaxInputEnvelopes", 4 );
   mMaxOutputEnvelopes = OptionalParameter( "MaxOutputEnvelopes", 4 );
   mFramesPerBuffer = OptionalParameter( "AudioBufferSize", 1024 );
@@ -280,7 +296,6 @@ void AudioExtension::Publish()
 void AudioExtension::Preflight() const
 {
   int hostApi = OptionalParameter( "EnableAudioExtension" );
-  if( hostApi == 6 ) hostApi = 0;
   if (hostApi != 0 && mSupportedAPIs.find(hostApi) == mSupportedAPIs.end())
   {
     std::string name = (hostApi < SIZE_HOST_APIS) ? HOST_APIS[hostApi] : "unknown";
@@ -312,40 +327,46 @@ void AudioExtension::Preflight() const
   Parameter( "AudioRecordOutput" );
   Parameter( "AudioRecordingFormat" );
   
-  // Retreive ifnormation for the requested HostAPI
-  const PaHostApiInfo* apiInfo;
-  PaHostApiIndex hostIdx;
-  if( !GetHostApiConfig( PaHostApiTypeId( ( int )Parameter( "EnableAudioExtension" ) ), apiInfo, hostIdx ) )
-    return;
+  // The null device has no inputs, and as many outputs as the mixer
+  int inputChannels = 0, outputChannels = 0;
+  if( hostApi == HOSTAPI_NULL )
+    outputChannels = Parameter( "AudioMixer" )->NumColumns();
+  else
+  {
+    // Retreive ifnormation for the requested HostAPI
+    const PaHostApiInfo* apiInfo;
+    PaHostApiIndex hostIdx;
+    if( !GetHostApiConfig( PaHostApiTypeId( ( int )Parameter( "EnableAudioExtension" ) ), apiInfo, hostIdx ) )
+      return;
   
-  std::stringstream preflightInfoStrm;
+    std::stringstream preflightInfoStrm;
 
-  // List the devices on this api
-	preflightInfoStrm << apiInfo->name << " was requested as the host API" << std::endl;
-	preflightInfoStrm << "HostAPI: " << apiInfo->name << " supports the following "
-                    << apiInfo->deviceCount << " devices." << std::endl;
-  for( int i = 0; i < apiInfo->deviceCount; i++ )
-  {
-    const PaDeviceInfo* info = Pa_GetDeviceInfo( Pa_HostApiDeviceIndexToDeviceIndex( hostIdx, i ) );
-
-		if(info->maxInputChannels > 0 && info->maxInputChannels == 0)
-			preflightInfoStrm << "    Audio Input Device ID [" << i << "] : " << info->name << " Supports " << info->maxInputChannels << " input channels" << std::endl;
-		else if(info->maxOutputChannels > 0 && info->maxOutputChannels == 0)
-			preflightInfoStrm << "    Audio Output Device ID [" << i << "] : " << info->name << " Supports " << info->maxOutputChannels << " input channels" << std::endl;
-		else
-			preflightInfoStrm << "    Device " << i << ": " << info->name << " Supports " << info->maxInputChannels
-                      << " input channels and " << info->maxOutputChannels << " output channels." << std::endl;
-  }
+    // List the devices on this api
+    preflightInfoStrm << apiInfo->name << " was requested as the host API" << std::endl;
+    preflightInfoStrm << "HostAPI: " << apiInfo->name << " supports the following "
+                      << apiInfo->deviceCount << " devices." << std::endl;
+    for( int i = 0; i < apiInfo->deviceCount; i++ )
+    {
+      const PaDeviceInfo* info = Pa_GetDeviceInfo( Pa_HostApiDeviceIndexToDeviceIndex( hostIdx, i ) );
+
+      if(info->maxInputChannels > 0 && info->maxInputChannels == 0)
+        preflightInfoStrm << "    Audio Input Device ID [" << i << "] : " << info->name << " Supports " << info->maxInputChannels << " input channels" << std::endl;
+      else if(info->maxOutputChannels > 0 && info->maxOutputChannels == 0)
+        preflightInfoStrm << "    Audio Output Device ID [" << i << "] : " << info->name << " Supports " << info->maxOutputChannels << " input channels" << std::endl;
+      else
+        preflightInfoStrm << "    Device " << i << ": " << info->name << " Supports " << info->maxInputChannels
+                        << " input channels and " << info->maxOutputChannels << " output channels." << std::endl;
+    }
   
-  // Attempt to setup requested device configuration
-  int inputChannels = 0, outputChannels = 0;
-  int inDev = Parameter( "AudioInputDevice" );
-  int outDev = Parameter( "AudioOutputDevice" );
-  GetDeviceConfig( apiInfo, hostIdx, inDev, outDev, inputChannels, outputChannels );
-	preflightInfoStrm << "Device configuration supports " << inputChannels
-                    << " input channels and " << outputChannels << " output channels." << std::endl;
+    // Attempt to setup requested device configuration
+    int inDev = Parameter( "AudioInputDevice" );
+    int outDev = Parameter( "AudioOutputDevice" );
+    GetDeviceConfig( apiInfo, hostIdx, inDev, outDev, inputChannels, outputChannels );
+    preflightInfoStrm << "Device configuration supports " << inputChannels
+                      << " input channels and " << outputChannels << " output channels." << std::endl;
 
-	bciout << preflightInfoStrm.str();
+    bciout << preflightInfoStrm.str();
+  }
   
   // Determine number of file input channels with libsndfile
   std::string audioInputFilename = Parameter( "AudioInputFile" );
@@ -374,7 +395,7 @@ void AudioExtension::Preflight() const
   ChannelDef channelDef;
   LoadMixer( Parameter( "AudioMixer" ), preflightMixer, channelDef,
     inputChannels, outputChannels, audioInputFileChannels );
-  std::vector< std::vector< float > > gainMatrix;
+  GainMatrix gainMatrix;
   EvaluateMixer( preflightMixer, gainMatrix );
   
   // Attempt to set up filters
@@ -392,7 +413,6 @@ void AudioExtension::Preflight() const
 void AudioExtension::Initialize()
 {
   mHostAPI = OptionalParameter( "EnableAudioExtension" );
-  if( mHostAPI == 6 ) mHostAPI = 0; // Disable on API 6
   if( mSupportedAPIs.find( mHostAPI ) == mSupportedAPIs.end() ) mHostAPI = 0;
   if( !mHostAPI ) return;
   
@@ -400,15 +420,22 @@ void AudioExtension::Initialize()
 	if (mpAudioStream != nullptr)
 		return;
 
-  // Retreive information for the requested HostAPI
-  const PaHostApiInfo* apiInfo;
-  PaHostApiIndex hostIdx;
-  if( !GetHostApiConfig( ( PaHostApiTypeId )mHostAPI, apiInfo, hostIdx ) ) return;
-  
-  // Attempt to setup requested device configuration
+  // Retreive information for the requested HostAPI, and
+  // attempt to setup requested device configuration
+  const PaHostApiInfo* apiInfo = NULL;
+  PaHostApiIndex hostIdx = 0;
   int inDev = Parameter( "AudioInputDevice" );
   int outDev = Parameter( "AudioOutputDevice" );
-  GetDeviceConfig( apiInfo, hostIdx, inDev, outDev, mInputChannels, mOutputChannels );
+  if( mHostAPI == HOSTAPI_NULL )
+  {
+    mInputChannels = 0;
+    mOutputChannels = Parameter( "AudioMixer" )->NumColumns();
+  }
+  else
+  {
+    if( !GetHostApiConfig( ( PaHostApiTypeId )mHostAPI, apiInfo, hostIdx ) ) return;
+    GetDeviceConfig( apiInfo, hostIdx, inDev, outDev, mInputChannels, mOutputChannels );
+  }
   
   // Init LibSndFile for decoding audio input
   if( mpAudioInputFile ) sf_close( mpAudioInputFile );
@@ -421,7 +448,30 @@ void AudioExtension::Initialize()
   // Load the mixer parameter
   LoadMixer( Parameter( "AudioMixer" ), mMixer, mChannelDef,
     mInputChannels, mOutputChannels, mFileChannels );
-  EvaluateMixer( mMixer, mGainMatrix );
+  mMixerOutputs = Parameter( "AudioMixer" )->NumColumns();
+  for( int i = 0; i < 3; i++ )
+    EvaluateMixer( mMixer, mGains[i] );
+  mGainsWrite = 0;
+  mGainsPending = 1;
+  mGainsRead = 2;
+
+  // Resolve channel types once, rather than in each audio callback
+  mSourceTypes.clear();
+  for( size_t i = 0; i < mChannelDef.size(); i++ )
+  {
+    const std::string &type = mChannelDef[i].first;
+    if( type == CHANNELTYPE_INPUT )
+      mSourceTypes.push_back( SourceInput );
+    else if( type == CHANNELTYPE_FILE )
+      mSourceTypes.push_back( SourceFile );
+    else if( type == CHANNELTYPE_TONE )
+      mSourceTypes.push_back( SourceTone );
+    else if( type == CHANNELTYPE_NOISE )
+      mSourceTypes.push_back( SourceNoise );
+    else
+      mSourceTypes.push_back( SourceNone );
+  }
+  mNoiseValues.assign( mChannelDef.size(), 0.0f );
   
   // Set up filters
   DesignFilterbank( Parameter( "AudioInputFilterbank" ), mInputFilter, mChannelDef.size() );
@@ -430,23 +480,37 @@ void AudioExtension::Initialize()
   // Setup the internal audio signals
   SignalProperties audioInputProperties;
   audioInputProperties.SetName( "InputAudioStream" );
-  audioInputProperties.SetChannels( Parameter( "AudioMixer" )->NumRows() );
+  audioInputProperties.SetChannels( static_cast<int>( mChannelDef.size() ) );
   audioInputProperties.SetElements( mFramesPerBuffer );
   audioInputProperties.SetUpdateRate( SAMPLE_RATE / mFramesPerBuffer );
   audioInputProperties.SetType( SignalType::float32 );
   audioInputProperties.SetIsStream( true );
-  mAudioInputBlock.SetProperties( audioInputProperties );
   mAudioInputEnvelope.SetProperties( audioInputProperties );
   
   SignalProperties audioOutputProperties;
   audioOutputProperties.SetName( "OutputAudioStream" );
-  audioOutputProperties.SetChannels( Parameter( "AudioMixer" )->NumColumns() );
+  audioOutputProperties.SetChannels( mMixerOutputs );
   audioOutputProperties.SetElements( mFramesPerBuffer );
   audioOutputProperties.SetUpdateRate( SAMPLE_RATE / mFramesPerBuffer );
   audioOutputProperties.SetType( SignalType::float32 );
   audioOutputProperties.SetIsStream( true );
-  mAudioOutputBlock.SetProperties( audioOutputProperties );
   mAudioOutputEnvelope.SetProperties( audioOutputProperties );
+
+  // Allocate all buffers shared with the audio callback
+  size_t inputSize = mFramesPerBuffer * mChannelDef.size(),
+         outputSize = mFramesPerBuffer * mMixerOutputs;
+  mBlocks.resize( AUDIO_BLOCKS );
+  for( size_t i = 0; i < mBlocks.size(); i++ )
+  {
+    mBlocks[i].input.assign( inputSize, 0.0f );
+    mBlocks[i].output.assign( outputSize, 0.0f );
+  }
+  mSpareBlock.input.assign( inputSize, 0.0f );
+  mSpareBlock.output.assign( outputSize, 0.0f );
+  mFileBuffers.resize( mpAudioInputFile ? FILE_READ_AHEAD : 0 );
+  for( size_t i = 0; i < mFileBuffers.size(); i++ )
+    mFileBuffers[i].assign( mFramesPerBuffer * mFileChannels, 0.0f );
+  mRecordBuffer.resize( mFramesPerBuffer * std::max<size_t>( mChannelDef.size(), mOutputChannels ) );
   
   // Prepare the envelope filters
   double frequency = Parameter( "AudioEnvelopeSmoothing" ).InHertz();
@@ -457,188 +521,112 @@ void AudioExtension::Initialize()
   FilterDesign::Real tfGain = 1.0f / abs( tf.Evaluate( 1.0 ) );
   
   mInputEnvelopeFilter.clear();
-  int numInputEnvelopes = std::min( mAudioInputBlock.Channels(), ( int )mMaxInputEnvelopes );
+  mInputEnvelopeStates.clear();
+  int numInputEnvelopes = std::min( mAudioInputEnvelope.Channels(), ( int )mMaxInputEnvelopes );
   for( int i = 0; i < numInputEnvelopes; i++ )
+  {
     mInputEnvelopeFilter.push_back( IIRFilter< FilterDesign::Real >()
       .SetGain( tfGain )
       .SetZeros( tf.Numerator().Roots() )
       .SetPoles( tf.Denominator().Roots() )
       .Initialize( 1 ) );
+    std::stringstream ss;
+    ss << "AudioInEnvelope" << i + 1;
+    mInputEnvelopeStates.push_back( BCIEvent::StateHandle( States->ByName( ss.str() ) ) );
+  }
     
   mOutputEnvelopeFilter.clear();
-  int numOutputEnvelopes = std::min( mAudioOutputBlock.Channels(), ( int )mMaxOutputEnvelopes );
+  mOutputEnvelopeStates.clear();
+  int numOutputEnvelopes = std::min( mAudioOutputEnvelope.Channels(), ( int )mMaxOutputEnvelopes );
   for( int i = 0; i < numOutputEnvelopes; i++ )
+  {
     mOutputEnvelopeFilter.push_back( IIRFilter< FilterDesign::Real >()
       .SetGain( tfGain )
       .SetZeros( tf.Numerator().Roots() )
       .SetPoles( tf.Denominator().Roots() )
       .Initialize( 1 ) );
+    std::stringstream ss;
+    ss << "AudioOutEnvelope" << i + 1;
+    mOutputEnvelopeStates.push_back( BCIEvent::StateHandle( States->ByName( ss.str() ) ) );
+  }
+  mFrameState = BCIEvent::StateHandle( States->ByName( "AudioFrame" ) );
   
-  // Create the stream
-  PaStreamParameters* inputParameters = NULL;
-  if( mInputChannels > 0 )
+  // The null device is driven by its own thread, and does not need a stream
+  if( mHostAPI != HOSTAPI_NULL )
   {
-    inputParameters = new PaStreamParameters();
-    inputParameters->device = inDev;
-    inputParameters->channelCount = mInputChannels;
-    inputParameters->sampleFormat = paFloat32;
-    inputParameters->suggestedLatency = Pa_GetDeviceInfo( inputParameters->device )->defaultLowInputLatency;
-    inputParameters->hostApiSpecificStreamInfo = NULL;
-  }
+    // Create the stream
+    PaStreamParameters* inputParameters = NULL;
+    if( mInputChannels > 0 )
+    {
+      inputParameters = new PaStreamParameters();
+      inputParameters->device = inDev;
+      inputParameters->channelCount = mInputChannels;
+      inputParameters->sampleFormat = paFloat32;
+      inputParameters->suggestedLatency = Pa_GetDeviceInfo( inputParameters->device )->defaultLowInputLatency;
+      inputParameters->hostApiSpecificStreamInfo = NULL;
+    }
 
-  PaStreamParameters* outputParameters = NULL;
-  if( mOutputChannels > 0 )
-  {
-    outputParameters = new PaStreamParameters();
-    outputParameters->device = outDev;
-    outputParameters->channelCount = mOutputChannels;
-    outputParameters->sampleFormat = paFloat32;
-    outputParameters->suggestedLatency = Pa_GetDeviceInfo( outputParameters->device )->defaultLowOutputLatency;
-    outputParameters->hostApiSpecificStreamInfo = NULL;
-  }
+    PaStreamParameters* outputParameters = NULL;
+    if( mOutputChannels > 0 )
+    {
+      outputParameters = new PaStreamParameters();
+      outputParameters->device = outDev;
+      outputParameters->channelCount = mOutputChannels;
+      outputParameters->sampleFormat = paFloat32;
+      outputParameters->suggestedLatency = Pa_GetDeviceInfo( outputParameters->device )->defaultLowOutputLatency;
+      outputParameters->hostApiSpecificStreamInfo = NULL;
+    }
   
-  // Open an output stream and delete temporary variables
-  pa_error = Pa_OpenStream( &mpAudioStream, inputParameters, outputParameters,
-														SAMPLE_RATE, mFramesPerBuffer, 0, &AudioExtension::AudioCallback, this );
-	// Start the stream
-	if (pa_error != paNoError)
-		bcierr << "Error: " << pa_error << "\nFailure to Open Stream.";
-
-  delete inputParameters;
-  delete outputParameters;
-	inputParameters = nullptr;
-	outputParameters = nullptr;
+    // Open an output stream and delete temporary variables
+    pa_error = Pa_OpenStream( &mpAudioStream, inputParameters, outputParameters,
+                              SAMPLE_RATE, mFramesPerBuffer, 0, &AudioExtension::AudioCallback, this );
+    if (pa_error != paNoError)
+      bcierr << "Error: " << pa_error << "\nFailure to Open Stream.";
 
+    delete inputParameters;
+    delete outputParameters;
+  }
 
-  // Prepare and start the audio thread
-  mBufferProcessed.Reset();
+  // Prepare the audio thread
   mFrameCount = 0;
   mRand.SetSeed( ( RandomGenerator::SeedType )PrecisionTime::Now() );
 }
 
 // **************************************************************************
 // Function:   Execute
-// Purpose:    This function deals with audio mixing in a separate thread
-//             in order to disassociate the sample block latency from the
-//             audio latency
+// Purpose:    This function deals with recording and envelope extraction in
+//             a separate thread in order to keep the audio callback free of
+//             file I/O and event processing.
+//             The audio callback must not wait for a synchronization object,
+//             so this thread polls for new blocks at a fraction of the buffer
+//             duration.
 // Parameters: N/A
 // Returns:    0
 // **************************************************************************
 int AudioExtension::OnExecute()
 {
   ThreadUtils::Priority::Set(ThreadUtils::Priority::Maximum - 1);
-  // Create buffers for sound file input and output
-  float* fileInputBuf = mpAudioInputFile ? new float[ mFramesPerBuffer * mFileChannels ] : NULL;
-  float* fileRecInBuf = mpAudioRecInputFile ? new float[ mFramesPerBuffer * mChannelDef.size() ] : NULL;
-  float* fileRecOutBuf = mpAudioRecOutputFile ? new float[ mFramesPerBuffer * mOutputChannels ] : NULL;
-  
-  while (mBufferProcessed.Wait())
+  Time::Interval pollInterval = Time::Seconds( mFramesPerBuffer / 4.0 / SAMPLE_RATE );
+  size_t idx = 0;
+  while( !Terminating() )
   {
-    mBufferProcessed.Reset();
-    // Gather file input and add to the input block
-    if( mpAudioInputFile )
+    ReportStatus();
+    ReadAhead();
+    if( mFullBlocks.Consume( idx ) )
     {
-      sf_count_t readSize = sf_readf_float( mpAudioInputFile, fileInputBuf, mFramesPerBuffer );
-      for( size_t row = 0; row < mChannelDef.size(); row++ )
-        if( mChannelDef[ row ].first == CHANNELTYPE_FILE )
-          for( size_t idx = mChannelDef[ row ].second; idx < mFramesPerBuffer * mFileChannels; idx += mFileChannels )
-            mAudioInputBlock.SetValue( row, idx / mFileChannels, readSize ? fileInputBuf[ idx ] : 0.0f );
+      ProcessBlock( mBlocks[idx] );
+      mFreeBlocks.Produce( idx );
     }
-      
-    // Synthesize new input and add it to the input block
-    for( size_t i = 0; i < mChannelDef.size(); i++ )
-    {
-      int frequency = mChannelDef[i].second;
-      if( mChannelDef[i].first == CHANNELTYPE_TONE )
-        for( size_t frame = 0; frame < mFramesPerBuffer; frame++ )
-          mAudioInputBlock.SetValue( i, frame, sin( 2 * M_PI * frequency * ( ( mFrameCount + frame ) / ( float )SAMPLE_RATE ) ) );
-
-      if( mChannelDef[i].first == CHANNELTYPE_NOISE )
-      {
-        if( frequency == 0 ) frequency = SAMPLE_RATE;
-        int period = frequency = SAMPLE_RATE / frequency;
-        if( period < 1 ) period = 1;
-        float val = ( float )mAudioInputBlock.Value( i, mAudioInputBlock.Elements() - 1 );
-        for( size_t frame = 0; frame < mFramesPerBuffer; frame++ )
-        {
-          if( ( mFrameCount + frame ) % period == 0 )
-            val = ( float )mRand.Random() / ( float )mRand.RandMax();
-          mAudioInputBlock.SetValue( i, frame, val );
-        }
-      }
-    }
-      
-    // Record input block to sound file if necessary
-    if( mpAudioRecInputFile )
-    {
-      int idx = 0;
-			for (size_t frame = 0; frame < mFramesPerBuffer; frame++)
-				for (size_t chan = 0; chan < mChannelDef.size(); chan++)
-					fileRecInBuf[idx++] = (float)mAudioInputBlock.Value(chan, frame);
-      sf_writef_float( mpAudioRecInputFile, fileRecInBuf, mFramesPerBuffer );
-    }
-      
-    // Extract input envelopes and push to events
-    mAudioInputEnvelope = mAudioInputBlock;
-    mInputFilter.Process( mAudioInputEnvelope, mAudioInputEnvelope );
-    for( size_t chan = 0; chan < mInputEnvelopeFilter.size(); chan++ )
-    {
-      GenericChannel channelData( mAudioInputEnvelope, static_cast<int>( chan ) );
-      Rectify::FullWaveRectify( channelData, channelData );
-      mInputEnvelopeFilter[chan].Process( channelData, channelData );
-      unsigned short value = static_cast< unsigned short >( RootMeanSquare( channelData ) * 65535.0f );
-      bcievent << "AudioInEnvelope" << chan + 1 << " " << value;
-    }
-
-    // Mix input to output block
-    for( int outChan = 0; outChan < mAudioOutputBlock.Channels(); outChan++ )
-    {
-      for( size_t frame = 0; frame < mFramesPerBuffer; frame++ )
-        mAudioOutputBlock.SetValue( outChan, frame, 0.0f );
-      for( size_t inChan = 0; inChan < mMixer.size(); inChan++ )
-      {
-        float gain = mGainMatrix[ inChan ][ outChan ];
-        for( size_t frame = 0; frame < mFramesPerBuffer; frame++ )
-        {
-          float newValue = ( float )mAudioOutputBlock( outChan, frame );
-          newValue = newValue + ( gain * ( float )mAudioInputBlock( inChan, frame ) );
-          mAudioOutputBlock.SetValue( outChan, frame, newValue );
-        }
-      }
-    }
-
-    // Filter and extract output envelopes and push to events
-    mAudioOutputEnvelope = mAudioOutputBlock;
-    mOutputFilter.Process( mAudioOutputEnvelope, mAudioOutputEnvelope );
-    for( size_t chan = 0; chan < mOutputEnvelopeFilter.size(); chan++ )
-    {
-      GenericChannel channelData( mAudioOutputEnvelope, static_cast<int>( chan ) );
-      Rectify::FullWaveRectify( channelData, channelData );
-      mOutputEnvelopeFilter[chan].Process( channelData, channelData );
-      unsigned short value = static_cast< unsigned short >( RootMeanSquare( channelData ) * 65535.0f );
-      bcievent << "AudioOutEnvelope" << chan + 1 << " " << value;
-    }
-      
-    // Record output block to sound file if necessary
-    if( mpAudioRecOutputFile )
-    {
-      int idx = 0;
-      for( size_t frame = 0; frame < mFramesPerBuffer; frame++ )
-        for( int chan = 0; chan < mOutputChannels; chan++ )
-          fileRecOutBuf[ idx++ ] = ( float )mAudioOutputBlock( chan, frame );
-      sf_writef_float( mpAudioRecOutputFile, fileRecOutBuf, mFramesPerBuffer );
-    }
-      
-    // Push the new sample count to an event
-    mFrameCount += mFramesPerBuffer;
-    bcievent << "AudioFrame " << mFrameCount ;
+    else
+      ThreadUtils::SleepFor( pollInterval );
   }
-  
-  // Cleanup allocated file I/O buffers
-  delete [] fileInputBuf;
-  delete [] fileRecInBuf;
-  delete [] fileRecOutBuf;
-  
+  // Process blocks remaining after the stream was stopped
+  while( mFullBlocks.Consume( idx ) )
+  {
+    ProcessBlock( mBlocks[idx] );
+    mFreeBlocks.Produce( idx );
+  }
+  ReportStatus();
   return 0;
 }
 
@@ -653,7 +641,8 @@ void AudioExtension::Process()
   if( !mHostAPI ) return;
  
   // Evaluate the Mixer and create the gain matrix for this block
-  EvaluateMixer( mMixer, mGainMatrix );
+  EvaluateMixer( mMixer, mGains[mGainsWrite] );
+  PublishGains();
 }
 
 // **************************************************************************
@@ -697,7 +686,7 @@ void AudioExtension::StartRun()
     if (!(mpAudioRecInputFile = sf_open( file.c_str(), SFM_WRITE, &audioRecInputInfo ) ) )
         bcierr << "Could not open output file \"" << file << "\": " << sf_strerror(NULL);
   }
-  
+
   // Setup Output Recording
   SF_INFO audioRecOutputInfo;
   audioRecOutputInfo.channels = mOutputChannels;
@@ -709,16 +698,31 @@ void AudioExtension::StartRun()
     if (!(mpAudioRecOutputFile = sf_open(file.c_str(), SFM_WRITE, &audioRecOutputInfo)))
         bcierr << "Could not open output file \"" << file << "\": " << sf_strerror(NULL);
   }
+
+  // Hand all buffers to their producers
+  mFreeBlocks.Reserve( mBlocks.size() );
+  mFullBlocks.Reserve( mBlocks.size() );
+  for( size_t i = 0; i < mBlocks.size(); i++ )
+    mFreeBlocks.Produce( i );
+  mFreeFileBuffers.Reserve( mFileBuffers.size() );
+  mFullFileBuffers.Reserve( mFileBuffers.size() );
+  for( size_t i = 0; i < mFileBuffers.size(); i++ )
+    mFreeFileBuffers.Produce( i );
+  mCallbacks = 0;
+  mDroppedBlocks = 0;
+  mFileUnderruns = 0;
+  mCallbackTime = Time::Interval();
+  mMaxCallbackTime = Time::Interval();
   
   // Start Audio I/O Stream and processing
   if( mpAudioInputFile ) sf_seek( mpAudioInputFile, 0, SEEK_SET );
-	
-	pa_error = Pa_StartStream(mpAudioStream);
-	if (pa_error == paNoError)
-		Start();
-	else
-		bcierr << "Error: " << pa_error << "\nFailure to Initialize Stream.";
+  ReadAhead();
+  Start();
 
+  if( mHostAPI == HOSTAPI_NULL )
+    mNullStream.Start();
+  else if ((pa_error = Pa_StartStream(mpAudioStream)) != paNoError)
+    bcierr << "Error: " << pa_error << "\nFailure to Initialize Stream.";
 }
 
 // **************************************************************************
@@ -731,11 +735,25 @@ void AudioExtension::StopRun()
 {
   if( !mHostAPI ) return;
 
-	if ((pa_error = Pa_StopStream(mpAudioStream)) != paNoError)
-		bcierr << "Error: " << pa_error << "\nFailure to Stop Stream.";
+  if( mHostAPI == HOSTAPI_NULL )
+    mNullStream.Terminate();
+  else if ((pa_error = Pa_StopStream(mpAudioStream)) != paNoError)
+    bcierr << "Error: " << pa_error << "\nFailure to Stop Stream.";
 
 	Terminate();
 
+  if( mCallbacks > 0 )
+    bciout << "AudioExtension rendered " << mCallbacks << " buffers of "
+           << mFramesPerBuffer * 1e3 / SAMPLE_RATE << "ms, taking "
+           << mCallbackTime.Seconds() * 1e3 / mCallbacks << "ms on average, and "
+           << mMaxCallbackTime.Seconds() * 1e3 << "ms at most";
+  if( mDroppedBlocks > 0 )
+    bciwarn << "AudioExtension: " << mDroppedBlocks
+            << " buffers could not be recorded or analyzed in time";
+  if( mFileUnderruns > 0 )
+    bciwarn << "AudioExtension: " << mFileUnderruns
+            << " buffers of silence were played because reading AudioInputFile was too slow";
+
 	if (mpAudioInputFile)
 		sf_close(mpAudioInputFile);
 	if (mpAudioRecInputFile)
@@ -768,50 +786,261 @@ namespace {
   }
 }
 
+// **************************************************************************
+// Function:   ReportStatus
+// Purpose:    Report problems flagged by the audio callback
+// Parameters: N/A
+// Returns:    N/A
+// **************************************************************************
+void AudioExtension::ReportStatus()
+{
+  PaStreamCallbackFlags flags = mStatusFlags.exchange( 0 );
+  if( flags != 0 )
+    bciwarn << "PA callback status flags: " << print( flags );
+  unsigned long frames = mFrameMismatches.exchange( 0 );
+  if( frames != 0 )
+    bcierr << "PA callback framesPerBuffer mismatch: " << frames
+           << "!=" << mFramesPerBuffer;
+}
+
+// **************************************************************************
+// Function:   ReadAhead
+// Purpose:    Fill all free file buffers from the audio input file
+// Parameters: N/A
+// Returns:    N/A
+// **************************************************************************
+void AudioExtension::ReadAhead()
+{
+  size_t idx = 0;
+  while( mpAudioInputFile && mFreeFileBuffers.Consume( idx ) )
+  {
+    std::vector< float > &buffer = mFileBuffers[idx];
+    sf_count_t readSize = sf_readf_float( mpAudioInputFile, buffer.data(), mFramesPerBuffer );
+    std::fill( buffer.begin() + readSize * mFileChannels, buffer.end(), 0.0f );
+    mFullFileBuffers.Produce( idx );
+  }
+}
+
+// **************************************************************************
+// Function:   ProcessBlock
+// Purpose:    Record a block of mixer input and output, extract envelopes,
+//             and post them as events
+// Parameters: block: A block rendered by the audio callback
+// Returns:    N/A
+// **************************************************************************
+void AudioExtension::ProcessBlock( const AudioBlock &block )
+{
+  size_t numIns = mChannelDef.size();
+
+  // Record input block to sound file if necessary
+  if( mpAudioRecInputFile )
+  {
+    int idx = 0;
+    for( size_t frame = 0; frame < mFramesPerBuffer; frame++ )
+      for( size_t chan = 0; chan < numIns; chan++ )
+        mRecordBuffer[ idx++ ] = block.input[ chan * mFramesPerBuffer + frame ];
+    sf_writef_float( mpAudioRecInputFile, mRecordBuffer.data(), mFramesPerBuffer );
+  }
+
+  // Extract input envelopes and push to events
+  std::copy( block.input.begin(), block.input.end(), mAudioInputEnvelope.MutableData() );
+  mInputFilter.Process( mAudioInputEnvelope, mAudioInputEnvelope );
+  for( size_t chan = 0; chan < mInputEnvelopeFilter.size(); chan++ )
+  {
+    GenericChannel channelData( mAudioInputEnvelope, static_cast<int>( chan ) );
+    Rectify::FullWaveRectify( channelData, channelData );
+    mInputEnvelopeFilter[chan].Process( channelData, channelData );
+    unsigned short value = static_cast< unsigned short >( RootMeanSquare( channelData ) * 65535.0f );
+    BCIEvent::Post( mInputEnvelopeStates[chan], value, block.time );
+  }
+
+  // Filter and extract output envelopes and push to events
+  std::copy( block.output.begin(), block.output.end(), mAudioOutputEnvelope.MutableData() );
+  mOutputFilter.Process( mAudioOutputEnvelope, mAudioOutputEnvelope );
+  for( size_t chan = 0; chan < mOutputEnvelopeFilter.size(); chan++ )
+  {
+    GenericChannel channelData( mAudioOutputEnvelope, static_cast<int>( chan ) );
+    Rectify::FullWaveRectify( channelData, channelData );
+    mOutputEnvelopeFilter[chan].Process( channelData, channelData );
+    unsigned short value = static_cast< unsigned short >( RootMeanSquare( channelData ) * 65535.0f );
+    BCIEvent::Post( mOutputEnvelopeStates[chan], value, block.time );
+  }
+
+  // Record output block to sound file if necessary
+  if( mpAudioRecOutputFile )
+  {
+    int idx = 0;
+    for( size_t frame = 0; frame < mFramesPerBuffer; frame++ )
+      for( int chan = 0; chan < mOutputChannels; chan++ )
+        mRecordBuffer[ idx++ ] = block.output[ chan * mFramesPerBuffer + frame ];
+    sf_writef_float( mpAudioRecOutputFile, mRecordBuffer.data(), mFramesPerBuffer );
+  }
+
+  // Push the sample count to an event
+  BCIEvent::Post( mFrameState, block.frameCount, block.time );
+}
+
 // **************************************************************************
 // Function:   AudioCallback
 // Purpose:    Recieve audio input data and send mixed output data
 // Parameters: input, output, number of frames per buffer, internal clock,
 //             stream status, and a pointer to the object
-// Returns:    True if Audio Host API Information was retreived correctly
+// Returns:    paContinue
 // **************************************************************************
 int AudioExtension::AudioCallback( const void *inputBuffer, void *outputBuffer,
   unsigned long framesPerBuffer, const PaStreamCallbackTimeInfo* timeInfo,
   PaStreamCallbackFlags statusFlags, void *userData )
 {
   AudioExtension* audioExtension = ( AudioExtension* )userData;
-  if (framesPerBuffer != audioExtension->mFramesPerBuffer)
-      bcierr << "PA callback framesPerBuffer mismatch: " << framesPerBuffer
-             << "!=" << audioExtension->mFramesPerBuffer;
-  if (statusFlags != 0)
-      bciwarn << "PA callback status flags: " << print(statusFlags);
-  // Push audio input data into the input buffer block
-  float* in = ( float* )inputBuffer;
-  int inputChannels = audioExtension->mInputChannels;
-  double* audioInputBlockData = audioExtension->mAudioInputBlock.MutableData();
-  for (size_t row = 0; row < audioExtension->mChannelDef.size(); row++)
+  audioExtension->RenderAudio( ( const float* )inputBuffer, ( float* )outputBuffer,
+    framesPerBuffer, statusFlags );
+  return paContinue;
+}
+
+// **************************************************************************
+// Function:   RenderAudio
+// Purpose:    Gather mixer inputs, mix them into the output buffer, and pass
+//             both to the worker thread
+// Parameters: input: Interleaved device input, or NULL
+//             output: Interleaved device output
+//             frames: Number of frames per buffer
+//             statusFlags: Stream status
+// Returns:    N/A
+// **************************************************************************
+void AudioExtension::RenderAudio( const float* input, float* output,
+  unsigned long frames, PaStreamCallbackFlags statusFlags )
+{
+  Time start = TimeUtils::MonotonicTime();
+  PrecisionTime now = PrecisionTime::Now();
+  if( statusFlags != 0 )
+    mStatusFlags.fetch_or( statusFlags );
+  if( frames != mFramesPerBuffer )
   {
-    if (audioExtension->mChannelDef[row].first == CHANNELTYPE_INPUT)
+    mFrameMismatches = frames;
+    std::fill( output, output + frames * mOutputChannels, 0.0f );
+    return;
+  }
+
+  // Get a block from the pool, or render into the spare block when the
+  // worker thread has fallen behind
+  size_t blockIdx = 0;
+  bool pooled = mFreeBlocks.Consume( blockIdx );
+  AudioBlock &block = pooled ? mBlocks[blockIdx] : mSpareBlock;
+  if( !pooled )
+    ++mDroppedBlocks;
+
+  size_t fileIdx = 0;
+  const float* fileInput = NULL;
+  if( mpAudioInputFile )
+  {
+    if( mFullFileBuffers.Consume( fileIdx ) )
+      fileInput = mFileBuffers[fileIdx].data();
+    else
+      ++mFileUnderruns;
+  }
+
+  // Gather mixer inputs
+  size_t numIns = mChannelDef.size();
+  for( size_t row = 0; row < numIns; row++ )
+  {
+    float* p = &block.input[ row * frames ];
+    int data = mChannelDef[row].second;
+    switch( mSourceTypes[row] )
     {
-      for (size_t idx = audioExtension->mChannelDef[row].second;
-        idx < audioExtension->mFramesPerBuffer * inputChannels;
-        idx += inputChannels)
+      case SourceInput:
+        for( size_t frame = 0; frame < frames; frame++ )
+          p[frame] = input ? input[ frame * mInputChannels + data ] : 0.0f;
+        break;
+      case SourceFile:
+        for( size_t frame = 0; frame < frames; frame++ )
+          p[frame] = fileInput ? fileInput[ frame * mFileChannels + data ] : 0.0f;
+        break;
+      case SourceTone:
+        for( size_t frame = 0; frame < frames; frame++ )
+          p[frame] = sin( 2 * M_PI * data * ( ( mFrameCount + frame ) / ( float )SAMPLE_RATE ) );
+        break;
+      case SourceNoise:
       {
-        int idxOut = audioExtension->mAudioInputBlock.LinearIndex(row, idx / inputChannels);
-        audioInputBlockData[idxOut] = in[idx];
-      }
+        int period = SAMPLE_RATE / ( data == 0 ? SAMPLE_RATE : data );
+        if( period < 1 ) period = 1;
+        float val = mNoiseValues[row];
+        for( size_t frame = 0; frame < frames; frame++ )
+        {
+          if( ( mFrameCount + frame ) % period == 0 )
+            val = ( float )mRand.Random() / ( float )mRand.RandMax();
+          p[frame] = val;
+        }
+        mNoiseValues[row] = val;
+      } break;
+      default:
+        std::fill( p, p + frames, 0.0f );
     }
   }
-  // Notify the AudioExtension thread that new data has been posted
-  audioExtension->mBufferProcessed.Set();
-  
-  // Populate output stream from the audio output buffer block
+  if( fileInput )
+    mFreeFileBuffers.Produce( fileIdx );
+
+  // Pick up the most recent gain matrix
+  if( mGainsPending.load() & cGainsFresh )
+    mGainsRead = mGainsPending.exchange( mGainsRead ) & ~cGainsFresh;
+  const float* gains = mGains[mGainsRead].data();
+
+  // Mix input to output block
+  for( int outChan = 0; outChan < mMixerOutputs; outChan++ )
+  {
+    float* out = &block.output[ outChan * frames ];
+    std::fill( out, out + frames, 0.0f );
+    for( size_t inChan = 0; inChan < numIns; inChan++ )
+    {
+      float gain = gains[ outChan * numIns + inChan ];
+      if( gain == 0.0f )
+        continue;
+      const float* in = &block.input[ inChan * frames ];
+#pragma omp simd
+      for( size_t frame = 0; frame < frames; frame++ )
+        out[frame] += gain * in[frame];
+    }
+  }
+
+  // Populate output stream from the output block
   int idx = 0;
-  float* out = ( float* )outputBuffer;
-  for( int frame = 0; frame < audioExtension->mAudioOutputBlock.Elements(); frame++ )
-    for( int chan = 0; chan < audioExtension->mAudioOutputBlock.Channels(); chan++ )
-      out[ idx++ ] = ( float )audioExtension->mAudioOutputBlock( chan, frame );
+  for( size_t frame = 0; frame < frames; frame++ )
+    for( int chan = 0; chan < mOutputChannels; chan++ )
+      output[ idx++ ] = block.output[ chan * frames + frame ];
+
+  mFrameCount += frames;
+  block.frameCount = mFrameCount;
+  block.time = now;
+  if( pooled )
+    mFullBlocks.Produce( blockIdx );
 
+  Time::Interval duration = TimeUtils::MonotonicTime() - start;
+  mCallbackTime += duration;
+  if( duration > mMaxCallbackTime )
+    mMaxCallbackTime = duration;
+  ++mCallbacks;
+}
+
+// **************************************************************************
+// Function:   NullStream::OnExecute
+// Purpose:    Call RenderAudio() once per buffer duration, discarding output
+// Parameters: N/A
+// Returns:    0
+// **************************************************************************
+int AudioExtension::NullStream::OnExecute()
+{
+  ThreadUtils::Priority::Set( ThreadUtils::Priority::Maximum );
+  unsigned long frames = mpParent->mFramesPerBuffer;
+  std::vector< float > output( frames * mpParent->mOutputChannels );
+  Time::Interval period = Time::Seconds( frames / ( double )SAMPLE_RATE );
+  Time next = TimeUtils::MonotonicTime();
+  while( !Terminating() )
+  {
+    mpParent->RenderAudio( NULL, output.data(), frames, 0 );
+    next += period;
+    Time::Interval wait = next - TimeUtils::MonotonicTime();
+    if( wait > 0 )
+      ThreadUtils::SleepFor( wait );
+  }
   return 0;
 }
 
@@ -948,22 +1177,31 @@ void AudioExtension::LoadMixer( const ParamRef &matrix, ExpressionMatrix &mixer,
 
 // **************************************************************************
 // Function:   EvaluateMixer
-// Purpose:    Stop and close the audio stream/thread if it is running
-//             on the input.
+// Purpose:    Evaluate the mixer expressions into a dense gain matrix with
+//             one row of input gains per output
+// Parameters: mixer: A Matrix of expressions with one row per input
+//             gainMatrix: The resulting gain matrix
+// Returns:    N/A
+// **************************************************************************
+void AudioExtension::EvaluateMixer( ExpressionMatrix &mixer, GainMatrix &gainMatrix ) const
+{
+  size_t numIns = mixer.size(), numOuts = numIns ? mixer[0].size() : 0;
+  gainMatrix.resize( numIns * numOuts );
+  for( size_t inChan = 0; inChan < numIns; inChan++ )
+    for( size_t outChan = 0; outChan < numOuts; outChan++ )
+      gainMatrix[ outChan * numIns + inChan ] = ( float )mixer[ inChan ][ outChan ].Evaluate();
+}
+
+// **************************************************************************
+// Function:   PublishGains
+// Purpose:    Make the gain matrix most recently evaluated into
+//             mGains[mGainsWrite] available to the audio callback
 // Parameters: N/A
-// Returns:    true if error occurred, false if not.
+// Returns:    N/A
 // **************************************************************************
-void AudioExtension::EvaluateMixer( ExpressionMatrix &mixer, std::vector< std::vector< float > > &gainMatrix ) const
+void AudioExtension::PublishGains()
 {
-  // Calculate the new gain matrix
-  if( gainMatrix.size() != mixer.size() ) gainMatrix.resize( mixer.size() );
-  for( size_t inChan = 0; inChan < mixer.size(); inChan++ )
-  {
-    if( gainMatrix[ inChan ].size() != mixer[ inChan ].size() ) 
-      gainMatrix[ inChan ].resize( mixer[ inChan ].size() );
-    for( size_t outChan = 0; outChan < mixer[ inChan ].size(); outChan++ )
-      gainMatrix[ inChan ][ outChan ] = ( float )mixer[ inChan ][ outChan ].Evaluate();
-  }
+  mGainsWrite = mGainsPending.exchange( mGainsWrite | cGainsFresh ) & ~cGainsFresh;
 }
 
 
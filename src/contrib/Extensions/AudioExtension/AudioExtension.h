@@ -37,6 +37,8 @@
 #include <map>
 #include <set>
 #include <vector>
+#include <atomic>
+#include <cstdint>
 #include <portaudio.h>
 #include <sndfile.h>
 #include "Environment.h"
@@ -44,7 +46,9 @@
 #include "RandomGenerator.h"
 #include "Expression/Expression.h"
 #include "IIRFilter.h"
-#include "WaitableEvent.h"
+#include "BCIEvent.h"
+#include "LockFreeQueue.h"
+#include "TimeUtils.h"
 
 
 class AudioExtension : public EnvironmentExtension, public Thread
@@ -68,8 +72,8 @@ class AudioExtension : public EnvironmentExtension, public Thread
   typedef std::vector< ExpressionVector > ExpressionMatrix;
   typedef std::vector< std::pair< std::string, int > > ChannelDef;
   typedef std::vector< IIRFilter< FilterDesign::Real > > FilterBank;
+  typedef std::vector< float > GainMatrix; // dense, one row of input gains per output
   ExpressionMatrix mMixer;
-  std::vector< std::vector< float > > mGainMatrix;
   
   // Internal configuration methods
   bool GetHostApiConfig( PaHostApiTypeId hostApi, const PaHostApiInfo* &apiInfo, PaHostApiIndex &hostIdx ) const;
@@ -77,24 +81,78 @@ class AudioExtension : public EnvironmentExtension, public Thread
     int &inputIdx, int &outputIdx, int &inputChannels, int &outputChannels ) const;
   void LoadMixer( const ParamRef &matrix, ExpressionMatrix &mixer,
     ChannelDef &channelDef, int audioIns, int audioOuts, int fileIns ) const;
-  void EvaluateMixer( ExpressionMatrix &mixer, std::vector< std::vector< float > > &gainMatrix ) const;
+  void EvaluateMixer( ExpressionMatrix &mixer, GainMatrix &gainMatrix ) const;
+  void PublishGains();
   void DesignFilterbank( const ParamRef &matrix, IIRFilter< FilterDesign::Real > &filter, size_t numCh ) const;
 
-
   // Static audio callback
   static int AudioCallback( const void *inputBuffer, void *outputBuffer,
     unsigned long framesPerBuffer, const PaStreamCallbackTimeInfo* timeInfo,
     PaStreamCallbackFlags statusFlags, void *userData );
-  
+  // Called from the audio callback, or from the null stream when no audio
+  // device is used. Must not wait, allocate memory, or write to bci streams.
+  void RenderAudio( const float* input, float* output, unsigned long frames, PaStreamCallbackFlags statusFlags );
+
+  // Drives RenderAudio() in real time for the "Null" host API, which allows to
+  // run and benchmark the extension without audio hardware.
+  class NullStream : public Thread
+  {
+   public:
+    NullStream( AudioExtension* p ) : mpParent( p ) {}
+    ~NullStream() { TerminateAndWait(); }
+   private:
+    int OnExecute() override;
+    AudioExtension* mpParent;
+  };
+
+  enum SourceType
+  {
+    SourceNone,
+    SourceInput,
+    SourceFile,
+    SourceTone,
+    SourceNoise
+  };
+
+  // Audio data travels between the audio callback and the worker thread in
+  // preallocated blocks. Block and file buffer indices are exchanged through
+  // lock-free queues, so neither side ever waits for the other.
+  struct AudioBlock
+  {
+    std::vector< float > input,   // channel-major, one channel per mixer row
+                         output;  // channel-major, one channel per mixer column
+    unsigned int frameCount;
+    PrecisionTime time;
+  };
+  std::vector< AudioBlock >          mBlocks;
+  AudioBlock                         mSpareBlock;
+  LockFreeQueue< size_t >            mFreeBlocks,
+                                     mFullBlocks;
+  std::vector< std::vector< float > > mFileBuffers;
+  LockFreeQueue< size_t >            mFreeFileBuffers,
+                                     mFullFileBuffers;
+
+  // Worker thread functions
+  void ReadAhead();
+  void ProcessBlock( const AudioBlock & );
+  void ReportStatus();
+
+  // The gain matrix is passed from Process() to the audio callback through
+  // a triple buffer: the writer and the callback each own one buffer, and
+  // swap it with the pending one.
+  enum { cGainsFresh = 4 };
+  GainMatrix                         mGains[3];
+  std::atomic< int >                 mGainsPending;
+  int                                mGainsWrite,
+                                     mGainsRead;
+
   // Member variables
   std::set< int >                    mSupportedAPIs;
   int                                mHostAPI;
   
-  WaitableEvent                      mBufferProcessed;
-  GenericSignal                      mAudioInputBlock,
-                                     mAudioOutputBlock,
-                                     mAudioInputEnvelope,
+  GenericSignal                      mAudioInputEnvelope,
                                      mAudioOutputEnvelope;
+  std::vector< float >               mRecordBuffer;
   
   unsigned int                       mFrameCount,
                                      mFramesPerBuffer,
@@ -103,12 +161,30 @@ class AudioExtension : public EnvironmentExtension, public Thread
   
   int                                mInputChannels,
                                      mOutputChannels,
-                                     mFileChannels;
+                                     mFileChannels,
+                                     mMixerOutputs;
   
   ChannelDef                         mChannelDef;
+  std::vector< SourceType >          mSourceTypes;
+  std::vector< float >               mNoiseValues;
   RandomGenerator                    mRand;
+
+  BCIEvent::StateHandle              mFrameState;
+  std::vector< BCIEvent::StateHandle > mInputEnvelopeStates,
+                                     mOutputEnvelopeStates;
+
+  // Written by the audio callback, and reported by the worker thread
+  std::atomic< unsigned long >       mStatusFlags,
+                                     mFrameMismatches;
+  // Callback statistics, reported after the stream has been stopped
+  uint64_t                           mCallbacks,
+                                     mDroppedBlocks,
+                                     mFileUnderruns;
+  Time::Interval                     mCallbackTime,
+                                     mMaxCallbackTime;
   
   PaStream                          *mpAudioStream;
+  NullStream                         mNullStream;
 	PaError														pa_error;
   
   SNDFILE                           *mpAudioInputFile,
@@ -77,7 +77,8 @@ struct EyetrackerLoggerSimulator::Private : Thread
 
   bool mEnabled = false;
   Expression mInit;
-  std::vector<std::pair<std::string, Expression>> mExpressions;
+  std::vector<std::pair<BCIEvent::StateHandle, Expression>> mExpressions;
+  BCIEvent::StateHandle mTimeState;
   TimeUtils::TimeInterval mPeriod = 0;
 };
 
@@ -172,9 +173,10 @@ void EyetrackerLoggerSimulator::Initialize()
         state += expressions->RowLabels()[row];
         state += expressions->ColumnLabels()[col];
         Expression expr = expressions(row, col);
-        p->mExpressions.push_back(std::make_pair(state, expr));
+        p->mExpressions.push_back(std::make_pair(BCIEvent::StateHandle(States->ByName(state)), expr));
       }
     }
+    p->mTimeState = BCIEvent::StateHandle(States->ByName("EyetrackerTime"));
   }
 }
 
@@ -214,10 +216,10 @@ int EyetrackerLoggerSimulator::Private::OnExecute()
       value = ::floor(value + 0.5);
       value = std::min(value, 65535.0);
       value = std::max(value, 0.0);
-      bcievent << entry.first << " " << value;
+      BCIEvent::Post(entry.first, static_cast<State::ValueType>(value));
     }
     variables["t"] += 1;
-    bcievent << "EyetrackerTime " << PrecisionTime::Now();
+    BCIEvent::Post(mTimeState, PrecisionTime::Now());
   }
   return 0;
 }
\ No newline at end of file
@@ -166,13 +166,16 @@ CoherenceFilter::Process( const GenericSignal& Input, GenericSignal& Output )
     for( int sample = std::max( 0, Input.Elements() - static_cast<int>( mInputBuffer[ch].size() ) ); sample < Input.Elements(); ++sample )
       mInputBuffer[ch][sample + mInputBuffer[ch].size() - Input.Elements()] = Input( ch, sample );
     // Remove mean to avoid artifacts.
-    std::valarray<real> zeroMeanBuffer = mInputBuffer[ch];
-    zeroMeanBuffer -= std::accumulate( &zeroMeanBuffer[0], &zeroMeanBuffer[zeroMeanBuffer.size()], 0.0 ) / zeroMeanBuffer.size();
+    size_t bufferLength = mInputBuffer[ch].size();
+    real mean = std::accumulate( &mInputBuffer[ch][0], &mInputBuffer[ch][0] + bufferLength, 0.0 ) / bufferLength;
+    real* zeroMeanBuffer = BlockArena().New<real>( bufferLength );
+    for( size_t sample = 0; sample < bufferLength; ++sample )
+      zeroMeanBuffer[sample] = mInputBuffer[ch][sample] - mean;
     // Convolve with the FIR filter using the configured step size.
     for( size_t bin = 0; bin < mFIRCoefficients.size(); ++bin )
     {
       int i = 0;
-      for( size_t sample = 0; sample < zeroMeanBuffer.size() - mFIRCoefficients[bin].size(); sample += mConvolutionStep )
+      for( size_t sample = 0; sample < bufferLength - mFIRCoefficients[bin].size(); sample += mConvolutionStep )
         mFIRConvolution[ch][bin][i++] = inner_product(
                                           &mFIRCoefficients[bin][0],
                                           &mFIRCoefficients[bin][mFIRCoefficients[bin].size()],
@@ -204,5 +207,8 @@ CoherenceFilter::Process( const GenericSignal& Input, GenericSignal& Output )
 CoherenceFilter::complex
 CoherenceFilter::InnerProduct( const std::valarray<complex>& inV1, const std::valarray<complex>& inV2 )
 {
-  return ( inV1 * inV2.apply( std::conj ) ).sum();
+  complex result = 0.0;
+  for( size_t i = 0; i < inV1.size(); ++i )
+    result += inV1[i] * std::conj( inV2[i] );
+  return result;
 }
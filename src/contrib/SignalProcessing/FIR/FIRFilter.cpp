@@ -24,6 +24,7 @@
 ////////////////////////////////////////////////////////////////////////////////
 #include "FIRFilter.h"
 
+#include <algorithm>
 #include <numeric>
 
 RegisterFilter( FIRFilter, 2.C );
@@ -119,7 +120,7 @@ FIRFilter::Process( const GenericSignal& Input, GenericSignal& Output )
     for( int sample = 0; sample < inputLength; ++sample )
       mBuffer[channel][bufferLength - inputLength + sample] = Input( channel, sample );
     // Compute buffer's convolution with coefficient vector.
-    DataVector result( 0.0, inputLength );
+    double* result = BlockArena().New<double>( inputLength );
     for( int sample = 0; sample < inputLength; ++sample )
       result[sample] = std::inner_product( &mFilter[channel][0], &mFilter[channel][filterLength], &mBuffer[channel][sample], 0.0 );
     // Compute output.
@@ -131,16 +132,15 @@ FIRFilter::Process( const GenericSignal& Input, GenericSignal& Output )
         break;
 
       case mean:
-        Output( channel, 0 ) = result.sum() / inputLength;
+        Output( channel, 0 ) = std::accumulate( result, result + inputLength, 0.0 ) / inputLength;
         break;
 
       case rms:
-        result *= result;
-        Output( channel, 0 ) = ::sqrt( result.sum() / inputLength );
+        Output( channel, 0 ) = ::sqrt( std::inner_product( result, result + inputLength, result, 0.0 ) / inputLength );
         break;
 
       case max:
-        Output( channel, 0 ) = result.max();
+        Output( channel, 0 ) = *std::max_element( result, result + inputLength );
         break;
 
       default:
@@ -30,6 +30,7 @@
 #include "MeasurementUnits.h"
 #include "Thread.h"
 
+#include <algorithm>
 #include <cmath>
 #include <cctype>
 
@@ -336,6 +337,7 @@ FilePlaybackADC::Initialize( const SignalProperties&, const SignalProperties& )
   mSuspendAtEnd = (Parameter("PlaybackLooped") == 0);
 
   mStateMappings.clear();
+  mSrcStates.Clear();
   if( Parameter("PlaybackStates") != 0 )
   {
     StateList* statesHere = States;
@@ -348,6 +350,7 @@ FilePlaybackADC::Initialize( const SignalProperties&, const SignalProperties& )
         unsigned int indf = statesFile->Index(statename);
         const class State& srf = statesFile->ByIndex( indf );
         mStateMappings.push_back(StateMapping( srf.Location(), srf.Length(), srh.Location(), srh.Length() ));
+        mSrcStates.Add( srf );
         //bciout << "Will play back " << statename << " from (" << indf << "," << srf.Location() << "," << srf.Length() << ")" << " to (" << i << "," << srh.Location() << "," << srh.Length() << ")";
       }
     }
@@ -387,12 +390,17 @@ FilePlaybackADC::Process( const GenericSignal&, GenericSignal& Output )
       curCh = mChList[ch];
       Output(ch, el) = mDataFile->RawValue(curCh, curDataSample);
     }
-    if( playStates )
+  }
+  if( playStates )
+  { // Read all played-back states for the entire block at once.
+    long long firstSample = ( long long )mBlockSize * ( long long )mCurBlock;
+    int count = static_cast<int>( std::min<long long>( mBlockSize, nSamples - firstSample ) );
+    if( count > 0 )
     {
-      mDataFile->ReadStateVector( curSample );
-      const StateVector* sv = mDataFile->StateVector();
+      mSrcValues.resize( mSrcStates.Columns() * count );
+      mDataFile->ReadStateValues( mSrcStates, firstSample, count, mSrcValues.data() );
       for( unsigned int i = 0; i < mStateMappings.size(); i++ )
-        mStateMappings[i].Copy( sv, 0, Statevector, el );
+        mStateMappings[i].Copy( mSrcValues.data() + i * count, count, Statevector );
     }
   }
   mCurBlock++;
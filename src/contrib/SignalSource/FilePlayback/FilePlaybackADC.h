@@ -72,12 +72,19 @@ class FilePlaybackADC : public GenericADC
 			public:
 				StateMapping(size_t srcLoc, size_t srcLen, size_t dstLoc, size_t dstLen) {mSrcLoc=srcLoc; mSrcLen=srcLen; mDstLoc=dstLoc; mDstLen=dstLen; mPrevVal=0;}
 				void Reset() { mPrevVal = 0; }
-				void Copy(const StateVector* srcVec, size_t srcSampleOffset, StateVector* dstVec, size_t dstSampleOffset )
+				size_t SrcLoc() const { return mSrcLoc; }
+				size_t SrcLen() const { return mSrcLen; }
+				// Copies a block of source values; as with SetStateValue(), a changed value
+				// is propagated to all subsequent samples of the destination state vector.
+				void Copy(const State::ValueType* srcValues, int count, StateVector* dstVec)
 				{
-					State::ValueType val = srcVec->StateValue( mSrcLoc, mSrcLen, srcSampleOffset );
-					if( val == mPrevVal ) return;
-					mPrevVal = val;
-					dstVec->SetStateValue( mDstLoc, mDstLen, dstSampleOffset, val );
+					int first = 0;
+					while( first < count && srcValues[first] == mPrevVal ) ++first;
+					if( first == count ) return;
+					mPrevVal = srcValues[count - 1];
+					mBuffer.assign( srcValues + first, srcValues + count );
+					mBuffer.resize( dstVec->Samples() - first, mPrevVal );
+					dstVec->SetSampleValues( mDstLoc, mDstLen, first, mBuffer.size(), mBuffer.data() );
 				}
 			private:
 				size_t mSrcLoc;
@@ -85,8 +92,11 @@ class FilePlaybackADC : public GenericADC
 				size_t mDstLoc;
 				size_t mDstLen;
 				State::ValueType mPrevVal;
+				std::vector<State::ValueType> mBuffer;
 		};
 		std::vector<StateMapping> mStateMappings;
+		StateVector::ColumnPlan mSrcStates;
+		std::vector<State::ValueType> mSrcValues;
     Clock mClock;
 };
 
@@ -30,6 +30,7 @@
 #include "Expression/Expression.h"
 #include "ImageStimulus.h"
 #include "Localization.h"
+#include "MediaCache.h"
 #include "TextStimulus.h"
 #include "ProgressBarVis.h"
 
@@ -114,6 +115,8 @@ StimulusPresentationTask::StimulusPresentationTask()
 
       "Application:Stimuli int TestAllStimuli= 0 1 0 1 // "
           "Load all stimuli during preflight phase, even if not presented (boolean)",
+      "Application:Stimuli int MediaCacheSize= 512 512 0 % // "
+          "Memory budget for decoded image and audio files, in MB",
 
       "Application:ProgressBar int ProgressBar= 0 1 0 1 // "
           "Display progress bar (boolean)",
@@ -260,6 +263,20 @@ void StimulusPresentationTask::OnPreflight(const SignalProperties &Input) const
         icon,
         av
     };
+    // The media cache budget is process-wide, so it is applied in Initialize() only.
+    if (int(Parameter("MediaCacheSize")) < 0)
+        bcierr << "MediaCacheSize must not be negative";
+    if (pImageStimulus != NULL)
+    {
+        // Decode icon files in parallel, so checking them below only needs to look them up.
+        std::vector<std::string> files;
+        for (size_t i = 0; i < stimParams.size(); ++i)
+            for (int j = 0; j < Parameter(stimParams[i])->NumColumns(); ++j)
+                if (Parameter("TestAllStimuli") != 0 || stimParams[i] != "Stimuli" ||
+                    activeStimuli.find(j + 1) != activeStimuli.end())
+                    files.push_back(Parameter(stimParams[i])(icon, j));
+        ImageStimulus::Preload(files);
+    }
     for (size_t i = 0; i < stimParams.size(); ++i)
         for (int j = 0; j < Parameter(stimParams[i])->NumColumns(); ++j)
         {
@@ -397,6 +414,22 @@ void StimulusPresentationTask::OnInitialize(const SignalProperties & /*Input*/)
     };
     ParamRef Stimuli = Parameter("Stimuli");
     std::set<int> activeStimuli = DetermineActiveStimuli();
+    MediaCache::Instance().SetBudget(int64_t(int(Parameter("MediaCacheSize"))) << 20);
+    if (iconSwitch)
+    {
+        // Icon files evicted from the media cache since Preflight are decoded in parallel here.
+        std::vector<std::string> files;
+        for (int i = 0; i < Stimuli->NumColumns(); ++i)
+            if (activeStimuli.find(i + 1) != activeStimuli.end())
+                files.push_back(Stimuli(icon, i));
+        if (presentFocusOn)
+            for (int i = 0; i < Parameter("FocusOn")->NumColumns(); ++i)
+                files.push_back(Parameter("FocusOn")(icon, i));
+        if (presentResult)
+            for (int i = 0; i < Parameter("Result")->NumColumns(); ++i)
+                files.push_back(Parameter("Result")(icon, i));
+        ImageStimulus::Preload(files);
+    }
     for (int i = 0; i < Stimuli->NumColumns(); ++i)
     {
         // For efficiency, avoid loading stimuli that are not going to be used
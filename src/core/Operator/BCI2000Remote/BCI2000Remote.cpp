@@ -28,6 +28,7 @@
 // $END_BCI2000_LICENSE$
 /////////////////////////////////////////////////////////////////////////////
 #include "BCI2000Remote.h"
+#include <cstring>
 #include <fstream>
 #include <sstream>
 #include <thread>
@@ -327,3 +328,117 @@ void BCI2000Remote::Watch::ThreadFunc()
         }
     }
 }
+
+namespace
+{
+uint32_t GetLittleEndian(const char *p, int bytes)
+{
+    uint32_t value = 0;
+    for (int i = bytes - 1; i >= 0; --i)
+        value = (value << 8) | static_cast<unsigned char>(p[i]);
+    return value;
+}
+} // namespace
+
+BCI2000Remote::Subscription* BCI2000Remote::NewSubscription(const std::vector<int>& channels,
+                                                            const std::vector<std::string>& states,
+                                                            int decimation, SubscriptionCallbackFn callback, void* data)
+{
+    std::ostringstream cmd;
+    cmd << "SUBSCRIBE SIGNAL";
+    if (!channels.empty())
+    {
+        cmd << " CHANNELS";
+        for (int ch : channels)
+            cmd << " " << ch;
+    }
+    if (!states.empty())
+    {
+        cmd << " STATES";
+        for (const auto& state : states)
+            cmd << " " << state;
+    }
+    if (decimation > 1)
+        cmd << " DECIMATE " << decimation;
+    // Frames are sent from the operator's machine, so listen on the interface
+    // we are connected to, and let the operator choose a port.
+    std::string ip = TelnetAddress().substr(0, TelnetAddress().rfind(':'));
+    cmd << " AT " << (ip.empty() ? "localhost" : ip) << ":0";
+
+    std::string addr;
+    int exitCode = 0;
+    if (!Execute(cmd.str(), &exitCode, &addr) || addr.empty())
+        return nullptr;
+    Subscription* pSubscription = new Subscription(this, addr, callback, data);
+    if (!pSubscription->mSocket.connected())
+    {
+        // The command's result was an error message rather than an address.
+        pSubscription->mAddress.clear();
+        delete pSubscription;
+        return nullptr;
+    }
+    return pSubscription;
+}
+
+BCI2000Remote::Subscription::Subscription(BCI2000Remote* parent, const std::string &address,
+                                          BCI2000Remote::SubscriptionCallbackFn fn, void* data)
+: mpParent(parent), mAddress(address), mCallback(fn), mpCallbackData(data), mDropped(0),
+  mSocket(address), mThread(&BCI2000Remote::Subscription::ThreadFunc, this)
+{
+}
+
+BCI2000Remote::Subscription::~Subscription()
+{
+    mAbort.write("quit", 4);
+    mThread.join();
+    mSocket.close();
+    if (!mAddress.empty())
+        mpParent->Execute("UNSUBSCRIBE SIGNAL " + mAddress, nullptr);
+}
+
+void BCI2000Remote::Subscription::ThreadFunc()
+{
+    const int headerSize = 4 * sizeof(uint32_t) + 4 * sizeof(uint16_t);
+    std::vector<char> buffer, chunk(1 << 16);
+    std::vector<float> signal;
+    std::vector<uint32_t> states;
+    fdio::fd_object* objects[] = { &mSocket, &mAbort }, * readable = nullptr;
+    while (mSocket.is_open() && readable != &mAbort) {
+        readable = fdio::fd_object::select(objects, 2, nullptr, 0, fdio::fd_object::infinite_timeout);
+        if (readable != &mSocket)
+            continue;
+        int count = mSocket.read(chunk.data(), chunk.size());
+        if (count <= 0)
+            break;
+        buffer.insert(buffer.end(), chunk.begin(), chunk.begin() + count);
+
+        size_t pos = 0;
+        while (buffer.size() - pos >= headerSize) {
+            const char* p = buffer.data() + pos;
+            uint32_t length = GetLittleEndian(p, 4);
+            if (length < headerSize)
+                return;
+            if (buffer.size() - pos < length)
+                break;
+            mDropped = GetLittleEndian(p + 12, 4);
+            int channels = GetLittleEndian(p + 16, 2), elements = GetLittleEndian(p + 18, 2),
+                numStates = GetLittleEndian(p + 20, 2), samples = GetLittleEndian(p + 22, 2);
+            size_t signalSize = size_t(channels) * elements, statesSize = size_t(numStates) * samples;
+            if (headerSize + 4 * (signalSize + statesSize) > length)
+                return;
+            p += headerSize;
+            signal.resize(signalSize);
+            for (size_t i = 0; i < signalSize; ++i, p += 4) {
+                uint32_t bits = GetLittleEndian(p, 4);
+                ::memcpy(&signal[i], &bits, sizeof(float));
+            }
+            states.resize(statesSize);
+            for (size_t i = 0; i < statesSize; ++i, p += 4)
+                states[i] = GetLittleEndian(p, 4);
+            if (mCallback)
+                mCallback(mpCallbackData, signal.data(), channels, elements, states.data(), numStates, samples);
+            pos += length;
+        }
+        buffer.erase(buffer.begin(), buffer.begin() + pos);
+    }
+}
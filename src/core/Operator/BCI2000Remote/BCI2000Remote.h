@@ -38,9 +38,12 @@
 
 #include "BCI2000Connection.h"
 #include "selfpipe.h"
+#include <atomic>
+#include <cstdint>
 #include <string>
 #include <map>
 #include <thread>
+#include <vector>
 
 class BCI2000Remote : public BCI2000Connection
 {
@@ -114,6 +117,38 @@ class BCI2000Remote : public BCI2000Connection
     };
     Watch* NewWatch(const std::string &, CallbackFn, void *);
 
+    // Subscriptions to the control signal and to state values, delivered in binary form
+    // for every block through a TCP connection. Signal values are arranged by channel,
+    // i.e. all elements of the first channel, followed by all elements of the second
+    // channel, and so on. State values are arranged by state in the same way, with one
+    // value per sample.
+    typedef void (STDCALL *SubscriptionCallbackFn)(void*, const float *signal, int channels, int elements,
+                                                   const uint32_t *states, int numStates, int samples);
+    class Subscription
+    {
+        friend class BCI2000Remote;
+    private:
+        Subscription(BCI2000Remote*, const std::string&, SubscriptionCallbackFn, void*);
+    public:
+        ~Subscription();
+        // Number of frames dropped by the operator because they were not read in time.
+        int DroppedFrames() const { return mDropped; }
+    private:
+        void ThreadFunc();
+
+        BCI2000Remote* mpParent;
+        std::string mAddress;
+        SubscriptionCallbackFn mCallback;
+        void* mpCallbackData;
+        std::atomic<int> mDropped;
+        client_tcpsocket mSocket;
+        fdio::selfpipe mAbort;
+        std::thread mThread;
+    };
+    // Channel numbers are 1-based. Empty lists subscribe to all channels, and to no states.
+    Subscription* NewSubscription(const std::vector<int> &channels, const std::vector<std::string> &states,
+                                  int decimation, SubscriptionCallbackFn, void *);
+
 private:
     bool WaitForSystemState(const std::string &);
     bool SimpleCommand(const std::string &);
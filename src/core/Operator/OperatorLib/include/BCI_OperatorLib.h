@@ -188,6 +188,8 @@ extern "C"
     function:  BCI_PutVisProperty
     purpose:   Sets the a property to the given value, or adds the property to
                to the property list if it is not present.
+               Display feedback properties (CfgID::DisplayRate, CfgID::DisplayResolution)
+               are not stored but forwarded to the module that owns the visualization.
     arguments: Pointer to a null-terminated vis ID string, numeric config ID, and
                a pointer to a null-terminated value string.
     returns:   1 if successful, 0 otherwise.
@@ -27,6 +27,7 @@
 
 #include "BCIException.h"
 #include "BCIStream.h"
+#include "CfgID.h"
 #include "Lockable.h"
 #include "Param.h"
 #include "ScriptInterpreter.h"
@@ -360,6 +361,8 @@ DLLEXPORT float STDCALL BCI_GetSignal(int inChannel, int inElement)
 function:  BCI_PutVisProperty
 purpose:   Parses a BCI2000 vis property definition line, and adds the resulting
            property to the property list.
+           Display feedback properties are forwarded to the module that owns
+           the visualization.
 arguments: Pointer to a null-terminated vis ID string, numeric config ID, and
            a pointer to a null-terminated value string.
 returns:   1 if successful, 0 otherwise.
@@ -368,6 +371,8 @@ DLLEXPORT int STDCALL BCI_PutVisProperty(const char *inVisID, int inCfgID, const
 {
     if (!gpStateMachine)
         return 0;
+    if (inCfgID == CfgID::DisplayRate || inCfgID == CfgID::DisplayResolution)
+        return gpStateMachine.load()->SendVisFeedback(inVisID, inCfgID, inValue) ? 1 : 0;
     WithLock(gpStateMachine) gpStateMachine.load()->Visualizations()[inVisID][inCfgID] = inValue;
     gpStateMachine.load()->ExecuteCallback(BCI_OnVisProperty, inVisID, inCfgID, inValue);
     return 1;
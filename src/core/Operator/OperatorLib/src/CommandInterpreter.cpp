@@ -50,7 +50,8 @@
 
 CommandInterpreter::CommandInterpreter(class StateMachine &inStateMachine)
     : mrStateMachine(inStateMachine), mpParent(NULL), mAbort(false), mWriteLineFunc(&OnWriteLineDefault),
-      mpWriteLineData(this), mReadLineFunc(NULL), mpReadLineData(NULL)
+      mpWriteLineData(this), mReadLineFunc(NULL), mpReadLineData(NULL), mWriteBinaryFunc(NULL),
+      mpWriteBinaryData(NULL)
 {
     Init();
 }
@@ -59,7 +60,8 @@ CommandInterpreter::CommandInterpreter(CommandInterpreter &inOther)
     : mrStateMachine(inOther.mrStateMachine), mpParent(&inOther), mExpressionVariables(inOther.mExpressionVariables),
       mLocalVariables(inOther.mLocalVariables), mAbort(false), mWriteLineFunc(inOther.mWriteLineFunc),
       mpWriteLineData(inOther.mpWriteLineData), mReadLineFunc(inOther.mReadLineFunc),
-      mpReadLineData(inOther.mpReadLineData)
+      mpReadLineData(inOther.mpReadLineData), mWriteBinaryFunc(inOther.mWriteBinaryFunc),
+      mpWriteBinaryData(inOther.mpWriteBinaryData)
 {
     Init();
 }
@@ -480,6 +482,14 @@ bool CommandInterpreter::ReadLine(std::string &outLine)
     return result;
 }
 
+bool CommandInterpreter::WriteBinary(const std::string &inData)
+{
+    bool result = false;
+    if (mWriteBinaryFunc)
+        result = mWriteBinaryFunc(mpWriteBinaryData, inData);
+    return result;
+}
+
 CommandInterpreter &CommandInterpreter::WriteLineHandler(WriteLineFunc inFunc, void *inData)
 {
     mWriteLineFunc = inFunc;
@@ -494,6 +504,13 @@ CommandInterpreter &CommandInterpreter::ReadLineHandler(ReadLineFunc inFunc, voi
     return *this;
 }
 
+CommandInterpreter &CommandInterpreter::WriteBinaryHandler(WriteBinaryFunc inFunc, void *inData)
+{
+    mWriteBinaryFunc = inFunc;
+    mpWriteBinaryData = inData;
+    return *this;
+}
+
 bool CommandInterpreter::OnWriteLineDefault(void *inData, const std::string &inLine)
 {
     CommandInterpreter *pInterpreter = reinterpret_cast<CommandInterpreter *>(inData);
@@ -143,6 +143,20 @@ class CommandInterpreter
     CommandInterpreter &WriteLineHandler(WriteLineFunc, void *);
     typedef bool (*ReadLineFunc)(void *, std::string &);
     CommandInterpreter &ReadLineHandler(ReadLineFunc, void *);
+    //  WriteBinary() writes a binary message to the connection associated with
+    //  a command interpreter. Connections that cannot carry binary messages
+    //  leave the handler null, and WriteBinary() returns false.
+    bool WriteBinary(const std::string &);
+    typedef bool (*WriteBinaryFunc)(void *, const std::string &);
+    CommandInterpreter &WriteBinaryHandler(WriteBinaryFunc, void *);
+    WriteBinaryFunc WriteBinaryHandlerFunc() const
+    {
+        return mWriteBinaryFunc;
+    }
+    void *WriteBinaryHandlerData() const
+    {
+        return mpWriteBinaryData;
+    }
 
     typedef std::vector<std::vector<std::string>> ArgumentList;
     static void ParseArguments(std::string &, ArgumentList &);
@@ -293,6 +307,8 @@ class CommandInterpreter
     void *mpWriteLineData;
     ReadLineFunc mReadLineFunc;
     void *mpReadLineData;
+    WriteBinaryFunc mWriteBinaryFunc;
+    void *mpWriteBinaryData;
 
     struct AuxData { void* data; CleanupFunction cleanup; };
     std::map<std::string, AuxData> mAuxData;
@@ -29,6 +29,7 @@
 #include "CommandInterpreter.h"
 #include "Lockable.h"
 #include "StateMachine.h"
+#include "Subscriptions.h"
 #include <cstdlib>
 
 namespace Interpreter
@@ -36,7 +37,8 @@ namespace Interpreter
 
 //// SignalType
 Interpreter::SignalType Interpreter::SignalType::sInstance;
-const ObjectType::MethodEntry Interpreter::SignalType::sMethodTable[] = {METHOD(Get), END};
+const ObjectType::MethodEntry Interpreter::SignalType::sMethodTable[] = {METHOD(Get), METHOD(Subscribe),
+                                                                         METHOD(Unsubscribe), END};
 
 bool Interpreter::SignalType::Get(CommandInterpreter &inInterpreter)
 {
@@ -69,4 +71,88 @@ bool Interpreter::SignalType::Get(CommandInterpreter &inInterpreter)
     return true;
 }
 
+// SUBSCRIBE SIGNAL [CHANNELS <ch1> <ch2> ...] [STATES <name1> <name2> ...] [DECIMATE <n>] [AT <address>]
+// Without an address, binary frames are sent through the current connection, and the subscription ID
+// is returned. Otherwise, the address of a TCP port is returned, and frames are sent to the first client
+// connecting to it.
+bool Interpreter::SignalType::Subscribe(CommandInterpreter &inInterpreter)
+{
+    enum
+    {
+        none,
+        channels,
+        states
+    } list = none;
+    std::vector<int> channelList;
+    std::vector<std::string> stateList;
+    int decimation = 1;
+    std::string address, token;
+    while (!(token = inInterpreter.GetOptionalToken()).empty())
+    {
+        if (!::stricmp(token.c_str(), "Channels"))
+            list = channels;
+        else if (!::stricmp(token.c_str(), "States"))
+            list = states;
+        else if (!::stricmp(token.c_str(), "Decimate"))
+        {
+            decimation = ::atoi(inInterpreter.GetToken().c_str());
+            list = none;
+        }
+        else if (!::stricmp(token.c_str(), "At"))
+        {
+            address = inInterpreter.GetToken();
+            list = none;
+        }
+        else if (list == channels)
+        {
+            int ch = ::atoi(token.c_str()) - 1;
+            if (ch < 0)
+                throw bciexception << "Invalid channel index: " << token;
+            channelList.push_back(ch);
+        }
+        else if (list == states)
+        {
+            const StateList &existing = inInterpreter.StateMachine().States();
+            if (existing.Size() > 0 && !existing.Exists(token))
+                throw bciexception << "State " << token << " does not exist";
+            stateList.push_back(token);
+        }
+        else
+            throw bciexception << "Unexpected argument: " << token;
+    }
+    if (decimation < 1)
+        throw bciexception << "Decimation is " << decimation << ", must be >= 1";
+
+    // Once added to the list, the subscription may be deleted by another thread
+    // when its receiver disconnects, so it is only accessed under the list's lock.
+    WithLock(inInterpreter.StateMachine().Subscriptions())
+    {
+        Subscription *pSubscription = new Subscription(inInterpreter, address);
+        pSubscription->SetChannels(channelList).SetStates(stateList).SetDecimation(decimation);
+        if (address.empty())
+            inInterpreter.Out() << pSubscription->ID();
+        else
+            inInterpreter.Out() << pSubscription->Address();
+    }
+    return true;
+}
+
+// UNSUBSCRIBE SIGNAL [<ID or address>]
+// Without an argument, all subscriptions sending through the current connection are removed.
+bool Interpreter::SignalType::Unsubscribe(CommandInterpreter &inInterpreter)
+{
+    Subscription::List &list = inInterpreter.StateMachine().Subscriptions();
+    std::string token = inInterpreter.GetOptionalToken();
+    if (token.empty())
+    {
+        const void *pOwner = inInterpreter.WriteBinaryHandlerData();
+        if (!pOwner || !list.DeleteByOwner(pOwner))
+            throw bciexception << "No subscriptions for this connection";
+        return true;
+    }
+    if (!list.Delete(token))
+        throw bciexception << "No subscription with ID or address \"" << token << "\"";
+    return true;
+}
+
 } // namespace Interpreter
\ No newline at end of file
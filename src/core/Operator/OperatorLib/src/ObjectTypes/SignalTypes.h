@@ -45,6 +45,8 @@ class SignalType : public ObjectType
 
   public:
     static bool Get(CommandInterpreter &);
+    static bool Subscribe(CommandInterpreter &);
+    static bool Unsubscribe(CommandInterpreter &);
 
   private:
     static const MethodEntry sMethodTable[];
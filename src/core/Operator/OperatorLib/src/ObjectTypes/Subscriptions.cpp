@@ -0,0 +1,362 @@
+////////////////////////////////////////////////////////////////////////////////
+// $Id$
+// Authors: BCI2000 team
+// Description: A subscription object, and a container for subscriptions.
+//   A subscription sends selected control signal channels and state values
+//   for every n-th block as a binary frame.
+//
+// $BEGIN_BCI2000_LICENSE$
+//
+// This file is part of BCI2000, a platform for real-time bio-signal research.
+// [ Copyright (C) 2000-2022: BCI2000 team and many external contributors ]
+//
+// BCI2000 is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// BCI2000 is distributed in the hope that it will be useful, but
+//                         WITHOUT ANY WARRANTY
+// - without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+// A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// $END_BCI2000_LICENSE$
+////////////////////////////////////////////////////////////////////////////////
+
+#include "Subscriptions.h"
+
+#include "BCIException.h"
+#include "BinaryData.h"
+#include "CommandInterpreter.h"
+#include "GenericSignal.h"
+#include "StateList.h"
+#include "StateMachine.h"
+#include "StateVector.h"
+#include "UnitTest.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <sstream>
+
+namespace
+{
+template <typename T> void PutLittleEndian(std::ostream &os, T t)
+{
+    Tiny::BinaryData<T, Tiny::LittleEndian>(t).Put(os);
+}
+template <typename T> void PutLittleEndian(std::ostream &os, const std::vector<T> &t)
+{
+    Tiny::BinaryIO<Tiny::LittleEndian == Tiny::HostOrder>::Put(os, t.data(), t.size());
+}
+template <typename T> bool GetLittleEndian(std::istream &is, T &t)
+{
+    Tiny::BinaryData<T, Tiny::LittleEndian> data;
+    if (data.Get(is))
+        t = data;
+    return !!is;
+}
+template <typename T> bool GetLittleEndian(std::istream &is, std::vector<T> &t)
+{
+    return !!Tiny::BinaryIO<Tiny::LittleEndian == Tiny::HostOrder>::Get(is, t.data(), t.size());
+}
+} // namespace
+
+// Subscription::Frame
+std::string Subscription::Frame::Encode() const
+{
+    std::ostringstream oss;
+    uint32_t length = 4 * sizeof(uint32_t) + 4 * sizeof(uint16_t) + signal.size() * sizeof(float) +
+                      stateValues.size() * sizeof(uint32_t);
+    PutLittleEndian<uint32_t>(oss, length);
+    PutLittleEndian<uint32_t>(oss, id);
+    PutLittleEndian<uint32_t>(oss, blockIndex);
+    PutLittleEndian<uint32_t>(oss, dropped);
+    PutLittleEndian<uint16_t>(oss, channels);
+    PutLittleEndian<uint16_t>(oss, elements);
+    PutLittleEndian<uint16_t>(oss, states);
+    PutLittleEndian<uint16_t>(oss, samples);
+    PutLittleEndian(oss, signal);
+    PutLittleEndian(oss, stateValues);
+    return oss.str();
+}
+
+bool Subscription::Frame::Decode(const std::string &inData)
+{
+    std::istringstream iss(inData);
+    uint32_t length = 0;
+    bool ok = GetLittleEndian(iss, length) && length == inData.length() && GetLittleEndian(iss, id) &&
+              GetLittleEndian(iss, blockIndex) && GetLittleEndian(iss, dropped) && GetLittleEndian(iss, channels) &&
+              GetLittleEndian(iss, elements) && GetLittleEndian(iss, states) && GetLittleEndian(iss, samples);
+    if (!ok)
+        return false;
+    signal.resize(channels * elements);
+    stateValues.resize(states * samples);
+    return GetLittleEndian(iss, signal) && GetLittleEndian(iss, stateValues) && iss.peek() == EOF;
+}
+
+UnitTest(SubscriptionFrameTest)
+{
+    Subscription::Frame frame;
+    frame.id = 3;
+    frame.blockIndex = 0x01020304;
+    frame.dropped = 2;
+    frame.channels = 2;
+    frame.elements = 3;
+    frame.states = 1;
+    frame.samples = 2;
+    frame.signal = {0.5f, -1, 2, 3, 4, 1e6f};
+    frame.stateValues = {7, 0xfffffffe};
+    std::string data = frame.Encode();
+    TestFail_if(data.length() != 16 + 8 + 6 * 4 + 2 * 4, "frame length is " << data.length());
+    // The length field comes first, and numbers are little endian.
+    TestFail_if(data[0] != char(data.length()) || data[1] || data[2] || data[3], "bad length field");
+    TestFail_if(data[8] != 0x04 || data[11] != 0x01, "block index is not little endian");
+
+    Subscription::Frame decoded;
+    TestRequire(decoded.Decode(data));
+    TestFail_if(decoded.id != frame.id || decoded.blockIndex != frame.blockIndex || decoded.dropped != frame.dropped,
+                "header mismatch");
+    TestFail_if(decoded.channels != frame.channels || decoded.elements != frame.elements ||
+                    decoded.states != frame.states || decoded.samples != frame.samples,
+                "dimension mismatch");
+    TestFail_if(decoded.signal != frame.signal, "signal mismatch");
+    TestFail_if(decoded.stateValues != frame.stateValues, "state values mismatch");
+
+    for (size_t length = 0; length < data.length(); ++length)
+        TestFail_if(Subscription::Frame().Decode(data.substr(0, length)), "truncated frame accepted at " << length);
+    TestFail_if(Subscription::Frame().Decode(data + '\0'), "frame with trailing data accepted");
+
+    Subscription::Frame empty;
+    TestRequire(decoded.Decode(empty.Encode()));
+    TestFail_if(!decoded.signal.empty() || !decoded.stateValues.empty(), "empty frame decoded with data");
+}
+
+// Subscription
+Subscription::Subscription(CommandInterpreter &inInterpreter, const std::string &inAddress)
+    : mID(0), mpOwner(nullptr), mWriteBinaryFunc(nullptr), mpWriteBinaryData(nullptr),
+      mrList(inInterpreter.StateMachine().Subscriptions()), mDecimation(1), mBlockIndex(0), mDropped(0),
+      mClosed(false), mSendFrames(&Subscription::SendFrames, this), mThread(&mSendFrames, "Subscription Send Frames")
+{
+    if (inAddress.empty())
+    {
+        mWriteBinaryFunc = inInterpreter.WriteBinaryHandlerFunc();
+        mpWriteBinaryData = inInterpreter.WriteBinaryHandlerData();
+        if (!mWriteBinaryFunc)
+            throw bciexception << "This connection cannot receive binary data, specify an address to listen at";
+        mpOwner = mpWriteBinaryData;
+    }
+    else
+    {
+        mListeningSocket.Open(inAddress);
+        if (!mListeningSocket.IsOpen())
+            throw bciexception << "Cannot listen at " << inAddress;
+        mAddress = mListeningSocket.Address();
+    }
+    mThread.Start();
+    mrList.Add(this);
+}
+
+Subscription::~Subscription()
+{
+    mrList.Remove(this); // unless deleted through the list
+    mThread.Terminate();
+    mListeningSocket.Close();
+    mSocket.Close();
+}
+
+Subscription &Subscription::SetChannels(const std::vector<int> &inChannels)
+{
+    ScopedLock(mrList);
+    mChannels = inChannels;
+    return *this;
+}
+
+Subscription &Subscription::SetStates(const std::vector<std::string> &inStates)
+{
+    ScopedLock(mrList);
+    mStates = inStates;
+    return *this;
+}
+
+Subscription &Subscription::SetDecimation(int inDecimation)
+{
+    if (inDecimation < 1)
+        throw bciexception << "Decimation is " << inDecimation << ", must be >= 1";
+    ScopedLock(mrList);
+    mDecimation = inDecimation;
+    return *this;
+}
+
+void Subscription::Deliver(const GenericSignal &inSignal, const StateList &inStates, const StateVector &inStateVector)
+{
+    uint32_t blockIndex = mBlockIndex++;
+    if (mClosed || blockIndex % mDecimation)
+        return;
+
+    std::vector<int> channels = mChannels;
+    if (channels.empty())
+        for (int ch = 0; ch < inSignal.Channels(); ++ch)
+            channels.push_back(ch);
+    Frame frame;
+    frame.id = mID;
+    frame.blockIndex = blockIndex;
+    frame.dropped = static_cast<uint32_t>(mDropped);
+    frame.channels = static_cast<uint16_t>(channels.size());
+    frame.elements = static_cast<uint16_t>(inSignal.Elements());
+    frame.states = static_cast<uint16_t>(mStates.size());
+    frame.samples = static_cast<uint16_t>(std::max(inStateVector.Samples() - 1, 0));
+    int elements = frame.elements, samples = frame.samples;
+    frame.signal.resize(channels.size() * elements, 0);
+    for (size_t i = 0; i < channels.size(); ++i)
+        if (channels[i] < inSignal.Channels())
+            for (int el = 0; el < elements; ++el)
+                frame.signal[i * elements + el] = static_cast<float>(inSignal(channels[i], el));
+
+    // States that do not exist in the current configuration are sent as zero.
+    frame.stateValues.resize(mStates.size() * samples, 0);
+    for (size_t i = 0; i < mStates.size(); ++i)
+        if (inStates.Exists(mStates[i]))
+        {
+            const State &s = inStates.ByName(mStates[i]);
+            if (s.Location() + s.Length() <= 8 * inStateVector.Length() && samples > 0)
+                inStateVector.StateValues(s.Location(), s.Length(), 0, samples, &frame.stateValues[i * samples]);
+        }
+
+    // Never block the caller: when the receiver falls behind, drop the oldest frames.
+    while (mQueue.Size() >= MaxQueuedFrames)
+    {
+        SynchronizedQueue<std::string>::Consumable c = mQueue.Consume();
+        if (c)
+            ++mDropped;
+    }
+    mQueue.Produce(frame.Encode());
+}
+
+void Subscription::SendFrames()
+{
+    while (mQueue.Wait())
+    {
+        SynchronizedQueue<std::string>::Consumable c;
+        while ((c = mQueue.Consume()))
+        {
+            if (mClosed)
+                continue;
+            if (mWriteBinaryFunc)
+            {
+                if (!mWriteBinaryFunc(mpWriteBinaryData, *c))
+                    mClosed = true;
+            }
+            else
+            {
+                // Frames are discarded until a client connects.
+                if (!mSocket.IsOpen() && !mListeningSocket.WaitForAccept(mSocket, 0))
+                    continue;
+                if (mSocket.Write(c->data(), c->length()) != int64_t(c->length()))
+                    mClosed = true;
+            }
+        }
+    }
+}
+
+// Subscription::List
+Subscription::List::List() : mNextID(1)
+{
+}
+
+Subscription::List::~List()
+{
+    std::vector<Subscription *> subscriptions;
+    WithLock(this)
+    {
+        subscriptions.swap(mSubscriptions);
+    }
+    for (auto p : subscriptions)
+        delete p;
+}
+
+void Subscription::List::Add(Subscription *inpSubscription)
+{
+    ScopedLock(this);
+    inpSubscription->mID = mNextID++;
+    mSubscriptions.push_back(inpSubscription);
+}
+
+bool Subscription::List::Remove(Subscription *inpSubscription)
+{
+    ScopedLock(this);
+    auto i = std::find(mSubscriptions.begin(), mSubscriptions.end(), inpSubscription);
+    if (i == mSubscriptions.end())
+        return false;
+    mSubscriptions.erase(i);
+    return true;
+}
+
+Subscription *Subscription::List::FindByID(int inID) const
+{
+    ScopedLock(this);
+    for (auto p : mSubscriptions)
+        if (p->ID() == inID)
+            return p;
+    return nullptr;
+}
+
+Subscription *Subscription::List::FindByAddress(const std::string &inAddress) const
+{
+    ScopedLock(this);
+    for (auto p : mSubscriptions)
+        if (!p->Address().empty() && p->Address() == inAddress)
+            return p;
+    return nullptr;
+}
+
+bool Subscription::List::Delete(const std::string &inAddressOrID)
+{
+    Subscription *pSubscription = nullptr;
+    WithLock(this)
+    {
+        pSubscription = FindByAddress(inAddressOrID);
+        if (!pSubscription)
+            pSubscription = FindByID(::atoi(inAddressOrID.c_str()));
+        if (pSubscription)
+            Remove(pSubscription);
+    }
+    delete pSubscription;
+    return pSubscription != nullptr;
+}
+
+int Subscription::List::DeleteByOwner(const void *inOwner)
+{
+    std::vector<Subscription *> owned;
+    WithLock(this)
+    {
+        for (auto p : mSubscriptions)
+            if (p->Owner() && p->Owner() == inOwner)
+                owned.push_back(p);
+        for (auto p : owned)
+            Remove(p);
+    }
+    for (auto p : owned)
+        delete p;
+    return static_cast<int>(owned.size());
+}
+
+void Subscription::List::Deliver(const GenericSignal &inSignal, const StateList &inStates,
+                                 const StateVector &inStateVector)
+{
+    std::vector<Subscription *> closed;
+    WithLock(this)
+    {
+        for (auto p : mSubscriptions)
+            if (p->Closed())
+                closed.push_back(p);
+            else
+                p->Deliver(inSignal, inStates, inStateVector);
+        for (auto p : closed)
+            Remove(p);
+    }
+    for (auto p : closed)
+        delete p;
+}
@@ -0,0 +1,191 @@
+////////////////////////////////////////////////////////////////////////////////
+// $Id$
+// Authors: BCI2000 team
+// Description: A subscription object, and a container for subscriptions.
+//   A subscription sends selected control signal channels and state values
+//   for every n-th block as a binary frame, either through the connection
+//   of the subscribing command interpreter (e.g., as a binary websocket
+//   message), or through a TCP connection to a dedicated port.
+//   Frames are queued, and sent from a separate thread. When a receiver
+//   cannot keep up, the oldest frames are dropped rather than blocking
+//   the state machine.
+//
+//   Frame layout, all numbers little endian:
+//     uint32  frame length in bytes, including this field
+//     uint32  subscription ID
+//     uint32  block index, counting all blocks since the subscription was created
+//     uint32  number of frames dropped so far
+//     uint16  channels, elements, states, samples
+//     float32 signal values, channels*elements, all elements of the first
+//             channel followed by all elements of the second channel, and so on
+//     uint32  state values, states*samples, all samples of the first state
+//             followed by all samples of the second state, and so on
+//
+// $BEGIN_BCI2000_LICENSE$
+//
+// This file is part of BCI2000, a platform for real-time bio-signal research.
+// [ Copyright (C) 2000-2022: BCI2000 team and many external contributors ]
+//
+// BCI2000 is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// BCI2000 is distributed in the hope that it will be useful, but
+//                         WITHOUT ANY WARRANTY
+// - without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+// A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// $END_BCI2000_LICENSE$
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef SUBSCRIPTIONS_H
+#define SUBSCRIPTIONS_H
+
+#include "Lockable.h"
+#include "Runnable.h"
+#include "Sockets.h"
+#include "SynchronizedQueue.h"
+#include "Thread.h"
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class CommandInterpreter;
+class GenericSignal;
+class StateList;
+class StateVector;
+
+class Subscription
+{
+  public:
+    enum
+    {
+        MaxQueuedFrames = 64,
+    };
+
+    // Without an address, frames are written through the command interpreter's
+    // binary write handler. With an address, a TCP port is opened for listening
+    // at that address, and frames are sent to the first client connecting.
+    Subscription(CommandInterpreter &, const std::string &address = "");
+    ~Subscription();
+
+  private:
+    Subscription(const Subscription &);
+    Subscription &operator=(const Subscription &);
+
+  public:
+    int ID() const
+    {
+        return mID;
+    }
+    // Address of the listening socket, empty for subscriptions
+    // that use the command interpreter's connection.
+    const std::string &Address() const
+    {
+        return mAddress;
+    }
+    // Identifies the connection of the interpreter that created the subscription.
+    const void *Owner() const
+    {
+        return mpOwner;
+    }
+    // True when the receiver has disconnected.
+    bool Closed() const
+    {
+        return mClosed;
+    }
+
+    // Zero-based channel indices, all channels if empty.
+    Subscription &SetChannels(const std::vector<int> &);
+    Subscription &SetStates(const std::vector<std::string> &);
+    Subscription &SetDecimation(int);
+    int Decimation() const
+    {
+        return mDecimation;
+    }
+    int64_t DroppedFrames() const
+    {
+        return mDropped;
+    }
+
+    // A frame as sent to the receiver, see the frame layout above.
+    struct Frame
+    {
+        uint32_t id = 0, blockIndex = 0, dropped = 0;
+        uint16_t channels = 0, elements = 0, states = 0, samples = 0;
+        std::vector<float> signal;
+        std::vector<uint32_t> stateValues;
+
+        std::string Encode() const;
+        // Returns false if the data are not a complete frame.
+        bool Decode(const std::string &);
+    };
+
+    class List : public Lockable<>
+    {
+      public:
+        List();
+        ~List();
+
+        // Called by the state machine for each block of the control signal.
+        void Deliver(const GenericSignal &, const StateList &, const StateVector &);
+
+        // Deletion is done by the list, such that subscriptions are not deleted
+        // twice when closing and unsubscribing happen at the same time.
+        // Subscriptions are looked up and removed from the list under its lock,
+        // but deleted outside of it, because deletion waits for the sending
+        // thread, which may be blocked in a write.
+        // Deletes the subscription listening at the given address or, if there
+        // is none, the one with the given ID. Returns false if none was found.
+        bool Delete(const std::string &addressOrID);
+        int DeleteByOwner(const void *);
+        int Size() const
+        {
+            return static_cast<int>(mSubscriptions.size());
+        }
+
+      private:
+        void Add(Subscription *);
+        bool Remove(Subscription *);
+        // Pointers returned are only valid while the list is locked.
+        Subscription *FindByID(int) const;
+        Subscription *FindByAddress(const std::string &) const;
+        friend class Subscription;
+
+        std::vector<Subscription *> mSubscriptions;
+        int mNextID;
+    };
+
+  private:
+    void Deliver(const GenericSignal &, const StateList &, const StateVector &);
+    void SendFrames();
+
+    int mID;
+    const void *mpOwner;
+    bool (*mWriteBinaryFunc)(void *, const std::string &);
+    void *mpWriteBinaryData;
+    List &mrList;
+
+    std::vector<int> mChannels;
+    std::vector<std::string> mStates;
+    int mDecimation;
+    uint32_t mBlockIndex;
+    std::atomic<int64_t> mDropped;
+    std::atomic<bool> mClosed;
+
+    ServerTCPSocket mListeningSocket;
+    TCPSocket mSocket;
+    std::string mAddress;
+
+    SynchronizedQueue<std::string> mQueue;
+    MemberCall<void(Subscription *)> mSendFrames;
+    Thread mThread;
+};
+
+#endif // SUBSCRIPTIONS_H
@@ -84,6 +84,7 @@ void StateMachine::Init()
     CloseConnections();
     WatchDataLock lock(this);
     mParameters.Clear();
+    mBroadcastParameters.Clear();
     mStates.Clear();
     mEvents.Clear();
     mIntroducedRandomSeed = false;
@@ -91,6 +92,7 @@ void StateMachine::Init()
     mStateVector = StateVector();
     mControlSignal = GenericSignal();
     mVisualizations.clear();
+    mVisOwners.clear();
 }
 
 bool StateMachine::Startup(const char *inArguments)
@@ -452,10 +454,25 @@ void StateMachine::PruneParameters()
 
 void StateMachine::BroadcastParameters()
 {
+    // Modules that support parameter deltas only receive parameters that differ
+    // from the previous broadcast.
+    ParamList changedParams;
+    for (int i = 0; i < mParameters.Size(); ++i)
+    {
+        const Param &p = mParameters.ByIndex(i);
+        if (!mBroadcastParameters.Exists(p.Path()) || mBroadcastParameters.ByPath(p.Path()) != p)
+            changedParams.Add(p);
+    }
+    bool sendDeltas = !mBroadcastParameters.Empty();
     for (int i = 0; i < mConnections.Size(); ++i)
-        if (mConnections[i]->Send(mParameters))
+    {
+        CoreClient &c = *mConnections[i];
+        bool deltas = sendDeltas && c.Protocol().Provides(ProtocolVersion::ParameterDeltas);
+        if (c.Send(deltas ? changedParams : mParameters))
             ThreadUtils::Idle();
+    }
     mParameters.Unchanged();
+    mBroadcastParameters = mParameters;
 }
 
 void StateMachine::BroadcastEndOfParameter()
@@ -951,6 +968,8 @@ void StateMachine::OnReceive(CoreConnection &conn, const Param &inParam)
     {
     case SetConfigIssued:
         mAutoParameters.ByPath(inParam.Path()) = inParam;
+        // Modules now disagree about the parameter's value, so it must be sent again.
+        mBroadcastParameters.Delete(inParam.Path());
         break;
 
     default: {
@@ -1022,6 +1041,7 @@ void StateMachine::OnReceive(CoreConnection &, const VisSignal &inSignal)
     {
         WatchDataLock lock(this);
         mControlSignal = inSignal;
+        mSubscriptions.Deliver(mControlSignal, mStates, mStateVector);
     }
     else
     {
@@ -1081,13 +1101,28 @@ void StateMachine::OnReceive(CoreConnection &, const VisBitmap &v)
     ExecuteCallback(BCI_OnVisBitmap, v.VisID().c_str(), b.Width(), b.Height(), b.RawData());
 }
 
-void StateMachine::OnReceive(CoreConnection &, const VisCfg &v)
+void StateMachine::OnReceive(CoreConnection &conn, const VisCfg &v)
 {
     DataLock lock(this);
     mVisualizations[v.VisID()][v.CfgID()] = v.CfgValue();
+    const CoreClient *pClient = static_cast<CoreClient *>(conn.UserData());
+    if (pClient)
+    {
+        VisOwner owner = {static_cast<int>(pClient->Tag() - 1), v.VisID()};
+        mVisOwners[VisID(v.VisID()).ToLayer()] = owner;
+    }
     ExecuteCallback(BCI_OnVisPropertyMessage, v.VisID().c_str(), v.CfgID(), v.CfgValue().c_str());
 }
 
+bool StateMachine::SendVisFeedback(const std::string &inVisID, int inCfgID, const std::string &inValue)
+{
+    DataLock lock(this);
+    auto i = mVisOwners.find(VisID(inVisID).ToLayer());
+    if (i == mVisOwners.end() || i->second.connection < 0 || i->second.connection >= mConnections.Size())
+        return false;
+    return mConnections[i->second.connection]->Send(VisCfg(i->second.visID, inCfgID, inValue));
+}
+
 void StateMachine::OnModuleStateChange(const CoreClient &inConnection, SysState inState)
 {
     int systemState = SystemState() & ~StateFlags;
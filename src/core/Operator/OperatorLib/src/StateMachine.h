@@ -44,6 +44,7 @@
 #include "Sockets.h"
 #include "StateList.h"
 #include "StateVector.h"
+#include "Subscriptions.h"
 #include "Thread.h"
 #include "VersionInfo.h"
 #include "VisTable.h"
@@ -51,6 +52,7 @@
 
 #include <cstddef>
 #include <fstream>
+#include <map>
 #include <set>
 #include <mutex>
 
@@ -204,6 +206,8 @@ class StateMachine : public CallbackBase, public Lockable<>, private Thread, Cor
     {
         return mVisualizations;
     }
+    // Forwards display feedback to the module that owns a visualization.
+    bool SendVisFeedback(const std::string &visID, int cfgID, const std::string &value);
 
     // Scripting events.
     ScriptEvents &EventScripts()
@@ -225,6 +229,16 @@ class StateMachine : public CallbackBase, public Lockable<>, private Thread, Cor
         return mWatches;
     }
 
+    // Subscriptions to the control signal and states.
+    class Subscription::List &Subscriptions()
+    {
+        return mSubscriptions;
+    }
+    const class Subscription::List &Subscriptions() const
+    {
+        return mSubscriptions;
+    }
+
     // Address of local connection.
     const std::string &LocalAddress() const
     {
@@ -278,10 +292,18 @@ class StateMachine : public CallbackBase, public Lockable<>, private Thread, Cor
     bool mIntroducedRandomSeed;
     std::string mPreviousRandomSeed;
     ParamList mParameters, mAutoParameters;
+    // Parameters as sent by the most recent broadcast.
+    ParamList mBroadcastParameters;
     StateList mStates, mEvents;
     class StateVector mStateVector;
     GenericSignal mControlSignal;
     VisTable mVisualizations;
+    struct VisOwner
+    {
+        int connection;
+        std::string visID;
+    };
+    std::map<std::string, VisOwner> mVisOwners; // display layer ID -> module connection
     std::string mLocalAddress;
 
     std::ofstream mDebugLog;
@@ -292,6 +314,7 @@ class StateMachine : public CallbackBase, public Lockable<>, private Thread, Cor
     } mListeners;
     ScriptEvents mScriptEvents;
     class Watch::List mWatches;
+    class Subscription::List mSubscriptions;
 
   public:
     typedef struct CoreClient::Info ConnectionInfo;
@@ -33,6 +33,7 @@
 #include "VersionInfo.h"
 #include "StringUtils.h"
 #include "BinaryData.h"
+#include "StateMachine.h"
 
 #include "../../extlib/websocketpp/websocketpp/sha1/sha1.hpp"
 
@@ -40,6 +41,7 @@
 #include <sstream>
 #include <string>
 #include <regex>
+#include <mutex>
 
 #ifndef _WIN32
 #include <unistd.h>
@@ -205,12 +207,15 @@ public:
     // CommandInterpreter interface
     static bool OnWriteLine(void*, const std::string&);
     static bool OnReadLine(void*, std::string&);
+    static bool OnWriteBinary(void*, const std::string&);
 
     // Input
     void OnMessage(const std::string&);
     // Output
     Session& WriteHello();
     Session& Write(const std::string&);
+    // Subscription frames are written from other threads.
+    Session& WriteFragment(const WebsocketFragment&);
 
     void AbortAndWait();
     void Close();
@@ -221,6 +226,11 @@ private:
     TCPSocket mSocket;
     BufferedIO mBuffer;
     std::iostream mStream;
+    // Fragments are written through an output-only buffer over the same socket,
+    // as subscription threads write while the session thread is reading from mBuffer.
+    BufferedIO mOutputBuffer;
+    std::ostream mOutput;
+    std::mutex mWriteMutex;
 };
 
 // WebsocketServer
@@ -267,23 +277,27 @@ int WebsocketServer::OnExecute()
 
 // WebsocketServer::Session
 WebsocketServer::Session::Session(WebsocketServer* pParent)
-    : Thread(false), ScriptInterpreter(pParent->mrStateMachine), mpParent(pParent), mStream(&mBuffer)
+    : Thread(false), ScriptInterpreter(pParent->mrStateMachine), mpParent(pParent), mStream(&mBuffer), mOutput(&mOutputBuffer)
 {
     mSocket.SetBlockingMode(false);
     mBuffer.SetIO(&mSocket);
+    mOutputBuffer.SetOutput(&mSocket.Output());
     ScriptInterpreter::WriteLineHandler(&OnWriteLine, this);
     ScriptInterpreter::ReadLineHandler(&OnReadLine, this);
+    ScriptInterpreter::WriteBinaryHandler(&OnWriteBinary, this);
     mpParent.load()->mListeningSocket.WaitForAccept(mSocket, 0);
     Thread::Start();
 }
 
 WebsocketServer::Session::~Session()
 {
+    ScriptInterpreter::StateMachine().Subscriptions().DeleteByOwner(this);
     Thread::TerminateAndWait();
 }
 
 void WebsocketServer::Session::AbortAndWait()
 {
+    ScriptInterpreter::StateMachine().Subscriptions().DeleteByOwner(this);
     ScriptInterpreter::Abort();
     Thread::TerminateAndWait();
 }
@@ -328,12 +342,12 @@ int WebsocketServer::Session::OnExecute()
             Close();
             return -1;
         case WebsocketFragment::Opcode::close:
-            f.write(mStream);
+            WriteFragment(f);
             Close();
             return 0;
         case WebsocketFragment::Opcode::ping:
             f.opcode = WebsocketFragment::Opcode::pong;
-            f.write(mStream);
+            WriteFragment(f);
             break;
         case WebsocketFragment::Opcode::pong:
             break;
@@ -352,7 +366,7 @@ void WebsocketServer::Session::OnMessage(const std::string& inMessage)
             WebsocketFragment f;
             f.fin = true;
             f.opcode = WebsocketFragment::Opcode::close;
-            f.write(mStream).flush();
+            WriteFragment(f);
             while (f.read(mStream) && f.opcode != WebsocketFragment::Opcode::close)
                 ;
             Close();
@@ -373,14 +387,13 @@ bool WebsocketServer::Session::OnWriteLine(void* inInstance, const std::string&
 {
     Session* this_ = reinterpret_cast<Session*>(inInstance);
     this_->Write(inLine);
-    return !!(this_->mStream);
+    return this_->mStream && this_->mOutput;
 }
 
 bool WebsocketServer::Session::OnReadLine(void* inInstance, std::string& outLine)
 {
     Session* this_ = reinterpret_cast<Session*>(inInstance);
     this_->Write("\\AwaitingInput:");
-    this_->mStream << std::flush;
     WebsocketFragment f;
     bool result = !!f.read(this_->mStream);
     if (result) {
@@ -390,6 +403,17 @@ bool WebsocketServer::Session::OnReadLine(void* inInstance, std::string& outLine
     return result;
 }
 
+bool WebsocketServer::Session::OnWriteBinary(void* inInstance, const std::string& inData)
+{
+    Session* this_ = reinterpret_cast<Session*>(inInstance);
+    WebsocketFragment f;
+    f.fin = true;
+    f.opcode = WebsocketFragment::Opcode::binary;
+    f.payload.assign(inData.begin(), inData.end());
+    this_->WriteFragment(f);
+    return !!(this_->mOutput);
+}
+
 WebsocketServer::Session& WebsocketServer::Session::WriteHello()
 {
     std::ostringstream oss;
@@ -407,6 +431,12 @@ WebsocketServer::Session& WebsocketServer::Session::Write(const std::string& inS
     f.opcode = WebsocketFragment::Opcode::text;
     f.payload.resize(inString.length());
     ::memcpy(f.payload.data(), inString.data(), inString.length());
-    f.write(mStream).flush();
+    return WriteFragment(f);
+}
+
+WebsocketServer::Session& WebsocketServer::Session::WriteFragment(const WebsocketFragment& inFragment)
+{
+    std::lock_guard<std::mutex> lock(mWriteMutex);
+    inFragment.write(mOutput).flush();
     return *this;
 }
@@ -136,6 +136,7 @@ MainWindow::MainWindow()
     SetupScripts();
     auto pVisMenu = GetWindowMenu()->addMenu("Visualizations");
     VisDisplay::Initialize(this, pVisMenu);
+    VisDisplay::SetFeedbackHandler(&MainWindow::OnVisFeedback);
 
     if (!mTelnet.isEmpty())
         OperatorModule::TelnetListen(mTelnet.toLocal8Bit().constData());
@@ -774,6 +775,11 @@ void MainWindow::OnInitializeVis(const char *inVisID, const char *inKind)
     VisDisplay::Create(inVisID, inKind);
 }
 
+void MainWindow::OnVisFeedback(const std::string &inVisID, int inCfgID, const std::string &inValue)
+{
+    bci::BCI_PutVisProperty(inVisID.c_str(), inCfgID, inValue.c_str());
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 //----------------------   IDE-managed Qt slots    ---------------------------
 ////////////////////////////////////////////////////////////////////////////////
@@ -142,6 +142,7 @@ class MainWindow : public QMainWindow, private bci::OperatorModule
     void OnVisPropertyMessage(const char *, int, const char *) override;
     void OnVisProperty(const char *, int, const char *) override;
     void OnInitializeVis(const char *, const char *) override;
+    static void OnVisFeedback(const std::string &, int, const std::string &);
 
   private:
     QLabel *mpStatusLabels[4];
@@ -50,6 +50,11 @@ void VisDisplay::Initialize(QWidget *inpWidget, QMenu *inpVisMenu)
     VisDisplayWindow::SetWindowMenu(inpVisMenu);
 }
 
+void VisDisplay::SetFeedbackHandler(FeedbackHandler inHandler)
+{
+    VisDisplayBase::SetFeedbackHandler(inHandler);
+}
+
 void VisDisplay::Deinitialize()
 {
     Assert(ThreadUtils::InMainThread());
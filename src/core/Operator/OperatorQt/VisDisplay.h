@@ -49,6 +49,10 @@ class VisDisplay
     static void HandleBitmap(const std::string &visID, const BitmapImage &);
     static void HandlePropertyMessage(const std::string &visID, CfgID, const std::string &);
     static void HandleProperty(const std::string &visID, CfgID, const std::string &);
+
+    // Receives feedback about displays, to be forwarded to the modules sending the data.
+    typedef void (*FeedbackHandler)(const std::string &visID, int cfgID, const std::string &value);
+    static void SetFeedbackHandler(FeedbackHandler);
 };
 
 // Proxy object for transmitting data across thread boundaries,
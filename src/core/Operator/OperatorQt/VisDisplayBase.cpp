@@ -35,6 +35,7 @@
 
 VisDisplayBase::VisContainer VisDisplayBase::sVisuals;
 VisDisplayBase::ConfigContainer VisDisplayBase::sVisconfigs;
+VisDisplay::FeedbackHandler VisDisplayBase::sFeedbackHandler = nullptr;
 
 ////////////////////////////////////////////////////////////////////////////////
 void VisDisplayBase::ConfigContainer::Save()
@@ -100,6 +101,17 @@ void VisDisplayBase::Clear()
     sVisuals.Clear();
 }
 
+void VisDisplayBase::SetFeedbackHandler(VisDisplay::FeedbackHandler inHandler)
+{
+    sFeedbackHandler = inHandler;
+}
+
+void VisDisplayBase::SendFeedback(CfgID inCfgID, const std::string &inValue)
+{
+    if (sFeedbackHandler)
+        sFeedbackHandler(mVisID, inCfgID, inValue);
+}
+
 VisDisplayBase::VisContainer &VisDisplayBase::Visuals()
 {
     return sVisuals;
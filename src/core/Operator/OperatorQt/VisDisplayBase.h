@@ -68,10 +68,12 @@ class VisDisplayBase : public QWidget
     static void HandleMemo(const VisID &, const std::string &);
     static void HandleBitmap(const VisID &, const BitmapImage &);
     static void HandleProperty(const VisID &, CfgID, const std::string &value, int configState);
+    static void SetFeedbackHandler(VisDisplay::FeedbackHandler);
 
   protected:
     struct ConfigSettings;
     virtual void OnSetConfig(ConfigSettings &);
+    void SendFeedback(CfgID, const std::string &);
     virtual void OnContextMenu(const QPoint &)
     {
     }
@@ -139,6 +141,7 @@ class VisDisplayBase : public QWidget
   private:
     static VisContainer sVisuals;
     static ConfigContainer sVisconfigs;
+    static VisDisplay::FeedbackHandler sFeedbackHandler;
 };
 
 template <class T> void VisDisplayBase::Create(const VisID &inVisID)
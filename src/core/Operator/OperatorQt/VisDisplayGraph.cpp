@@ -54,7 +54,8 @@ VisDisplayGraph::VisDisplayGraph(const std::string &inSourceID)
       mpActToggleChannelLabels(NULL), mpActToggleColor(NULL), mpActInvertDisplay(NULL), mpActChooseColors(NULL),
       mpActSmallerFont(nullptr), mpActLargerFont(nullptr), mNumChannels(0), mSignalElements(0), mUserScaling(0),
       mUserZoom(0), mpCurrentHPItem(NULL), mpCurrentLPItem(NULL), mpCurrentNotchItem(NULL), mpStatusBar(NULL),
-      mpStatusLabel(NULL), mAutoScale(false), mAutoScaleTime(cAutoScaleTime), mFixedScale(false), mMinValue(-1), mMaxValue(1), mElementGain(0)
+      mpStatusLabel(NULL), mAutoScale(false), mAutoScaleTime(cAutoScaleTime), mFixedScale(false), mMinValue(-1), mMaxValue(1), mElementGain(0),
+      mFeedbackRate(0), mFeedbackResolution(0)
 {
     BuildStatusBar();
     UpdateStatusBar();
@@ -229,6 +230,8 @@ void VisDisplayGraph::OnSetConfig(ConfigSettings &inConfig)
     // Sanity checks.
     if (mDisplay.MinValue() == mDisplay.MaxValue())
         mDisplay.SetMaxValue(mDisplay.MinValue() + 1);
+
+    SendDisplayFeedback();
 }
 
 void VisDisplayGraph::ShowStatusBar(bool inVisible)
@@ -894,6 +897,28 @@ void VisDisplayGraph::SyncDisplay()
     GUI::DrawContext dc = {{0, 0, float(this->width()), float(this->height()) - heightReduction}, 0};
     dc.device = this;
     mDisplay.SetContext(dc);
+    SendDisplayFeedback();
+}
+
+void VisDisplayGraph::SendDisplayFeedback()
+{
+    // Let the sending module adapt its data rate to what can be displayed: the screen's
+    // refresh rate, and the number of pixels available for the samples it sends.
+    int numSamples = 0, displaySamples = NominalDisplaySamples();
+    if (!Visconfigs()[mVisID].Get(CfgID::NumSamples, numSamples) || numSamples < 1 || displaySamples < 1)
+        numSamples = displaySamples = 1;
+    int resolution = static_cast<int>(static_cast<int64_t>(this->width()) * numSamples / displaySamples);
+    if (resolution > 0 && resolution != mFeedbackResolution)
+    {
+        mFeedbackResolution = resolution;
+        SendFeedback(CfgID::DisplayResolution, std::to_string(resolution));
+    }
+    double rate = QGuiApplication::primaryScreen()->refreshRate();
+    if (rate > 0 && rate != mFeedbackRate)
+    {
+        mFeedbackRate = rate;
+        SendFeedback(CfgID::DisplayRate, std::to_string(rate));
+    }
 }
 
 void VisDisplayGraph::paintEvent(QPaintEvent *iopEvent)
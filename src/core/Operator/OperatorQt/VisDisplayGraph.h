@@ -150,9 +150,12 @@ class VisDisplayGraph : public VisDisplayLayer
     SignalDisplay mDisplay;
     bool mAutoScale, mFixedScale;
     float mMinValue, mMaxValue, mElementGain;
+    double mFeedbackRate;
+    int mFeedbackResolution;
 
   private:
     void SyncDisplay();
+    void SendDisplayFeedback();
 
   protected:
     // Qt event handlers
@@ -41,7 +41,7 @@ RegisterFilter(SignalGeneratorADC, 1);
 
 SignalGeneratorADC::SignalGeneratorADC()
     : mRandomGenerator(this), mNoiseAmplitude(0), mDCOffset(0), mSineChannelX(0), mSineChannelY(0), mSineChannelZ(0),
-      mModulateAmplitude(1), mAmplitudeX(1), mAmplitudeY(1), mAmplitudeZ(1)
+      mModulateAmplitude(1), mSynthetic(false), mAmplitudeX(1), mAmplitudeY(1), mAmplitudeZ(1)
 {
 }
 
@@ -102,7 +102,23 @@ void SignalGeneratorADC::Publish()
 
     "Source matrix SourceProperties= 0 [ Frequency Amplitude ] // Source properties",
     "Source matrix MixingMatrix= 0 1 // Source-to-sensor projection, rows are sources, columns are sensors",
+
+    "Source:Synthetic%20Signal int SyntheticSignal= 0 0 0 1 "
+        "// signal model: "
+        " 0: sine waves and white noise,"
+        " 1: band-limited noise of NoiseAmplitude RMS, and ERPs "
+        "(enumeration)",
+    "Source:Synthetic%20Signal floatlist NoiseBand= 2 1Hz 40Hz % % % "
+        "// corner frequencies of band-limited noise, use 0 to omit a corner",
+    "Source:Synthetic%20Signal float EventRate= 1Hz 1Hz 0 % "
+        "// mean rate of randomly occurring ERPs",
+    "Source:Synthetic%20Signal float ERPAmplitude= 10muV 10muV % % "
+        "// amplitude of the ERP's P3 component",
   END_PARAMETER_DEFINITIONS
+
+  BEGIN_STATE_DEFINITIONS
+    "SyntheticEvent 1 0 0 0",
+  END_STATE_DEFINITIONS
 }
 
 void SignalGeneratorADC::AutoConfig(const SignalProperties &)
@@ -149,6 +165,17 @@ void SignalGeneratorADC::Preflight(const SignalProperties &, SignalProperties &O
         Expression(Parameter("OffsetMultiplier")).Evaluate();
     Expression(Parameter("AmplitudeMultiplier")).Evaluate();
     Parameter("RandomSeed");
+    if (Parameter("SyntheticSignal") != 0)
+    {
+        if (Parameter("NoiseBand")->NumValues() != 2)
+            bcierr << "NoiseBand must have two entries";
+        else if (Parameter("NoiseBand")(1).InHertz() != 0 &&
+                 Parameter("NoiseBand")(1).InHertz() <= Parameter("NoiseBand")(0).InHertz())
+            bcierr << "NoiseBand corners must be in ascending order";
+        Parameter("EventRate").InHertz();
+        Parameter("ERPAmplitude").InVolts();
+        State("SyntheticEvent");
+    }
 
     if (Parameter("MixingMatrix")->NumValues())
         PreflightCondition(Parameter("SourceCh") == Parameter("MixingMatrix")->NumColumns());
@@ -208,6 +235,25 @@ void SignalGeneratorADC::Initialize(const SignalProperties &, const SignalProper
     mAmplitudeY = 1.0;
     mAmplitudeZ = 1.0;
 
+    mSynthetic = (Parameter("SyntheticSignal") != 0);
+    if (mSynthetic)
+        mSynthesizer.SetSamplingRate(Parameter("SamplingRate").InHertz())
+            .SetChannels(Output.Channels())
+            .SetNoiseBand(Parameter("NoiseBand")(0).InHertz(), Parameter("NoiseBand")(1).InHertz())
+            .SetNoiseAmplitude(mNoiseAmplitude)
+            .SetEventRate(Parameter("EventRate").InHertz())
+            .SetERPAmplitude(Parameter("ERPAmplitude").InMicrovolts() * 1e-6)
+            .Initialize();
+
+    mRawGains.resize(Output.Channels());
+    mRawOffsets.resize(Output.Channels());
+    for (int ch = 0; ch < Output.Channels(); ++ch)
+    {
+        const PhysicalUnit &u = Output.ValueUnit(ch);
+        mRawOffsets[ch] = u.PhysicalToRawValue(0);
+        mRawGains[ch] = u.PhysicalToRawValue(1) - mRawOffsets[ch];
+    }
+
     mMixingMatrix.clear();
     if (Parameter("SourceProperties")->NumValues() > 0)
     {
@@ -265,6 +311,9 @@ void SignalGeneratorADC::Initialize(const SignalProperties &, const SignalProper
 
 void SignalGeneratorADC::StartRun()
 {
+    // RandomGenerator has been re-seeded from RandomSeed at this point.
+    if (mSynthetic)
+        mSynthesizer.SetSeed(mRandomGenerator.Seed()).Reset();
     if (Parameter("RandomSeed") != 0)
         for (size_t i = 0; i < mSourcePhases.size(); ++i)
             mSourcePhases[i] = 0;
@@ -303,46 +352,56 @@ void SignalGeneratorADC::Process(const GenericSignal &, GenericSignal &Output)
     if (offset != 0)
         offset *= mOffsetMultiplier.Evaluate();
 
-#pragma omp parallel for
-    for (int sample = 0; sample < Output.Elements(); ++sample)
-      for (int ch = 0; ch < Output.Channels(); ++ch)
-        pDataOut[Output.LinearIndex(ch, sample)] = offset;
-
-    for (int sample = 0; sample < Output.Elements(); ++sample)
+    if (mSynthetic)
     {
-        mSourcePhases += mSourceFrequencies;
-        mSourcePhases -= mSourcePhases.apply(floor);
-        mSourceValues = sin(mSourcePhases * (2 * Pi())) * mSourceAmplitudes * mAmplitudeMultiplier.Evaluate();
-        if (mModulateAmplitude)
+        mSynthesizer.Process(Output);
+        State("SyntheticEvent") = 0;
+        for (int onset : mSynthesizer.Onsets())
         {
-            if (mSineChannelX > 0)
-                mSourceValues[mSineChannelX - 1] *= mAmplitudeX;
-            if (mSineChannelY > 0)
-                mSourceValues[mSineChannelY - 1] *= mAmplitudeY;
-            else if (mSineChannelY == 0)
-                mSourceValues *= mAmplitudeY;
-            if (mSineChannelZ > 0)
-                mSourceValues[mSineChannelZ - 1] *= mAmplitudeZ;
+            State("SyntheticEvent")(onset) = 1;
+            if (onset + 1 < Output.Elements())
+                State("SyntheticEvent")(onset + 1) = 0;
         }
+    }
+    else
+    {
+        std::fill(pDataOut, pDataOut + Output.Channels() * Output.Elements(), 0);
+        for (int sample = 0; sample < Output.Elements(); ++sample)
+        {
+            mSourcePhases += mSourceFrequencies;
+            mSourcePhases -= mSourcePhases.apply(floor);
+            mSourceValues = sin(mSourcePhases * (2 * Pi())) * mSourceAmplitudes * mAmplitudeMultiplier.Evaluate();
+            if (mModulateAmplitude)
+            {
+                if (mSineChannelX > 0)
+                    mSourceValues[mSineChannelX - 1] *= mAmplitudeX;
+                if (mSineChannelY > 0)
+                    mSourceValues[mSineChannelY - 1] *= mAmplitudeY;
+                else if (mSineChannelY == 0)
+                    mSourceValues *= mAmplitudeY;
+                if (mSineChannelZ > 0)
+                    mSourceValues[mSineChannelZ - 1] *= mAmplitudeZ;
+            }
 #pragma omp parallel for
-        for (int ch = 0; ch < Output.Channels(); ++ch)
-            pDataOut[Output.LinearIndex(ch, sample)] +=
-                (mMixingMatrix[ch] * mSourceValues).sum();
+            for (int ch = 0; ch < Output.Channels(); ++ch)
+                pDataOut[Output.LinearIndex(ch, sample)] += (mMixingMatrix[ch] * mSourceValues).sum();
 
-        for (int ch = 0; ch < Output.Channels(); ++ch)
-          pDataOut[Output.LinearIndex(ch, sample)] +=
-          (mRandomGenerator.Random() * mNoiseAmplitude / mRandomGenerator.RandMax() - mNoiseAmplitude / 2);
+            for (int ch = 0; ch < Output.Channels(); ++ch)
+                pDataOut[Output.LinearIndex(ch, sample)] +=
+                    (mRandomGenerator.Random() * mNoiseAmplitude / mRandomGenerator.RandMax() - mNoiseAmplitude / 2);
+        }
     }
 
+    // Conversion into raw values is linear, with precomputed gain and offset per channel.
+    const GenericSignal::ValueType min = Output.Type().Min(), max = Output.Type().Max();
 #pragma omp parallel for
-    for (int sample = 0; sample < Output.Elements(); ++sample)
-      for (int ch = 0; ch < Output.Channels(); ++ch)
-      {
-          GenericSignal::ValueType &value = pDataOut[Output.LinearIndex(ch, sample)];
-          value = Output.Properties().ValueUnit(ch).PhysicalToRawValue(value);
-          value = std::max(value, Output.Type().Min());
-          value = std::min(value, Output.Type().Max());
-      }
+    for (int ch = 0; ch < Output.Channels(); ++ch)
+    {
+        GenericSignal::ValueType *pChannel = pDataOut + Output.LinearIndex(ch, 0);
+        const GenericSignal::ValueType gain = mRawGains[ch], rawOffset = mRawOffsets[ch] + gain * offset;
+        for (int sample = 0; sample < Output.Elements(); ++sample)
+            pChannel[sample] = std::min(std::max(gain * pChannel[sample] + rawOffset, min), max);
+    }
 
 #if _WIN32
     if (GetAsyncKeyState(VK_SPACE) & 0x80000000)
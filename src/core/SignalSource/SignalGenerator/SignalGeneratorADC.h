@@ -30,6 +30,7 @@
 #include "Expression.h"
 #include "GenericADC.h"
 #include "RandomGenerator.h"
+#include "SignalSynthesizer.h"
 #include <valarray>
 #include <vector>
 
@@ -63,10 +64,14 @@ class SignalGeneratorADC : public GenericADC
 
     int mSineChannelX, mSineChannelY, mSineChannelZ;
     bool mModulateAmplitude;
+    bool mSynthetic;
+    // Linear physical-to-raw conversion per channel
+    std::vector<GenericSignal::ValueType> mRawGains, mRawOffsets;
     // Internal State
     double mAmplitudeX, mAmplitudeY, mAmplitudeZ;
     Clock mClock;
     RandomGenerator mRandomGenerator;
+    SignalSynthesizer mSynthesizer;
 };
 
 #endif // SIGNAL_GENERATOR_ADC_H
@@ -36,6 +36,7 @@
 #include "TimeValue.h"
 
 #include <QtGui>
+#include <algorithm>
 #include <iomanip>
 #include <sstream>
 
@@ -102,7 +103,8 @@ BCI2000Viewer::ActionEntry BCI2000Viewer::sActions[] = {
 //---------------------------------------------------------------------------
 
 BCI2000Viewer::BCI2000Viewer(QWidget *parent)
-    : QMainWindow(parent), ui(new Ui::BCI2000Viewer), mSamplePos(0), mNumSignalChannels(0), mPositionEdited(false),
+    : QMainWindow(parent), ui(new Ui::BCI2000Viewer), mSamplePos(0), mNumDisplaySamples(0), mDisplayDecimation(1),
+      mNumSignalChannels(0), mPositionEdited(false),
       mSamplingRate(0.0), mRemoveMean(false), mpAVControl(nullptr), mpAudioFrameState(nullptr),
       mPrevReadSignalDuration(0),
       mpAudioSink(new AudioSink(bci::Rate::FromHertz(44100), 2, 441))
@@ -128,6 +130,8 @@ BCI2000Viewer::BCI2000Viewer(QWidget *parent)
         .SetChannelColors(cChannelColorsDefault);
     mPlaybackTimer.setInterval(20);
     connect(&mPlaybackTimer, SIGNAL(timeout()), this, SLOT(PlaybackTimer()));
+    mOverviewTimer.setInterval(500);
+    connect(&mOverviewTimer, SIGNAL(timeout()), this, SLOT(OverviewTimer()));
     ReadSettings();
 
     if (QApplication::arguments().size() > 1)
@@ -356,7 +360,7 @@ void BCI2000Viewer::on_editPosition_editingFinished()
         TimeValue t;
         std::istringstream iss(ui->editPosition->text().toLocal8Bit().constData());
         if (iss >> t)
-            SetSamplePos(static_cast<int>(t * mFile.SamplingRate() - ui->signalDisplay->Display().NumSamples() / 2));
+            SetSamplePos(static_cast<int64_t>(t * mFile.SamplingRate()) - mNumDisplaySamples / 2);
     }
     this->grabKeyboard();
 }
@@ -547,12 +551,11 @@ void BCI2000Viewer::ToPrevBlock()
 }
 void BCI2000Viewer::ToPrevPage()
 {
-    SetSamplePos(std::max<int64_t>(0LL, mSamplePos - ui->signalDisplay->Display().NumSamples()));
+    SetSamplePos(std::max<int64_t>(0LL, mSamplePos - mNumDisplaySamples));
 }
 void BCI2000Viewer::ToNextPage()
 {
-    SetSamplePos(std::min(mFile.NumSamples() - ui->signalDisplay->Display().NumSamples(),
-                          mSamplePos + ui->signalDisplay->Display().NumSamples()));
+    SetSamplePos(std::min(mFile.NumSamples() - mNumDisplaySamples, mSamplePos + mNumDisplaySamples));
 }
 
 bool BCI2000Viewer::GoBack_Enabled() const
@@ -561,32 +564,32 @@ bool BCI2000Viewer::GoBack_Enabled() const
 }
 bool BCI2000Viewer::GoForward_Enabled() const
 {
-    return mSamplePos < mFile.NumSamples() - ui->signalDisplay->Display().NumSamples() - 1;
+    return mSamplePos < mFile.NumSamples() - mNumDisplaySamples - 1;
 }
 
 // Temporal resolution
 void BCI2000Viewer::SampleZoomIn()
 {
-    int prevNumSamples = ui->signalDisplay->Display().NumSamples(), newNumSamples = prevNumSamples / 2;
-    ui->signalDisplay->Display().SetNumSamples(newNumSamples);
+    int64_t prevNumSamples = mNumDisplaySamples, newNumSamples = prevNumSamples / 2;
+    mNumDisplaySamples = newNumSamples;
     SetSamplePos(mSamplePos + (prevNumSamples - newNumSamples) / 2);
 }
 bool BCI2000Viewer::SampleZoomIn_Enabled() const
 {
-    return mFile.IsOpen() && ui->signalDisplay->Display().NumSamples() / 2 >= mFile.SignalProperties().Elements();
+    return mFile.IsOpen() && mNumDisplaySamples / 2 >= mFile.SignalProperties().Elements();
 }
 
 void BCI2000Viewer::SampleZoomOut()
 {
-    int prevNumSamples = ui->signalDisplay->Display().NumSamples(), newNumSamples = prevNumSamples * 2;
+    int64_t prevNumSamples = mNumDisplaySamples, newNumSamples = prevNumSamples * 2;
     if (newNumSamples > mFile.NumSamples())
         newNumSamples = mFile.NumSamples();
-    ui->signalDisplay->Display().SetNumSamples(newNumSamples);
+    mNumDisplaySamples = newNumSamples;
     SetSamplePos(mSamplePos + (prevNumSamples - newNumSamples) / 2);
 }
 bool BCI2000Viewer::SampleZoomOut_Enabled() const
 {
-    return ui->signalDisplay->Display().NumSamples() < mFile.NumSamples();
+    return mNumDisplaySamples < mFile.NumSamples();
 }
 
 // Number of displayed channels
@@ -858,6 +861,8 @@ bool BCI2000Viewer::StateSelected() const
 void BCI2000Viewer::DoFileOpen(const QString &inName)
 {
     DestroyAVObjects();
+    mOverviewTimer.stop();
+    mOverview.Close();
     std::string name = inName.toLocal8Bit().constData();
     mFile.Open(name.c_str());
     if (!mFile.IsOpen())
@@ -868,6 +873,8 @@ void BCI2000Viewer::DoFileOpen(const QString &inName)
             QMessageBox::critical(this, QApplication::applicationName(), message);
         }
         this->setWindowTitle(QApplication::applicationName());
+        mNumDisplaySamples = 0;
+        mDisplayDecimation = 1;
         ui->signalDisplay->Display().SetNumSamples(0);
         mSamplingRate = 0.0;
     }
@@ -878,8 +885,10 @@ void BCI2000Viewer::DoFileOpen(const QString &inName)
         ValueList<std::string> units;
         for (int ch = 0; ch < mFile.SignalProperties().Channels(); ++ch)
             units.push_back(mFile.SignalProperties().ValueUnit(ch).RawToPhysical(1));
+        mNumDisplaySamples = std::min<int64_t>(static_cast<int64_t>(mFile.SamplingRate() * 10), mFile.NumSamples());
+        mDisplayDecimation = 1;
         ui->signalDisplay->Display()
-            .SetNumSamples(std::min<int>(static_cast<int>(mFile.SamplingRate() * 10), mFile.NumSamples()))
+            .SetNumSamples(static_cast<int>(mNumDisplaySamples))
             .SetUnitsPerValue(1.0)
             .SetValueUnits(units)
             .SetMinValue(-100)
@@ -887,6 +896,11 @@ void BCI2000Viewer::DoFileOpen(const QString &inName)
             .SetUnitsPerSample(1.0 / mFile.SamplingRate())
             .SetSampleUnit(":s");
         mSamplingRate = mFile.SamplingRate();
+        // The overview is used for display when zoomed out, and may take a while
+        // to be created for a large file.
+        mOverview.Open(name);
+        if (!mOverview.Ready())
+            mOverviewTimer.start();
     }
     FillChannelList();
     CreateAVObjects();
@@ -972,7 +986,7 @@ void BCI2000Viewer::ReadSettings()
 
 void BCI2000Viewer::UpdateSamplePos()
 {
-    ui->signalDisplay->Display().SetSampleOffset(mSamplePos);
+    ui->signalDisplay->Display().SetSampleOffset(mSamplePos / mDisplayDecimation);
     UpdateTimeField();
     UpdateAVObjects();
     UpdateActions();
@@ -982,7 +996,7 @@ void BCI2000Viewer::UpdateTimeField()
 {
     if (mFile.IsOpen())
     {
-        TimeValue pos = static_cast<long>((2 * mSamplePos + ui->signalDisplay->Display().NumSamples()) / 2 /
+        TimeValue pos = static_cast<long>((2 * mSamplePos + mNumDisplaySamples) / 2 /
                                           mFile.SamplingRate()),
                   length = static_cast<long>(mFile.NumSamples() / mFile.SamplingRate());
         std::ostringstream oss;
@@ -1067,7 +1081,9 @@ void BCI2000Viewer::UpdateVerticalScroller()
     ui->verticalScrollBar->blockSignals(false);
 }
 
-GenericSignal BCI2000Viewer::ConstructDisplaySignal(int64_t inPos, int64_t inLength)
+// Constructs a signal with one element per sample, or, if an overview level is given,
+// with one element per half bin of that level.
+GenericSignal BCI2000Viewer::ConstructDisplaySignal(int64_t inPos, int64_t inLength, int inOverviewLevel)
 {
     GenericSignal result;
     if (mFile.IsOpen())
@@ -1078,26 +1094,43 @@ GenericSignal BCI2000Viewer::ConstructDisplaySignal(int64_t inPos, int64_t inLen
             QApplication::setOverrideCursor(Qt::WaitCursor);
         int i = 1;
         std::vector<StateRef> states;
+        std::vector<std::string> stateNames;
         for (; i < ui->channelList->count() && (ui->channelList->item(i)->flags() & Qt::ItemIsUserCheckable); ++i)
             if (ui->channelList->item(i)->checkState() == Qt::Checked)
-                states.push_back(mFile.State(ui->channelList->item(i)->text().toLocal8Bit().constData()));
+            {
+                stateNames.push_back(ui->channelList->item(i)->text().toLocal8Bit().constData());
+                states.push_back(mFile.State(stateNames.back()));
+            }
         std::vector<int> channels;
         int base = ++i;
         for (; i < ui->channelList->count() && (ui->channelList->item(i)->flags() & Qt::ItemIsUserCheckable); ++i)
             if (ui->channelList->item(i)->checkState() == Qt::Checked)
                 channels.push_back(i - base);
 
-        GenericSignal signal(channels.size() + states.size(), inLength), statevalues(states.size(), inLength);
-        int64_t sampleInFile = inPos;
-        for (int64_t sample = 0; sample < signal.Elements() && sampleInFile < mFile.NumSamples();
-             ++sample, ++sampleInFile)
+        int64_t elements = inLength;
+        if (inOverviewLevel >= 0)
+        {
+            int64_t halfBin = mOverview.Decimation(inOverviewLevel) / 2;
+            elements = (inLength + halfBin - 1) / halfBin;
+        }
+        GenericSignal signal(channels.size() + states.size(), elements), statevalues(states.size(), elements);
+        if (inOverviewLevel >= 0)
+        {
+            ReadOverview(inOverviewLevel, inPos, channels, stateNames, signal, statevalues);
+        }
+        else
         {
-            for (int channelIdx = 0; channelIdx < static_cast<int>(channels.size()); ++channelIdx)
-                signal(channelIdx, sample) = mFile.CalibratedValue(channels[channelIdx], sampleInFile);
+            int64_t sampleInFile = inPos;
+            for (int64_t sample = 0; sample < signal.Elements() && sampleInFile < mFile.NumSamples();
+                 ++sample, ++sampleInFile)
+            {
+                for (int channelIdx = 0; channelIdx < static_cast<int>(channels.size()); ++channelIdx)
+                    signal(channelIdx, sample) = mFile.CalibratedValue(channels[channelIdx], sampleInFile);
 
-            mFile.ReadStateVector(sampleInFile);
-            for (size_t i = 0; i < states.size(); ++i)
-                statevalues(i, sample) = states[i].AsUnsigned();
+                mFile.ReadStateVector(sampleInFile);
+                for (size_t i = 0; i < states.size(); ++i)
+                    statevalues(i, sample) = states[i].AsUnsigned();
+            }
         }
 
         if (FilterActive())
@@ -1142,6 +1175,96 @@ GenericSignal BCI2000Viewer::ConstructDisplaySignal(int64_t inPos, int64_t inLen
     return result;
 }
 
+// Fills signal and state values from the overview, with one element per half bin.
+// Signal values alternate between the minimum and the maximum of each bin, so the
+// trace covers the bin's range. Listed states show their maximum within each half
+// bin, so short events remain visible; other states are read once per half bin.
+void BCI2000Viewer::ReadOverview(int inLevel, int64_t inPos, const std::vector<int> &inChannels,
+                                 const std::vector<std::string> &inStates, GenericSignal &outSignal,
+                                 GenericSignal &outStatevalues)
+{
+    int64_t halfBin = mOverview.Decimation(inLevel) / 2, firstHalf = inPos / halfBin,
+            length = std::min<int64_t>(outSignal.Elements(), (mFile.NumSamples() - 1) / halfBin - firstHalf + 1);
+    if (length < 1)
+        return;
+    int64_t firstBin = firstHalf / 2, numBins = (firstHalf + length - 1) / 2 - firstBin + 1;
+    int channels = mOverview.Channels();
+    std::vector<BCI2000FileOverview::Bin> bins(numBins * channels);
+    mOverview.ReadBins(inLevel, firstBin, numBins, bins.data());
+    for (int64_t el = 0; el < length; ++el)
+    {
+        int64_t half = firstHalf + el;
+        const BCI2000FileOverview::Bin *pBin = &bins[(half / 2 - firstBin) * channels];
+        bool upper = half % 2;
+        for (size_t i = 0; i < inChannels.size(); ++i)
+            outSignal(i, el) = upper ? pBin[inChannels[i]].max : pBin[inChannels[i]].min;
+    }
+
+    std::vector<size_t> unlisted;
+    for (size_t i = 0; i < inStates.size(); ++i)
+    {
+        const auto *pChanges = mOverview.StateChanges(inStates[i]);
+        if (!pChanges)
+        {
+            unlisted.push_back(i);
+            continue;
+        }
+        int64_t begin = firstHalf * halfBin;
+        auto change = std::upper_bound(pChanges->begin(), pChanges->end(), begin,
+                                       [](int64_t pos, const BCI2000FileOverview::Change &c) { return pos < c.sample; });
+        --change; // The first change is at sample 0.
+        for (int64_t el = 0; el < length; ++el, begin += halfBin)
+        {
+            while (change + 1 != pChanges->end() && (change + 1)->sample <= begin)
+                ++change;
+            State::ValueType value = change->value;
+            for (auto c = change + 1; c != pChanges->end() && c->sample < begin + halfBin; ++c)
+                value = std::max(value, c->value);
+            outStatevalues(i, el) = value;
+        }
+    }
+    if (!unlisted.empty())
+    {
+        std::vector<StateRef> states;
+        for (size_t i : unlisted)
+            states.push_back(mFile.State(inStates[i]));
+        for (int64_t el = 0; el < length; ++el)
+        {
+            mFile.ReadStateVector((firstHalf + el) * halfBin);
+            for (size_t j = 0; j < unlisted.size(); ++j)
+                outStatevalues(unlisted[j], el) = states[j].AsUnsigned();
+        }
+    }
+}
+
+// When there are multiple samples per pixel, data are taken from the overview if available.
+int BCI2000Viewer::OverviewLevel()
+{
+    if (FilterActive() || !mOverview.Ready())
+        return -1;
+    return mOverview.LevelFor(mNumDisplaySamples / std::max(1, ui->signalDisplay->width()));
+}
+
+void BCI2000Viewer::UpdateDisplayResolution(int inOverviewLevel)
+{
+    int64_t decimation = inOverviewLevel < 0 ? 1 : mOverview.Decimation(inOverviewLevel) / 2;
+    int numSamples = static_cast<int>((mNumDisplaySamples + decimation - 1) / decimation);
+    if (decimation != mDisplayDecimation || numSamples != ui->signalDisplay->Display().NumSamples())
+    {
+        mDisplayDecimation = decimation;
+        ui->signalDisplay->Display().SetNumSamples(numSamples).SetUnitsPerSample(decimation / mFile.SamplingRate());
+    }
+}
+
+void BCI2000Viewer::OverviewTimer()
+{
+    if (mOverview.Ready())
+    {
+        mOverviewTimer.stop();
+        SetSamplePos(mSamplePos);
+    }
+}
+
 int64_t BCI2000Viewer::NumSamples() const
 {
     return mFile.NumSamples();
@@ -1149,7 +1272,7 @@ int64_t BCI2000Viewer::NumSamples() const
 
 int64_t BCI2000Viewer::NumDisplaySamples() const
 {
-    return ui->signalDisplay->Display().NumSamples();
+    return mNumDisplaySamples;
 }
 
 void BCI2000Viewer::SetSamplePos(int64_t inPos)
@@ -1161,13 +1284,17 @@ void BCI2000Viewer::SetSamplePos(int64_t inPos)
             mSamplePos = mFile.NumSamples() - NumDisplaySamples() - 1;
         if (mSamplePos < 0)
             mSamplePos = 0;
-        GenericSignal signal = ConstructDisplaySignal(mSamplePos, NumDisplaySamples());
+        int overviewLevel = OverviewLevel();
+        UpdateDisplayResolution(overviewLevel);
+        GenericSignal signal = ConstructDisplaySignal(mSamplePos, NumDisplaySamples(), overviewLevel);
         ui->signalDisplay->Display().WrapForward(signal);
     }
     else
     {
         ui->signalDisplay->Display().SetNumSamples(0).WrapForward(GenericSignal(0, 0));
         mSamplePos = 0;
+        mNumDisplaySamples = 0;
+        mDisplayDecimation = 1;
     }
     UpdateSamplePos();
 }
@@ -1186,7 +1313,7 @@ void BCI2000Viewer::MoveSamplePos(int64_t inPosDiff)
     }
     if (inPosDiff != 0 && mFile.IsOpen())
     {
-        if (FilterActive() || mRemoveMean)
+        if (FilterActive() || mRemoveMean || mDisplayDecimation > 1)
         {
             SetSamplePos(mSamplePos + inPosDiff);
         }
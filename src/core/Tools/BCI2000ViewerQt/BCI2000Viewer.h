@@ -31,6 +31,7 @@
 
 #include "AudioSink.h"
 #include "AVControl.h"
+#include "BCI2000FileOverview.h"
 #include "BCI2000FileReader.h"
 #include "Color.h"
 #include "DisplayFilter.h"
@@ -178,6 +179,7 @@ class BCI2000Viewer : public QMainWindow
     bool Playing() const;
   private slots:
     void PlaybackTimer();
+    void OverviewTimer();
 
   private:
     // Internal functions
@@ -189,7 +191,11 @@ class BCI2000Viewer : public QMainWindow
     void UpdateTimeField();
     void UpdateChannelLabels();
     void UpdateVerticalScroller();
-    GenericSignal ConstructDisplaySignal(int64_t samplePos, int64_t length);
+    GenericSignal ConstructDisplaySignal(int64_t samplePos, int64_t length, int overviewLevel = -1);
+    void ReadOverview(int level, int64_t samplePos, const std::vector<int> &channels,
+                      const std::vector<std::string> &states, GenericSignal &signal, GenericSignal &statevalues);
+    int OverviewLevel();
+    void UpdateDisplayResolution(int overviewLevel);
     void FilterChanged();
     bool FilterActive();
 
@@ -207,7 +213,11 @@ class BCI2000Viewer : public QMainWindow
     static const QColor cHeadingColor;
 
     BCI2000FileReader mFile;
+    BCI2000FileOverview mOverview;
+    QTimer mOverviewTimer;
     int64_t mSamplePos;
+    // Length of the displayed interval in samples, and number of samples per display sample.
+    int64_t mNumDisplaySamples, mDisplayDecimation;
     int mNumSignalChannels;
     bool mPositionEdited;
     float mSamplingRate;
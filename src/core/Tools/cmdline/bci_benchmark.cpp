@@ -0,0 +1,381 @@
+////////////////////////////////////////////////////////////////////
+// $Id$
+// Author: BCI2000 team
+// Description: A headless benchmark for BCI2000 filter chains.
+//          Instantiates the filters from the PipeDefinition linked
+//          into the executable, feeds them with synthetic data as
+//          fast as possible, and writes throughput, per-filter
+//          latency percentiles, and heap allocation counts to the
+//          standard output in JSON format.
+//
+// $BEGIN_BCI2000_LICENSE$
+//
+// This file is part of BCI2000, a platform for real-time bio-signal research.
+// [ Copyright (C) 2000-2022: BCI2000 team and many external contributors ]
+//
+// BCI2000 is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// BCI2000 is distributed in the hope that it will be useful, but
+//                         WITHOUT ANY WARRANTY
+// - without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+// A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// $END_BCI2000_LICENSE$
+////////////////////////////////////////////////////////////////////
+#include "BCIStream.h"
+#include "ClassName.h"
+#include "Files.h"
+#include "GenericFilter.h"
+#include "GenericSignal.h"
+#include "GenericVisualization.h"
+#include "MeasurementUnits.h"
+#include "MessageChannel.h"
+#include "ParamList.h"
+#include "SignalSynthesizer.h"
+#include "StateList.h"
+#include "StateVector.h"
+#include "TimeUtils.h"
+#include "bci_tool.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <vector>
+
+std::string ToolInfo[] = {
+    "",
+    "Run a BCI2000 filter chain on synthetic data, and report its performance.",
+    "Instantiates the filters linked into the executable, feeds them with band-limited\n"
+    "noise and ERPs at maximum speed, and writes throughput, per-filter latency percentiles,\n"
+    "and heap allocation counts to standard output in JSON format.\n"
+    "Filter parameters are taken from the filters' defaults, and from the parameter file\n"
+    "if one is given. The states Running, SyntheticEvent, and StimulusCode are set by\n"
+    "the benchmark; StimulusCode is 1 at each ERP onset.\n"
+    "Heap allocations are only counted in builds with the USE_ALLOCATION_COUNTER option.",
+    "text",
+    "-c<N>,    --channels=<N>        Number of channels, defaults to 16",
+    "-r<Hz>,   --rate=<Hz>           Sampling rate in Hz, defaults to 1000",
+    "-s<N>,    --blocksize=<N>       Samples per block, defaults to 32",
+    "-n<N>,    --blocks=<N>          Number of blocks to measure, defaults to 1000",
+    "-w<N>,    --warmup=<N>          Number of blocks before measurement, defaults to 10",
+    "-e<Hz>,   --eventrate=<Hz>      Rate of synthetic ERPs, defaults to 1",
+    "          --seed=<N>            Seed for synthetic data, defaults to 1",
+    "-p<file>, --parameters=<file>   Load parameters from <file>",
+    ""};
+
+class Benchmark
+{
+  public:
+    Benchmark();
+    ~Benchmark();
+
+    bool Setup(OptionSet &);
+    bool Run(int blocks, int warmup);
+    void Report(std::ostream &) const;
+
+  private:
+    struct Statistics
+    {
+        std::string name, filter;
+        std::vector<double> durations;
+        long long allocations;
+    };
+    static void WriteStatistics(std::ostream &, const Statistics &);
+    static void SetPulses(StateVector &, const State &, const std::vector<int> &);
+
+    Environment::Context &mEnvironment;
+    // Visualization messages are discarded.
+    File mNullFile;
+    BufferedIO mNullBuffer;
+    MessageChannel mVisualization;
+    ParamList mParamlist;
+    StateList mStatelist;
+    StateVector *mpStatevector;
+    GenericSignal mInput, mOutput;
+    SignalSynthesizer mSynthesizer;
+    int mBlocks;
+    double mSynthesisTime;
+    Statistics mChain;
+    std::vector<Statistics> mFilters;
+};
+
+ToolResult ToolInit()
+{
+    return noError;
+}
+
+ToolResult ToolMain(Streambuf &, Streambuf &out, OptionSet &arOptions)
+{
+    int blocks = ::atoi(arOptions.getopt("-n|--blocks", "1000").c_str()),
+        warmup = ::atoi(arOptions.getopt("-w|--warmup", "10").c_str());
+    Benchmark benchmark;
+    if (!benchmark.Setup(arOptions))
+        return illegalOption;
+    if (!arOptions.empty() || blocks < 1 || warmup < 0)
+        return illegalOption;
+    if (!benchmark.Run(blocks, warmup))
+        return genericError;
+    Tiny::OStream output(out);
+    benchmark.Report(output);
+    return output ? noError : fileIOError;
+}
+
+Benchmark::Benchmark()
+    : mEnvironment(*Environment::Context::GlobalInstance()), mVisualization(mNullBuffer), mpStatevector(nullptr),
+      mBlocks(0), mSynthesisTime(0)
+{
+    mNullBuffer.SetOutput(&mNullFile.Output());
+    GenericVisualization::SetOutputChannel(&mVisualization);
+    mChain.allocations = 0;
+}
+
+Benchmark::~Benchmark()
+{
+    if (mEnvironment.Phase() != Environment::nonaccess)
+        mEnvironment.EnterPhase(Environment::nonaccess);
+    mEnvironment.EnterPhase(Environment::destruction);
+    GenericFilter::DisposeFilters();
+    delete mpStatevector;
+}
+
+bool Benchmark::Setup(OptionSet &arOptions)
+{
+    mEnvironment.EnterPhase(Environment::construction, &mParamlist, &mStatelist);
+    GenericFilter::InstantiateFilters();
+    mEnvironment.EnterPhase(Environment::nonaccess);
+    mEnvironment.EnterPhase(Environment::publication, &mParamlist, &mStatelist);
+    GenericFilter::PublishFilters();
+    mEnvironment.EnterPhase(Environment::nonaccess);
+    if (!bcierr__.Empty())
+        return false;
+
+    // Parameters and states that are otherwise provided by source and application modules.
+    const char *params[] = {
+        "Source:Signal%20Properties int SourceCh= 16 16 1 % // number of channels",
+        "Source:Signal%20Properties int SampleBlockSize= 32 32 1 % // number of samples per block",
+        "Source:Signal%20Properties float SamplingRate= 1000Hz 1000Hz 0 % // sample rate",
+        "Source:Signal%20Properties list ChannelNames= 0 % % % // list of channel names",
+        "System:Randomization int RandomSeed= 1 1 % % // seed for synthetic data",
+        "Visualize int EvaluateTiming= 0 0 0 1 // (boolean)",
+    };
+    for (const char *p : params)
+    {
+        Param param(p);
+        if (!mParamlist.Exists(param.Name()))
+            mParamlist.Add(param);
+    }
+    const char *states[] = {
+        "Running 1 0 0 0",      "Recording 1 0 0 0",     "SourceTime 16 0 0 0", "StimulusTime 16 0 0 0",
+        "SyntheticEvent 1 0 0 0", "StimulusCode 16 0 0 0", "StimulusType 1 0 0 0", "StimulusBegin 1 0 0 0",
+        "Feedback 1 0 0 0",     "TargetCode 8 0 0 0",    "ResultCode 8 0 0 0",
+    };
+    for (const char *s : states)
+    {
+        State state;
+        state.FromDefinition(s);
+        if (!mStatelist.Exists(state.Name()))
+            mStatelist.Add(state);
+    }
+    mStatelist.AssignPositions();
+
+    std::string file = arOptions.getopt("-p|--parameters", "");
+    if (!file.empty() && !mParamlist.Load(file, true))
+    {
+        bcierr << "Could not load parameters from " << file;
+        return false;
+    }
+    struct
+    {
+        const char *options, *param;
+    } overrides[] = {
+        {"-c|--channels", "SourceCh"},        {"-r|--rate", "SamplingRate"}, {"-s|--blocksize", "SampleBlockSize"},
+        {"--seed", "RandomSeed"},
+    };
+    for (const auto &o : overrides)
+    {
+        std::string value = arOptions.getopt(o.options, "");
+        if (!value.empty())
+            mParamlist(o.param) = value;
+    }
+    double eventRate = ::atof(arOptions.getopt("-e|--eventrate", "1").c_str());
+    MeasurementUnits::Initialize(mParamlist);
+    int channels = ::atoi(mParamlist("SourceCh").c_str()), blockSize = ::atoi(mParamlist("SampleBlockSize").c_str());
+    double rate = MeasurementUnits::SamplingRate();
+    if (channels < 1 || blockSize < 1 || !bcierr__.Empty())
+    {
+        bcierr << "Invalid signal dimensions";
+        return false;
+    }
+
+    // Input signal properties as they would be sent by a source module, in muV.
+    SignalProperties input(channels, blockSize, SignalType::float32);
+    input.SetName("Synthetic Signal").SetUpdateRate(rate / blockSize);
+    input.ElementUnit().SetOffset(0).SetGain(1.0 / rate).SetSymbol("s");
+    for (int ch = 0; ch < channels; ++ch)
+    {
+        input.ValueUnit(ch).SetOffset(0).SetGain(1e-6).SetSymbol("V").SetRawMin(-100).SetRawMax(100);
+        if (ch < mParamlist.ByPath("ChannelNames").NumValues())
+            input.ChannelLabels()[ch] = mParamlist.ByPath("ChannelNames").Value(ch).ToString();
+        else
+            input.ChannelLabels()[ch] = "Ch" + std::to_string(ch + 1);
+    }
+    delete mpStatevector;
+    mpStatevector = new StateVector(mStatelist, blockSize + 1);
+
+    SignalProperties output;
+    mEnvironment.EnterPhase(Environment::preflight, &mParamlist, &mStatelist);
+    GenericFilter::PreflightFilters(input, output);
+    mEnvironment.EnterPhase(Environment::nonaccess);
+    if (!bcierr__.Empty())
+        return false;
+    mInput = GenericSignal(input);
+    mOutput = GenericSignal(output);
+
+    mEnvironment.EnterPhase(Environment::initialization, &mParamlist, &mStatelist, mpStatevector);
+    GenericFilter::InitializeFilters();
+    mEnvironment.EnterPhase(Environment::nonaccess);
+    if (!bcierr__.Empty())
+        return false;
+
+    mSynthesizer.SetSamplingRate(rate)
+        .SetChannels(channels)
+        .SetSeed(::atoi(mParamlist("RandomSeed").c_str()))
+        .SetNoiseBand(1, std::min(40.0, rate / 4))
+        .SetNoiseAmplitude(10)
+        .SetEventRate(eventRate)
+        .SetERPAmplitude(10)
+        .Initialize();
+
+    mChain.name = "chain";
+    mFilters.clear();
+    for (GenericFilter *pFilter : GenericFilter::AllFilters())
+    {
+        Statistics s;
+        s.name = pFilter->Name();
+        s.filter = ClassName(typeid(*pFilter));
+        s.allocations = 0;
+        mFilters.push_back(s);
+        pFilter->EnableProfiling(true);
+    }
+    return true;
+}
+
+bool Benchmark::Run(int inBlocks, int inWarmup)
+{
+    mEnvironment.EnterPhase(Environment::startRun, &mParamlist, &mStatelist, mpStatevector);
+    GenericFilter::StartRunFilters();
+    mEnvironment.EnterPhase(Environment::nonaccess);
+    mpStatevector->SetStateValue("Running", 1);
+    mpStatevector->CommitStateChanges();
+
+    const State &event = mStatelist.ByName("SyntheticEvent"), &stimulus = mStatelist.ByName("StimulusCode");
+    mChain.durations.reserve(inBlocks);
+    for (auto &s : mFilters)
+        s.durations.reserve(inBlocks);
+    mBlocks = 0;
+    mSynthesisTime = 0;
+    for (int block = 0; block < inWarmup + inBlocks && bcierr__.Empty(); ++block)
+    {
+        Time t0 = TimeUtils::MonotonicTime();
+        mSynthesizer.Process(mInput);
+        SetPulses(*mpStatevector, event, mSynthesizer.Onsets());
+        SetPulses(*mpStatevector, stimulus, mSynthesizer.Onsets());
+
+        Time t1 = TimeUtils::MonotonicTime();
+        int allocations = MemoryDebugging::HeapAllocations();
+        mEnvironment.EnterPhase(Environment::processing, &mParamlist, &mStatelist, mpStatevector);
+        GenericFilter::ProcessFilters(mInput, mOutput);
+        mEnvironment.EnterPhase(Environment::nonaccess);
+        Time t2 = TimeUtils::MonotonicTime();
+        mpStatevector->CommitStateChanges();
+
+        if (block < inWarmup)
+            continue;
+        ++mBlocks;
+        mSynthesisTime += (t1 - t0).Seconds();
+        mChain.durations.push_back((t2 - t1).Seconds());
+        mChain.allocations = allocations < 0 ? -1 : mChain.allocations + MemoryDebugging::HeapAllocations() - allocations;
+        auto s = mFilters.begin();
+        for (GenericFilter *pFilter : GenericFilter::AllFilters())
+        {
+            const auto &data = pFilter->PerformanceData();
+            s->durations.push_back(data.lastDuration);
+            s->allocations = data.lastAllocations < 0 ? -1 : s->allocations + data.lastAllocations;
+            ++s;
+        }
+    }
+
+    mEnvironment.EnterPhase(Environment::stopRun, &mParamlist, &mStatelist, mpStatevector);
+    GenericFilter::StopRunFilters();
+    mEnvironment.EnterPhase(Environment::nonaccess);
+    return bcierr__.Empty();
+}
+
+// Sets a state to 1 at the given sample positions, and to 0 otherwise.
+void Benchmark::SetPulses(StateVector &ioStatevector, const State &inState, const std::vector<int> &inPositions)
+{
+    ioStatevector.SetStateValue(inState.Location(), inState.Length(), 0, 0);
+    for (int pos : inPositions)
+    {
+        ioStatevector.SetStateValue(inState.Location(), inState.Length(), pos, 1);
+        ioStatevector.SetStateValue(inState.Location(), inState.Length(), pos + 1, 0);
+    }
+}
+
+void Benchmark::Report(std::ostream &os) const
+{
+    double total = 0;
+    for (double d : mChain.durations)
+        total += d;
+    double samples = mBlocks * double(mInput.Elements()), realTime = samples / MeasurementUnits::SamplingRate();
+    os << std::setprecision(6) << "{\n"
+       << "  \"channels\": " << mInput.Channels() << ",\n"
+       << "  \"samplingRate\": " << MeasurementUnits::SamplingRate() << ",\n"
+       << "  \"blockSize\": " << mInput.Elements() << ",\n"
+       << "  \"blocks\": " << mBlocks << ",\n"
+       << "  \"processingTime\": " << total << ",\n"
+       << "  \"synthesisTime\": " << mSynthesisTime << ",\n"
+       << "  \"samplesPerSecond\": " << samples / total << ",\n"
+       << "  \"valuesPerSecond\": " << samples * mInput.Channels() / total << ",\n"
+       << "  \"realTimeFactor\": " << realTime / total << ",\n"
+       << "  \"chain\": ";
+    WriteStatistics(os, mChain);
+    os << ",\n  \"filters\": [";
+    for (size_t i = 0; i < mFilters.size(); ++i)
+    {
+        os << (i ? ",\n    " : "\n    ");
+        WriteStatistics(os, mFilters[i]);
+    }
+    os << "\n  ]\n}" << std::endl;
+}
+
+// Durations are reported in milliseconds, percentiles use the nearest-rank method.
+void Benchmark::WriteStatistics(std::ostream &os, const Statistics &inStatistics)
+{
+    std::vector<double> d = inStatistics.durations;
+    std::sort(d.begin(), d.end());
+    double sum = 0;
+    for (double x : d)
+        sum += x;
+    auto percentile = [&d](double p) {
+        size_t rank = static_cast<size_t>(std::ceil(p / 100 * d.size()));
+        return d.empty() ? 0 : d[std::max<size_t>(rank, 1) - 1] * 1e3;
+    };
+    os << "{ \"name\": \"" << inStatistics.name << "\"";
+    if (!inStatistics.filter.empty())
+        os << ", \"filter\": \"" << inStatistics.filter << "\"";
+    os << ", \"mean\": " << (d.empty() ? 0 : sum / d.size() * 1e3) << ", \"p50\": " << percentile(50)
+       << ", \"p90\": " << percentile(90) << ", \"p99\": " << percentile(99) << ", \"p999\": " << percentile(99.9)
+       << ", \"max\": " << (d.empty() ? 0 : d.back() * 1e3) << ", \"allocations\": ";
+    if (inStatistics.allocations < 0)
+        os << "null";
+    else
+        os << inStatistics.allocations << ", \"allocationsPerBlock\": "
+           << (d.empty() ? 0 : double(inStatistics.allocations) / d.size());
+    os << " }";
+}
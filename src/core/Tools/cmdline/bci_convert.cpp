@@ -0,0 +1,192 @@
+////////////////////////////////////////////////////////////////////
+// $Id$
+// Author: BCI2000 team
+// Description: Functionality shared by the command line converters.
+//
+// $BEGIN_BCI2000_LICENSE$
+//
+// This file is part of BCI2000, a platform for real-time bio-signal research.
+// [ Copyright (C) 2000-2022: BCI2000 team and many external contributors ]
+//
+// BCI2000 is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// BCI2000 is distributed in the hope that it will be useful, but
+//                         WITHOUT ANY WARRANTY
+// - without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+// A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// $END_BCI2000_LICENSE$
+////////////////////////////////////////////////////////////////////
+#include "bci_convert.h"
+
+#include "ReusableThread.h"
+#include "Runnable.h"
+#include "ThreadUtils.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace
+{
+int sThreads = 0;
+
+// Rows are formatted in batches, and a batch is split among threads only
+// if it is large enough to outweigh the cost of waking up threads.
+const size_t cBatchValues = 1 << 16, cMinValuesPerThread = 1 << 12;
+
+} // namespace
+
+namespace Conversion
+{
+
+void SetThreads(int n)
+{
+    sThreads = n < 0 ? 0 : n;
+}
+
+int Threads()
+{
+    return sThreads > 0 ? sThreads : ThreadUtils::NumberOfProcessors();
+}
+
+char *FormatNumber(double value, char *p)
+{
+#if __cpp_lib_to_chars >= 201611L
+    // Equivalent to printf's %g format, as used by std::ostream at default precision.
+    return std::to_chars(p, p + cMaxNumberLength, value, std::chars_format::general, 6).ptr;
+#else
+    return p + ::snprintf(p, cMaxNumberLength, "%g", value);
+#endif
+}
+
+char *FormatInteger(int64_t value, char *p)
+{
+    return std::to_chars(p, p + cMaxNumberLength, value).ptr;
+}
+
+struct TableWriter::Private
+{
+    // Formats a range of rows into a string.
+    struct Part : Runnable
+    {
+        const Private *mpParent;
+        size_t mBegin, mEnd;
+        std::string mText;
+        void OnRun() override;
+    };
+
+    std::ostream &mrOutput;
+    int mIntegerColumns, mColumns;
+    std::vector<double> mValues;
+    size_t mRows;
+    std::vector<Part> mParts;
+    std::vector<ReusableThread *> mThreads;
+
+    Private(std::ostream &os, int integerColumns, int columns)
+        : mrOutput(os), mIntegerColumns(integerColumns), mColumns(columns), mRows(0)
+    {
+    }
+    ~Private()
+    {
+        for (auto pThread : mThreads)
+            delete pThread;
+    }
+    void Flush();
+};
+
+void TableWriter::Private::Part::OnRun()
+{
+    int columns = mpParent->mColumns, integerColumns = mpParent->mIntegerColumns;
+    mText.resize((mEnd - mBegin) * (columns * (cMaxNumberLength + 1) + 1));
+    char *p = &mText[0];
+    const double *pValue = mpParent->mValues.data() + mBegin * columns;
+    for (size_t row = mBegin; row < mEnd; ++row)
+    {
+        for (int col = 0; col < integerColumns; ++col)
+        {
+            *p++ = '\t';
+            p = FormatInteger(static_cast<int64_t>(*pValue++), p);
+        }
+        for (int col = integerColumns; col < columns; ++col)
+        {
+            *p++ = '\t';
+            p = FormatNumber(*pValue++, p);
+        }
+        *p++ = '\n';
+    }
+    mText.resize(p - mText.data());
+}
+
+void TableWriter::Private::Flush()
+{
+    if (mRows == 0)
+        return;
+    size_t values = mRows * mColumns, parts = 1;
+    if (values >= 2 * cMinValuesPerThread)
+        parts = std::min<size_t>(Threads(), values / cMinValuesPerThread);
+    if (parts < 1)
+        parts = 1;
+    mParts.resize(parts);
+    while (mThreads.size() < parts - 1)
+        mThreads.push_back(new ReusableThread);
+
+    size_t begin = 0;
+    for (size_t i = 0; i < parts; ++i)
+    {
+        Part &part = mParts[i];
+        part.mpParent = this;
+        part.mBegin = begin;
+        part.mEnd = (mRows * (i + 1)) / parts;
+        begin = part.mEnd;
+    }
+    // The calling thread formats the first part while worker threads format the others.
+    std::vector<bool> running(parts, false);
+    for (size_t i = 1; i < parts; ++i)
+        running[i] = mThreads[i - 1]->Run(mParts[i]);
+    mParts[0].Run();
+    for (size_t i = 1; i < parts; ++i)
+        if (running[i])
+            mThreads[i - 1]->Wait();
+        else
+            mParts[i].Run();
+    for (const auto &part : mParts)
+        mrOutput.write(part.mText.data(), part.mText.size());
+    mRows = 0;
+}
+
+TableWriter::TableWriter(std::ostream &os, int integerColumns, int columns)
+    : p(new Private(os, integerColumns, columns))
+{
+    size_t rows = cBatchValues / (columns > 0 ? columns : 1);
+    p->mValues.resize((rows > 0 ? rows : 1) * columns);
+}
+
+TableWriter::~TableWriter()
+{
+    p->Flush();
+    delete p;
+}
+
+double *TableWriter::AddRow()
+{
+    if ((p->mRows + 1) * p->mColumns > p->mValues.size())
+        p->Flush();
+    return p->mValues.data() + p->mRows++ * p->mColumns;
+}
+
+TableWriter &TableWriter::Flush()
+{
+    p->Flush();
+    return *this;
+}
+
+} // namespace Conversion
@@ -0,0 +1,77 @@
+////////////////////////////////////////////////////////////////////
+// $Id$
+// Author: BCI2000 team
+// Description: Functionality shared by the command line converters:
+//   Fast formatting of numbers into text, and a table writer that
+//   formats batches of rows in parallel, and writes them in order.
+//   The number of threads is set by the --threads option common to
+//   all command line tools.
+//
+// $BEGIN_BCI2000_LICENSE$
+//
+// This file is part of BCI2000, a platform for real-time bio-signal research.
+// [ Copyright (C) 2000-2022: BCI2000 team and many external contributors ]
+//
+// BCI2000 is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// BCI2000 is distributed in the hope that it will be useful, but
+//                         WITHOUT ANY WARRANTY
+// - without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+// A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// $END_BCI2000_LICENSE$
+////////////////////////////////////////////////////////////////////
+#ifndef BCI_CONVERT_H
+#define BCI_CONVERT_H
+
+#include <cstdint>
+#include <iostream>
+
+namespace Conversion
+{
+// Number of threads to use for conversion, 0 for the number of processors.
+void SetThreads(int);
+int Threads();
+
+// Format a number into a buffer of at least cMaxNumberLength characters,
+// returning a pointer past the last character written.
+// The result is identical to the output of a std::ostream at default precision.
+enum
+{
+    cMaxNumberLength = 32
+};
+char *FormatNumber(double, char *);
+char *FormatInteger(int64_t, char *);
+
+// Writes rows of tab-separated numbers, each row beginning with a tab.
+// The first columns of each row are written as integers.
+class TableWriter
+{
+  public:
+    TableWriter(std::ostream &, int integerColumns, int columns);
+    ~TableWriter();
+
+  private:
+    TableWriter(const TableWriter &);
+    TableWriter &operator=(const TableWriter &);
+
+  public:
+    // Returns storage for the values of the next row.
+    double *AddRow();
+    // Formats and writes all rows added so far.
+    TableWriter &Flush();
+
+  private:
+    struct Private;
+    Private *p;
+};
+
+} // namespace Conversion
+
+#endif // BCI_CONVERT_H
@@ -0,0 +1,200 @@
+////////////////////////////////////////////////////////////////////
+// $Id$
+// Author: BCI2000 team
+// Description: A benchmark for the text conversion used by the
+//          command line converters. Formats a table of synthetic
+//          state and signal values with std::ostream, with the
+//          converters' number formatting, and with the parallel
+//          table writer at increasing numbers of threads, and
+//          writes throughput to the standard output in JSON format.
+//
+// $BEGIN_BCI2000_LICENSE$
+//
+// This file is part of BCI2000, a platform for real-time bio-signal research.
+// [ Copyright (C) 2000-2022: BCI2000 team and many external contributors ]
+//
+// BCI2000 is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// BCI2000 is distributed in the hope that it will be useful, but
+//                         WITHOUT ANY WARRANTY
+// - without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+// A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// $END_BCI2000_LICENSE$
+////////////////////////////////////////////////////////////////////
+#include "TimeUtils.h"
+#include "bci_convert.h"
+#include "bci_tool.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <random>
+#include <vector>
+
+std::string ToolInfo[] = {
+    "bci_convert_benchmark",
+    "Measure the throughput of text conversion in the command line converters.",
+    "Formats a table of synthetic state and signal values, as written by bci_stream2table,\n"
+    "using std::ostream, using the converters' number formatting, and using the parallel\n"
+    "table writer with 1 up to the number of threads given by the --threads option.\n"
+    "Output is discarded, and throughput is written to standard output in JSON format.",
+    "text",
+    "-n<N>,    --rows=<N>            Number of table rows, defaults to 100000",
+    "-c<N>,    --columns=<N>         Number of signal columns, defaults to 64",
+    "-s<N>,    --states=<N>          Number of state columns, defaults to 8",
+    ""};
+
+namespace
+{
+// Counts and discards its output.
+class NullBuf : public std::streambuf
+{
+  public:
+    NullBuf() : mCount(0)
+    {
+    }
+    int64_t Count() const
+    {
+        return mCount;
+    }
+
+  protected:
+    int overflow(int c) override
+    {
+        ++mCount;
+        return traits_type::not_eof(c);
+    }
+    std::streamsize xsputn(const char *, std::streamsize n) override
+    {
+        mCount += n;
+        return n;
+    }
+
+  private:
+    int64_t mCount;
+};
+
+struct Result
+{
+    std::string method;
+    int threads;
+    double seconds;
+    int64_t bytes;
+};
+
+} // namespace
+
+ToolResult ToolInit()
+{
+    return noError;
+}
+
+ToolResult ToolMain(Streambuf &, Streambuf &out, OptionSet &arOptions)
+{
+    int rows = ::atoi(arOptions.getopt("-n|--rows", "100000").c_str()),
+        columns = ::atoi(arOptions.getopt("-c|--columns", "64").c_str()),
+        states = ::atoi(arOptions.getopt("-s|--states", "8").c_str());
+    if (!arOptions.empty() || rows < 1 || columns < 0 || states < 0 || columns + states < 1)
+        return illegalOption;
+
+    // Signal values resemble calibrated EEG, state values are small integers.
+    int width = states + columns;
+    std::vector<double> table(size_t(rows) * width);
+    std::mt19937 rng(1);
+    std::normal_distribution<double> signal(0, 20);
+    std::uniform_int_distribution<int> state(0, 255);
+    for (int row = 0; row < rows; ++row)
+    {
+        double *p = &table[size_t(row) * width];
+        for (int col = 0; col < states; ++col)
+            *p++ = state(rng);
+        for (int col = 0; col < columns; ++col)
+            *p++ = signal(rng);
+    }
+
+    std::vector<Result> results;
+    {
+        NullBuf buf;
+        std::ostream os(&buf);
+        Time t0 = TimeUtils::MonotonicTime();
+        const double *p = table.data();
+        for (int row = 0; row < rows; ++row)
+        {
+            for (int col = 0; col < states; ++col)
+                os << "\t" << static_cast<int64_t>(*p++);
+            for (int col = 0; col < columns; ++col)
+                os << "\t" << *p++;
+            os << "\n";
+        }
+        Result r = {"ostream", 1, (TimeUtils::MonotonicTime() - t0).Seconds(), buf.Count()};
+        results.push_back(r);
+    }
+    {
+        NullBuf buf;
+        std::ostream os(&buf);
+        Time t0 = TimeUtils::MonotonicTime();
+        const double *p = table.data();
+        std::vector<char> line(width * (Conversion::cMaxNumberLength + 1) + 1);
+        for (int row = 0; row < rows; ++row)
+        {
+            char *q = line.data();
+            for (int col = 0; col < states; ++col)
+            {
+                *q++ = '\t';
+                q = Conversion::FormatInteger(static_cast<int64_t>(*p++), q);
+            }
+            for (int col = 0; col < columns; ++col)
+            {
+                *q++ = '\t';
+                q = Conversion::FormatNumber(*p++, q);
+            }
+            *q++ = '\n';
+            os.write(line.data(), q - line.data());
+        }
+        Result r = {"FormatNumber", 1, (TimeUtils::MonotonicTime() - t0).Seconds(), buf.Count()};
+        results.push_back(r);
+    }
+    std::vector<int> threadCounts;
+    for (int n = 1; n < Conversion::Threads(); n *= 2)
+        threadCounts.push_back(n);
+    threadCounts.push_back(Conversion::Threads());
+    for (int threads : threadCounts)
+    {
+        Conversion::SetThreads(threads);
+        NullBuf buf;
+        std::ostream os(&buf);
+        Time t0 = TimeUtils::MonotonicTime();
+        {
+            Conversion::TableWriter writer(os, states, width);
+            const double *p = table.data();
+            for (int row = 0; row < rows; ++row, p += width)
+                std::copy(p, p + width, writer.AddRow());
+        }
+        Result r = {"TableWriter", threads, (TimeUtils::MonotonicTime() - t0).Seconds(), buf.Count()};
+        results.push_back(r);
+    }
+
+    Tiny::OStream output(out);
+    output << std::setprecision(6) << "{\n"
+           << "  \"rows\": " << rows << ",\n"
+           << "  \"stateColumns\": " << states << ",\n"
+           << "  \"signalColumns\": " << columns << ",\n"
+           << "  \"results\": [";
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        const Result &r = results[i];
+        output << (i ? ",\n    " : "\n    ") << "{ \"method\": \"" << r.method << "\", \"threads\": " << r.threads
+               << ", \"seconds\": " << r.seconds << ", \"bytes\": " << r.bytes
+               << ", \"valuesPerSecond\": " << double(rows) * width / r.seconds
+               << ", \"megabytesPerSecond\": " << r.bytes / r.seconds / (1 << 20)
+               << ", \"speedup\": " << results.front().seconds / r.seconds << " }";
+    }
+    output << "\n  ]\n}" << std::endl;
+    return output ? noError : fileIOError;
+}
@@ -392,250 +392,48 @@ ToolResult ToolMain(Streambuf &inbuf, Streambuf &outbuf, OptionSet &options)
                     output.Send(inputProperties);
             }
 
-            int curSample = 0;
+            // Read the file block by block, decoding all channels of a block at once.
+            int64_t numSamples = file.NumSamples(), sample = 0;
             int nBlocksRead = 0, nBlocksTransmitted = 0;
             GenericSignal inputSignal(inputProperties);
+            SignalProperties outputProperties(inputProperties);
+            outputProperties.SetType(SignalType::float32);
+            GenericSignal outputSignal(outputProperties);
 
-            int sampleCount = 0;
-            ///////////////////////
-            // Derive a code on the basis of whether we want to transmit states, data or calibrated data
-            // Choose a suitable case in the switch statement to transfer the data accordingly
-            // Saves time as compared to checking for these states in while loop everytime
-            // Bit(Possible values) - Transmit States(0/1), Transmit Data(0/1), CalibrateData(0/1)
-            // There are six possible cases -
-            // 1. Transmit States(0), Transmit Data(0), CalibrateData(0) - 0
-            // 2. Transmit States(0), Transmit Data(1), CalibrateData(0) - 2
-            // 3. Transmit States(0), Transmit Data(1), CalibrateData(1) - 3
-            // 4. Transmit States(1), Transmit Data(0), CalibrateData(0) - 4
-            // 5. Transmit States(1), Transmit Data(1), CalibrateData(0) - 6
-            // 6. Transmit States(1), Transmit Data(1), CalibrateData(1) - 7
-            // It's no use to calibrateData if we are not transmitting the data. Hence, omitting the two cases where
-            // Transmit Data(0), CalibrateData(1)
-            ///////////////////////
-            int switchCase = 0;
-            if (transmitStates)
-            {
-                if (transmitData)
-                {
-                    switchCase = calibrateData ? 7 : 6; // Transmit States(1), Transmit Data(1), CalibrateData(1) - 7;
-                                                        // Transmit States(1), Transmit Data(1), CalibrateData(0) - 6;
-                }
-                else
-                {
-                    switchCase = 4;
-                }
-            }
-            else
-            {
-                if (transmitData)
-                {
-                    switchCase = calibrateData ? 3 : 2;
-                }
-                else
-                {
-                    switchCase = 0;
-                }
-            }
-
-            switch (switchCase)
+            while (sample + sampleBlockSize <= numSamples && (duration < 0.0 || nBlocksTransmitted < duration))
             {
-            case 0: // Transmit States(0), Transmit Data(0), CalibrateData(0) - 0
-                while (sampleCount < file.NumSamples() && (duration < 0.0 || nBlocksTransmitted < duration))
-                {
-                    for (int i = 0; i < sourceCh; ++i)
-                        inputSignal.SetValue(i, curSample, file.RawValue(i, sampleCount));
-
-                    file.ReadStateVector(sampleCount);
-                    ::memcpy(statevector.Data(curSample), file.StateVector()->Data(), stateVectorLength);
-
-                    if (++curSample == sampleBlockSize)
-                    {
-                        curSample = 0;
-                        if (++nBlocksRead > offset)
-                        {
-                            nBlocksTransmitted++;
-                        }
-                    }
-                    ++sampleCount;
-                }
-                break;
-            case 2: // Transmit States(0), Transmit Data(1), CalibrateData(0) - 2
-                while (sampleCount < file.NumSamples() && (duration < 0.0 || nBlocksTransmitted < duration))
+                if (++nBlocksRead > offset)
                 {
-                    for (int i = 0; i < sourceCh; ++i)
-                        inputSignal.SetValue(i, curSample, file.RawValue(i, sampleCount));
-
-                    file.ReadStateVector(sampleCount);
-                    ::memcpy(statevector.Data(curSample), file.StateVector()->Data(), stateVectorLength);
-
-                    if (++curSample == sampleBlockSize)
+                    if (transmitStates)
                     {
-                        curSample = 0;
-                        if (++nBlocksRead > offset)
+                        for (int i = 0; i < sampleBlockSize; ++i)
                         {
-                            output.Send(inputSignal);
-                            nBlocksTransmitted++;
+                            file.ReadStateVector(sample + i);
+                            ::memcpy(statevector.Data(i), file.StateVector()->Data(), stateVectorLength);
                         }
+                        output.Send(statevector);
                     }
-                    ++sampleCount;
-                }
-                break;
-            case 3: // Transmit States(0), Transmit Data(1), CalibrateData(1) - 3
-                while (sampleCount < file.NumSamples() && (duration < 0.0 || nBlocksTransmitted < duration))
-                {
-                    for (int i = 0; i < sourceCh; ++i)
-                        inputSignal.SetValue(i, curSample, file.RawValue(i, sampleCount));
-
-                    file.ReadStateVector(sampleCount);
-                    ::memcpy(statevector.Data(curSample), file.StateVector()->Data(), stateVectorLength);
-
-                    if (++curSample == sampleBlockSize)
+                    if (transmitData)
                     {
-                        curSample = 0;
-                        if (++nBlocksRead > offset)
+                        file.ReadRawSignal(sample, inputSignal);
+                        if (calibrateData)
                         {
-                            SignalProperties outputProperties(inputProperties);
-                            outputProperties.SetType(SignalType::float32);
-                            GenericSignal outputSignal(outputProperties);
+                            const GenericSignal::ValueType *pIn = inputSignal.ConstData();
+                            GenericSignal::ValueType *pOut = outputSignal.MutableData();
                             for (int i = 0; i < sourceCh; ++i)
                                 for (int j = 0; j < sampleBlockSize; ++j)
-                                    outputSignal(i, j) = (inputSignal(i, j) - offsets[i]) * gains[i];
-                            // Send the data.
+                                    *pOut++ = (*pIn++ - offsets[i]) * gains[i];
                             output.Send(outputSignal);
-                            nBlocksTransmitted++;
-                        }
-                    }
-                    ++sampleCount;
-                }
-                break;
-            case 4: // Transmit States(1), Transmit Data(0), CalibrateData(0) - 4
-                while (sampleCount < file.NumSamples() && (duration < 0.0 || nBlocksTransmitted < duration))
-                {
-                    for (int i = 0; i < sourceCh; ++i)
-                        inputSignal.SetValue(i, curSample, file.RawValue(i, sampleCount));
-
-                    file.ReadStateVector(sampleCount);
-                    ::memcpy(statevector.Data(curSample), file.StateVector()->Data(), stateVectorLength);
-
-                    if (++curSample == sampleBlockSize)
-                    {
-                        curSample = 0;
-                        if (++nBlocksRead > offset)
-                        {
-                            output.Send(statevector);
-                            nBlocksTransmitted++;
                         }
-                    }
-                    ++sampleCount;
-                }
-                break;
-            case 6: // Transmit States(1), Transmit Data(1), CalibrateData(0) - 6
-                while (sampleCount < file.NumSamples() && (duration < 0.0 || nBlocksTransmitted < duration))
-                {
-                    for (int i = 0; i < sourceCh; ++i)
-                        inputSignal.SetValue(i, curSample, file.RawValue(i, sampleCount));
-
-                    file.ReadStateVector(sampleCount);
-                    ::memcpy(statevector.Data(curSample), file.StateVector()->Data(), stateVectorLength);
-
-                    if (++curSample == sampleBlockSize)
-                    {
-                        curSample = 0;
-                        if (++nBlocksRead > offset)
-                        {
-                            output.Send(statevector);
+                        else
                             output.Send(inputSignal);
-                            nBlocksTransmitted++;
-                        }
-                    }
-                    ++sampleCount;
-                }
-                break;
-            case 7: // Transmit States(1), Transmit Data(1), CalibrateData(1) - 7
-                while (sampleCount < file.NumSamples() && (duration < 0.0 || nBlocksTransmitted < duration))
-                {
-                    for (int i = 0; i < sourceCh; ++i)
-                        inputSignal.SetValue(i, curSample, file.RawValue(i, sampleCount));
-
-                    file.ReadStateVector(sampleCount);
-                    ::memcpy(statevector.Data(curSample), file.StateVector()->Data(), stateVectorLength);
-
-                    if (++curSample == sampleBlockSize)
-                    {
-                        curSample = 0;
-                        if (++nBlocksRead > offset)
-                        {
-                            output.Send(statevector);
-                            SignalProperties outputProperties(inputProperties);
-                            outputProperties.SetType(SignalType::float32);
-                            GenericSignal outputSignal(outputProperties);
-                            for (int i = 0; i < sourceCh; ++i)
-                                for (int j = 0; j < sampleBlockSize; ++j)
-                                    outputSignal(i, j) = (inputSignal(i, j) - offsets[i]) * gains[i];
-                            // Send the data.
-                            output.Send(outputSignal);
-                            nBlocksTransmitted++;
-                        }
                     }
-                    ++sampleCount;
+                    nBlocksTransmitted++;
                 }
-                break;
-            default:
-                std::cerr << "Incorrect states for transmitStates, transmitData and calibrateData" << std::endl;
-                return illegalOption;
-                break;
+                sample += sampleBlockSize;
             }
-            /*
-            while (sampleCount < file.NumSamples() && (duration < 0.0 || nBlocksTransmitted < duration))
-            {
-                beginForLoopTime = chrono::high_resolution_clock::now();
-                for (int i = 0; i < sourceCh; ++i)
-                    inputSignal.SetValue(i, curSample, file.RawValue(i, sampleCount));
-                endForLoopTime = chrono::high_resolution_clock::now();
-
-                file.ReadStateVector(sampleCount);
-                ::memcpy(statevector.Data(curSample), file.StateVector()->Data(), stateVectorLength);
-                endInReadTime = chrono::high_resolution_clock::now();
-
-
-                if (++curSample == sampleBlockSize)
-                {
-                    curSample = 0;
-                    if (++nBlocksRead > offset)
-                    {
-                        if (transmitStates)
-                        {
-                            output.Send(statevector);
-                        }
-                        if (transmitData)
-                        {
-                            if (calibrateData)
-                            {
-                                SignalProperties outputProperties(inputProperties);
-                                outputProperties.SetType(SignalType::float32);
-                                GenericSignal outputSignal(outputProperties);
-                                for (int i = 0; i < sourceCh; ++i)
-                                    for (int j = 0; j < sampleBlockSize; ++j)
-                                        outputSignal(i, j) = (inputSignal(i, j) - offsets[i]) * gains[i];
-                                // Send the data.
-                                output.Send(outputSignal);
-                            }
-                            else
-                                output.Send(inputSignal);
-                        }
-                        nBlocksTransmitted++;
-                    }
-                }
-                ++sampleCount;
-                ++niter;
-                endOuterIfTime = chrono::high_resolution_clock::now();
-                totalForLoopTime += chrono::duration_cast<chrono::nanoseconds>(endForLoopTime -
-            beginForLoopTime).count(); totalInReadTime += chrono::duration_cast<chrono::nanoseconds>(endInReadTime -
-            endForLoopTime).count(); totalOuterIfTime += chrono::duration_cast<chrono::nanoseconds>(endOuterIfTime -
-            endInReadTime).count();
-            }*/
 
-            if (curSample != 0)
+            if (sample < numSamples && (duration < 0.0 || nBlocksTransmitted < duration))
             {
                 std::cerr << "Non-integer number of data blocks in input" << std::endl;
                 result = illegalInput;
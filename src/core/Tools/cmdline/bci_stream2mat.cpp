@@ -40,6 +40,7 @@
 #include <iostream>
 #include <set>
 #include <string>
+#include <vector>
 
 std::string ToolInfo[] = {"bci_stream2mat", "Convert a binary BCI2000 stream into a matlab .mat file",
                           "Reads a BCI2000 compliant binary stream from standard input, "
@@ -94,7 +95,10 @@ class StreamToMat : public MessageChannel
     SignalProperties mSignalProperties;
     typedef std::set<std::string> StringSet; // A set is a sorted container of unique values.
     StringSet mStateNames;
+    StateVector::ColumnPlan mStatePlan;
+    std::vector<State::ValueType> mStateValues;
     size_t mDataCols;
+    std::vector<float> mDataColumn;
     std::streamoff mDataElementSizePos, mDataColsPos, mDataSizePos;
 
     std::ostream &Output()
@@ -326,17 +330,30 @@ void StreamToMat::WriteHeader()
 }
 
 void StreamToMat::WriteData(const GenericSignal &s)
-{
+{ // Each column is assembled in memory, and written at once.
+    mDataColumn.clear();
     if (mpStatevector == NULL)
-        for (size_t i = 0; i < mStateNames.size(); ++i)
-            WriteFloat32(0);
+        mDataColumn.resize(mStateNames.size(), 0);
     else
-        for (StringSet::const_iterator i = mStateNames.begin(); i != mStateNames.end(); ++i)
-            WriteFloat32(static_cast<float>(mpStatevector->StateValue(*i)));
+    {
+        if (static_cast<size_t>(mStatePlan.Columns()) != mStateNames.size())
+        {
+            for (StringSet::const_iterator i = mStateNames.begin(); i != mStateNames.end(); ++i)
+                if (mStatelist.Exists(*i))
+                    mStatePlan.Add(mStatelist.ByName(*i));
+                else
+                    mStatePlan.Add(0, 0);
+            mStateValues.resize(mStatePlan.Columns());
+        }
+        mpStatevector->ExtractColumns(mStatePlan, 0, 1, mStateValues.data());
+        for (State::ValueType value : mStateValues)
+            mDataColumn.push_back(static_cast<float>(value));
+    }
 
-    for (int i = 0; i < s.Channels(); ++i)
-        for (int j = 0; j < s.Elements(); ++j)
-            WriteFloat32(static_cast<float>(s(i, j)));
+    const GenericSignal::ValueType *pData = s.ConstData();
+    for (int i = 0; i < s.Channels() * s.Elements(); ++i)
+        mDataColumn.push_back(static_cast<float>(pData[i]));
+    Output().write(reinterpret_cast<const char *>(mDataColumn.data()), mDataColumn.size() * sizeof(float));
     ++mDataCols;
 }
 
@@ -360,6 +377,7 @@ bool StreamToMat::OnState(std::istream &arIn)
     {
         mStatelist.Delete(s.Name());
         mStatelist.Add(s);
+        mStatePlan.Clear();
         if (mpStatevector)
         {
             delete mpStatevector;
@@ -391,6 +409,7 @@ bool StreamToMat::OnVisSignalProperties(std::istream &arIn)
 
     // Write a header first.
     mStateNames.clear();
+    mStatePlan.Clear();
     for (const auto &s : mStatelist)
         if (s.Kind() != State::Padding && !s.Name().empty() && ::isalpha(s.Name().front()))
             mStateNames.insert(s.Name());
@@ -31,10 +31,14 @@
 #include "State.h"
 #include "StateList.h"
 #include "StateVector.h"
+#include "bci_convert.h"
 #include "bci_tool.h"
 
+#include <algorithm>
 #include <iostream>
+#include <memory>
 #include <string>
+#include <vector>
 
 std::string ToolInfo[] = {
     "bci_stream2table",
@@ -56,6 +60,7 @@ class StreamToTable : public MessageChannel
     }
     ~StreamToTable()
     {
+        mpTable.reset();
         delete mpStatevector;
     }
     void Finish();
@@ -69,13 +74,17 @@ class StreamToTable : public MessageChannel
 
   private:
     void WriteOut(const GenericSignal &);
+    void BuildStatePlan();
 
     Tiny::OStream mOutput;
+    std::unique_ptr<Conversion::TableWriter> mpTable;
     StateList mStatelist;
     StateVector *mpStatevector;
     SignalProperties mSignalProperties;
     typedef std::set<std::string> StringSet; // A set is a sorted container of unique values.
     StringSet mStateNames;
+    StateVector::ColumnPlan mStatePlan;
+    std::vector<State::ValueType> mStateValues;
     bool mInitialized, mWriteoutPending;
 };
 
@@ -101,6 +110,9 @@ void StreamToTable::Finish()
 {
     if (mWriteoutPending)
         WriteOut(GenericSignal());
+    if (mpTable)
+        mpTable->Flush();
+    mOutput.flush();
 }
 
 bool StreamToTable::OnParam(std::istream &is)
@@ -121,6 +133,8 @@ bool StreamToTable::OnState(std::istream &is)
             delete mpStatevector;
             mpStatevector = new StateVector(mStatelist);
         }
+        if (mInitialized)
+            BuildStatePlan();
     }
     return true;
 }
@@ -146,11 +160,9 @@ bool StreamToTable::OnStateVector(std::istream &is)
     static GenericSignal nullSignal;
     if (mWriteoutPending)
         WriteOut(nullSignal);
-    if (mpStatevector)
-    {
+    if (!mpStatevector)
         mpStatevector = new StateVector(mStatelist);
-        mpStatevector->Unserialize(is);
-    }
+    mpStatevector->Unserialize(is);
     mWriteoutPending = true;
     return true;
 }
@@ -167,28 +179,43 @@ void StreamToTable::WriteOut(const GenericSignal &inSignal)
             mStateNames.insert(state.Name());
         for (StringSet::const_iterator i = mStateNames.begin(); i != mStateNames.end(); ++i)
             mOutput << "\t" << *i;
+        BuildStatePlan();
         for (int i = 0; i < inSignal.Channels(); ++i)
             for (int j = 0; j < inSignal.Elements(); ++j)
                 mOutput << "\tSignal(" << mSignalProperties.ChannelLabels()[i] << ","
                         << mSignalProperties.ElementLabels()[j] << ")";
-        mOutput << std::endl;
+        mOutput << '\n';
+        mpTable.reset(new Conversion::TableWriter(mOutput, static_cast<int>(mStateValues.size()),
+                                                  static_cast<int>(mStateValues.size()) +
+                                                      inSignal.Channels() * inSignal.Elements()));
         mInitialized = true;
     }
     if (inSignal.Properties() != mSignalProperties)
         bcierr << "Ignored signal with inconsistent properties";
     else
-    {
+    { // Rows are formatted and written in batches by the table writer.
+        double *pRow = mpTable->AddRow();
         if (mpStatevector)
-            for (StringSet::const_iterator i = mStateNames.begin(); i != mStateNames.end(); ++i)
-                mOutput << "\t" << mpStatevector->StateValue(i->c_str());
+            mpStatevector->ExtractColumns(mStatePlan, 0, 1, mStateValues.data());
         else
-            for (StringSet::const_iterator i = mStateNames.begin(); i != mStateNames.end(); ++i)
-                mOutput << "\t0";
+            std::fill(mStateValues.begin(), mStateValues.end(), 0);
+        for (State::ValueType value : mStateValues)
+            *pRow++ = static_cast<double>(value);
 
         for (int i = 0; i < inSignal.Channels(); ++i)
             for (int j = 0; j < inSignal.Elements(); ++j)
-                mOutput << "\t" << inSignal(i, j);
-        mOutput << std::endl;
+                *pRow++ = inSignal(i, j);
     }
     mWriteoutPending = false;
 }
+
+void StreamToTable::BuildStatePlan()
+{
+    mStatePlan.Clear();
+    for (StringSet::const_iterator i = mStateNames.begin(); i != mStateNames.end(); ++i)
+        if (mStatelist.Exists(*i))
+            mStatePlan.Add(mStatelist.ByName(*i));
+        else
+            mStatePlan.Add(0, 0);
+    mStateValues.resize(mStatePlan.Columns());
+}
@@ -25,6 +25,7 @@
 // $END_BCI2000_LICENSE$
 ////////////////////////////////////////////////////////////////////
 #include "bci_tool.h"
+#include "bci_convert.h"
 #include "ExceptionCatcher.h"
 #include "Files.h"
 #include "VersionInfo.h"
@@ -78,8 +79,9 @@ int main(int argc, char **argv)
         std::string inputFile;
         std::string outputFile;
         int bufferSize;
+        int threads;
     } options = {
-        true, false, false, false, "", "", 0,
+        true, false, false, false, "", "", 0, 0,
     };
 
     if (toolOptions.findopt("-h|-H|--help|-?"))
@@ -110,6 +112,8 @@ int main(int argc, char **argv)
     options.bufferSize = ::atoi(buffer.c_str());
     if (options.bufferSize < 0)
         options.bufferSize *= -1;
+    options.threads = ::atoi(toolOptions.getopt("--threads", "0").c_str());
+    Conversion::SetThreads(options.threads);
 
     File inputFile;
     if (options.inputFile.empty() || options.inputFile == "-")
@@ -168,6 +172,7 @@ int main(int argc, char **argv)
             << "\t-i<file>, --input=<file>        Get input from <file>\n"
             << "\t-o<file>, --output=<file>       Write output to <file>\n"
             << "\t-b<size>, --buffer=<size>       Set IO buffer to <size>\n"
+            << "\t          --threads=<n>         Use <n> threads for conversion, 0 for all processors\n"
             << "\tWhen a minus character is given as a file name, it refers"
             << "\tto standard input/output";
         for (int i = firstOption; ToolInfo[i] != ""; ++i)
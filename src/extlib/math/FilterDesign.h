@@ -2,7 +2,8 @@
 // $Id: FilterDesign.h 6484 2022-01-03 16:59:03Z mellinger $
 // Author: juergen.mellinger@uni-tuebingen.de
 // Description: IIR filter design classes that design
-//       Butterworth, Chebyshev, or Resonator type digital filters.
+//       Butterworth, Chebyshev, or Resonator type digital filters,
+//       and a Kaiser windowed-sinc design for linear-phase FIR lowpass filters.
 //       Based on mkfilter.C written by
 //         A.J. Fisher, University of York   <fisher@minster.york.ac.uk>
 //         September 1992
@@ -32,7 +33,9 @@
 #ifndef FILTER_DESIGN_H
 #define FILTER_DESIGN_H
 
+#include "BCIStream.h"
 #include "Polynomials.h"
+#include <cmath>
 #include <complex>
 #include <vector>
 
@@ -129,6 +132,104 @@ class Resonator
     int mCharacter;
 };
 
+// Linear-phase FIR lowpass design by the window method.
+// Filter length and Kaiser window shape are chosen from transition width and
+// stopband attenuation using Kaiser's empirical formulas, unless a length is
+// specified explicitly. Coefficients are symmetric, of odd length, and
+// normalized to unit gain at DC.
+// Defined inline so FIR filters may be designed without linking FilterDesign.cpp.
+class WindowedSinc
+{
+  public:
+    WindowedSinc() : mCorner(0), mTransitionWidth(0), mAttenuation_dB(60), mLength(0)
+    {
+    }
+    WindowedSinc &Lowpass(Real corner) // -6dB point, in terms of the sampling rate
+    {
+        mCorner = corner;
+        return *this;
+    }
+    WindowedSinc &TransitionWidth(Real width) // in terms of the sampling rate
+    {
+        mTransitionWidth = width;
+        return *this;
+    }
+    WindowedSinc &Attenuation_dB(Real attenuation_dB) // stopband attenuation, positive
+    {
+        mAttenuation_dB = attenuation_dB;
+        return *this;
+    }
+    WindowedSinc &Length(int length) // overrides the length computed from transition width
+    {
+        mLength = length;
+        return *this;
+    }
+    int ActualLength() const;
+    std::vector<Real> Coefficients() const;
+
+  private:
+    static Real BesselI0(Real);
+
+    Real mCorner, mTransitionWidth, mAttenuation_dB;
+    int mLength;
+};
+
+inline int WindowedSinc::ActualLength() const
+{
+    int length = mLength;
+    if (length < 1)
+    {
+        if (mTransitionWidth <= 0 || mTransitionWidth >= 0.5)
+        {
+            bcierr << "Transition width must be > 0 and < 0.5";
+            return 1;
+        }
+        length = static_cast<int>(::ceil((mAttenuation_dB - 7.95) / (14.36 * mTransitionWidth))) + 1;
+    }
+    return length | 1;
+}
+
+inline std::vector<Real> WindowedSinc::Coefficients() const
+{
+    if (mCorner <= 0 || mCorner >= 0.5)
+    {
+        bcierr << "Corner frequency must be > 0 and < 0.5";
+        return std::vector<Real>(1, 1.0);
+    }
+    Real beta = 0;
+    if (mAttenuation_dB > 50)
+        beta = 0.1102 * (mAttenuation_dB - 8.7);
+    else if (mAttenuation_dB > 21)
+        beta = 0.5842 * ::pow(mAttenuation_dB - 21, 0.4) + 0.07886 * (mAttenuation_dB - 21);
+
+    const Real pi = 2.0 * ::acos(0.0);
+    const int length = ActualLength(), center = length / 2;
+    std::vector<Real> coeffs(length);
+    Real sum = 0, norm = BesselI0(beta);
+    for (int i = 0; i < length; ++i)
+    {
+        int n = i - center;
+        Real sinc = n == 0 ? 2 * mCorner : ::sin(2 * pi * mCorner * n) / (pi * n);
+        Real x = center > 0 ? Real(n) / center : 0;
+        coeffs[i] = sinc * BesselI0(beta * ::sqrt(1 - x * x)) / norm;
+        sum += coeffs[i];
+    }
+    for (auto &c : coeffs)
+        c /= sum;
+    return coeffs;
+}
+
+inline Real WindowedSinc::BesselI0(Real x)
+{ // Power series, converges quickly for the arguments that occur in window design.
+    Real sum = 1, term = 1, halfX = x / 2;
+    for (int k = 1; term > 1e-12 * sum; ++k)
+    {
+        term *= (halfX / k) * (halfX / k);
+        sum += term;
+    }
+    return sum;
+}
+
 // Compute direct form II transposed structure filter coefficients from
 // a transfer function.
 // The list returned corresponds to the coefficient vector arguments of the
@@ -141,7 +242,7 @@ template <class T> void ComputeCoefficients(const Ratpoly<Complex> &inTF, T &out
     Real normFactor = a.rbegin()->real();
     for (ComplexVector::const_reverse_iterator i = b.rbegin(); i != b.rend(); ++i)
         outInputCoeffs.push_back(i->real() / normFactor);
-    for (ComplexVector::const_reverse_iterator i = a.rbegin(); i != b.rend(); ++i)
+    for (ComplexVector::const_reverse_iterator i = a.rbegin(); i != a.rend(); ++i)
         outOutputCoeffs.push_back(i->real() / normFactor);
 }
 
@@ -46,7 +46,7 @@ template <typename T> class MEMPredictor : public LinearPredictor<T>
     void TransferFunction(const DataVector &, Ratpoly<T> &) const override;
 
   private:
-    mutable DataVector mWk1, mWk2;
+    mutable DataVector mWk1, mWk2, mCoeff, mWkm;
 };
 
 // Implementation
@@ -60,9 +60,14 @@ template <typename T> void MEMPredictor<T>::TransferFunction(const DataVector &i
     static const T eps = std::numeric_limits<T>::epsilon();
     size_t n = inData.size();
 
-    DataVector coeff, wkm;
-    coeff.resize(LinearPredictor<T>::mModelOrder + 1);
-    wkm.resize(coeff.size());
+    // Work buffers are kept across calls to avoid heap allocations.
+    DataVector &coeff = mCoeff, &wkm = mWkm;
+    if (coeff.size() != LinearPredictor<T>::mModelOrder + 1)
+        coeff.resize(LinearPredictor<T>::mModelOrder + 1);
+    coeff = 0;
+    if (wkm.size() != coeff.size())
+        wkm.resize(coeff.size());
+    wkm = 0;
 
     if (mWk1.size() != n)
         mWk1.resize(n);
@@ -127,7 +132,7 @@ template <typename T> void MEMPredictor<T>::TransferFunction(const DataVector &i
     for (size_t k = 1; k <= LinearPredictor<T>::mModelOrder; k++)
         coeff[k] *= -1;
 
-    outResult = Ratpoly<T>(Polynomial<T>(std::sqrt(meanPower)), Polynomial<T>::FromCoefficients(coeff));
+    outResult.AssignAllPole(std::sqrt(meanPower), coeff);
 }
 
 #endif // MEM_PREDICTOR_H
@@ -63,6 +63,9 @@ template <class T> class Polynomial
     static Polynomial FromRoots(const Vector &roots, const T &factor = 1);
     static Polynomial FromCoefficients(const Vector &coefficients);
     template <typename U> static Polynomial FromCoefficients(const std::valarray<U> &);
+    // In-place assignment, reusing storage allocated by previous assignments.
+    Polynomial &AssignConstant(const T &);
+    template <typename U> Polynomial &AssignCoefficients(const std::valarray<U> &);
 
     Polynomial &operator*=(const T &);
     Polynomial &operator*=(const Polynomial &);
@@ -108,6 +111,9 @@ template <class T> class Ratpoly // A rational expression with a polynomial nume
   public:
     Ratpoly(const T & = 1);
     Ratpoly(const Polynomial<T> &numerator, const Polynomial<T> &denominator);
+    // Assigns a constant numerator and a denominator given by its coefficients,
+    // reusing storage allocated by previous assignments.
+    template <typename U> Ratpoly &AssignAllPole(const T &numerator, const std::valarray<U> &denominatorCoefficients);
 
     Ratpoly &operator*=(const T &);
     Ratpoly &operator*=(const Polynomial<T> &);
@@ -177,6 +183,33 @@ Polynomial<T> Polynomial<T>::FromCoefficients(const std::valarray<U> &inCoeffici
     return Polynomial<T>(coefficients);
 }
 
+template <class T> Polynomial<T> &Polynomial<T>::AssignConstant(const T &factor)
+{
+    mRootsKnown = true;
+    mConstantFactor = factor;
+    mRoots.clear();
+    mCoefficients.clear();
+    return *this;
+}
+
+template <class T>
+template <class U>
+Polynomial<T> &Polynomial<T>::AssignCoefficients(const std::valarray<U> &inCoefficients)
+{
+    mRootsKnown = false;
+    mConstantFactor = 1;
+    mRoots.clear();
+    mCoefficients.resize(inCoefficients.size());
+    for (size_t i = 0; i < inCoefficients.size(); ++i)
+        mCoefficients[i] = inCoefficients[i];
+    if (mCoefficients.size() == 1)
+    {
+        mConstantFactor = mCoefficients[0];
+        mRootsKnown = true;
+    }
+    return *this;
+}
+
 template <class T> template <class R, class Z> R Polynomial<T>::DoEvaluate(const Z &z, int d) const
 {
     R result = 0;
@@ -299,6 +332,16 @@ Ratpoly<T>::Ratpoly(const Polynomial<T> &numerator, const Polynomial<T> &denomin
     Simplify();
 }
 
+template <class T>
+template <class U>
+Ratpoly<T> &Ratpoly<T>::AssignAllPole(const T &numerator, const std::valarray<U> &denominatorCoefficients)
+{
+    mNumerator.AssignConstant(numerator);
+    mDenominator.AssignCoefficients(denominatorCoefficients);
+    Simplify();
+    return *this;
+}
+
 template <class T> Ratpoly<T> &Ratpoly<T>::operator*=(const T &f)
 {
     mNumerator *= f;
@@ -0,0 +1,165 @@
+////////////////////////////////////////////////////////////////////////////////
+// $Id$
+// Author: BCI2000 team
+// Description: An FIR decimation filter.
+//   The filter's Coefficients property holds the FIR impulse response, which
+//   is typically obtained from FilterDesign::WindowedSinc; its Decimation
+//   property is the ratio of input to output sampling rates.
+//
+//   Output samples are only computed at the positions that are retained
+//   after decimation, i.e. at the last input sample of each group of
+//   Decimation input samples. This is equivalent in cost to a polyphase
+//   implementation, where each of the Decimation subfilters contributes
+//   Coefficients().size()/Decimation products to an output sample.
+//   Input samples are kept in a sample-major history buffer, so the
+//   innermost loop runs over adjacent channels and may be vectorized by
+//   the compiler.
+//
+//   The filter's Process() method computes an output signal from an input
+//   signal, and saves the last input samples for the next call to
+//   Process(). Thus, continuous processing may be achieved by calling
+//   Process() repeatedly.
+//   Process() is templatized for its argument signal type T. This type must
+//   provide the following member functions:
+//     T::Channels() to return the number of channels,
+//     T::Elements() to return the number of elements (samples),
+//     T::operator()(channel, sample) for read/write access.
+//   The number of output elements must not exceed the number of input
+//   elements divided by Decimation.
+//
+//   The filter's Initialize() method adapts the history buffer to the number
+//   of channels provided, and resets it to zero.
+//   As there is no feedback, NaNs in the input will not stall the filter but
+//   leave it after Coefficients().size() samples.
+//
+// $BEGIN_BCI2000_LICENSE$
+//
+// This file is part of BCI2000, a platform for real-time bio-signal research.
+// [ Copyright (C) 2000-2022: BCI2000 team and many external contributors ]
+//
+// BCI2000 is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// BCI2000 is distributed in the hope that it will be useful, but
+//                         WITHOUT ANY WARRANTY
+// - without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+// A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// $END_BCI2000_LICENSE$
+////////////////////////////////////////////////////////////////////////////////
+#ifndef POLYPHASE_DECIMATOR_H
+#define POLYPHASE_DECIMATOR_H
+
+#include "Debugging.h"
+#include <algorithm>
+#include <vector>
+
+template <typename Real> class PolyphaseDecimator
+{
+  public:
+    PolyphaseDecimator() : mDecimation(1), mChannels(0)
+    {
+        SetCoefficients(std::vector<Real>(1, 1));
+    }
+
+    // Properties
+    const std::vector<Real> &Coefficients() const
+    {
+        return mCoefficients;
+    }
+    template <typename U> PolyphaseDecimator &SetCoefficients(const std::vector<U> &c)
+    {
+        mCoefficients.assign(c.begin(), c.end());
+        if (mCoefficients.empty())
+            mCoefficients.push_back(1);
+        mReversed.assign(mCoefficients.rbegin(), mCoefficients.rend());
+        return Initialize();
+    }
+    int Decimation() const
+    {
+        return mDecimation;
+    }
+    PolyphaseDecimator &SetDecimation(int d)
+    {
+        mDecimation = std::max(d, 1);
+        return *this;
+    }
+    int Channels() const
+    {
+        return mChannels;
+    }
+    PolyphaseDecimator &SetChannels(int c)
+    {
+        return Initialize(c);
+    }
+    // Group delay of a linear-phase filter, in input samples.
+    int Delay() const
+    {
+        return static_cast<int>(mCoefficients.size() - 1) / 2;
+    }
+
+    // Methods
+    PolyphaseDecimator &Initialize()
+    {
+        return Initialize(mChannels);
+    }
+    PolyphaseDecimator &Initialize(size_t inChannels)
+    {
+        mChannels = static_cast<int>(inChannels);
+        mHistory.clear();
+        mHistory.resize((mCoefficients.size() - 1) * mChannels, 0);
+        mAccumulator.clear();
+        mAccumulator.resize(mChannels, 0);
+        return *this;
+    }
+    template <typename T> PolyphaseDecimator &Process(const T &, T &);
+
+  private:
+    int mDecimation, mChannels;
+    std::vector<Real> mCoefficients, mReversed, mHistory, mAccumulator;
+};
+
+template <typename Real>
+template <typename T>
+inline PolyphaseDecimator<Real> &PolyphaseDecimator<Real>::Process(const T &Input, T &Output)
+{
+    Assert(Input.Channels() == mChannels);
+    Assert(Output.Elements() * mDecimation <= Input.Elements());
+    const int channels = mChannels, inSamples = Input.Elements(), outSamples = Output.Elements(),
+              length = static_cast<int>(mReversed.size()), historyLength = length - 1;
+
+    // Append input to the history buffer, transposing it into sample-major order.
+    mHistory.resize((historyLength + inSamples) * channels);
+    Real *pRow = mHistory.data() + historyLength * channels;
+    for (int sample = 0; sample < inSamples; ++sample, pRow += channels)
+        for (int ch = 0; ch < channels; ++ch)
+            pRow[ch] = Input(ch, sample);
+
+    Real *pAcc = mAccumulator.data();
+    const Real *pCoeff = mReversed.data();
+    for (int outSample = 0; outSample < outSamples; ++outSample)
+    {
+        std::fill(mAccumulator.begin(), mAccumulator.end(), 0);
+        const Real *pIn = mHistory.data() + (outSample + 1) * mDecimation * channels - channels;
+        for (int k = 0; k < length; ++k, pIn += channels)
+        {
+            const Real c = pCoeff[k];
+            for (int ch = 0; ch < channels; ++ch)
+                pAcc[ch] += c * pIn[ch];
+        }
+        for (int ch = 0; ch < channels; ++ch)
+            Output(ch, outSample) = pAcc[ch];
+    }
+
+    // Keep the most recent input samples for the next call.
+    std::copy(mHistory.begin() + inSamples * channels, mHistory.end(), mHistory.begin());
+    mHistory.resize(historyLength * channels);
+    return *this;
+}
+
+#endif // POLYPHASE_DECIMATOR_H
@@ -0,0 +1,371 @@
+////////////////////////////////////////////////////////////////////////////////
+// $Id$
+// Author: BCI2000 team
+// Description: A generator for synthetic EEG-like test signals, consisting of
+//   band-limited noise and event-related potentials (ERPs) that occur at
+//   random times.
+//
+//   Noise is white noise from a counter-based generator, i.e. each noise
+//   value is a hash of the seed, the sample index, and the channel index.
+//   Thus, output only depends on Seed and the other properties, but not on
+//   how samples are distributed across calls to Process().
+//   The noise is filtered by a second order Butterworth highpass at
+//   NoiseBand().first, and a second order Butterworth lowpass at
+//   NoiseBand().second (both in Hz). A corner of zero, or a lowpass corner
+//   at or above the Nyquist frequency, omits the respective filter.
+//   NoiseAmplitude is the RMS value of the filtered noise.
+//
+//   Events are a Poisson process with rate EventRate (in Hz). At each
+//   event, a fixed ERP template with P1, N1, and P3 components is added to
+//   all channels, scaled with ERPAmplitude (the P3 peak value) and a random
+//   per-channel gain between 0.5 and 1. Onsets() lists the onsets of events
+//   that occurred during the last call to Process(), as sample positions
+//   relative to its output.
+//
+//   Computation is done in sample-major order, so the innermost loops run
+//   over adjacent channels and may be vectorized by the compiler.
+//
+//   Process() is templatized for its output signal type T. This type must
+//   provide the following member functions:
+//     T::Channels() to return the number of channels,
+//     T::Elements() to return the number of elements (samples),
+//     T::operator()(channel, sample) for write access.
+//
+// $BEGIN_BCI2000_LICENSE$
+//
+// This file is part of BCI2000, a platform for real-time bio-signal research.
+// [ Copyright (C) 2000-2022: BCI2000 team and many external contributors ]
+//
+// BCI2000 is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// BCI2000 is distributed in the hope that it will be useful, but
+//                         WITHOUT ANY WARRANTY
+// - without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+// A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// $END_BCI2000_LICENSE$
+////////////////////////////////////////////////////////////////////////////////
+#ifndef SIGNAL_SYNTHESIZER_H
+#define SIGNAL_SYNTHESIZER_H
+
+#include "Debugging.h"
+#include "FilterDesign.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+class SignalSynthesizer
+{
+  public:
+    typedef double Real;
+
+    SignalSynthesizer()
+        : mSamplingRate(1), mChannels(0), mSeed(0), mNoiseBand(0, 0), mNoiseAmplitude(1), mEventRate(0),
+          mERPAmplitude(1), mSampleIndex(0), mNextEvent(0), mEventCount(0), mNoiseScale(0)
+    {
+    }
+
+    // Properties
+    Real SamplingRate() const
+    {
+        return mSamplingRate;
+    }
+    SignalSynthesizer &SetSamplingRate(Real r)
+    {
+        mSamplingRate = r;
+        return *this;
+    }
+    int Channels() const
+    {
+        return mChannels;
+    }
+    SignalSynthesizer &SetChannels(int c)
+    {
+        mChannels = c;
+        return *this;
+    }
+    uint32_t Seed() const
+    {
+        return mSeed;
+    }
+    SignalSynthesizer &SetSeed(uint32_t s)
+    {
+        mSeed = s;
+        return *this;
+    }
+    const std::pair<Real, Real> &NoiseBand() const
+    {
+        return mNoiseBand;
+    }
+    SignalSynthesizer &SetNoiseBand(Real low, Real high)
+    {
+        mNoiseBand = std::make_pair(low, high);
+        return *this;
+    }
+    Real NoiseAmplitude() const
+    {
+        return mNoiseAmplitude;
+    }
+    SignalSynthesizer &SetNoiseAmplitude(Real a)
+    {
+        mNoiseAmplitude = a;
+        return *this;
+    }
+    Real EventRate() const
+    {
+        return mEventRate;
+    }
+    SignalSynthesizer &SetEventRate(Real r)
+    {
+        mEventRate = r;
+        return *this;
+    }
+    Real ERPAmplitude() const
+    {
+        return mERPAmplitude;
+    }
+    SignalSynthesizer &SetERPAmplitude(Real a)
+    {
+        mERPAmplitude = a;
+        return *this;
+    }
+    // Number of samples produced since Initialize() or Reset().
+    int64_t SampleIndex() const
+    {
+        return mSampleIndex;
+    }
+    const std::vector<int> &Onsets() const
+    {
+        return mOnsets;
+    }
+
+    // Methods
+    // Applies properties, and resets the generator.
+    SignalSynthesizer &Initialize();
+    // Restarts output at sample index zero.
+    SignalSynthesizer &Reset();
+    template <typename T> SignalSynthesizer &Process(T &);
+
+  private:
+    // A 32 bit integer hash with good avalanche behavior ("lowbias32").
+    static uint32_t Hash(uint32_t x)
+    {
+        x ^= x >> 16;
+        x *= 0x7feb352dU;
+        x ^= x >> 15;
+        x *= 0x846ca68bU;
+        x ^= x >> 16;
+        return x;
+    }
+    // A uniform random value in [0, 1), drawn from a stream selected by key.
+    Real Uniform(uint32_t key, uint32_t index) const
+    {
+        return Hash(Hash(mSeed ^ key) + index) * (1.0 / 4294967296.0);
+    }
+    void NextEvent();
+    void AddSection(const FilterDesign::Butterworth &);
+    void ProcessSections(Real *, int);
+
+    struct Section
+    {
+        Real b0, b1, b2, a1, a2;
+        std::vector<Real> z1, z2;
+    };
+
+    Real mSamplingRate;
+    int mChannels;
+    uint32_t mSeed;
+    std::pair<Real, Real> mNoiseBand;
+    Real mNoiseAmplitude, mEventRate, mERPAmplitude;
+
+    int64_t mSampleIndex, mNextEvent;
+    uint32_t mEventCount;
+    Real mNoiseScale;
+    std::vector<Section> mSections;
+    std::vector<uint32_t> mChannelKeys;
+    std::vector<Real> mSpatialGains, mTemplate, mERP, mBuffer;
+    std::vector<int64_t> mActiveEvents;
+    std::vector<int> mOnsets;
+};
+
+inline SignalSynthesizer &SignalSynthesizer::Initialize()
+{
+    const Real nyquist = mSamplingRate / 2;
+    mSections.clear();
+    if (mNoiseBand.first > 0)
+        AddSection(FilterDesign::Butterworth().Order(2).Highpass(mNoiseBand.first / mSamplingRate));
+    if (mNoiseBand.second > 0 && mNoiseBand.second < nyquist)
+        AddSection(FilterDesign::Butterworth().Order(2).Lowpass(mNoiseBand.second / mSamplingRate));
+
+    // Normalize noise to unit RMS, using the energy of the filter's impulse response.
+    Real energy = 1;
+    if (!mSections.empty())
+    {
+        Real lowest = mNoiseBand.first > 0 ? mNoiseBand.first : mNoiseBand.second;
+        int length = static_cast<int>(std::min<Real>(50 * mSamplingRate / lowest, 1 << 24));
+        for (auto &s : mSections)
+        {
+            s.z1.assign(1, 0);
+            s.z2.assign(1, 0);
+        }
+        energy = 0;
+        for (int i = 0; i < std::max(length, 1024); ++i)
+        {
+            Real x = (i == 0);
+            ProcessSections(&x, 1);
+            energy += x * x;
+        }
+    }
+    // Uniform noise from signed 32 bit integers, having unit variance after scaling.
+    mNoiseScale = mNoiseAmplitude * ::sqrt(3.0 / energy) / 2147483648.0;
+
+    // ERP template, a sum of Gaussians with peak latencies and widths in seconds.
+    static const struct
+    {
+        Real latency, width, amplitude;
+    } components[] = {
+        {0.10, 0.015, 0.3},
+        {0.17, 0.025, -0.6},
+        {0.35, 0.070, 1.0},
+    };
+    mTemplate.resize(static_cast<size_t>(0.7 * mSamplingRate) + 1);
+    for (size_t i = 0; i < mTemplate.size(); ++i)
+    {
+        Real t = i / mSamplingRate, value = 0;
+        for (const auto &c : components)
+            value += c.amplitude * ::exp(-0.5 * (t - c.latency) * (t - c.latency) / (c.width * c.width));
+        mTemplate[i] = mERPAmplitude * value;
+    }
+    return Reset();
+}
+
+inline SignalSynthesizer &SignalSynthesizer::Reset()
+{
+    enum
+    {
+        channelKey = 1,
+        gainKey,
+    };
+    mChannelKeys.resize(mChannels);
+    mSpatialGains.resize(mChannels);
+    for (int ch = 0; ch < mChannels; ++ch)
+    {
+        mChannelKeys[ch] = Hash(mSeed ^ Hash(channelKey + ch));
+        mSpatialGains[ch] = 0.5 + 0.5 * Uniform(gainKey, ch);
+    }
+    for (auto &s : mSections)
+    {
+        s.z1.assign(mChannels, 0);
+        s.z2.assign(mChannels, 0);
+    }
+    mSampleIndex = 0;
+    mNextEvent = 0;
+    mEventCount = 0;
+    mActiveEvents.clear();
+    mOnsets.clear();
+    NextEvent();
+    return *this;
+}
+
+inline void SignalSynthesizer::NextEvent()
+{
+    enum
+    {
+        eventKey = 3
+    };
+    if (mEventRate <= 0)
+    {
+        mNextEvent = INT64_MAX;
+        return;
+    }
+    Real interval = -::log(1 - Uniform(eventKey, mEventCount++)) * mSamplingRate / mEventRate;
+    mNextEvent += std::max<int64_t>(static_cast<int64_t>(interval), 1);
+}
+
+inline void SignalSynthesizer::AddSection(const FilterDesign::Butterworth &inDesign)
+{
+    std::vector<FilterDesign::Real> b, a;
+    FilterDesign::ComputeCoefficients(inDesign.TransferFunction(), b, a);
+    Assert(b.size() == 3 && a.size() == 3);
+    Section s = {b[0] / a[0], b[1] / a[0], b[2] / a[0], a[1] / a[0], a[2] / a[0]};
+    mSections.push_back(s);
+}
+
+// Applies all filter sections to a row of channel values, using direct form II transposed.
+inline void SignalSynthesizer::ProcessSections(Real *ioRow, int inChannels)
+{
+    for (auto &s : mSections)
+    {
+        Real *z1 = s.z1.data(), *z2 = s.z2.data();
+        const Real b0 = s.b0, b1 = s.b1, b2 = s.b2, a1 = s.a1, a2 = s.a2;
+        for (int ch = 0; ch < inChannels; ++ch)
+        {
+            Real x = ioRow[ch], y = b0 * x + z1[ch];
+            z1[ch] = b1 * x - a1 * y + z2[ch];
+            z2[ch] = b2 * x - a2 * y;
+            ioRow[ch] = y;
+        }
+    }
+}
+
+template <typename T> inline SignalSynthesizer &SignalSynthesizer::Process(T &Output)
+{
+    Assert(Output.Channels() == mChannels);
+    const int channels = mChannels, samples = Output.Elements();
+
+    // ERP waveform, common to all channels up to spatial gain.
+    mOnsets.clear();
+    mERP.assign(samples, 0);
+    const int64_t end = mSampleIndex + samples;
+    for (; mNextEvent < end; NextEvent())
+    {
+        mActiveEvents.push_back(mNextEvent);
+        mOnsets.push_back(static_cast<int>(mNextEvent - mSampleIndex));
+    }
+    const int64_t templateLength = mTemplate.size();
+    for (size_t i = 0; i < mActiveEvents.size();)
+    {
+        int64_t onset = mActiveEvents[i];
+        for (int64_t n = std::max(onset, mSampleIndex); n < std::min(onset + templateLength, end); ++n)
+            mERP[n - mSampleIndex] += mTemplate[n - onset];
+        if (onset + templateLength <= end)
+            mActiveEvents.erase(mActiveEvents.begin() + i);
+        else
+            ++i;
+    }
+
+    mBuffer.resize(static_cast<size_t>(samples) * channels);
+    const uint32_t *pKeys = mChannelKeys.data();
+    const Real *pGains = mSpatialGains.data(), noiseScale = mNoiseScale;
+    Real *pRow = mBuffer.data();
+    for (int sample = 0; sample < samples; ++sample, pRow += channels)
+    {
+        uint64_t index = mSampleIndex + sample;
+        uint32_t sampleKey = Hash(static_cast<uint32_t>(index) ^ Hash(static_cast<uint32_t>(index >> 32) ^ mSeed));
+        for (int ch = 0; ch < channels; ++ch)
+            pRow[ch] = static_cast<int32_t>(Hash(sampleKey ^ pKeys[ch])) * noiseScale;
+        ProcessSections(pRow, channels);
+        const Real erp = mERP[sample];
+        if (erp != 0)
+            for (int ch = 0; ch < channels; ++ch)
+                pRow[ch] += erp * pGains[ch];
+    }
+    for (int ch = 0; ch < channels; ++ch)
+    {
+        const Real *pIn = mBuffer.data() + ch;
+        for (int sample = 0; sample < samples; ++sample, pIn += channels)
+            Output(ch, sample) = *pIn;
+    }
+    mSampleIndex = end;
+    return *this;
+}
+
+#endif // SIGNAL_SYNTHESIZER_H
@@ -73,22 +73,21 @@ template <typename T> class ObjectPtr
 
     explicit ObjectPtr(Record &record = sNullRecord) : mpRecord(&record)
     {
-        ++mpRecord->usage;
+        Acquire();
     }
     ObjectPtr(const ObjectPtr &other) : mpRecord(other.mpRecord)
     {
-        ++mpRecord->usage;
+        Acquire();
     }
     ~ObjectPtr()
     {
-        --mpRecord->usage;
-        Assert(mpRecord->usage >= 0);
+        Release();
     }
     ObjectPtr &operator=(const ObjectPtr &other)
     {
-        --mpRecord->usage;
+        Release();
         mpRecord = other.mpRecord;
-        ++mpRecord->usage;
+        Acquire();
         return *this;
     }
     T &operator()()
@@ -117,6 +116,22 @@ template <typename T> class ObjectPtr
     }
 
   private:
+    // The null record is shared by observers used from different threads,
+    // so its usage count is not maintained.
+    void Acquire()
+    {
+        if (mpRecord != &sNullRecord)
+            ++mpRecord->usage;
+    }
+    void Release()
+    {
+        if (mpRecord != &sNullRecord)
+        {
+            --mpRecord->usage;
+            Assert(mpRecord->usage >= 0);
+        }
+    }
+
     static Record sNullRecord;
     Record *mpRecord;
 };
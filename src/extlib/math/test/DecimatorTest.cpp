@@ -0,0 +1,224 @@
+////////////////////////////////////////////////////////////////////////////////
+// $Id$
+// Author: BCI2000 team
+// Description: Tests PolyphaseDecimator with a FilterDesign::WindowedSinc
+//   anti-aliasing filter for passband ripple, attenuation of aliasing
+//   components, and agreement with filtering followed by downsampling.
+//   Returns 0 if all tests pass.
+//
+// $BEGIN_BCI2000_LICENSE$
+//
+// This file is part of BCI2000, a platform for real-time bio-signal research.
+// [ Copyright (C) 2000-2022: BCI2000 team and many external contributors ]
+//
+// BCI2000 is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// BCI2000 is distributed in the hope that it will be useful, but
+//                         WITHOUT ANY WARRANTY
+// - without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+// A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// $END_BCI2000_LICENSE$
+////////////////////////////////////////////////////////////////////////////////
+#include "ExceptionCatcher.h"
+#include "FilterDesign.h"
+#include "PolyphaseDecimator.h"
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+using namespace std;
+
+#define OPTION(x, f) else if (!::stricmp(argv[i], "--" #x)) x = f(++i < argc ? argv[i] : "")
+
+// A minimal signal type satisfying the requirements of PolyphaseDecimator::Process().
+class Signal
+{
+  public:
+    Signal(int channels, int elements) : mChannels(channels), mElements(elements), mData(channels * elements)
+    {
+    }
+    int Channels() const
+    {
+        return mChannels;
+    }
+    int Elements() const
+    {
+        return mElements;
+    }
+    float &operator()(int ch, int sample)
+    {
+        return mData[ch * mElements + sample];
+    }
+    const float &operator()(int ch, int sample) const
+    {
+        return mData[ch * mElements + sample];
+    }
+
+  private:
+    int mChannels, mElements;
+    vector<float> mData;
+};
+
+const double m_pi = 2.0 * ::acos(0.0);
+
+// Feeds one sinusoid per channel through the decimator, and returns the
+// amplitude per channel of the output after the filter has settled.
+// Amplitudes are obtained from a least-squares fit of sine and cosine
+// components at the input frequency, evaluated at retained sample positions,
+// so the fit also applies to aliased output.
+vector<double> Amplitudes(PolyphaseDecimator<float> &decimator, const vector<double> &freqs, int blockSize,
+                          int blocks)
+{
+    int channels = static_cast<int>(freqs.size()), decimation = decimator.Decimation();
+    int settled = static_cast<int>(decimator.Coefficients().size()) / decimation + 1;
+    decimator.Initialize(channels);
+    Signal input(channels, blockSize), output(channels, blockSize / decimation);
+    vector<double> ss(channels, 0), cc(channels, 0), sc(channels, 0), ys(channels, 0), yc(channels, 0);
+    for (int block = 0, sample = 0, outSample = 0; block < blocks; ++block)
+    {
+        for (int i = 0; i < blockSize; ++i)
+            for (int ch = 0; ch < channels; ++ch)
+                input(ch, i) = static_cast<float>(::sin(2 * m_pi * freqs[ch] * (sample + i)));
+        decimator.Process(input, output);
+        for (int i = 0; i < output.Elements(); ++i, ++outSample)
+            if (outSample > settled)
+                for (int ch = 0; ch < channels; ++ch)
+                {
+                    double phase = 2 * m_pi * freqs[ch] * (sample + (i + 1) * decimation - 1),
+                           s = ::sin(phase), c = ::cos(phase), y = output(ch, i);
+                    ss[ch] += s * s;
+                    cc[ch] += c * c;
+                    sc[ch] += s * c;
+                    ys[ch] += y * s;
+                    yc[ch] += y * c;
+                }
+        sample += blockSize;
+    }
+    vector<double> amplitude(channels);
+    for (int ch = 0; ch < channels; ++ch)
+    {
+        double det = ss[ch] * cc[ch] - sc[ch] * sc[ch], a = (ys[ch] * cc[ch] - yc[ch] * sc[ch]) / det,
+               b = (yc[ch] * ss[ch] - ys[ch] * sc[ch]) / det;
+        amplitude[ch] = ::sqrt(a * a + b * b);
+    }
+    return amplitude;
+}
+
+double dB(double x)
+{
+    return 20 * ::log10(x);
+}
+
+int main_(int argc, char **argv)
+{
+    bool help = false;
+    int decimation = 10, blocksize = 40;
+    double passband = 0.8, attenuation = 60;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (!stricmp(argv[i], "--help"))
+        {
+            help = true;
+        }
+        OPTION(decimation, atoi);
+        OPTION(blocksize, atoi);
+        OPTION(passband, atof);
+        OPTION(attenuation, atof);
+        else cerr << "Unknown option: " << argv[i] << endl;
+    }
+    if (help)
+    {
+        cout << "Options: --decimation <n> --blocksize <n> --passband <fraction of output Nyquist> "
+                "--attenuation <dB>"
+             << endl;
+        return 0;
+    }
+    if (decimation < 2 || blocksize % decimation)
+    {
+        cerr << "Decimation must be > 1, and divide blocksize" << endl;
+        return -1;
+    }
+
+    // Frequencies in terms of the input sampling rate.
+    double nyquist = 0.5 / decimation, passEdge = passband * nyquist;
+    vector<double> coeffs = FilterDesign::WindowedSinc()
+                                .Lowpass((passEdge + nyquist) / 2)
+                                .TransitionWidth(nyquist - passEdge)
+                                .Attenuation_dB(attenuation)
+                                .Coefficients();
+    PolyphaseDecimator<float> decimator;
+    decimator.SetCoefficients(coeffs).SetDecimation(decimation);
+    cout << "Decimation: " << decimation << ", filter length: " << coeffs.size() << endl;
+
+    int failures = 0;
+    int blocks = 20 * static_cast<int>(coeffs.size()) / blocksize + 10;
+
+    // Passband ripple: the Kaiser window's ripple equals its stopband attenuation.
+    vector<double> freqs;
+    for (int i = 1; i <= 16; ++i)
+        freqs.push_back(passEdge * i / 16);
+    vector<double> amps = Amplitudes(decimator, freqs, blocksize, blocks);
+    double maxRipple = 0;
+    for (size_t i = 0; i < amps.size(); ++i)
+        maxRipple = max(maxRipple, ::fabs(dB(amps[i])));
+    double allowedRipple = -dB(1 - 2 * ::pow(10, -attenuation / 20));
+    cout << "Passband ripple: " << maxRipple << "dB (allowed: " << allowedRipple << "dB)" << endl;
+    failures += (maxRipple > allowedRipple);
+
+    // Aliasing: components above the output Nyquist frequency must be attenuated.
+    freqs.clear();
+    for (double f = nyquist + nyquist / 14; f < 0.5; f += nyquist / 7)
+        freqs.push_back(f);
+    amps = Amplitudes(decimator, freqs, blocksize, blocks);
+    double maxAlias = 0;
+    for (size_t i = 0; i < amps.size(); ++i)
+        maxAlias = max(maxAlias, amps[i]);
+    cout << "Aliasing: " << dB(maxAlias) << "dB (allowed: " << -attenuation + 6 << "dB)" << endl;
+    failures += (dB(maxAlias) > -attenuation + 6);
+
+    // Agreement with direct convolution followed by downsampling, across block boundaries.
+    int channels = 3, samples = blocks * blocksize;
+    vector<double> x(channels * samples);
+    srand(1);
+    for (size_t i = 0; i < x.size(); ++i)
+        x[i] = rand() * 2.0 / RAND_MAX - 1;
+    decimator.Initialize(channels);
+    Signal input(channels, blocksize), output(channels, blocksize / decimation);
+    double maxDiff = 0;
+    for (int block = 0; block < blocks; ++block)
+    {
+        for (int ch = 0; ch < channels; ++ch)
+            for (int i = 0; i < blocksize; ++i)
+                input(ch, i) = static_cast<float>(x[ch * samples + block * blocksize + i]);
+        decimator.Process(input, output);
+        for (int ch = 0; ch < channels; ++ch)
+            for (int i = 0; i < output.Elements(); ++i)
+            {
+                int n = block * blocksize + (i + 1) * decimation - 1;
+                double y = 0;
+                for (int k = 0; k < static_cast<int>(coeffs.size()) && k <= n; ++k)
+                    y += coeffs[k] * static_cast<float>(x[ch * samples + n - k]);
+                maxDiff = max(maxDiff, ::fabs(y - output(ch, i)));
+            }
+    }
+    cout << "Deviation from direct convolution: " << maxDiff << endl;
+    failures += (maxDiff > 1e-4);
+
+    cout << (failures ? "FAILED" : "passed") << endl;
+    return failures ? -1 : 0;
+}
+
+int main(int argc, char **argv)
+{
+    FunctionCall<int(int, char **)> call(main_, argc, argv);
+    bool finished = ExceptionCatcher().SetMessage("Terminating").Run(call);
+    return finished ? call.Result() : -1;
+}
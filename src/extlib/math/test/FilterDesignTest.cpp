@@ -0,0 +1,85 @@
+////////////////////////////////////////////////////////////////////////////////
+// $Id$
+// Author: BCI2000 team
+// Description: Tests FilterDesign::ComputeCoefficients() for numerator and
+//   denominator polynomials of equal and of different order.
+//   Returns 0 if all tests pass.
+//
+// $BEGIN_BCI2000_LICENSE$
+//
+// This file is part of BCI2000, a platform for real-time bio-signal research.
+// [ Copyright (C) 2000-2022: BCI2000 team and many external contributors ]
+//
+// BCI2000 is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// BCI2000 is distributed in the hope that it will be useful, but
+//                         WITHOUT ANY WARRANTY
+// - without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+// A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// $END_BCI2000_LICENSE$
+////////////////////////////////////////////////////////////////////////////////
+#include "ExceptionCatcher.h"
+#include "FilterDesign.h"
+#include <cmath>
+#include <iostream>
+#include <numeric>
+#include <vector>
+
+using namespace std;
+using namespace FilterDesign;
+
+// Compares coefficients to expected values, and reports the result.
+int Check(const char *name, const vector<Real> &coeffs, const vector<Real> &expected)
+{
+    bool ok = coeffs.size() == expected.size();
+    for (size_t i = 0; ok && i < coeffs.size(); ++i)
+        ok = ::fabs(coeffs[i] - expected[i]) < 1e-12;
+    cout << name << ":";
+    for (auto c : coeffs)
+        cout << " " << c;
+    cout << (ok ? "" : " (wrong)") << endl;
+    return ok ? 0 : 1;
+}
+
+int main_(int, char **)
+{
+    int failures = 0;
+    vector<Real> b, a;
+
+    // An all-pole transfer function has fewer numerator than denominator coefficients.
+    // (z - 0.5)(z + 0.25) = z^2 - 0.25z - 0.125
+    ComplexVector poles = {0.5, -0.25};
+    Ratpoly<Complex> allPole(Polynomial<Complex>(1.0), Polynomial<Complex>::FromRoots(poles));
+    ComputeCoefficients(allPole, b, a);
+    failures += Check("All-pole b", b, {1.0});
+    failures += Check("All-pole a", a, {1.0, -0.25, -0.125});
+
+    // A Butterworth lowpass has a numerator and denominator of equal order, and a
+    // normalized leading denominator coefficient. Coefficients do not include the
+    // numerator's constant factor, so the DC gain is compared with it divided out.
+    const int order = 4;
+    Ratpoly<Complex> lowpass = Butterworth().Order(order).Lowpass(0.1).TransferFunction();
+    ComputeCoefficients(lowpass, b, a);
+    Real dcGain = accumulate(b.begin(), b.end(), 0.0) / accumulate(a.begin(), a.end(), 0.0),
+         expected = abs(lowpass.Evaluate(1.0) / lowpass.Numerator().ConstantFactor());
+    bool ok = b.size() == order + 1 && a.size() == order + 1 && a[0] == 1 && ::fabs(dcGain / expected - 1) < 1e-9;
+    cout << "Butterworth: " << b.size() << " and " << a.size() << " coefficients, DC gain " << dcGain << endl;
+    failures += !ok;
+
+    cout << (failures ? "FAILED" : "passed") << endl;
+    return failures ? -1 : 0;
+}
+
+int main(int argc, char **argv)
+{
+    FunctionCall<int(int, char **)> call(main_, argc, argv);
+    bool finished = ExceptionCatcher().SetMessage("Terminating").Run(call);
+    return finished ? call.Result() : -1;
+}
@@ -0,0 +1,174 @@
+////////////////////////////////////////////////////////////////////////////////
+// $Id$
+// Author: BCI2000 team
+// Description: Tests SignalSynthesizer for reproducibility across block
+//   sizes, dependence on seed, noise amplitude and band limitation, and
+//   event rate.
+//   Returns 0 if all tests pass.
+//
+// $BEGIN_BCI2000_LICENSE$
+//
+// This file is part of BCI2000, a platform for real-time bio-signal research.
+// [ Copyright (C) 2000-2022: BCI2000 team and many external contributors ]
+//
+// BCI2000 is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// BCI2000 is distributed in the hope that it will be useful, but
+//                         WITHOUT ANY WARRANTY
+// - without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+// A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// $END_BCI2000_LICENSE$
+////////////////////////////////////////////////////////////////////////////////
+#include "ExceptionCatcher.h"
+#include "SignalSynthesizer.h"
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+using namespace std;
+
+#define OPTION(x, f) else if (!::stricmp(argv[i], "--" #x)) x = f(++i < argc ? argv[i] : "")
+
+// A minimal signal type satisfying the requirements of SignalSynthesizer::Process().
+class Signal
+{
+  public:
+    Signal(int channels, int elements) : mChannels(channels), mElements(elements), mData(channels * elements)
+    {
+    }
+    int Channels() const
+    {
+        return mChannels;
+    }
+    int Elements() const
+    {
+        return mElements;
+    }
+    double &operator()(int ch, int sample)
+    {
+        return mData[ch * mElements + sample];
+    }
+
+  private:
+    int mChannels, mElements;
+    vector<double> mData;
+};
+
+// Runs the synthesizer over a number of samples, using blocks of the given size,
+// and returns its output in channel-major order. Event onsets are counted.
+vector<double> Run(SignalSynthesizer &synth, int samples, int blockSize, int &events)
+{
+    int channels = synth.Channels();
+    vector<double> result(channels * samples);
+    synth.Reset();
+    events = 0;
+    for (int pos = 0; pos < samples; pos += blockSize)
+    {
+        Signal block(channels, min(blockSize, samples - pos));
+        synth.Process(block);
+        events += static_cast<int>(synth.Onsets().size());
+        for (int ch = 0; ch < channels; ++ch)
+            for (int i = 0; i < block.Elements(); ++i)
+                result[ch * samples + pos + i] = block(ch, i);
+    }
+    return result;
+}
+
+int main_(int argc, char **argv)
+{
+    bool help = false;
+    int channels = 16, blocksize = 32;
+    double rate = 1000, low = 1, high = 40;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (!stricmp(argv[i], "--help"))
+        {
+            help = true;
+        }
+        OPTION(channels, atoi);
+        OPTION(blocksize, atoi);
+        OPTION(rate, atof);
+        OPTION(low, atof);
+        OPTION(high, atof);
+        else cerr << "Unknown option: " << argv[i] << endl;
+    }
+    if (help)
+    {
+        cout << "Options: --channels <n> --blocksize <n> --rate <Hz> --low <Hz> --high <Hz>" << endl;
+        return 0;
+    }
+
+    int failures = 0, samples = static_cast<int>(200 * rate), events = 0, events2 = 0;
+    SignalSynthesizer synth;
+    synth.SetSamplingRate(rate).SetChannels(channels).SetSeed(1).SetNoiseBand(low, high).SetNoiseAmplitude(1);
+
+    // Reproducibility: output must not depend on block size.
+    synth.SetEventRate(2).SetERPAmplitude(5).Initialize();
+    vector<double> a = Run(synth, samples, blocksize, events), b = Run(synth, samples, 7, events2);
+    bool identical = (a == b) && (events == events2);
+    cout << "Block size independence: " << (identical ? "yes" : "no") << endl;
+    failures += !identical;
+    // Events must follow the configured rate, within 4 standard deviations.
+    double expected = 2 * samples / rate;
+    cout << "Events: " << events << " (expected: " << expected << ")" << endl;
+    failures += (::fabs(events - expected) > 4 * ::sqrt(expected));
+
+    // A different seed must produce a different signal.
+    synth.SetSeed(2).Initialize();
+    b = Run(synth, samples, blocksize, events2);
+    bool different = (a != b);
+    cout << "Seed dependence: " << (different ? "yes" : "no") << endl;
+    failures += !different;
+
+    // Noise RMS must match NoiseAmplitude, and channels must be uncorrelated.
+    synth.SetEventRate(0).Initialize();
+    a = Run(synth, samples, blocksize, events);
+    double maxDeviation = 0, maxCorrelation = 0;
+    for (int ch = 0; ch < channels; ++ch)
+    {
+        double ss = 0, cross = 0;
+        for (int i = 0; i < samples; ++i)
+        {
+            ss += a[ch * samples + i] * a[ch * samples + i];
+            cross += a[ch * samples + i] * a[((ch + 1) % channels) * samples + i];
+        }
+        maxDeviation = max(maxDeviation, ::fabs(::sqrt(ss / samples) - 1));
+        if (channels > 1)
+            maxCorrelation = max(maxCorrelation, ::fabs(cross / ss));
+    }
+    cout << "RMS deviation: " << maxDeviation << ", cross correlation: " << maxCorrelation << endl;
+    failures += (maxDeviation > 0.1) + (maxCorrelation > 0.1);
+
+    // Band limitation: a lag-1 autocorrelation near 1 indicates a low-pass character,
+    // a mean near zero indicates absence of a DC component.
+    double mean = 0, lag1 = 0, ss = 0;
+    for (int i = 0; i < samples; ++i)
+    {
+        mean += a[i];
+        ss += a[i] * a[i];
+        if (i > 0)
+            lag1 += a[i] * a[i - 1];
+    }
+    mean /= samples;
+    double expectedLag1 = ::cos(2 * 3.14159265358979 * (low + high) / 2 / rate);
+    cout << "Mean: " << mean << ", lag-1 autocorrelation: " << lag1 / ss << endl;
+    failures += (::fabs(mean) > 0.05) + (lag1 / ss < expectedLag1 - 0.1);
+
+    cout << (failures ? "FAILED" : "passed") << endl;
+    return failures ? -1 : 0;
+}
+
+int main(int argc, char **argv)
+{
+    FunctionCall<int(int, char **)> call(main_, argc, argv);
+    bool finished = ExceptionCatcher().SetMessage("Terminating").Run(call);
+    return finished ? call.Result() : -1;
+}
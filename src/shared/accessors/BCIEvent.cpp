@@ -6,6 +6,8 @@
 //   Basing the accessor on std::ostream allows for convenient
 //   conversion of numbers (e.g., state values) into event descriptor
 //   strings.
+//   For high-rate event sources, there is also a binary interface
+//   that bypasses string formatting and parsing.
 //
 // $BEGIN_BCI2000_LICENSE$
 //
@@ -30,10 +32,9 @@
 #include "BCIEvent.h"
 
 #include "BCIException.h"
+#include "BCIStream.h"
 #include "EventQueue.h"
 
-#include <list>
-
 static std::atomic<EventQueue *> spQueue;
 
 BCIEvent::BCIEvent() : std::ostream(&mBuf), mBuf(PrecisionTime::Now())
@@ -54,6 +55,33 @@ std::ostream &BCIEvent::operator()(const char *inDescriptor)
     return *this << inDescriptor;
 }
 
+BCIEvent::StateHandle::StateHandle(const State &inState) : mLocation(inState.Location()), mLength(inState.Length())
+{
+    if (inState.Kind() != State::EventKind)
+        throw std_invalid_argument << "Trying to obtain an event handle for state \"" << inState.Name()
+                                   << "\". "
+                                      "This state was not defined as an event state. "
+                                      "Use BEGIN_EVENT_DEFINITIONS/END_EVENT_DEFINITIONS to define states "
+                                      "as event states.";
+}
+
+void BCIEvent::Post(const StateHandle &inHandle, State::ValueType inValue, PrecisionTime inTimestamp)
+{
+    PostWithDuration(inHandle, inValue, -1, inTimestamp);
+}
+
+void BCIEvent::PostWithDuration(const StateHandle &inHandle, State::ValueType inValue, int inDuration,
+                                PrecisionTime inTimestamp)
+{
+    EventQueue *pQueue = spQueue;
+    if (!pQueue)
+        throw std_runtime_error << "No event queue specified";
+    if (!inHandle.IsValid())
+        throw std_invalid_argument << "Trying to post an event through an invalid state handle";
+    EventQueue::Event event = {inHandle.Location(), inHandle.Length(), inValue, inDuration, inTimestamp};
+    pQueue->PushBack(event);
+}
+
 void BCIEvent::SetEventQueue(EventQueue *inpQueue)
 {
     spQueue = inpQueue;
@@ -84,7 +112,16 @@ int BCIEvent::StringBuf::sync()
     if (!pQueue)
         throw std_runtime_error << "No event queue specified";
     if (!str().empty())
-        pQueue->PushBack(str(), mTimestamp);
+    {
+        // Errors in the descriptor are reported rather than thrown, as producers
+        // may run in threads that do not handle exceptions.
+        EventQueue::Event event;
+        std::string error;
+        if (pQueue->Translate(str(), mTimestamp, event, error))
+            pQueue->PushBack(event);
+        else
+            bcierr__ << error;
+    }
     str("");
     return result;
 }
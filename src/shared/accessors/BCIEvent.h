@@ -6,6 +6,12 @@
 //   Basing the accessor on std::ostream allows for convenient
 //   conversion of numbers (e.g., state values) into event descriptor
 //   strings.
+//   For high-rate event sources, there is also a binary interface:
+//   obtain a StateHandle once, e.g. in Initialize(), and post events
+//   through it from any thread without formatting or parsing strings:
+//     BCIEvent::StateHandle h(States->ByName("JoystickXpos"));
+//     ...
+//     BCIEvent::Post(h, xPos);
 //
 // $BEGIN_BCI2000_LICENSE$
 //
@@ -31,6 +37,7 @@
 #define BCI_EVENT_H
 
 #include "PrecisionTime.h"
+#include "State.h"
 #include <iostream>
 #include <sstream>
 
@@ -54,6 +61,35 @@ class BCIEvent : public std::ostream
     }
     std::ostream &operator()(const char *inDescriptor);
 
+    class StateHandle
+    {
+      public:
+        StateHandle() : mLocation(-1), mLength(0)
+        {
+        }
+        explicit StateHandle(const State &);
+        bool IsValid() const
+        {
+            return mLocation >= 0;
+        }
+        int Location() const
+        {
+            return mLocation;
+        }
+        int Length() const
+        {
+            return mLength;
+        }
+
+      private:
+        int mLocation, mLength;
+    };
+    // A duration of 0 sets the state at a single sample only, a duration of -1
+    // sets the state at the current and all following samples.
+    static void Post(const StateHandle &, State::ValueType, PrecisionTime = PrecisionTime::Now());
+    static void PostWithDuration(const StateHandle &, State::ValueType, int duration,
+                                 PrecisionTime = PrecisionTime::Now());
+
   private:
     static void SetEventQueue(class EventQueue *);
     static void AllowEvents();
@@ -35,6 +35,7 @@
 ////////////////////////////////////////////////////////////////////////////////
 #include "Environment.h"
 
+#include "Arena.h"
 #include "BCIEvent.h"
 #include "BCIException.h"
 #include "BCIStream.h"
@@ -771,6 +772,11 @@ std::string Environment::CurrentSession() const
     return sRunManager.CurrentSession();
 }
 
+Tiny::Arena *Environment::CurrentBlockArena()
+{
+    return Tiny::Arena::Current();
+}
+
 std::string Environment::CurrentRun() const
 {
     return sRunManager.CurrentRun();
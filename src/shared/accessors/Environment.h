@@ -54,6 +54,7 @@
 namespace Tiny
 {
 class File;
+class Arena;
 }
 
 class RunManager;
@@ -384,6 +385,10 @@ class Environment : public EnvironmentBase
     std::string CurrentRun() const;
     Tiny::File &CurrentRunFile() const;
     std::string CurrentSession() const;
+    // The block arena of the filter that is processing a block in the calling thread,
+    // or null outside Process() and Resting(). Helper classes that are not filters
+    // may draw per-block temporaries from it.
+    static Tiny::Arena *CurrentBlockArena();
 
     void OnParamAccess(const std::string &path) const override;
     void OnStateAccess(const std::string &name) const override;
@@ -42,6 +42,10 @@ class StateRef
     operator uint32_t() const;
     StateRef operator()(size_t offset) const;
     const State *operator->() const;
+    StateVector *Vector() const
+    {
+        return mpStateVector;
+    }
 
     StateRef &Reset(const StateRef &);
 
@@ -0,0 +1,550 @@
+////////////////////////////////////////////////////////////////////////////////
+// $Id$
+// Author: BCI2000 team
+// Description: Provides a multi-level min/max/mean overview of the signal in
+//   a BCI2000 data file, together with lists of state value changes.
+//   The overview is cached in a sidecar file, and created in a background
+//   thread when no up-to-date sidecar file exists.
+//
+// $BEGIN_BCI2000_LICENSE$
+//
+// This file is part of BCI2000, a platform for real-time bio-signal research.
+// [ Copyright (C) 2000-2022: BCI2000 team and many external contributors ]
+//
+// BCI2000 is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// BCI2000 is distributed in the hope that it will be useful, but
+//                         WITHOUT ANY WARRANTY
+// - without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+// A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// $END_BCI2000_LICENSE$
+////////////////////////////////////////////////////////////////////////////////
+#include "BCI2000FileOverview.h"
+
+#include "BCI2000FileReader.h"
+#include "BCIException.h"
+#include "FileUtils.h"
+#include "Thread.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <map>
+
+// Sidecar file layout, in native byte order:
+//  header: magic string, version, byte order mark, data file length and
+//          modification time, number of samples, channels, decimation factors,
+//          number of levels, and offset of the state section;
+//  signal bins of all levels, starting with level 0, each level arranged by bin;
+//  state section: number of states, followed by name, number of changes, and
+//          changes for each state. States without a list have -1 changes.
+namespace
+{
+const char cMagic[] = "BCI2000Overview";
+const uint32_t cVersion = 1, cByteOrderMark = 0x01020304;
+const int cChunkSamples = 4096;
+// Only levels with more bins than this are created, except for level 0.
+const int64_t cMinBins = 256;
+
+template <typename T> void Put(std::ostream &os, const T &t)
+{
+    os.write(reinterpret_cast<const char *>(&t), sizeof(T));
+}
+
+template <typename T> bool Get(std::istream &is, T &t)
+{
+    return !!is.read(reinterpret_cast<char *>(&t), sizeof(T));
+}
+
+struct Header
+{
+    uint32_t version = 0, byteOrderMark = 0;
+    int64_t dataFileLength = 0;
+    uint64_t dataFileTime = 0;
+    int64_t numSamples = 0;
+    int32_t channels = 0, baseDecimation = 0, levelDecimation = 0, levels = 0;
+    int64_t stateOffset = 0;
+
+    void Write(std::ostream &os) const
+    {
+        os.write(cMagic, sizeof(cMagic));
+        Put(os, version), Put(os, byteOrderMark), Put(os, dataFileLength), Put(os, dataFileTime);
+        Put(os, numSamples), Put(os, channels), Put(os, baseDecimation), Put(os, levelDecimation);
+        Put(os, levels), Put(os, stateOffset);
+    }
+    bool Read(std::istream &is)
+    {
+        char magic[sizeof(cMagic)] = "";
+        return is.read(magic, sizeof(magic)) && !::memcmp(magic, cMagic, sizeof(cMagic)) && Get(is, version) &&
+               Get(is, byteOrderMark) && Get(is, dataFileLength) && Get(is, dataFileTime) && Get(is, numSamples) &&
+               Get(is, channels) && Get(is, baseDecimation) && Get(is, levelDecimation) && Get(is, levels) &&
+               Get(is, stateOffset);
+    }
+    static int64_t Size()
+    {
+        return sizeof(cMagic) + 2 * sizeof(uint32_t) + 3 * sizeof(int64_t) + 4 * sizeof(int32_t) + sizeof(int64_t);
+    }
+};
+
+std::vector<int64_t> BinsPerLevel(int64_t inSamples)
+{
+    std::vector<int64_t> bins(1, (inSamples + BCI2000FileOverview::cBaseDecimation - 1) /
+                                     BCI2000FileOverview::cBaseDecimation);
+    while (bins.back() > cMinBins)
+        bins.push_back((bins.back() + BCI2000FileOverview::cLevelDecimation - 1) /
+                       BCI2000FileOverview::cLevelDecimation);
+    return bins;
+}
+
+// Accumulates bins of one level, and writes them to their region of the sidecar file.
+struct LevelWriter
+{
+    int channels = 0;
+    int64_t count = 0, written = 0, offset = 0;
+    std::vector<float> min, max;
+    std::vector<double> sum;
+    std::vector<BCI2000FileOverview::Bin> pending;
+
+    void Init(int inChannels, int64_t inOffset)
+    {
+        channels = inChannels;
+        offset = inOffset;
+        Clear();
+    }
+    void Clear()
+    {
+        count = 0;
+        min.assign(channels, std::numeric_limits<float>::max());
+        max.assign(channels, -std::numeric_limits<float>::max());
+        sum.assign(channels, 0);
+    }
+    void Add(int ch, float value)
+    {
+        min[ch] = std::min(min[ch], value);
+        max[ch] = std::max(max[ch], value);
+        sum[ch] += value;
+    }
+    void Add(const BCI2000FileOverview::Bin *bins, int64_t samples)
+    {
+        for (int ch = 0; ch < channels; ++ch)
+        {
+            min[ch] = std::min(min[ch], bins[ch].min);
+            max[ch] = std::max(max[ch], bins[ch].max);
+            sum[ch] += bins[ch].mean * samples;
+        }
+    }
+    // Completes the current bin from samples accumulated so far.
+    const BCI2000FileOverview::Bin *Complete(int64_t samples)
+    {
+        for (int ch = 0; ch < channels; ++ch)
+            pending.push_back({min[ch], max[ch], static_cast<float>(sum[ch] / samples)});
+        Clear();
+        return &pending[pending.size() - channels];
+    }
+    void Flush(std::ostream &os)
+    {
+        if (pending.empty())
+            return;
+        os.seekp(offset + written * channels * sizeof(BCI2000FileOverview::Bin));
+        os.write(reinterpret_cast<const char *>(pending.data()), pending.size() * sizeof(BCI2000FileOverview::Bin));
+        written += pending.size() / channels;
+        pending.clear();
+    }
+};
+
+typedef std::map<std::string, std::vector<BCI2000FileOverview::Change>> ChangeMap;
+
+bool WriteSidecar(const std::string &inDataFile, const std::string &inSidecar, std::atomic<double> &outProgress,
+                  const std::function<bool()> &inCancelled)
+{
+    outProgress = 0;
+    BCI2000FileReader reader;
+    reader.Open(inDataFile.c_str(), 1024 * 1024);
+    if (!reader.IsOpen() || reader.NumSamples() < 1)
+        return false;
+
+    Header header;
+    header.version = cVersion;
+    header.byteOrderMark = cByteOrderMark;
+    header.dataFileLength = FileUtils::Length(inDataFile);
+    header.dataFileTime = FileUtils::ModificationTime(inDataFile).RawUInt();
+    header.numSamples = reader.NumSamples();
+    header.channels = reader.SignalProperties().Channels();
+    header.baseDecimation = BCI2000FileOverview::cBaseDecimation;
+    header.levelDecimation = BCI2000FileOverview::cLevelDecimation;
+    std::vector<int64_t> bins = BinsPerLevel(header.numSamples);
+    header.levels = static_cast<int32_t>(bins.size());
+
+    std::string tempFile = inSidecar + ".tmp";
+    std::ofstream os(tempFile.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!os.is_open())
+        return false;
+    header.Write(os);
+
+    std::vector<LevelWriter> levels(bins.size());
+    int64_t offset = Header::Size();
+    for (size_t i = 0; i < levels.size(); ++i)
+    {
+        levels[i].Init(header.channels, offset);
+        offset += bins[i] * header.channels * sizeof(BCI2000FileOverview::Bin);
+    }
+
+    // A state's change list is dropped when it would exceed the size of the level 0 bins.
+    StateVector::ColumnPlan plan;
+    std::vector<std::string> names;
+    for (const auto &state : *reader.States())
+    {
+        plan.Add(state);
+        names.push_back(state.Name());
+    }
+    size_t maxChanges = std::max<size_t>(cMinBins, bins[0]);
+    std::vector<std::vector<BCI2000FileOverview::Change>> changes(names.size());
+    std::vector<bool> dense(names.size(), false);
+    std::vector<State::ValueType> values;
+
+    int channels = header.channels;
+    std::vector<int64_t> samplesInBin(levels.size(), 0);
+    GenericSignal block;
+    for (int64_t chunk = 0; chunk < header.numSamples; chunk += cChunkSamples)
+    {
+        if (inCancelled())
+            break;
+        int64_t count = std::min<int64_t>(cChunkSamples, header.numSamples - chunk);
+        if (block.Elements() != count)
+            block = GenericSignal(channels, static_cast<int>(count));
+        reader.ReadCalibratedSignal(chunk, block);
+        const GenericSignal::ValueType *pData = block.ConstData();
+        for (int64_t sample = chunk; sample < chunk + count; ++sample)
+        {
+            for (int ch = 0; ch < channels; ++ch)
+                levels[0].Add(ch, static_cast<float>(pData[ch * count + sample - chunk]));
+            bool last = (sample == header.numSamples - 1);
+            if (++levels[0].count == BCI2000FileOverview::cBaseDecimation || last)
+            {
+                // Propagate completed bins upwards through the levels.
+                int64_t samples = levels[0].count;
+                const BCI2000FileOverview::Bin *pBin = levels[0].Complete(samples);
+                for (size_t i = 1; i < levels.size(); ++i)
+                {
+                    levels[i].Add(pBin, samples);
+                    samplesInBin[i] += samples;
+                    if (++levels[i].count < BCI2000FileOverview::cLevelDecimation && !last)
+                        break;
+                    samples = samplesInBin[i];
+                    samplesInBin[i] = 0;
+                    pBin = levels[i].Complete(samples);
+                }
+            }
+        }
+        for (auto &level : levels)
+            if (level.pending.size() >= cChunkSamples)
+                level.Flush(os);
+
+        values.resize(plan.Columns() * count);
+        if (!values.empty())
+            reader.ReadStateValues(plan, chunk, count, values.data());
+        for (int col = 0; col < plan.Columns(); ++col)
+        {
+            if (dense[col])
+                continue;
+            auto &list = changes[col];
+            const State::ValueType *pValue = &values[col * count];
+            for (int64_t i = 0; i < count; ++i)
+                if (list.empty() || pValue[i] != list.back().value)
+                    list.push_back({chunk + i, pValue[i]});
+            if (list.size() > maxChanges)
+            {
+                dense[col] = true;
+                std::vector<BCI2000FileOverview::Change>().swap(list);
+            }
+        }
+        outProgress = static_cast<double>(chunk + count) / header.numSamples;
+    }
+    bool success = !inCancelled();
+    if (success)
+    {
+        for (auto &level : levels)
+            level.Flush(os);
+        os.seekp(offset);
+        header.stateOffset = offset;
+        Put(os, static_cast<int32_t>(names.size()));
+        for (size_t i = 0; i < names.size(); ++i)
+        {
+            Put(os, static_cast<int32_t>(names[i].length()));
+            os.write(names[i].data(), names[i].length());
+            Put(os, static_cast<int64_t>(dense[i] ? -1 : changes[i].size()));
+            for (const auto &change : changes[i])
+                Put(os, change.sample), Put(os, change.value);
+        }
+        os.seekp(0);
+        header.Write(os);
+        success = !!os;
+    }
+    os.close();
+    if (success)
+    {
+        FileUtils::RemoveFile(inSidecar);
+        success = FileUtils::Rename(tempFile, inSidecar);
+    }
+    if (!success)
+        FileUtils::RemoveFile(tempFile);
+    return success;
+}
+
+} // namespace
+
+struct BCI2000FileOverview::Private
+{
+    Private();
+    ~Private();
+    bool Load();
+    void StopBuilder();
+
+    std::string mDataFile, mSidecar;
+    std::ifstream mStream;
+    Header mHeader;
+    std::vector<int64_t> mBins, mOffsets;
+    ChangeMap mChanges;
+
+    std::atomic<bool> mReady;
+    std::atomic<double> mProgress;
+
+    class Builder : public Thread
+    {
+      public:
+        Builder(BCI2000FileOverview::Private *p) : Thread("BCI2000FileOverview Builder"), p(p)
+        {
+        }
+        ~Builder()
+        {
+            TerminateAndWait();
+        }
+
+      private:
+        int OnExecute() override
+        {
+            std::function<bool()> cancelled = [this]() { return Terminating(); };
+            if (WriteSidecar(p->mDataFile, p->mSidecar, p->mProgress, cancelled) && !Terminating())
+                p->mReady = p->Load();
+            return 0;
+        }
+        BCI2000FileOverview::Private *p;
+    } *mpBuilder;
+};
+
+BCI2000FileOverview::Private::Private() : mReady(false), mProgress(0), mpBuilder(nullptr)
+{
+}
+
+BCI2000FileOverview::Private::~Private()
+{
+    StopBuilder();
+}
+
+void BCI2000FileOverview::Private::StopBuilder()
+{
+    delete mpBuilder;
+    mpBuilder = nullptr;
+}
+
+bool BCI2000FileOverview::Private::Load()
+{
+    mStream.close();
+    mStream.clear();
+    mStream.open(mSidecar.c_str(), std::ios::in | std::ios::binary);
+    Header header;
+    if (!header.Read(mStream))
+        return false;
+    if (header.version != cVersion || header.byteOrderMark != cByteOrderMark ||
+        header.dataFileLength != FileUtils::Length(mDataFile) ||
+        header.dataFileTime != FileUtils::ModificationTime(mDataFile).RawUInt() ||
+        header.baseDecimation != cBaseDecimation || header.levelDecimation != cLevelDecimation)
+        return false;
+    std::vector<int64_t> bins = BinsPerLevel(header.numSamples);
+    if (static_cast<int32_t>(bins.size()) != header.levels)
+        return false;
+
+    std::vector<int64_t> offsets;
+    int64_t offset = Header::Size();
+    for (int64_t n : bins)
+    {
+        offsets.push_back(offset);
+        offset += n * header.channels * sizeof(Bin);
+    }
+    if (header.stateOffset != offset)
+        return false;
+    mStream.seekg(offset);
+    ChangeMap changes;
+    int32_t states = 0;
+    if (!Get(mStream, states))
+        return false;
+    for (int32_t i = 0; i < states; ++i)
+    {
+        int32_t length = 0;
+        int64_t count = 0;
+        if (!Get(mStream, length) || length < 0)
+            return false;
+        std::string name(length, '\0');
+        if (!mStream.read(&name[0], length) || !Get(mStream, count))
+            return false;
+        if (count < 0)
+            continue;
+        auto &list = changes[name];
+        list.resize(count);
+        for (auto &change : list)
+            if (!Get(mStream, change.sample) || !Get(mStream, change.value))
+                return false;
+    }
+    mHeader = header;
+    mBins.swap(bins);
+    mOffsets.swap(offsets);
+    mChanges.swap(changes);
+    return true;
+}
+
+BCI2000FileOverview::BCI2000FileOverview() : p(new Private)
+{
+}
+
+BCI2000FileOverview::~BCI2000FileOverview()
+{
+    delete p;
+}
+
+BCI2000FileOverview &BCI2000FileOverview::Open(const std::string &inDataFile)
+{
+    Close();
+    // A sidecar file next to the data file is used even if the directory is not writable.
+    p->mDataFile = inDataFile;
+    p->mSidecar = FileUtils::AbsolutePath(inDataFile) + ".ovw";
+    bool loaded = p->Load();
+    if (!loaded && p->mSidecar != SidecarFile(inDataFile))
+    {
+        p->mSidecar = SidecarFile(inDataFile);
+        loaded = p->Load();
+    }
+    if (loaded)
+    {
+        p->mProgress = 1;
+        p->mReady = true;
+    }
+    else if (!p->mSidecar.empty())
+    {
+        p->mStream.close();
+        p->mpBuilder = new Private::Builder(p);
+        p->mpBuilder->Start();
+    }
+    return *this;
+}
+
+BCI2000FileOverview &BCI2000FileOverview::Close()
+{
+    p->StopBuilder();
+    p->mReady = false;
+    p->mProgress = 0;
+    p->mStream.close();
+    p->mDataFile.clear();
+    p->mSidecar.clear();
+    p->mHeader = Header();
+    p->mBins.clear();
+    p->mOffsets.clear();
+    p->mChanges.clear();
+    return *this;
+}
+
+bool BCI2000FileOverview::Ready() const
+{
+    return p->mReady;
+}
+
+double BCI2000FileOverview::Progress() const
+{
+    return p->mProgress;
+}
+
+int64_t BCI2000FileOverview::NumSamples() const
+{
+    return Ready() ? p->mHeader.numSamples : 0;
+}
+
+int BCI2000FileOverview::Channels() const
+{
+    return Ready() ? p->mHeader.channels : 0;
+}
+
+int BCI2000FileOverview::Levels() const
+{
+    return Ready() ? p->mHeader.levels : 0;
+}
+
+int64_t BCI2000FileOverview::Decimation(int inLevel) const
+{
+    int64_t decimation = cBaseDecimation;
+    for (int i = 0; i < inLevel; ++i)
+        decimation *= cLevelDecimation;
+    return decimation;
+}
+
+int64_t BCI2000FileOverview::NumBins(int inLevel) const
+{
+    if (inLevel < 0 || inLevel >= Levels())
+        throw std_range_error << "Overview level " << inLevel << " out of range";
+    return p->mBins[inLevel];
+}
+
+int BCI2000FileOverview::LevelFor(int64_t inSamplesPerBin) const
+{
+    int level = -1;
+    while (level + 1 < Levels() && Decimation(level + 1) <= inSamplesPerBin)
+        ++level;
+    return level;
+}
+
+BCI2000FileOverview &BCI2000FileOverview::ReadBins(int inLevel, int64_t inFirstBin, int64_t inCount, Bin *outBins)
+{
+    if (inFirstBin < 0 || inCount < 0 || inFirstBin + inCount > NumBins(inLevel))
+        throw std_range_error << "Bin range [" << inFirstBin << ", " << inFirstBin + inCount
+                              << ") exceeds number of bins at overview level " << inLevel;
+    int64_t recordSize = p->mHeader.channels * sizeof(Bin);
+    p->mStream.clear();
+    p->mStream.seekg(p->mOffsets[inLevel] + inFirstBin * recordSize);
+    if (!p->mStream.read(reinterpret_cast<char *>(outBins), inCount * recordSize))
+        throw std_runtime_error << "Could not read from overview file " << p->mSidecar;
+    return *this;
+}
+
+const std::vector<BCI2000FileOverview::Change> *BCI2000FileOverview::StateChanges(const std::string &inName) const
+{
+    if (!Ready())
+        return nullptr;
+    auto i = p->mChanges.find(inName);
+    return i == p->mChanges.end() ? nullptr : &i->second;
+}
+
+bool BCI2000FileOverview::CreateSidecar(const std::string &inDataFile)
+{
+    std::string sidecar = SidecarFile(inDataFile);
+    std::atomic<double> progress(0);
+    return !sidecar.empty() && WriteSidecar(inDataFile, sidecar, progress, []() { return false; });
+}
+
+std::string BCI2000FileOverview::SidecarFile(const std::string &inDataFile)
+{
+    std::string path = FileUtils::AbsolutePath(inDataFile), sidecar = path + ".ovw";
+    if (FileUtils::IsWritableDirectory(FileUtils::ExtractDirectory(path)))
+        return sidecar;
+    std::string dir = FileUtils::TemporaryDirectory();
+    if (dir.empty())
+        return "";
+    return FileUtils::EnsureSeparator(dir) + std::to_string(std::hash<std::string>()(path)) + ".ovw";
+}
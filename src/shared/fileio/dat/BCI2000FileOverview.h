@@ -0,0 +1,100 @@
+////////////////////////////////////////////////////////////////////////////////
+// $Id$
+// Author: BCI2000 team
+// Description: Provides a multi-level min/max/mean overview of the signal in
+//   a BCI2000 data file, together with lists of state value changes.
+//   The overview is cached in a sidecar file, and created in a background
+//   thread when no up-to-date sidecar file exists.
+//
+// $BEGIN_BCI2000_LICENSE$
+//
+// This file is part of BCI2000, a platform for real-time bio-signal research.
+// [ Copyright (C) 2000-2022: BCI2000 team and many external contributors ]
+//
+// BCI2000 is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// BCI2000 is distributed in the hope that it will be useful, but
+//                         WITHOUT ANY WARRANTY
+// - without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+// A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// $END_BCI2000_LICENSE$
+////////////////////////////////////////////////////////////////////////////////
+#ifndef BCI2000_FILE_OVERVIEW_H
+#define BCI2000_FILE_OVERVIEW_H
+
+#include "State.h"
+
+#include <string>
+#include <vector>
+
+class BCI2000FileOverview
+{
+  public:
+    // Each bin of level 0 summarizes cBaseDecimation samples, and each bin of a
+    // higher level summarizes cLevelDecimation bins of the level below.
+    static const int cBaseDecimation = 256;
+    static const int cLevelDecimation = 4;
+
+    struct Bin
+    {
+        float min, max, mean;
+    };
+    struct Change
+    {
+        int64_t sample;
+        State::ValueType value;
+    };
+
+  public:
+    BCI2000FileOverview();
+    ~BCI2000FileOverview();
+
+  private:
+    BCI2000FileOverview(const BCI2000FileOverview &);
+    BCI2000FileOverview &operator=(const BCI2000FileOverview &);
+
+  public:
+    // Opens the overview for a data file. When there is no sidecar file matching
+    // the data file's size and modification time, creation of a sidecar file is
+    // started in the background, and Ready() becomes true when it is finished.
+    BCI2000FileOverview &Open(const std::string &dataFile);
+    BCI2000FileOverview &Close();
+    bool Ready() const;
+    // Fraction of the data file processed so far when creating the sidecar file.
+    double Progress() const;
+
+    int64_t NumSamples() const;
+    int Channels() const;
+    int Levels() const;
+    int64_t Decimation(int level) const;
+    int64_t NumBins(int level) const;
+    // Returns the coarsest level whose bins do not exceed the given number of
+    // samples, or -1 if level 0 is already too coarse.
+    int LevelFor(int64_t samplesPerBin) const;
+
+    // Reads calibrated signal bins for all channels, arranged by bin, i.e. all
+    // channels of the first bin, followed by all channels of the second bin, and so on.
+    BCI2000FileOverview &ReadBins(int level, int64_t firstBin, int64_t count, Bin *outBins);
+    // Value changes of a state, beginning with its value at sample 0.
+    // Returns null for states that change too often to be listed.
+    const std::vector<Change> *StateChanges(const std::string &name) const;
+
+    // Creates a sidecar file for the given data file, without using a background thread.
+    static bool CreateSidecar(const std::string &dataFile);
+    // The sidecar file is located next to the data file if possible, and in the
+    // temporary directory otherwise.
+    static std::string SidecarFile(const std::string &dataFile);
+
+  private:
+    struct Private;
+    Private *p;
+};
+
+#endif // BCI2000_FILE_OVERVIEW_H
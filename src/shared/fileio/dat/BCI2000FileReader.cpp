@@ -26,12 +26,16 @@
 ////////////////////////////////////////////////////////////////////////////////
 #include "BCI2000FileReader.h"
 #include "BCIException.h"
+#include "FileMapping.h"
 #include "Files.h"
 #include "Streambuf.h"
 
+#include <algorithm>
+#include <cstring>
 #include <fstream>
 #include <iostream>
 #include <sstream>
+#include <vector>
 
 struct BCI2000FileReader::Private
 {
@@ -41,6 +45,7 @@ struct BCI2000FileReader::Private
     void ReadHeader(const char *);
     void CalculateNumSamples();
     const char *BufferSample(int64_t sample);
+    int64_t BufferedSamples(int64_t sample) const;
 
     ParamList mParamlist;
     StateList mStatelist;
@@ -48,6 +53,9 @@ struct BCI2000FileReader::Private
     bool mInitialized;
 
     File *mpFile;
+    // When the file can be mapped into memory, samples are accessed through the
+    // mapping, and the buffer is not used.
+    FileMapping mMapping;
     std::string mFilename, mFileFormatVersion;
 
     ::SignalProperties mSignalProperties;
@@ -88,6 +96,7 @@ void BCI2000FileReader::Private::Reset()
 
     mFilename = "";
     mpFile->Close();
+    mMapping.Close();
     delete[] mpBuffer;
     mpBuffer = NULL;
     mBufferSize = 0;
@@ -123,6 +132,32 @@ template <typename T> static GenericSignal::ValueType ReadValue_SwapBytes(const
     return *reinterpret_cast<const T *>(reinterpret_cast<char *>(b));
 }
 
+template <typename T, bool SwapBytes>
+static void DecodeSamples(const char *pData, int stride, int64_t count, GenericSignal &ioSignal, int firstElement)
+{
+    int channels = ioSignal.Channels(), elements = ioSignal.Elements();
+    GenericSignal::ValueType *pOut = ioSignal.MutableData() + firstElement;
+    for (int64_t sample = 0; sample < count; ++sample, pData += stride)
+    {
+        const char *p = pData;
+        for (int ch = 0; ch < channels; ++ch, p += sizeof(T))
+        {
+            T value;
+            if (SwapBytes)
+            {
+                char *b = reinterpret_cast<char *>(&value) + sizeof(T);
+                for (size_t i = 0; i < sizeof(T); ++i)
+                    *--b = p[i];
+            }
+            else
+            {
+                ::memcpy(&value, p, sizeof(T));
+            }
+            pOut[ch * elements + sample] = value;
+        }
+    }
+}
+
 BCI2000FileReader::BCI2000FileReader() : p(new Private)
 {
 }
@@ -154,6 +189,7 @@ BCI2000FileReader &BCI2000FileReader::Open(const char *inFilename, int inBufSize
         if (ErrorState() == NoError)
         {
             p->CalculateNumSamples();
+            p->mMapping.Open(inFilename);
             p->mBufferSize = inBufSize;
             p->mpBuffer = new char[p->mBufferSize];
             p->mBufferBegin = 0;
@@ -314,6 +350,97 @@ BCI2000FileReader &BCI2000FileReader::ReadStateVector(int64_t inSample)
     return *this;
 }
 
+BCI2000FileReader &BCI2000FileReader::ReadStateValues(const StateVector::ColumnPlan &inPlan, int64_t inSample,
+                                                      int64_t inCount, State::ValueType *outValues)
+{
+    if (inPlan.ByteLength() > p->mStatevectorLength)
+        throw std_range_error << "State column plan exceeds the file's state vector length";
+    if (inSample < 0 || inCount < 0 || inSample + inCount > NumSamples())
+        throw std_range_error << "Sample range [" << inSample << ", " << inSample + inCount
+                              << ") exceeds file size of " << NumSamples() << " samples";
+    int stride = p->mDataSize * SignalProperties().Channels() + p->mStatevectorLength;
+    // Values are arranged by column, so we extract each buffered chunk of samples into a
+    // temporary, and distribute it into the output columns.
+    std::vector<State::ValueType> chunk;
+    int64_t sample = inSample, end = inSample + inCount;
+    while (sample < end)
+    {
+        const char *pData = p->BufferSample(sample) + p->mDataSize * SignalProperties().Channels();
+        int64_t count = std::min(std::max<int64_t>(p->BufferedSamples(sample), 1), end - sample);
+        if (count == inCount)
+        {
+            inPlan.Extract(pData, stride, count, outValues);
+        }
+        else
+        {
+            chunk.resize(inPlan.Columns() * count);
+            inPlan.Extract(pData, stride, count, chunk.data());
+            for (int col = 0; col < inPlan.Columns(); ++col)
+                std::copy(chunk.begin() + col * count, chunk.begin() + (col + 1) * count,
+                          outValues + col * inCount + (sample - inSample));
+        }
+        sample += count;
+    }
+    return *this;
+}
+
+BCI2000FileReader &BCI2000FileReader::ReadRawSignal(int64_t inSample, GenericSignal &outSignal)
+{
+    if (outSignal.Channels() > SignalProperties().Channels())
+        throw std_range_error << "Signal has " << outSignal.Channels() << " channels, file has "
+                              << SignalProperties().Channels();
+    if (inSample < 0 || inSample + outSignal.Elements() > NumSamples())
+        throw std_range_error << "Sample range [" << inSample << ", " << inSample + outSignal.Elements()
+                              << ") exceeds file size of " << NumSamples() << " samples";
+    static const bool isBigEndian = (*reinterpret_cast<const uint16_t *>("\0\1") == 0x0001);
+    int stride = p->mDataSize * SignalProperties().Channels() + p->mStatevectorLength;
+    int64_t sample = inSample, end = inSample + outSignal.Elements();
+    while (sample < end)
+    {
+        const char *pData = p->BufferSample(sample);
+        int64_t count = std::min(std::max<int64_t>(p->BufferedSamples(sample), 1), end - sample);
+        int first = static_cast<int>(sample - inSample);
+        switch (p->mSignalType)
+        {
+        case SignalType::int16:
+            if (isBigEndian)
+                DecodeSamples<int16_t, true>(pData, stride, count, outSignal, first);
+            else
+                DecodeSamples<int16_t, false>(pData, stride, count, outSignal, first);
+            break;
+        case SignalType::int32:
+            if (isBigEndian)
+                DecodeSamples<int32_t, true>(pData, stride, count, outSignal, first);
+            else
+                DecodeSamples<int32_t, false>(pData, stride, count, outSignal, first);
+            break;
+        case SignalType::float32:
+            if (isBigEndian)
+                DecodeSamples<float, true>(pData, stride, count, outSignal, first);
+            else
+                DecodeSamples<float, false>(pData, stride, count, outSignal, first);
+            break;
+        default:
+            throw std_runtime_error << "Unsupported data format: " << p->mSignalType.Name();
+        }
+        sample += count;
+    }
+    return *this;
+}
+
+BCI2000FileReader &BCI2000FileReader::ReadCalibratedSignal(int64_t inSample, GenericSignal &outSignal)
+{
+    ReadRawSignal(inSample, outSignal);
+    GenericSignal::ValueType *pData = outSignal.MutableData();
+    for (int ch = 0; ch < outSignal.Channels(); ++ch)
+    {
+        GenericSignal::ValueType offset = p->mSourceOffsets[ch], gain = p->mSourceGains[ch];
+        for (int el = 0; el < outSignal.Elements(); ++el, ++pData)
+            *pData = (*pData - offset) * gain;
+    }
+    return *this;
+}
+
 void BCI2000FileReader::Private::ReadHeader(const char *inPrmfile)
 {
     BufferedIO buf;
@@ -451,6 +578,8 @@ const char *BCI2000FileReader::Private::BufferSample(int64_t inSample)
                               << " samples";
     int numChannels = mSignalProperties.Channels();
     int64_t filepos = mHeaderLength + inSample * (mDataSize * numChannels + mStatevectorLength);
+    if (mMapping)
+        return mMapping.BaseAddress() + filepos;
     if (filepos < mBufferBegin || filepos + mDataSize * numChannels + mStatevectorLength >= mBufferEnd)
     {
         if (mpFile->SeekTo(filepos) != filepos)
@@ -468,3 +597,14 @@ const char *BCI2000FileReader::Private::BufferSample(int64_t inSample)
     }
     return mpBuffer + (filepos - mBufferBegin);
 }
+
+int64_t BCI2000FileReader::Private::BufferedSamples(int64_t inSample) const
+{ // Number of complete samples in the buffer, starting at the given sample.
+    if (mMapping)
+        return std::max<int64_t>(0, static_cast<int64_t>(mNumSamples) - inSample);
+    int64_t sampleSize = mDataSize * mSignalProperties.Channels() + mStatevectorLength;
+    int64_t filepos = mHeaderLength + inSample * sampleSize;
+    if (filepos < mBufferBegin)
+        return 0;
+    return std::max<int64_t>(0, (mBufferEnd - filepos) / sampleSize);
+}
@@ -92,6 +92,14 @@ class BCI2000FileReader
     virtual GenericSignal::ValueType RawValue(int channel, int64_t sample);
     GenericSignal::ValueType CalibratedValue(int channel, int64_t sample);
     virtual BCI2000FileReader &ReadStateVector(int64_t sample);
+    //  Reads the values of all states in a column plan for a range of samples,
+    //  without going through the StateVector object. Values are arranged by column.
+    BCI2000FileReader &ReadStateValues(const StateVector::ColumnPlan &, int64_t sample, int64_t count,
+                                       State::ValueType *values);
+    //  Reads raw or calibrated values of all channels for a range of samples beginning at the given
+    //  sample, with one signal element per sample. The signal's channels must not exceed SourceCh().
+    BCI2000FileReader &ReadRawSignal(int64_t sample, GenericSignal &);
+    BCI2000FileReader &ReadCalibratedSignal(int64_t sample, GenericSignal &);
 
   protected:
     void Reset();
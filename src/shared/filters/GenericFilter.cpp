@@ -29,6 +29,7 @@
 #include "ClassName.h"
 #include "StopWatch.h"
 #include "SubchainFilter.h"
+#include "TimeUtils.h"
 #include <iomanip>
 #include <limits>
 #include <sstream>
@@ -46,13 +47,34 @@ struct GenericFilter::Private
     bool mTimedCalls;
     bool mProfiling;
     struct PerformanceData mPerformanceData;
+    Tiny::Arena mBlockArena;
+    int mBlocksInRun;
+    bool mAllocationsReported;
 
-    Private() : mTimedCalls(false), mProfiling(false)
+    Private() : mTimedCalls(false), mProfiling(false), mBlocksInRun(0), mAllocationsReported(false)
     {
     }
+    void CheckAllocations(GenericFilter *, const char *, int);
 };
 thread_local void *GenericFilter::Private::stAuxThreadData;
 
+// When heap allocations are counted, report filters that keep allocating
+// memory once their first blocks have been processed.
+void GenericFilter::Private::CheckAllocations(GenericFilter *inpFilter, const char *inFunction, int inCountBefore)
+{
+    const int cWarmupBlocks = 2;
+    if (inCountBefore < 0 || mAllocationsReported || ++mBlocksInRun <= cWarmupBlocks)
+        return;
+    int count = MemoryDebugging::HeapAllocations() - inCountBefore;
+    if (count > 0)
+    {
+        bciwarn_ << ClassName(typeid(*inpFilter)) << "::" << inFunction << ": "
+                 << "Allocated heap memory " << count << " times while processing a single block, "
+                 << "consider using BlockArena() for temporaries";
+        mAllocationsReported = true;
+    }
+}
+
 GenericFilter::Chain &GenericFilter::RootChain()
 {
     static GenericFilter::Chain rootChain(Registrar::Registrars());
@@ -83,6 +105,11 @@ bool GenericFilter::TimedCalls() const
     return p->mTimedCalls;
 }
 
+Tiny::Arena &GenericFilter::BlockArena()
+{
+    return p->mBlockArena;
+}
+
 const struct GenericFilter::PerformanceData &GenericFilter::PerformanceData() const
 {
     return p->mPerformanceData;
@@ -296,16 +323,23 @@ void GenericFilter::CallInitialize(const SignalProperties &Input, const SignalPr
     p->mPerformanceData.totalDuration = 0;
     p->mPerformanceData.maxDuration = 0;
     p->mPerformanceData.minDuration = Inf<double>();
+    p->mPerformanceData.lastDuration = 0;
+    p->mPerformanceData.lastAllocations = -1;
     CALL_BODY_(Initialize, (Input, Output));
 }
 
 void GenericFilter::CallProcess(const GenericSignal &Input, GenericSignal &Output)
 {
+    Tiny::Arena::Scope arenaScope(p->mBlockArena);
+    int allocations = MemoryDebugging::HeapAllocations();
     if (p->mProfiling)
     {
-        StopWatch profWatch_;
+        Time begin = TimeUtils::MonotonicTime();
         TIMED_CALL_BODY_(Process, (Input, Output));
-        double t = profWatch_.Lapse() * 1e-3;
+        double t = (TimeUtils::MonotonicTime() - begin).Seconds();
+        p->mPerformanceData.lastDuration = t;
+        p->mPerformanceData.lastAllocations =
+            allocations < 0 ? -1 : MemoryDebugging::HeapAllocations() - allocations;
         ++p->mPerformanceData.count;
         p->mPerformanceData.totalDuration += t;
         p->mPerformanceData.minDuration = std::min(p->mPerformanceData.minDuration, t);
@@ -315,14 +349,22 @@ void GenericFilter::CallProcess(const GenericSignal &Input, GenericSignal &Outpu
     {
         TIMED_CALL_BODY_(Process, (Input, Output));
     }
+    p->CheckAllocations(this, "Process", allocations);
 }
 
 void GenericFilter::CallResting(const GenericSignal &Input, GenericSignal &Output)
 {
+    Tiny::Arena::Scope arenaScope(p->mBlockArena);
     TIMED_CALL_BODY_(Resting, (Input, Output));
 }
 
-CALL_0(StartRun)
+void GenericFilter::CallStartRun()
+{
+    p->mBlocksInRun = 0;
+    p->mAllocationsReported = false;
+    CALL_BODY_(StartRun, ());
+}
+
 CALL_0(StopRun)
 CALL_0(Resting)
 CALL_0(Halt)
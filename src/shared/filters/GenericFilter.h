@@ -26,6 +26,7 @@
 #ifndef GENERIC_FILTER_H
 #define GENERIC_FILTER_H
 
+#include "Arena.h"
 #include "Directory.h"
 #include "Environment.h"
 #include "GenericVisualization.h"
@@ -101,6 +102,10 @@ class GenericFilter : public Directory::Node, public Environment, private Uncopy
     }
     // Override this to always enable/disable timing measurement for Process() calls.
     virtual bool TimedCalls() const;
+    // An arena for temporaries that are only needed during a single Process()
+    // or Resting() call. All memory allocated from it is reclaimed when the call
+    // returns, and is reused in the next call without touching the heap.
+    Tiny::Arena &BlockArena();
 
   public:
     struct PerformanceData
@@ -110,6 +115,10 @@ class GenericFilter : public Directory::Node, public Environment, private Uncopy
         double maxDuration;
         double minDuration;
         double blockDuration;
+        // Duration of the most recent Process() call, and the number of heap
+        // allocations it made (-1 if allocations are not counted).
+        double lastDuration;
+        int lastAllocations;
     };
     const PerformanceData &PerformanceData() const;
     void EnableProfiling(bool);
@@ -27,6 +27,9 @@
 #include "Bitmap.h"
 #include "OpenGLContext.h"
 
+#include <algorithm>
+#include <cmath>
+
 #if 0
 #if _WIN32
 #include <Windows.h>
@@ -68,14 +71,28 @@ Bitmap& Bitmap::operator=(const Bitmap& inOther)
   return *this;
 }
 
-Bitmap &Bitmap::CopyFrom(const OpenGLTexture *inTexture)
+Bitmap &Bitmap::CopyFrom(const OpenGLTexture *inTexture, const Region *inpRegion)
 {
     OpenGLTexture::PixelInfo info = {};
     std::vector<uint32_t> pixels;
     inTexture->GetPixelData(info, pixels);
-    for (int x = 0; x < std::min(info.width, Width()); ++x)
-        for (int y = 0; y < std::min(info.height, Height()); ++y)
-            (*this)(x, Height() - y - 1) = RGBColor(pixels[y * info.width + x] & 0xffffff);
+    // Texture rows are bottom-up, so when heights differ, the texture's bottom
+    // row ends up in the bitmap's bottom row, as in a full copy.
+    int width = std::min(info.width, Width()), height = std::min(info.height, Height());
+    Rect full = {0, float(Height() - height), float(width), float(Height())};
+    Region region = inpRegion ? *inpRegion : Region(full);
+    region.Clip(full).Simplify();
+    for (const Rect *r = region.First(); r; r = region.Next(r))
+    {
+        int left = ::floor(r->left), right = ::ceil(r->right), top = ::floor(r->top), bottom = ::ceil(r->bottom);
+        for (int y = top; y < bottom; ++y)
+        {
+            int srcRow = Height() - y - 1;
+            const uint32_t *pSrc = pixels.data() + srcRow * info.width;
+            for (int x = left; x < right; ++x)
+                (*this)(x, y) = RGBColor(pSrc[x] & 0xffffff);
+        }
+    }
     return *this;
 }
 
@@ -44,7 +44,8 @@ class Bitmap : public BitmapImage
     Bitmap(int inWidth, int inHeight, uint16_t *inpData);
     Bitmap &operator=(const BitmapImage &);
     Bitmap &operator=(const Bitmap&);
-    Bitmap &CopyFrom(const OpenGLTexture *);
+    // When a region is given, only pixels inside that region are converted.
+    Bitmap &CopyFrom(const OpenGLTexture *, const Region * = nullptr);
 #if 0
   Bitmap& GrabFrom( void* window, const GUI::Rect* = 0 );
 #endif
@@ -44,6 +44,8 @@
 #include <QWindow>
 #endif
 
+#include <cmath>
+
 namespace
 {
 #if USE_QT
@@ -158,6 +160,8 @@ class OffscreenBuffer : public Lockable<std::mutex>
             }
         }
         mBitmap = GUI::Bitmap(mWidthPx, mHeightPx);
+        GUI::Rect r = {0, 0, float(mWidthPx), float(mHeightPx)};
+        mDirty = r;
         mValid = true;
     }
     void Destroy()
@@ -173,7 +177,38 @@ class OffscreenBuffer : public Lockable<std::mutex>
     {
         mpGL.load()->SwapBuffers();
         if (mHeightPx * mWidthPx != 0)
-          mBitmap.CopyFrom(mpFramebuffer->Front());
+          mBitmap.CopyFrom(mpFramebuffer->Front(), &mDirty);
+        mDirty.Clear();
+        mRequested = false;
+        mReady = true;
+    }
+    // Adds a region given in content coordinates to the region that needs to be
+    // read back into the bitmap.
+    void AddDirty(const GUI::Region &inRegion, const GUI::Rect &inContentRect)
+    {
+        if (inContentRect.Empty())
+            return;
+        float sx = mWidthPx / inContentRect.Width(), sy = mHeightPx / inContentRect.Height();
+        for (const GUI::Rect *p = inRegion.First(); p; p = inRegion.Next(p))
+        {
+            GUI::Rect r = {std::floor((p->left - inContentRect.left) * sx), std::floor((p->top - inContentRect.top) * sy),
+                           std::ceil((p->right - inContentRect.left) * sx),
+                           std::ceil((p->bottom - inContentRect.top) * sy)};
+            mDirty.Add(r);
+        }
+    }
+    bool Dirty() const
+    {
+        return !mDirty.Empty();
+    }
+    // Bitmap read-back is done on request only, so it does not burden every frame.
+    std::atomic<bool> &Requested()
+    {
+        return mRequested;
+    }
+    std::atomic<bool> &Ready()
+    {
+        return mReady;
     }
     GUI::OpenGLContext *Gl()
     {
@@ -194,6 +229,8 @@ class OffscreenBuffer : public Lockable<std::mutex>
     std::atomic<GUI::OpenGLContext *> mpGL;
     GUI::Framebuffer *mpFramebuffer;
     GUI::Bitmap mBitmap;
+    GUI::Region mDirty;
+    std::atomic<bool> mRequested{false}, mReady{false};
 };
 
 } // namespace
@@ -430,23 +467,35 @@ int DisplayWindow::Data::RenderingThreadFunc()
                     mpSelf->Emit(OnUpdateReceived, &r);
                 }
             }
+            auto &b = mScaledContentBuffer;
             if (mpSelf->InvalidRegion().Empty())
                 requests.clear();
             else
             { // paint into content buffer
-                mpSelf->Paint();
-                auto &b = mScaledContentBuffer;
+                GUI::Region painted;
+                mpSelf->Paint(&painted);
                 if (b.Gl())
-                    WithLock(b) WithGLContext(b.Gl())
-                    {
-                        // copy content buffer to visualization backbuffer
-                        b.Gl()->Clear(mpSelf->Color());
-                        pContentBuffer->Front()->CopyToCurrentViewport();
-                        b.Sync();
-                    }
+                    WithLock(b) b.AddDirty(painted, dc.rect);
                 Time renderEnd = TimeUtils::MonotonicTime();
                 renderObs.Observe((renderEnd - renderBegin).Seconds());
             }
+            if (b.Gl() && b.Requested())
+                WithLock(b)
+                {
+                    if (b.Dirty())
+                        WithGLContext(b.Gl())
+                        {
+                            // copy content buffer to visualization backbuffer, and read back changed pixels
+                            b.Gl()->Clear(mpSelf->Color());
+                            pContentBuffer->Front()->CopyToCurrentViewport();
+                            b.Sync();
+                        }
+                    else
+                    {
+                        b.Requested() = false;
+                        b.Ready() = true;
+                    }
+                }
 
             Time blitBegin = TimeUtils::MonotonicTime(), swapEnd;
             Time timeDone = nextFrame.time - nextFrame.rate.Period() / 2;
@@ -616,11 +665,30 @@ DisplayWindow &DisplayWindow::ConfigureBitmapBuffer(int inWidthPx, int inHeightP
     return *this;
 }
 
+bool DisplayWindow::RequestBitmapData()
+{
+    OffscreenBuffer &b = d->mScaledContentBuffer;
+    if (!b.Valid() || !b.Gl() || !d->mRenderingThread.Running())
+        return false;
+    b.Ready() = false;
+    b.Requested() = true;
+    return true;
+}
+
+bool DisplayWindow::BitmapDataReady() const
+{
+    return d->mScaledContentBuffer.Ready();
+}
+
 void DisplayWindow::OnBitmapData(GUI::Bitmap &ioImage, const GUI::Rect *inpRectPx) const
 {
     OffscreenBuffer &b = d->mScaledContentBuffer;
     if (b.Valid())
-        WithLock(b) ioImage = d->mScaledContentBuffer.Bitmap();
+        WithLock(b)
+        {
+            ioImage = d->mScaledContentBuffer.Bitmap();
+            b.Ready() = false;
+        }
     else
         GraphDisplay::OnBitmapData(ioImage, inpRectPx);
 }
@@ -115,6 +115,13 @@ class DisplayWindow : public GraphDisplay
     StringUtils::NameValueList Info() const;
 
     DisplayWindow &ConfigureBitmapBuffer(int width, int height);
+    // Asks the rendering thread to read back the bitmap buffer's changed pixels
+    // at its next opportunity. Returns false if there is no rendering thread to
+    // serve the request, in which case BitmapData() should be called directly.
+    bool RequestBitmapData();
+    // True when a requested read-back has completed, and BitmapData() has not
+    // been called since.
+    bool BitmapDataReady() const;
 
   protected:
     void OnBitmapData(GUI::Bitmap &, const GUI::Rect *) const override;
@@ -287,7 +287,7 @@ void GraphDisplay::Change()
     Invalidate();
 }
 
-void GraphDisplay::Paint()
+void GraphDisplay::Paint(GUI::Region *outpPainted)
 {
     GUI::DrawContext context = this->Context();
     const GUI::Rect &rect = context.rect;
@@ -301,6 +301,8 @@ void GraphDisplay::Paint()
         mpRegion->Clear();
     }
     invalidRegion.Clip(rect).Simplify();
+    if (outpPainted)
+        *outpPainted = invalidRegion;
     OpenGLContext *pGL = context.gl;
 
 #if USE_QT
@@ -82,7 +82,8 @@ class GraphDisplay : public Broadcaster, private Uncopyable
 
     // Events
     void Change();
-    void Paint();
+    // Paints the invalid region, and optionally reports it in pixel coordinates.
+    void Paint(GUI::Region * = nullptr);
 
     bool Tick(const ClockTick &);
     bool Click(const GUI::Point &);
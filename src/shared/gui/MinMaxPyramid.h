@@ -0,0 +1,174 @@
+////////////////////////////////////////////////////////////////////////////////
+// $Id$
+// Author: BCI2000 team
+// Description: A multi-resolution min/max summary of a GenericSignal's
+//   channels, used to draw signals with many more samples than pixels.
+//   Level 0 is the signal itself; each further level holds the minimum
+//   and maximum of pairs of entries in the level below, so the extrema
+//   over any sample range can be obtained in logarithmic time.
+//   Updates are incremental: after samples in a range have changed,
+//   only the entries above that range are recomputed.
+//   NaN samples are ignored; for a range that contains only NaNs,
+//   Extrema() returns an empty Range.
+//
+// $BEGIN_BCI2000_LICENSE$
+//
+// This file is part of BCI2000, a platform for real-time bio-signal research.
+// [ Copyright (C) 2000-2022: BCI2000 team and many external contributors ]
+//
+// BCI2000 is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// BCI2000 is distributed in the hope that it will be useful, but
+//                         WITHOUT ANY WARRANTY
+// - without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+// A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// $END_BCI2000_LICENSE$
+////////////////////////////////////////////////////////////////////////////////
+#ifndef MIN_MAX_PYRAMID_H
+#define MIN_MAX_PYRAMID_H
+
+#include "GenericSignal.h"
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+class MinMaxPyramid
+{
+  public:
+    struct Range
+    {
+        GenericSignal::ValueType min, max;
+        bool Empty() const
+        {
+            return !(min <= max);
+        }
+    };
+
+    MinMaxPyramid() : mpData(nullptr), mChannels(0), mSamples(0)
+    {
+    }
+
+    // Attaches to a signal, and builds all levels from scratch.
+    void Rebuild(const GenericSignal &inData)
+    {
+        mpData = &inData;
+        mChannels = inData.Channels();
+        mSamples = inData.Elements();
+        mLevels.clear();
+        for (int length = (mSamples + 1) / 2; mSamples > 1; length = (length + 1) / 2)
+        {
+            mLevels.push_back(Level(length, mChannels));
+            if (length == 1)
+                break;
+        }
+        Update(0, mSamples);
+    }
+
+    // Recomputes levels above the sample range [inBegin, inEnd) for all channels.
+    void Update(int inBegin, int inEnd)
+    {
+        if (!mpData || inBegin >= inEnd)
+            return;
+        int begin = std::max(inBegin, 0), end = std::min(inEnd, mSamples);
+        for (size_t l = 0; l < mLevels.size(); ++l)
+        {
+            begin /= 2;
+            end = (end + 1) / 2;
+            Level &level = mLevels[l];
+            for (int ch = 0; ch < mChannels; ++ch)
+                for (int i = begin; i < end; ++i)
+                {
+                    Range r = EmptyRange();
+                    Combine(r, Child(l, ch, 2 * i));
+                    if (2 * i + 1 < ChildLength(l))
+                        Combine(r, Child(l, ch, 2 * i + 1));
+                    level.At(ch, i) = r;
+                }
+        }
+    }
+
+    // Extrema of a channel over the sample range [inBegin, inEnd).
+    Range Extrema(int inCh, int inBegin, int inEnd) const
+    {
+        Range r = EmptyRange();
+        int begin = std::max(inBegin, 0), end = std::min(inEnd, mSamples);
+        if (!mpData)
+            return r;
+        for (size_t l = 0; begin < end; ++l)
+        {
+            if (begin & 1)
+                Combine(r, Child(l, inCh, begin++));
+            if (end & 1)
+                Combine(r, Child(l, inCh, --end));
+            if (l == mLevels.size())
+            {
+                for (int i = begin; i < end; ++i)
+                    Combine(r, Child(l, inCh, i));
+                break;
+            }
+            begin /= 2;
+            end /= 2;
+        }
+        return r;
+    }
+
+  private:
+    struct Level : std::vector<Range>
+    {
+        Level(int length, int channels) : std::vector<Range>(length * channels), length(length)
+        {
+        }
+        Range &At(int ch, int i)
+        {
+            return (*this)[ch * length + i];
+        }
+        const Range &At(int ch, int i) const
+        {
+            return (*this)[ch * length + i];
+        }
+        int length;
+    };
+
+    static Range EmptyRange()
+    {
+        Range r = {std::numeric_limits<GenericSignal::ValueType>::infinity(),
+                   -std::numeric_limits<GenericSignal::ValueType>::infinity()};
+        return r;
+    }
+    static void Combine(Range &ioRange, const Range &inRange)
+    {
+        // Comparisons with NaN are false, so NaN samples leave the range unchanged.
+        if (inRange.min < ioRange.min)
+            ioRange.min = inRange.min;
+        if (inRange.max > ioRange.max)
+            ioRange.max = inRange.max;
+    }
+    // Entry i of the level below level l, i.e. signal samples for l == 0.
+    Range Child(size_t l, int ch, int i) const
+    {
+        if (l == 0)
+        {
+            GenericSignal::ValueType value = (*mpData)(ch, i);
+            Range r = {value, value};
+            return r;
+        }
+        return mLevels[l - 1].At(ch, i);
+    }
+    int ChildLength(size_t l) const
+    {
+        return l == 0 ? mSamples : mLevels[l - 1].length;
+    }
+
+    const GenericSignal *mpData;
+    int mChannels, mSamples;
+    std::vector<Level> mLevels;
+};
+
+#endif // MIN_MAX_PYRAMID_H
@@ -29,9 +29,12 @@
 #include "Exception.h"
 #include "FastConv.h"
 #include "Tree.h"
+#include "UnitTest.h"
 
 #include <cmath>
 #include <iomanip>
+#include <limits>
+#include <random>
 #include <sstream>
 
 #include <QPainter>
@@ -39,6 +42,51 @@
 
 #undef TEST_UPDATE_RGN
 
+UnitTest(MinMaxPyramidTest)
+{
+    // Queries are compared against a brute-force search while samples are appended
+    // in chunks of varying size, such that updates cross level boundaries.
+    std::mt19937 random(1);
+    auto draw = [&random](int n) { return static_cast<int>(random() % n); };
+    for (int samples : {1, 2, 3, 5, 8, 13, 64, 100, 257})
+    {
+        SignalProperties p(2, samples);
+        GenericSignal signal(p, GenericSignal::NaN);
+        MinMaxPyramid pyramid;
+        pyramid.Rebuild(signal);
+        int filled = 0;
+        while (filled < samples)
+        {
+            int count = std::min(1 + draw(17), samples - filled);
+            for (int ch = 0; ch < signal.Channels(); ++ch)
+                for (int i = filled; i < filled + count; ++i)
+                    signal(ch, i) = draw(10) ? draw(2001) - 1000 : GenericSignal::NaN;
+            pyramid.Update(filled, filled + count);
+            filled += count;
+            for (int query = 0; query < 20; ++query)
+            {
+                int ch = draw(signal.Channels()), begin = draw(samples + 1), end = draw(samples + 1);
+                if (begin > end)
+                    std::swap(begin, end);
+                double min = std::numeric_limits<double>::infinity(), max = -min;
+                for (int i = begin; i < end; ++i)
+                {
+                    if (signal(ch, i) < min)
+                        min = signal(ch, i);
+                    if (signal(ch, i) > max)
+                        max = signal(ch, i);
+                }
+                MinMaxPyramid::Range r = pyramid.Extrema(ch, begin, end);
+                TestFail_if(r.Empty() != (min > max), samples << " samples, [" << begin << ", " << end
+                                                              << "): emptiness differs");
+                TestFail_if(!r.Empty() && (r.min != min || r.max != max),
+                            samples << " samples, [" << begin << ", " << end << "): got " << r.min << ".." << r.max
+                                    << ", expected " << min << ".." << max);
+            }
+        }
+    }
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 const RGBColor SignalDisplay::cAxisColorDefault = RGBColor::Aqua;
 const RGBColor SignalDisplay::cChannelColorsDefault[] = {RGBColor::White, RGBColor::White,  RGBColor::White,
@@ -51,14 +99,13 @@ SignalDisplay::SignalDisplay()
       mNumSamples(cNumSamplesDefault), mSampleCursor(0), mNumDisplayGroups(0), mMaxDisplayGroups(0),
       mNumDisplayChannels(0), mTopGroup(0), mChannelGroupSize(1), mMarkerChannels(0), mTickLength(mTickLength),
       mFontSize(11), mNumericValueWidth(0), mMinValue(cMinValueDefault), mMaxValue(cMaxValueDefault),
-      mAxisColor(cAxisColorDefault), mChannelColors(cChannelColorsDefault), mParent(NULL), mpSignalPoints(NULL),
+      mAxisColor(cAxisColorDefault), mChannelColors(cChannelColorsDefault), mParent(NULL),
       mSymbolWidth(cLabelWidth)
 {
 }
 
 SignalDisplay::~SignalDisplay()
 {
-    delete[] mpSignalPoints;
 }
 
 namespace
@@ -192,6 +239,7 @@ void SignalDisplay::AdaptTo(const GenericSignal &inSignal)
         WithLock(mDataLock)
         {
             mData = GenericSignal(SignalProperties(inSignal.Channels(), mNumSamples), GenericSignal::NaN);
+            mDataExtrema.Rebuild(mData);
             SetDisplayGroups(DisplayGroups());
             SyncLabelWidth();
             mSampleCursor = 0;
@@ -211,6 +259,11 @@ SignalDisplay &SignalDisplay::WrapForward(const GenericSignal &inSignal)
     for (int i = 0; i < inSignal.Channels(); ++i)
         for (int j = 0; j < inSignal.Elements(); ++j)
             mData(i, (mSampleCursor + j) % mData.Elements()) = inSignal(i, j);
+    // Only the summary above newly written samples needs updating.
+    int updateEnd = mSampleCursor + inSignal.Elements();
+    mDataExtrema.Update(mSampleCursor, updateEnd);
+    if (updateEnd > mData.Elements())
+        mDataExtrema.Update(0, updateEnd - mData.Elements());
 
     SyncGraphics();
 
@@ -299,6 +352,7 @@ SignalDisplay &SignalDisplay::ScrollForward(const GenericSignal &inSignal)
         while (j < mData.Elements())
             mData(i, j++) = inSignal(i, k++);
     }
+    mDataExtrema.Rebuild(mData);
 
     SyncGraphics();
     Invalidate();
@@ -327,6 +381,7 @@ SignalDisplay &SignalDisplay::ScrollBack(const GenericSignal &inSignal)
         while (j > 0)
             mData(i, --j) = inSignal(i, --k);
     }
+    mDataExtrema.Rebuild(mData);
 
     SyncGraphics();
     Invalidate();
@@ -493,6 +548,7 @@ SignalDisplay &SignalDisplay::SetNumSamples(int inNumSamples)
             ++idx2;
         }
         mData = newData;
+        mDataExtrema.Rebuild(mData);
         mSampleCursor = 0;
         Invalidate();
         mNumSamples = newNumSamples;
@@ -687,25 +743,44 @@ void SignalDisplay::DrawSignalPolyline(const PaintInfo &p)
         sampleEnd = PosToSample(clipRect.right() + 1);
         sampleEnd = std::min(sampleEnd + 1, mNumSamples);
     }
-    delete[] mpSignalPoints;
-    try
-    {
-        mpSignalPoints = new QPoint[mNumSamples];
-    }
-    catch (const std::bad_alloc &)
-    {
-        throw std_bad_alloc << "Could not allocate memory for " << mNumSamples << " points";
-    }
+    // With more samples than pixel columns, we draw from the min/max summary,
+    // i.e. at most two points per pixel column.
+    bool decimate = (mNumSamples > 2 * mDataWidth && mData.Elements() == mNumSamples);
+    size_t numPoints = decimate ? 2 * (mDataWidth + 1) : mNumSamples;
+    if (mSignalPoints.size() < numPoints)
+        try
+        {
+            mSignalPoints.resize(numPoints);
+        }
+        catch (const std::bad_alloc &)
+        {
+            throw std_bad_alloc << "Could not allocate memory for " << numPoints << " points";
+        }
     p.painter->setFont(p.symbolFont);
     int numPens = static_cast<int>(p.signalPens.size());
 
-    for (int j = sampleBegin; j < sampleEnd; ++j)
-        mpSignalPoints[j].setX(SampleLeft(j));
+    QPoint *pSignalPoints = mSignalPoints.data();
+    if (!decimate)
+        for (int j = sampleBegin; j < sampleEnd; ++j)
+            pSignalPoints[j].setX(SampleLeft(j));
     for (int i = 0; i < mNumDisplayChannels; ++i)
     {
         int channelBottom = ChannelBottom(i), channel = i + mTopGroup * mChannelGroupSize;
         QString style = p.signalStyles[channel % p.signalStyles.length()];
         p.painter->setPen(p.signalPens[channel % numPens]);
+        if (decimate)
+        {
+            if (sampleBegin < mSampleCursor && mSampleCursor < sampleEnd)
+            {
+                DrawDecimatedPolyline(p, i, style, sampleBegin, mSampleCursor);
+                DrawDecimatedPolyline(p, i, style, mSampleCursor, sampleEnd);
+            }
+            else
+            {
+                DrawDecimatedPolyline(p, i, style, sampleBegin, sampleEnd);
+            }
+            continue;
+        }
         int runEnd = sampleBegin;
         while (runEnd < sampleEnd)
         {
@@ -721,21 +796,70 @@ void SignalDisplay::DrawSignalPolyline(const PaintInfo &p)
                     y = maxY;
                 else if (y < minY)
                     y = minY;
-                mpSignalPoints[runEnd++].setY(ToInt(y));
+                pSignalPoints[runEnd++].setY(ToInt(y));
             }
             if (runBegin <= mSampleCursor && mSampleCursor < runEnd)
             {
-                DrawLine(p.painter, style, mpSignalPoints + runBegin, mSampleCursor - runBegin);
-                DrawLine(p.painter, style, mpSignalPoints + mSampleCursor, runEnd - mSampleCursor);
+                DrawLine(p.painter, style, pSignalPoints + runBegin, mSampleCursor - runBegin);
+                DrawLine(p.painter, style, pSignalPoints + mSampleCursor, runEnd - mSampleCursor);
             }
             else
             {
-                DrawLine(p.painter, style, mpSignalPoints + runBegin, runEnd - runBegin);
+                DrawLine(p.painter, style, pSignalPoints + runBegin, runEnd - runBegin);
             }
         }
     }
 }
 
+void SignalDisplay::DrawDecimatedPolyline(const PaintInfo &p, int i, const QString &style, int sampleBegin,
+                                          int sampleEnd)
+{
+    float baseInterval = mNumDisplayGroups > 0 ? mDataHeight / mNumDisplayGroups : mDataHeight;
+    double maxY = mDataRect.bottom() + 1, minY = mDataRect.top() - 1;
+    int channelBottom = ChannelBottom(i), channel = i + mTopGroup * mChannelGroupSize;
+    QPoint *pPoints = mSignalPoints.data();
+    int numPoints = 0, prevY = 0;
+    int columnBegin = sampleBegin;
+    while (columnBegin < sampleEnd)
+    {
+        // Samples [columnBegin, columnEnd) map to the same pixel column.
+        int x = SampleLeft(columnBegin), columnEnd = std::max(columnBegin + 1, PosToSample(x + 1));
+        while (columnEnd < sampleEnd && SampleLeft(columnEnd) <= x)
+            ++columnEnd;
+        columnEnd = std::min(columnEnd, sampleEnd);
+        MinMaxPyramid::Range r = mDataExtrema.Extrema(channel, columnBegin, columnEnd);
+        columnBegin = columnEnd;
+        if (r.Empty())
+        { // A column without valid data interrupts the line.
+            if (numPoints > 0)
+                DrawLine(p.painter, style, pPoints, numPoints);
+            numPoints = 0;
+            continue;
+        }
+        int y[2];
+        double range = mMaxValue - mMinValue,
+               values[2] = {(r.min - mMinValue) / range, (r.max - mMinValue) / range};
+        for (int k = 0; k < 2; ++k)
+        {
+            double v = channelBottom - 1 - baseInterval * values[k];
+            if (v > maxY)
+                v = maxY;
+            else if (v < minY)
+                v = minY;
+            y[k] = ToInt(v);
+        }
+        // Enter the column at the end closer to the previous column's exit point.
+        if (numPoints > 0 && std::abs(y[1] - prevY) < std::abs(y[0] - prevY))
+            std::swap(y[0], y[1]);
+        pPoints[numPoints++] = QPoint(x, y[0]);
+        if (y[1] != y[0])
+            pPoints[numPoints++] = QPoint(x, y[1]);
+        prevY = y[1];
+    }
+    if (numPoints > 0)
+        DrawLine(p.painter, style, pPoints, numPoints);
+}
+
 void SignalDisplay::DrawSignalField2d(const PaintInfo &p)
 {
     int sampleBegin = 0, sampleEnd = mNumSamples;
@@ -36,6 +36,7 @@
 #include "GenericSignal.h"
 #include "Label.h"
 #include "Lockable.h"
+#include "MinMaxPyramid.h"
 #include <set>
 #include <vector>
 
@@ -456,6 +457,7 @@ class SignalDisplay
     std::string mChannelLabelWidth;
     std::vector<std::pair<double, RGBColor>> mValueColors;
     GenericSignal mData;
+    MinMaxPyramid mDataExtrema;
     Lockable<std::recursive_mutex> mDataLock;
 
   private:
@@ -463,6 +465,7 @@ class SignalDisplay
     void SetupPainting(PaintInfo &, const void *);
     void ClearBackground(const PaintInfo &);
     void DrawSignalPolyline(const PaintInfo &);
+    void DrawDecimatedPolyline(const PaintInfo &, int channel, const QString &style, int sampleBegin, int sampleEnd);
     void DrawSignalField2d(const PaintInfo &);
     void DrawMarkerChannels(const PaintInfo &);
     void DrawCursor(const PaintInfo &);
@@ -482,7 +485,7 @@ class SignalDisplay
     QPaintDevice *mParent;
     QRect mDisplayRect, mDataRect, mCursorRect;
     QRegion mDisplayRgn;
-    QPoint *mpSignalPoints;
+    std::vector<QPoint> mSignalPoints;
     int mSymbolWidth;
 
     struct PaintInfo
@@ -38,6 +38,7 @@
 #include "SysCommand.h"
 
 #include "Sockets.h"
+#include "UnitTest.h"
 
 CoreConnection::CoreConnection(Client &client)
     : MessageChannel(mBuffer), mIsLocal(true), mrClient(client), mpUserData(0),
@@ -57,6 +58,7 @@ CoreConnection &CoreConnection::SetInput(Tiny::InputObject *input, bool async)
 {
     mReceiver.SetInput(input);
     mReceiver.SetAsync(async);
+    ResetReceivedStateVector();
     Waitable::AssociateWith(mReceiver);
     return *this;
 }
@@ -65,6 +67,7 @@ CoreConnection &CoreConnection::SetOutput(Tiny::OutputObject *output, bool async
 {
     mBuffer.SetOutput(output);
     mSender.SetAsync(async);
+    ResetSentStateVector();
     return *this;
 }
 
@@ -74,6 +77,11 @@ CoreConnection &CoreConnection::SetIO(Tiny::IOObject *io, int flags)
     return SetOutput(io ? &io->Output() : 0, flags & AsyncSend);
 }
 
+bool CoreConnection::OnCongested()
+{
+    return mSender.Async() && !mSender.Empty().Test();
+}
+
 bool CoreConnection::OnMessageBuffered(const Message &msg)
 {
     if (!mSender.Async())
@@ -107,6 +115,11 @@ bool CoreConnection::HandleMessage(CoreConnection *p, const Message &r)
     return p->MessageChannel::Handle(r);
 }
 
+void CoreConnection::NotifyQueued(CoreConnection *p)
+{
+    p->mrClient.OnMessageQueued(*p);
+}
+
 int CoreConnection::HandleMessages(int inMax)
 {
     return mReceiver.DoHandleMessages(inMax);
@@ -250,6 +263,7 @@ bool CoreConnection::Receiver::OnMessageReceived(const Message &msg)
             throw std_runtime_error << "Error reading message into memory";
     }
     mQueue.Produce(msg);
+    NotifyQueued(mpParent);
     return true;
 }
 
@@ -258,4 +272,39 @@ void CoreConnection::Receiver::ThreadFunc()
     while (!mThread.Terminating() && mBuffer.Input()->Good() &&
            (mBuffer.Input()->Available() || mBuffer.Input()->Wait()))
         MessageChannel::HandleMessages();
+    // At end of input, the consumer must still wake up to notice the connection's state.
+    if (!mThread.Terminating())
+    {
+        NotifyQueued(mpParent);
+        mQueue.Wake();
+    }
+}
+
+UnitTest(CoreConnectionCloseTest)
+{
+    // When the remote side closes, a connection that receives asynchronously
+    // must wake up its consumer, so it may notice the closed connection.
+    struct : CoreConnection::Client
+    {
+        std::atomic<int> queued{ 0 };
+        void OnMessageQueued(CoreConnection &) override
+        {
+            ++queued;
+        }
+    } client;
+    ServerTCPSocket server;
+    server.Open("127.0.0.1", 0);
+    TestRequire(server.IsOpen());
+    ClientTCPSocket socket;
+    socket.Open(server.IP(), server.Port());
+    TestRequire(socket.IsOpen() && server.WaitForAccept(5000));
+    CoreConnection connection(client);
+    connection.SetIO(&socket, CoreConnection::AsyncReceive);
+    TestFail_if(connection.Wait(Time::Seconds(0.1)), "connection signaled without input");
+    server.Close();
+    TestFail_if(!connection.Wait(Time::Seconds(5)), "connection not signaled when closed");
+    TestFail_if(client.queued == 0, "client not notified when closed");
+    connection.HandleMessages();
+    TestFail_if(socket.Connected(), "socket still connected");
+    connection.SetIO(nullptr);
 }
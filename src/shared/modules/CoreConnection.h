@@ -177,6 +177,11 @@ class CoreConnection : public MessageChannel, public Waitable
         {
             return true;
         }
+        // Called from the receiving thread of an asynchronous connection when a
+        // message has been queued.
+        virtual void OnMessageQueued(CoreConnection &)
+        {
+        }
     };
 
   public:
@@ -251,6 +256,7 @@ class CoreConnection : public MessageChannel, public Waitable
     bool OnSend(const VisCfg &) override;
 
   protected:
+    bool OnCongested() override;
     bool OnMessageBuffered(const Message &) override;
     bool OnMessageReceived(const Message &) override;
 
@@ -291,6 +297,7 @@ class CoreConnection : public MessageChannel, public Waitable
     void WriteMessage(const Message &);
     static void WriteMessage(CoreConnection *, const Message &);
     static bool HandleMessage(CoreConnection *, const Message &);
+    static void NotifyQueued(CoreConnection *);
 
   private:
     UnbufferedIO mBuffer;
@@ -41,6 +41,8 @@
 #include "SysCommand.h"
 #include "VersionInfo.h"
 
+#include <algorithm>
+#include <cmath>
 #include <cstdlib>
 #include <sstream>
 #include <string>
@@ -50,10 +52,19 @@
 
 static const std::string sModuleName = FileUtils::ExtractBase(FileUtils::ExecutablePath());
 
+// Offset into status message codes. A fused module reports its state like a source module.
+#if MODTYPE == FUSED
+static const int sStatusOffset = 0;
+#else
+static const int sStatusOffset = MODTYPE - 1;
+#endif
+
 CoreModule::CoreModule()
-    : mFiltersInitialized(false), mTerminating(false), mRunning(false), mActiveResting(false), mStartRunPending(false),
+    : mFiltersInitialized(false), mTerminating(false), mRunning(false), mActiveResting(false), mNextBlockPending(false),
+      mStartRunPending(false),
       mStopRunPending(false), mNeedStopRun(false), mReceivingNextModuleInfo(false), mGlobalID(NULL),
-      mOperatorBackLink(false), mAutoConfig(false), mOperator(*this), mPreviousModule(*this), mNextModule(*this),
+      mOperatorBackLink(false), mAutoConfig(false), mWakeupPending(false), mWakeups(0), mMaxDispatchLatency(0),
+      mOperator(*this), mPreviousModule(*this), mNextModule(*this),
       mInitialStatevector(0, 0), mEnvironment(*Environment::Context::GlobalInstance())
 {
     mOperatorSocket.SetFlushAfterWrite(true);
@@ -123,6 +134,11 @@ bool CoreModule::IsLastModule() const
 #endif
 }
 
+bool CoreModule::IsFusedModule() const
+{
+    return IsFirstModule() && IsLastModule();
+}
+
 bool CoreModule::Initialize(int &ioArgc, char **ioArgv)
 {
     // Make sure there is only one instance of each module running at a time.
@@ -243,14 +259,23 @@ bool CoreModule::Initialize(int &ioArgc, char **ioArgv)
 // and only be left when the program exits.
 void CoreModule::MainMessageLoop()
 {
-    // max time a GUI event needs to wait before it gets processed
-    const Time::Interval bciMessageTimeout = Time::Seconds(0.1);
     Waitables inputs;
-    inputs.Add(mOperator).Add(mPreviousModule);
+    inputs.Add(mOperator);
+    if (!IsFusedModule())
+        inputs.Add(mPreviousModule);
 
     while (!mTerminating)
     {
-        inputs.Wait(bciMessageTimeout);
+        // The previous module's socket is connected after the main loop has been entered.
+        // The Operator socket is read by the connection's receiving thread, which
+        // calls OnWakeUp() instead.
+        std::vector<std::ptrdiff_t> fds;
+        if (!IsFusedModule() && mPreviousModuleSocket.IsOpen())
+            fds.push_back(mPreviousModuleSocket.Fd());
+        OnWaitForMessages(inputs, fds);
+        mWakeupTime = TimeUtils::MonotonicTime();
+        mWakeupPending = true;
+        ++mWakeups;
         ProcessBCIAndGUIMessages();
         if (mOperator.Bad() || !mOperatorSocket.Connected())
             Terminate();
@@ -262,16 +287,24 @@ void CoreModule::ProcessBCIAndGUIMessages()
     bool repeat = true;
     while (repeat)
     {
-        mPreviousModule.HandleMessages();
+        if (!IsFusedModule())
+            mPreviousModule.HandleMessages();
         mOperator.HandleMessages();
 
-
         repeat = false;
-        if (mActiveResting && !mTerminating)
+        if ((mActiveResting || mNextBlockPending) && !mTerminating)
         {
+            if (mNextBlockPending && mWakeupPending)
+            {
+                double latency = (TimeUtils::MonotonicTime() - mWakeupTime).Seconds();
+                mDispatchLatency.Observe(latency);
+                mMaxDispatchLatency = std::max(mMaxDispatchLatency, latency);
+                mWakeupPending = false;
+            }
+            mNextBlockPending = false;
             ProcessFilters();
             mActiveResting &= bcierr__.Empty();
-            repeat |= mActiveResting;
+            repeat |= mActiveResting || mNextBlockPending;
         }
         // Allow for the GUI to process messages from its message queue if there are any.
         OnProcessGUIMessages();
@@ -282,9 +315,9 @@ void CoreModule::ProcessBCIAndGUIMessages()
         if (mOperator.Bad())
             bcierr << "Lost connection to operator: " << mOperator.DescribeIOState();
 #endif
-        if (mPreviousModule.Bad())
+        if (!IsFusedModule() && mPreviousModule.Bad())
             bcierr << "Lost connection to " PREVMODULE ": " << mPreviousModule.DescribeIOState();
-        if (mNextModule.Bad())
+        if (!IsFusedModule() && mNextModule.Bad())
             bcierr << "Lost connection to " NEXTMODULE ": " << mNextModule.DescribeIOState();
     }
 }
@@ -397,6 +430,11 @@ void CoreModule::InitializeOperatorConnection(const std::string &inOperatorAddre
 
 void CoreModule::InitializeCoreConnections()
 {
+    if (IsFusedModule())
+    { // All filter chains live in this process, so there are no other core modules to connect to.
+        mServerSocket.Close();
+        return;
+    }
     std::string nextModuleAddress, address = "/NextModuleAddress";
     if (mNextModuleInfo.Exists(address))
         nextModuleAddress = mNextModuleInfo.ByPath(address).Value();
@@ -605,7 +643,7 @@ void CoreModule::InitializeFilters()
     }
     if (bcierr__.Empty())
     {
-        mOperator.Send(Status(sModuleName + " initialized", Status::firstInitializedMessage + MODTYPE - 1));
+        mOperator.Send(Status(sModuleName + " initialized", Status::firstInitializedMessage + sStatusOffset));
         mFiltersInitialized = true;
         mActiveResting = IsFirstModule();
     }
@@ -614,13 +652,17 @@ void CoreModule::InitializeFilters()
 void CoreModule::StartRunFilters()
 {
     mStartRunPending = false;
+    mRunStartTime = TimeUtils::MonotonicTime();
+    mWakeups = 0;
+    mDispatchLatency.Reset();
+    mMaxDispatchLatency = 0;
     mActiveResting = false;
     mEnvironment.EnterPhase(Environment::startRun, &mParamlist, &mStatelist, &mStatevector);
     GenericFilter::StartRunFilters();
     mEnvironment.EnterPhase(Environment::nonaccess);
     mNeedStopRun = true;
     if (bcierr__.Empty())
-        mOperator.Send(Status(sModuleName + " running", Status::firstRunningMessage + 2 * (MODTYPE - 1)));
+        mOperator.Send(Status(sModuleName + " running", Status::firstRunningMessage + 2 * sStatusOffset));
 }
 
 void CoreModule::StopRunFilters()
@@ -629,14 +671,16 @@ void CoreModule::StopRunFilters()
     mEnvironment.EnterPhase(Environment::stopRun, &mParamlist, &mStatelist, &mStatevector);
     GenericFilter::StopRunFilters();
     mEnvironment.EnterPhase(Environment::nonaccess);
+    GenericVisualization::SendPending(true);
     mNeedStopRun = false;
+    ReportWakeupStatistics();
     ResetStatevector();
     if (bcierr__.Empty() && !mTerminating)
     {
         BroadcastParameterChanges();
         if (IsFirstModule())
             mOperator.Send(SysCommand::Suspend);
-        mOperator.Send(Status(sModuleName + " suspended", Status::firstSuspendedMessage + 2 * (MODTYPE - 1)));
+        mOperator.Send(Status(sModuleName + " suspended", Status::firstSuspendedMessage + 2 * sStatusOffset));
     }
     mEnvironment.EnterPhase(Environment::resting, &mParamlist, &mStatelist, &mStatevector);
     GenericFilter::RestingFilters();
@@ -644,6 +688,21 @@ void CoreModule::StopRunFilters()
     mActiveResting = IsFirstModule();
 }
 
+void CoreModule::ReportWakeupStatistics()
+{
+    if (!mParamlist.Exists("/DebugLevel") || !::atoi(mParamlist.ByPath("/DebugLevel").Value().c_str()))
+        return;
+    double duration = (TimeUtils::MonotonicTime() - mRunStartTime).Seconds();
+    std::ostringstream oss;
+    oss << "Main loop: " << mWakeups << " wakeups in " << duration << "s";
+    if (mDispatchLatency.Count() > 0)
+        oss << ", wakeup-to-dispatch latency over " << mDispatchLatency.Count() << " blocks: "
+            << "mean " << mDispatchLatency.Mean() * 1e3 << "ms, "
+            << "std dev " << ::sqrt(mDispatchLatency.Variance()) * 1e3 << "ms, "
+            << "max " << mMaxDispatchLatency * 1e3 << "ms";
+    bciout << oss.str();
+}
+
 void CoreModule::BroadcastParameterChanges()
 {
     ParamList changedParameters;
@@ -668,6 +727,7 @@ void CoreModule::ProcessFilters()
     mEnvironment.EnterPhase(Environment::processing, &mParamlist, &mStatelist, &mStatevector);
     GenericFilter::ProcessFilters(mInputSignal, mOutputSignal, !(mRunning || wasRunning));
     mEnvironment.EnterPhase(Environment::nonaccess);
+    GenericVisualization::SendPending();
     if (bcierr__.Empty() && (mRunning || wasRunning))
         SendOutput();
     if (bcierr__.Empty() && mStopRunPending)
@@ -683,6 +743,11 @@ void CoreModule::SendOutput()
         mOperator.Send(mStatevector);
         mOperator.Send(mOutputSignal);
     }
+    if (IsFusedModule())
+    { // Hand the state vector back to the source chain without serializing it.
+        mNextBlockPending = true;
+        return;
+    }
     mNextModule.Send(mStatevector);
     if (!IsLastModule())
         mNextModule.Send(mOutputSignal);
@@ -754,6 +819,11 @@ void CoreModule::OnReceive(CoreConnection &, const VisSignalProperties &s)
     }
 }
 
+void CoreModule::OnReceive(CoreConnection &, const VisCfg &v)
+{
+    GenericVisualization::ApplyDisplayFeedback(v);
+}
+
 bool CoreModule::OnStateVector(CoreConnection &, std::istream &is)
 {
     mStatevector.Unserialize(is);
@@ -797,6 +867,11 @@ void CoreModule::OnReceive(CoreConnection &, const ProtocolVersion &p)
     }
 }
 
+void CoreModule::OnMessageQueued(CoreConnection &)
+{
+    OnWakeUp();
+}
+
 bool CoreModule::OnSend(CoreConnection &inConnection, const VisSignal &inSignal)
 {
     const GenericSignal *pSignal = &inSignal.Signal();
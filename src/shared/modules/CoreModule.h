@@ -35,6 +35,24 @@
 //              }
 //           };
 //
+//          The main loop does not poll. Between messages, it calls
+//          OnWaitForMessages(), which must return when one of the given
+//          file descriptors becomes readable, when OnWakeUp() is called, or
+//          when there are GUI events to process. The default implementation only
+//          waits for BCI messages, so GUI integrations must override it as well,
+//          e.g. by registering the file descriptors with the GUI's own event
+//          dispatcher, and waking up the dispatcher from OnWakeUp().
+//          OnWakeUp() is called from another thread when a message arrives at
+//          the Operator connection, which is read by a thread of its own, and
+//          when that connection is closed.
+//
+//          A fused module (MODTYPE == FUSED) contains the source, signal processing,
+//          and application filter chains in a single executable. Towards the
+//          Operator, it acts as a system consisting of a single module, e.g.
+//            Startup system localhost Fused:4000
+//          Blocks are handed from one chain to the next in memory, and the state
+//          vector is passed back to the source chain without leaving the process.
+//
 // $BEGIN_BCI2000_LICENSE$
 //
 // This file is part of BCI2000, a platform for real-time bio-signal research.
@@ -64,10 +82,15 @@
 #include "GenericVisualization.h"
 #include "ParamList.h"
 #include "ProtocolVersion.h"
+#include "SimpleStatistics.h"
 #include "Sockets.h"
 #include "StateList.h"
 #include "StateVector.h"
+#include "TimeUtils.h"
 #include "Uncopyable.h"
+#include "Waitable.h"
+
+#include <vector>
 
 #if MODTYPE
 
@@ -77,6 +100,8 @@
 #define SIGPROC_NAME "SignalProcessing"
 #define APP 3
 #define APP_NAME "Application"
+#define FUSED 4
+#define FUSED_NAME "Fused"
 
 #if (MODTYPE == SIGSRC)
 #define THISMODULE SIGSRC_NAME
@@ -93,6 +118,11 @@
 #define THISOPPORT "4002"
 #define THISMODULE APP_NAME
 #define NEXTMODULE SIGSRC_NAME
+#elif (MODTYPE == FUSED)
+#define PREVMODULE FUSED_NAME
+#define THISOPPORT "4000"
+#define THISMODULE FUSED_NAME
+#define NEXTMODULE FUSED_NAME
 #else
 #error Unknown MODTYPE value
 #endif
@@ -129,15 +159,24 @@ class CoreModule : CoreConnection::Client, Uncopyable
     {
         return false;
     }
+    virtual void OnWaitForMessages(const Waitables &inputs, const std::vector<std::ptrdiff_t> &inputFds)
+    {
+        inputs.Wait();
+    }
+    virtual void OnWakeUp()
+    {
+    }
 
   private:
     void DoRun(int &argc, char **argv);
     bool Initialize(int &argc, char **argv);
     void MainMessageLoop();
     void ProcessBCIAndGUIMessages();
+    void ReportWakeupStatistics();
 
     bool IsFirstModule() const;
     bool IsLastModule() const;
+    bool IsFusedModule() const;
 
     void InitializeOperatorConnection(const std::string &operatorAddress);
     void InitializeCoreConnections();
@@ -165,8 +204,10 @@ class CoreModule : CoreConnection::Client, Uncopyable
     void OnReceive(CoreConnection &, const State &) override;
     void OnReceive(CoreConnection &, const VisSignal &) override;
     void OnReceive(CoreConnection &, const VisSignalProperties &) override;
+    void OnReceive(CoreConnection &, const VisCfg &) override;
     void OnReceive(CoreConnection &, const SysCommand &) override;
     void OnReceive(CoreConnection &, const ProtocolVersion &) override;
+    void OnMessageQueued(CoreConnection &) override;
 
     bool OnSend(CoreConnection &, const VisSignal &) override;
 
@@ -183,7 +224,13 @@ class CoreModule : CoreConnection::Client, Uncopyable
         mReceivingNextModuleInfo;
     void *mGlobalID;
     bool mOperatorBackLink, mAutoConfig;
-    bool mActiveResting;
+    bool mActiveResting, mNextBlockPending;
+    // Time from returning from OnWaitForMessages() to processing a block.
+    bool mWakeupPending;
+    Time mWakeupTime, mRunStartTime;
+    int mWakeups;
+    SimpleStatistics<double> mDispatchLatency;
+    double mMaxDispatchLatency;
     std::map<const GenericSignal *, int> mLargeSignals;
     Environment::Context &mEnvironment;
 };
@@ -27,12 +27,20 @@
 #include "CoreModule_Qt.h"
 #include "Debugging.h"
 #include "QtMain.h"
-#include "ThreadUtils.h"
+#include <QAbstractEventDispatcher>
 #include <QApplication>
+#include <QSocketNotifier>
 
 // In some versions of Qt4, QApplication::hasPendingEvents() always returns true.
 // In Qt6, QApplication::hasPendingEvents() has been removed.
 static const int cMaxPending = 100;
+#if _WIN32
+// On Windows, socket notifiers put sockets into non-blocking mode, so we
+// wait for BCI messages, and poll for GUI events.
+static const bool cUseSocketNotifiers = false;
+#else
+static const bool cUseSocketNotifiers = true;
+#endif
 
 CoreModuleQt::CoreModuleQt() : mpApp(nullptr), mCount(0)
 {
@@ -41,6 +49,12 @@ CoreModuleQt::CoreModuleQt() : mpApp(nullptr), mCount(0)
 
 CoreModuleQt::~CoreModuleQt()
 {
+    WithLock(mDispatcher)
+    {
+        mDispatcher.pDispatcher = nullptr;
+    }
+    for (auto p : mNotifiers)
+        delete p;
     delete mpApp;
 }
 
@@ -48,6 +62,10 @@ void CoreModuleQt::OnInitialize(int &ioArgc, char **ioArgv)
 {
     mpApp = new QtApplication(ioArgc, ioArgv);
     qApp->processEvents();
+    WithLock(mDispatcher)
+    {
+        mDispatcher.pDispatcher = QAbstractEventDispatcher::instance();
+    }
 }
 
 void CoreModuleQt::OnProcessGUIMessages()
@@ -57,12 +75,51 @@ void CoreModuleQt::OnProcessGUIMessages()
         qApp->sendPostedEvents();
         qApp->processEvents();
     }
-#ifdef __APPLE__
-    ThreadUtils::SleepForMs(2); // prevents core modules from taking 100% CPU on OSX under Qt 4.7
-#endif                          // __APPLE__
 }
 
 bool CoreModuleQt::OnGUIMessagesPending()
 {
-    return qApp && (++mCount % cMaxPending);
+    // When waiting through Qt's event dispatcher, GUI events posted during
+    // processing will end the next wait immediately.
+    return qApp && !cUseSocketNotifiers && (++mCount % cMaxPending);
+}
+
+// Qt's event dispatcher wakes up on GUI events, timers, and BCI messages
+// arriving at one of the sockets registered with it.
+void CoreModuleQt::OnWaitForMessages(const Waitables &inputs, const std::vector<std::ptrdiff_t> &inputFds)
+{
+    if (!qApp)
+    {
+        inputs.Wait();
+        return;
+    }
+    if (!cUseSocketNotifiers)
+    {
+        inputs.Wait(Time::Seconds(0.1)); // max time a GUI event needs to wait before it gets processed
+        return;
+    }
+    if (inputFds != mFds)
+    {
+        for (auto p : mNotifiers)
+            delete p;
+        mNotifiers.clear();
+        mFds = inputFds;
+        for (auto fd : mFds)
+            mNotifiers.push_back(new QSocketNotifier(fd, QSocketNotifier::Read));
+    }
+    // Messages may already be buffered, or arrive at connections that are not sockets.
+    // A message queued after this test will still end the wait through OnWakeUp().
+    if (!inputs.Wait(Time::Interval(0)))
+        qApp->processEvents(QEventLoop::AllEvents | QEventLoop::WaitForMoreEvents);
+}
+
+// Called from the receiving thread of the Operator connection. A wakeup arriving
+// before the dispatcher starts waiting is not lost, but ends the next wait.
+void CoreModuleQt::OnWakeUp()
+{
+    WithLock(mDispatcher)
+    {
+        if (mDispatcher.pDispatcher)
+            mDispatcher.pDispatcher->wakeUp();
+    }
 }
@@ -28,6 +28,7 @@
 #define CORE_MODULE_QT_H
 
 #include "CoreModule.h"
+#include "Lockable.h"
 
 class CoreModuleQt : public CoreModule
 {
@@ -39,9 +40,17 @@ class CoreModuleQt : public CoreModule
     void OnInitialize(int &argc, char **argv) override;
     void OnProcessGUIMessages() override;
     bool OnGUIMessagesPending() override;
+    void OnWaitForMessages(const Waitables &, const std::vector<std::ptrdiff_t> &) override;
+    void OnWakeUp() override;
 
     class QtApplication* mpApp;
+    struct : Lockable<std::mutex>
+    {
+        class QAbstractEventDispatcher *pDispatcher = nullptr;
+    } mDispatcher;
     int mCount;
+    std::vector<std::ptrdiff_t> mFds;
+    std::vector<class QSocketNotifier *> mNotifiers;
 };
 
 typedef CoreModuleQt CoreModuleQT;
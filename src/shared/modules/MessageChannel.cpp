@@ -82,6 +82,14 @@ struct MessageChannel::MemoryPool : ObjectPool<MemoryStreambuf>
 {
 };
 
+// State vectors sent and received as deltas, and a buffer for decoding.
+struct MessageChannel::StateVectorDeltas
+{
+    StateVector sent, received;
+    int sinceKeyframe = 0;
+    std::stringstream buffer;
+};
+
 // Buffered Messages
 struct MessageChannel::Message::Data
 {
@@ -185,7 +193,8 @@ bool MessageChannel::Message::ReadIntoMemory() const
 }
 
 // MessageChannel
-MessageChannel::MessageChannel(Streambuf &buf) : mrBuffer(buf), mMemoryPool(*new MemoryPool)
+MessageChannel::MessageChannel(Streambuf &buf)
+    : mrBuffer(buf), mMemoryPool(*new MemoryPool), mStateVectorDeltas(*new StateVectorDeltas)
 {
     ResetStatistics();
 }
@@ -193,6 +202,7 @@ MessageChannel::MessageChannel(Streambuf &buf) : mrBuffer(buf), mMemoryPool(*new
 MessageChannel::~MessageChannel()
 {
     delete &mMemoryPool;
+    delete &mStateVectorDeltas;
 }
 
 // Main message handling functions.
@@ -238,7 +248,10 @@ bool MessageChannel::Handle(const Message &msg)
     switch (msg.DescSupp())
     {
         CONSIDER(ProtocolVersion);
-        CONSIDER(StateVector);
+    case Header<StateVector>::descSupp:
+        pType = "StateVector";
+        didNotRead = !ReceiveStateVector(is) && is;
+        break;
         CONSIDER(VisSignal);
         CONSIDER(Status);
         CONSIDER(Param);
@@ -298,6 +311,31 @@ bool MessageChannel::OnProtocolVersion(std::istream &is)
     return !mProtocol.Unserialize(is).fail();
 }
 
+// Delta encoded state vectors are decoded, and handed on in full format.
+bool MessageChannel::ReceiveStateVector(std::istream &is)
+{
+    if (!StateVector::IsDelta(is))
+        return OnStateVector(is);
+    StateVectorDeltas &deltas = mStateVectorDeltas;
+    if (!deltas.received.UnserializeDelta(is))
+        return false;
+    deltas.buffer.clear();
+    deltas.buffer.str("");
+    deltas.received.Serialize(deltas.buffer);
+    return OnStateVector(deltas.buffer);
+}
+
+void MessageChannel::ResetReceivedStateVector()
+{
+    mStateVectorDeltas.received = StateVector();
+}
+
+void MessageChannel::ResetSentStateVector()
+{
+    mStateVectorDeltas.sent = StateVector();
+    mStateVectorDeltas.sinceKeyframe = 0;
+}
+
 void MessageChannel::ResetStatistics()
 {
     mMessagesSent = 0;
@@ -306,6 +344,52 @@ void MessageChannel::ResetStatistics()
     mBytesReceived = 0;
 }
 
+// Packed parameters are sent as parameter messages.
+namespace
+{
+struct PackedParam
+{
+    const Param &param;
+    std::ostream &Serialize(std::ostream &os) const
+    {
+        return param.SerializePacked(os);
+    }
+};
+} // namespace
+
+template <> struct MessageChannel::Header<PackedParam>
+{
+    enum
+    {
+        descSupp = 0x0200
+    };
+};
+
+// Delta encoded state vectors are sent as state vector messages.
+namespace
+{
+struct StateVectorDelta
+{
+    const StateVector &states;
+    const StateVector *pReference;
+    std::ostream &Serialize(std::ostream &os) const
+    {
+        return states.SerializeDelta(os, pReference);
+    }
+};
+
+// A keyframe is sent at regular intervals even if the reference matches.
+const int cStateVectorKeyframeInterval = 64;
+} // namespace
+
+template <> struct MessageChannel::Header<StateVectorDelta>
+{
+    enum
+    {
+        descSupp = 0x0500
+    };
+};
+
 // Functions that send messages.
 // Generic implementation.
 template <class T> bool MessageChannel::Send(const T &t)
@@ -331,6 +415,39 @@ template <> bool MessageChannel::Send(const BitmapImage &bitmap)
     return Send(VisBitmap(bitmap));
 }
 
+template <> bool MessageChannel::Send(const Param &param)
+{
+    if (!OnSend(param))
+        return false;
+    // Only list and matrix parameters benefit from packing.
+    const std::string &type = param.Type();
+    bool pack = Protocol().Provides(ProtocolVersion::PackedParameters) &&
+                (type.find("matrix") != std::string::npos || type.find("list") != std::string::npos);
+    if (pack)
+        return OnMessageBuffered(Message(mMemoryPool, PackedParam{param}, mrBuffer));
+    return OnMessageBuffered(Message(mMemoryPool, param, mrBuffer));
+}
+
+template <> bool MessageChannel::Send(const StateVector &states)
+{
+    if (!OnSend(states))
+        return false;
+    if (!Protocol().Provides(ProtocolVersion::StateVectorDeltas))
+        return OnMessageBuffered(Message(mMemoryPool, states, mrBuffer));
+    // Messages are serialized on construction, so the reference may be updated right away.
+    StateVectorDeltas &deltas = mStateVectorDeltas;
+    const StateVector *pReference = &deltas.sent;
+    if (deltas.sinceKeyframe == 0 || deltas.sent.Length() != states.Length())
+    {
+        pReference = nullptr;
+        deltas.sinceKeyframe = cStateVectorKeyframeInterval;
+    }
+    --deltas.sinceKeyframe;
+    Message msg(mMemoryPool, StateVectorDelta{states, pReference}, mrBuffer);
+    deltas.sent = states;
+    return OnMessageBuffered(msg);
+}
+
 template <> bool MessageChannel::Send(const ParamList &parameters)
 {
     bool result = true;
@@ -352,9 +469,7 @@ template <> bool MessageChannel::Send(const StateList &states)
 template bool MessageChannel::Send(const ProtocolVersion &);
 template bool MessageChannel::Send(const Status &);
 template bool MessageChannel::Send(const SysCommand &);
-template bool MessageChannel::Send(const Param &);
 template bool MessageChannel::Send(const State &);
-template bool MessageChannel::Send(const StateVector &);
 template bool MessageChannel::Send(const VisSignal &);
 template bool MessageChannel::Send(const VisSignalConst &);
 template bool MessageChannel::Send(const VisMemo &);
@@ -58,6 +58,11 @@ class MessageChannel : public Tiny::BasicIOObject, Uncopyable
     bool HandleMessage();
     template <typename T> bool Send(const T &);
     void ResetStatistics();
+    // True if previously sent messages are still waiting to be transmitted.
+    bool Congested()
+    {
+        return OnCongested();
+    }
 
     // Properties
     Streambuf &Buffer()
@@ -178,14 +183,26 @@ class MessageChannel : public Tiny::BasicIOObject, Uncopyable
         return true;
     }
 
+    virtual bool OnCongested()
+    {
+        return false;
+    }
+
     void SetProtocol(const ProtocolVersion &v)
     {
         mProtocol = v;
     }
+    // To be called when input or output is connected to a different peer, such
+    // that state vector deltas are not decoded, or encoded, against stale data.
+    void ResetReceivedStateVector();
+    void ResetSentStateVector();
 
   private:
     struct MemoryPool;
     MemoryPool &mMemoryPool;
+    struct StateVectorDeltas;
+    StateVectorDeltas &mStateVectorDeltas;
+    bool ReceiveStateVector(std::istream &);
 
   protected:
     bool OnMightBlock() const;
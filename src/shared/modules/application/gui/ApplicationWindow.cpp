@@ -119,15 +119,33 @@ ApplicationWindow::Data::Visualization::~Visualization()
 void ApplicationWindow::Data::Visualization::SenderThread()
 {
     SendReferenceFrame(mpWindow->DisplayWindow::BitmapData(mWidth, mHeight));
-    mInvalid = 0;
+    mInvalid = 1; // make sure the reference frame is followed by an up-to-date frame
     int64_t lastTickSent = 0;
+    bool pending = false;
+    Time requested;
     WithThreadPriority(-1) while (mTickEvent.Wait())
     {
+        // Bitmap read-back is requested from the rendering thread at the decimated rate only,
+        // and the frame is encoded and sent here once it is available.
+        if (pending && mpWindow->BitmapDataReady())
+        {
+            pending = false;
+            SendDifferenceFrame(mpWindow->DisplayWindow::BitmapData(mWidth, mHeight));
+        }
+        else if (pending && (TimeUtils::MonotonicTime() - requested).Seconds() > 1)
+        { // The rendering thread did not serve the request, e.g. because its buffer was
+          // reconfigured. Request again rather than waiting forever.
+            pending = false;
+            mInvalid = 1;
+        }
         int64_t tick = mpWindow->Tick().count;
-        if (tick >= lastTickSent + mTemporalDecimation && mInvalid.exchange(0))
+        if (!pending && tick >= lastTickSent + mTemporalDecimation && mInvalid.exchange(0))
         {
             lastTickSent = tick;
-            SendDifferenceFrame(mpWindow->DisplayWindow::BitmapData(mWidth, mHeight));
+            requested = TimeUtils::MonotonicTime();
+            pending = mpWindow->RequestBitmapData();
+            if (!pending)
+                SendDifferenceFrame(mpWindow->DisplayWindow::BitmapData(mWidth, mHeight));
         }
     }
     SendReferenceFrame(mpWindow->DisplayWindow::BitmapData(mWidth, mHeight));
@@ -28,9 +28,12 @@
 #include "BCIStream.h"
 #include "FileUtils.h"
 #include "Lockable.h"
+#include "MediaCache.h"
 #include "NumericConstants.h"
 #include "AVUtils.h"
 
+#include <set>
+
 #if USE_QT
 #include <QBitmap>
 #include <QImage>
@@ -40,7 +43,7 @@
 
 struct ImageStimulus::Data : Lockable<>
 {
-    std::string mFile;
+    std::string mFile, mCacheKey;
     int mRenderingMode;
 
 #if USE_QT
@@ -163,6 +166,37 @@ static int LibavLoad(QImage& outImage, const std::string& inName)
     return result;
 }
 
+// Decoded images are shared between stimuli through the media cache.
+// Copies of a QImage share their pixel data until one of them is modified.
+struct CachedImage : MediaCache::Entry
+{
+    QImage image;
+    int64_t Bytes() const override
+    {
+        return int64_t(image.bytesPerLine()) * image.height();
+    }
+};
+
+static int LoadImage(QImage &outImage, const std::string &inFile, const std::string &inCacheKey)
+{
+    auto pCached = MediaCache::Instance().Get<CachedImage>(inCacheKey);
+    if (pCached)
+    {
+        outImage = pCached->image;
+        return resultOk;
+    }
+    auto pEntry = std::make_shared<CachedImage>();
+    int result = resultOk;
+    if (!pEntry->image.load(QString(inFile.c_str())))
+        result = LibavLoad(pEntry->image, inFile);
+    if (result == resultOk)
+    {
+        outImage = pEntry->image;
+        MediaCache::Instance().Put(inCacheKey, pEntry);
+    }
+    return result;
+}
+
 #endif // USE_QT
 
 ImageStimulus::ImageStimulus(GUI::GraphDisplay &display) : GraphObject(display, ImageStimulusZOrder), d(new Data)
@@ -184,13 +218,11 @@ ImageStimulus &ImageStimulus::SetFile(const std::string &inName)
 
     // Attempt to load the image
     std::string file = FileUtils::AbsolutePath(inName);
+    d->mCacheKey = MediaCache::Key(file, "image");
 #if USE_QT
     delete d->mpImage;
     d->mpImage = new QImage();
-    if (!d->mpImage->load(QString(file.c_str())))
-        result |= resultErr;
-    if (result != resultOk)
-      result = LibavLoad(*d->mpImage, file);
+    result = LoadImage(*d->mpImage, file, d->mCacheKey);
 #endif
 
     // An error occurred while loading the image
@@ -204,6 +236,7 @@ ImageStimulus &ImageStimulus::SetFile(const std::string &inName)
         delete d->mpImage;
         d->mpImage = nullptr;
         d->mFile = "";
+        d->mCacheKey = "";
     }
     else
         d->mFile = inName;
@@ -212,6 +245,27 @@ ImageStimulus &ImageStimulus::SetFile(const std::string &inName)
     return *this;
 }
 
+void ImageStimulus::Preload(const std::vector<std::string> &inFiles)
+{
+#if USE_QT
+    std::set<std::string> files;
+    for (const auto &name : inFiles)
+        if (!name.empty())
+            files.insert(FileUtils::AbsolutePath(name));
+    std::vector<std::pair<std::string, std::string>> toLoad;
+    for (const auto &file : files)
+    {
+        std::string key = MediaCache::Key(file, "image");
+        if (!key.empty() && !MediaCache::Instance().Get(key))
+            toLoad.push_back(std::make_pair(file, key));
+    }
+    MediaCache::ForEach(toLoad.size(), [&toLoad](size_t i) {
+        QImage image;
+        LoadImage(image, toLoad[i].first, toLoad[i].second);
+    });
+#endif // USE_QT
+}
+
 std::string ImageStimulus::File() const
 {
     ScopedLock(d);
@@ -303,7 +357,24 @@ void ImageStimulus::OnChange(GUI::DrawContext &ioDC)
         bool storeScaled = width * height < 2 * OriginalWidth() * OriginalHeight();
         storeScaled |= width < OriginalWidth();
         storeScaled |= height < OriginalHeight();
-        QImage img = storeScaled ? d->mpImage->scaled(width, height) : *d->mpImage;
+        QImage img = *d->mpImage;
+        if (storeScaled)
+        {
+            // Stimuli showing the same file at the same size share the scaled image.
+            std::string key;
+            if (!d->mCacheKey.empty())
+                key = d->mCacheKey + " scaled " + std::to_string(width) + "x" + std::to_string(height);
+            auto pCached = MediaCache::Instance().Get<CachedImage>(key);
+            if (pCached)
+                img = pCached->image;
+            else
+            {
+                auto pEntry = std::make_shared<CachedImage>();
+                pEntry->image = d->mpImage->scaled(width, height);
+                img = pEntry->image;
+                MediaCache::Instance().Put(key, pEntry);
+            }
+        }
         // Create the normal pixmap
         if (PresentationMode() != ShowHide)
             d->mpImageBufferNormal = NewBufferFromImage(img, d->mRenderingMode == GUI::RenderingMode::Transparent);
@@ -29,6 +29,9 @@
 #include "GraphObject.h"
 #include "VisualStimulus.h"
 
+#include <string>
+#include <vector>
+
 class ImageStimulus : public VisualStimulus, public GUI::GraphObject
 {
   public:
@@ -51,6 +54,10 @@ class ImageStimulus : public VisualStimulus, public GUI::GraphObject
         return NativeHeight();
     }
 
+    // Decodes image files into the process-wide media cache in parallel, such that
+    // SetFile() does not need to decode them again. Errors are reported by SetFile().
+    static void Preload(const std::vector<std::string> &files);
+
   protected:
     // GraphObject event handlers
     void OnPaint(const GUI::DrawContext &) override;
@@ -72,6 +72,10 @@ void ARSpectrum::Initialize(const SignalProperties &Input, const SignalPropertie
     m.SetModelOrder(Parameter("ModelOrder"));
     mPredictors.resize(Input.Channels(), m);
 
+    // Transfer functions are kept per channel, so their storage is reused across blocks.
+    mTransferFunctions.clear();
+    mTransferFunctions.resize(Input.Channels());
+
     mSpectra.clear();
     mSpectra.resize(Input.Channels(), DataVector(Output.Elements()));
 
@@ -98,7 +102,7 @@ void ARSpectrum::Process(const GenericSignal &Input, GenericSignal &Output)
         for (size_t i = 0; i < mInputs[ch].size(); ++i)
             mInputs[ch][i] = Input(ch, i);
 
-        Ratpoly<Real> tf;
+        Ratpoly<Real> &tf = mTransferFunctions[ch];
         mPredictors[ch].TransferFunction(mInputs[ch], tf);
         tf *= ::sqrt(2.0); // Multiply power by a factor of 2 to account for positive and negative frequencies.
         switch (mOutputType)
@@ -58,6 +58,7 @@ class ARSpectrum : public Spectrum
 
     std::vector<MEMPredictor<Real>> mPredictors;
     std::vector<TransferSpectrum<Real>> mTransferSpectra;
+    std::vector<Ratpoly<Real>> mTransferFunctions;
     std::vector<DataVector> mInputs, mSpectra;
     int mOutputType;
 };
@@ -29,8 +29,7 @@
 #include "Label.h"
 
 #include <algorithm>
-#include <limits>
-#include <map>
+#include <cmath>
 #include <vector>
 
 RegisterFilter(AverageDisplay, 2.C1);
@@ -38,7 +37,8 @@ RegisterFilter(AverageDisplay, 2.C1);
 const RGBColor AverageDisplay::sChannelColors[] = {RGBColor::Red,    RGBColor::Green, RGBColor::Blue,
                                                    RGBColor::Yellow, RGBColor::White, RGBColor::NullColor};
 
-AverageDisplay::AverageDisplay() : mLastTargetCode(0)
+AverageDisplay::AverageDisplay()
+    : mCapacity(0), mTrialTarget(0), mTrialSamples(0), mLastTargetCode(0), mTargetsChanged(false)
 {
     BEGIN_PARAMETER_DEFINITIONS
         "Visualize matrix AvgDisplayCh= 2 2 "
@@ -75,24 +75,27 @@ void AverageDisplay::Initialize(const SignalProperties &Input, const SignalPrope
         mVisualizations[i].Send(CfgID::Visible, false);
     mVisualizations.clear();
     mChannelIndices.clear();
-    mPowerSums.clear();
     mTargetCodes.clear();
-    mSignalOfCurrentRun.clear();
+    mTrialLengths.clear();
+    mAverages.clear();
 #ifdef SET_BASELINE
     mBaselines.clear();
     mBaselineSamples.clear();
 #endif // SET_BASELINE
     LabelList markerLabels;
+    int maxPosition = 0;
     for (int i = 0; i < Parameter("AvgDisplayMarkers")->NumRows(); ++i)
     {
         std::string markerName = Parameter("AvgDisplayMarkers")(i, 0);
         int position = static_cast<int>(OptionalParameter(markerName, -1).InSampleBlocks() * Input.Elements());
         if (position >= 0)
             markerLabels.push_back(Label(position, markerName));
+        maxPosition = std::max(maxPosition, position);
     }
+    std::ostringstream sampleUnit;
+    sampleUnit << (1.0 / Input.SamplingRate()) << "s";
 
     int numChannels = Parameter("AvgDisplayCh")->NumRows();
-    mPowerSums.resize(maxPower + 1, std::vector<std::vector<std::vector<double>>>(numChannels));
     for (int i = 0; i < numChannels; ++i)
     {
         std::ostringstream oss;
@@ -109,6 +112,7 @@ void AverageDisplay::Initialize(const SignalProperties &Input, const SignalPrope
         vis.Send(CfgID::MinValue, int(Parameter("AvgDisplayMin")));
         vis.Send(CfgID::MaxValue, int(Parameter("AvgDisplayMax")));
         vis.Send(CfgID::NumSamples, 0);
+        vis.Send(CfgID::SampleUnit, sampleUnit.str());
         vis.Send(CfgID::GraphType, CfgID::Polyline);
 
         if (!markerLabels.empty())
@@ -124,133 +128,177 @@ void AverageDisplay::Initialize(const SignalProperties &Input, const SignalPrope
         mChannelIndices.push_back(static_cast<int>(Parameter("AvgDisplayCh")(i, 0) - 1));
     }
 
-    mSignalOfCurrentRun.resize(numChannels);
+    mAverages.resize(numChannels);
 #ifdef SET_BASELINE
     mBaselines.resize(numChannels);
     mBaselineSamples.resize(numChannels);
 #endif // SET_BASELINE
+    // Initial room for at least a second of data, or the last marker, rounded up to full blocks.
+    int capacity = std::max(maxPosition + 1, static_cast<int>(::ceil(Input.SamplingRate())));
+    capacity = ((capacity + Input.Elements() - 1) / Input.Elements()) * Input.Elements();
+    mCapacity = 0;
+    Allocate(0, capacity);
+    mTrialTarget = 0;
+    mTrialSamples = 0;
     mLastTargetCode = 0;
+    mTargetsChanged = false;
 }
 
 void AverageDisplay::Process(const GenericSignal &Input, GenericSignal &Output)
 {
     int targetCode = State("TargetCode");
     if (targetCode == 0 && targetCode != mLastTargetCode)
+        EndTrial();
+    if (targetCode != 0)
     {
-        size_t targetIndex = find(mTargetCodes.begin(), mTargetCodes.end(), mLastTargetCode) - mTargetCodes.begin();
-        if (targetIndex == mTargetCodes.size())
-            mTargetCodes.push_back(mLastTargetCode);
-        // End of the current target code run.
-        for (size_t i = 0; i < mChannelIndices.size(); ++i)
+        if (mLastTargetCode == 0)
+            BeginTrial(targetCode);
+        AddBlock(Input);
+#ifdef SET_BASELINE
+        if (OptionalState("BaselineInterval") || OptionalState("Baseline"))
         {
-            for (int power = 0; power <= maxPower; ++power)
+            for (size_t i = 0; i < mChannelIndices.size(); ++i)
             {
-                // - If the target code occurred for the first time, adapt the power sums.
-                if (mPowerSums[power][i].size() <= targetIndex)
-                    mPowerSums[power][i].resize(targetIndex + 1);
-                // - Update power sum sizes.
-                if (mPowerSums[power][i][targetIndex].size() < mSignalOfCurrentRun[i].size())
-                    mPowerSums[power][i][targetIndex].resize(mSignalOfCurrentRun[i].size(), 0);
+                mBaselineSamples[i] += Input.Elements();
+                for (int j = 0; j < Input.Elements(); ++j)
+                    mBaselines[i] += Input(mChannelIndices[i], j);
             }
-#ifdef SET_BASELINE
-            if (mBaselineSamples[i] > 0)
-                mBaselines[i] /= mBaselineSamples[i];
+        }
 #endif // SET_BASELINE
-            // - Compute power sum entries.
-            for (size_t j = 0; j < mSignalOfCurrentRun[i].size(); ++j)
-            {
+    }
+    mLastTargetCode = targetCode;
+    Output = Input;
+}
+
+void AverageDisplay::BeginTrial(int inTargetCode)
+{
+    size_t targetIndex = find(mTargetCodes.begin(), mTargetCodes.end(), inTargetCode) - mTargetCodes.begin();
+    if (targetIndex == mTargetCodes.size())
+    {
+        // If the target code occurred for the first time, add accumulators.
+        Allocate(static_cast<int>(targetIndex + 1), mCapacity);
+        mTargetCodes.push_back(inTargetCode);
+        mTrialLengths.push_back(0);
+        mTargetsChanged = true;
+    }
+    mTrialTarget = static_cast<int>(targetIndex);
+    mTrialSamples = 0;
 #ifdef SET_BASELINE
-                mSignalOfCurrentRun[i][j] -= mBaselines[i];
+    for (size_t i = 0; i < mBaselines.size(); ++i)
+    {
+        mBaselineSamples[i] = 0;
+        mBaselines[i] = 0;
+    }
 #endif // SET_BASELINE
-                double summand = 1.0;
-                for (size_t power = 0; power < maxPower; ++power)
-                {
-                    mPowerSums[power][i][targetIndex][j] += summand;
-                    summand *= mSignalOfCurrentRun[i][j];
-                }
-                mPowerSums[maxPower][i][targetIndex][j] += summand;
-            }
-        }
-        // - Clear target run buffer.
-        for (size_t i = 0; i < mSignalOfCurrentRun.size(); ++i)
-            mSignalOfCurrentRun[i].clear();
+}
+
+void AverageDisplay::AddBlock(const GenericSignal &Input)
+{
+    int numSamples = Input.Elements();
+    if (mTrialSamples + numSamples > mCapacity)
+        Allocate(static_cast<int>(mTargetCodes.size()), std::max(2 * mCapacity, mTrialSamples + numSamples));
+
+    const GenericSignal::ValueType *pInput = Input.ConstData();
+    for (size_t i = 0; i < mChannelIndices.size(); ++i)
+    {
+        const GenericSignal::ValueType *x = pInput + Input.LinearIndex(mChannelIndices[i], 0);
+        double *sums = Sums(mTrialTarget, static_cast<int>(i)) + mTrialSamples;
+#pragma omp simd
+        for (int j = 0; j < numSamples; ++j)
+            sums[j] += x[j];
+    }
+    double *counts = Counts(mTrialTarget) + mTrialSamples;
+#pragma omp simd
+    for (int j = 0; j < numSamples; ++j)
+        counts[j] += 1;
+    mTrialSamples += numSamples;
+}
+
+void AverageDisplay::EndTrial()
+{
+    if (mTargetCodes.empty())
+        return;
 #ifdef SET_BASELINE
-        for (size_t i = 0; i < mBaselines.size(); ++i)
+    // The baseline is known only at the end of a trial, so it is subtracted from
+    // all samples of the trial at once.
+    for (size_t i = 0; i < mChannelIndices.size(); ++i)
+    {
+        if (mBaselineSamples[i] > 0)
         {
-            mBaselineSamples[i] = 0;
-            mBaselines[i] = 0;
+            double baseline = mBaselines[i] / mBaselineSamples[i];
+            double *sums = Sums(mTrialTarget, static_cast<int>(i));
+#pragma omp simd
+            for (int j = 0; j < mTrialSamples; ++j)
+                sums[j] -= baseline;
         }
+        mBaselineSamples[i] = 0;
+        mBaselines[i] = 0;
+    }
 #endif // SET_BASELINE
-        // - Compute and display averages.
-        for (size_t channel = 0; channel < mVisualizations.size(); ++channel)
-        {
-            int numTargets = static_cast<int>(mPowerSums[maxPower][channel].size());
-            size_t numSamples = std::numeric_limits<size_t>::max();
-            for (int target = 0; target < numTargets; ++target)
-                numSamples = std::min(numSamples, mPowerSums[maxPower][channel][target].size());
+    mTrialLengths[mTrialTarget] = std::max(mTrialLengths[mTrialTarget], mTrialSamples);
+    mTrialSamples = 0;
+    SendAverages();
+}
 
-            // To minimize user confusion, always send target averages in ascending order
-            // of target codes. This ensures that colors in the display don't depend
-            // on the order of target codes in the task sequence once all target codes
-            // occurred.
-            // We cannot, however, avoid color changes when yet unknown target codes
-            // occur.
-            //
-            // The map is automatically sorted by its "key", so all we need to do
-            // is to put the target codes and their indices into it, using the
-            // target code as "key" and the index as "value", and later iterate over
-            // the map to get the indices sorted by their associated target code.
-            std::map<int, int> targetCodesToIndex;
-            for (int target = 0; target < numTargets; ++target)
-                targetCodesToIndex[mTargetCodes[target]] = target;
+void AverageDisplay::SendAverages()
+{
+    int numTargets = static_cast<int>(mTargetCodes.size());
+    int numSamples = *std::min_element(mTrialLengths.begin(), mTrialLengths.end());
 
-            GenericSignal average(numTargets, numSamples);
-            LabelList labels;
-            for (std::map<int, int>::const_iterator target = targetCodesToIndex.begin();
-                 target != targetCodesToIndex.end(); ++target)
-            {
-                for (size_t sample = 0; sample < numSamples; ++sample)
-                    // If everything behaves as we believe it will,
-                    // a division by zero is impossible.
-                    // If it occurs nevertheless, the logic is messed up.
-                    average(target->second, sample) =
-                        mPowerSums[1][channel][target->second][sample] / mPowerSums[0][channel][target->second][sample];
-                std::ostringstream oss;
-                oss << "Target " << target->first;
-                std::string targetName = OptionalParameter("TargetNames", target->first);
-                if (targetName != "")
-                    oss << " (" << targetName << ")";
-                labels.push_back(Label(target->second, oss.str()));
-            }
-            mVisualizations[channel].Send(CfgID::ChannelLabels, labels);
+    // Labels only need to be sent when a new target code occurred.
+    LabelList labels;
+    if (mTargetsChanged)
+    {
+        // Averages are sent in order of first occurrence, and labeled with their target codes.
+        for (int target = 0; target < numTargets; ++target)
+        {
             std::ostringstream oss;
-            oss << (1.0 / Input.Properties().SamplingRate()) << "s";
-            mVisualizations[channel].Send(CfgID::SampleUnit, oss.str());
-            mVisualizations[channel].Send(average);
+            oss << "Target " << mTargetCodes[target];
+            std::string targetName = OptionalParameter("TargetNames", mTargetCodes[target]);
+            if (targetName != "")
+                oss << " (" << targetName << ")";
+            labels.push_back(Label(target, oss.str()));
         }
     }
-    if (targetCode != 0)
+    for (size_t channel = 0; channel < mVisualizations.size(); ++channel)
     {
-        // Store the current signal to the end of the run buffer.
-        for (size_t i = 0; i < mChannelIndices.size(); ++i)
+        GenericSignal &average = mAverages[channel];
+        if (average.Channels() != numTargets || average.Elements() != numSamples)
+            average = GenericSignal(numTargets, numSamples);
+        GenericSignal::ValueType *pAverage = average.MutableData();
+        for (int target = 0; target < numTargets; ++target)
         {
-            size_t signalCursorPos = mSignalOfCurrentRun[i].size();
-            mSignalOfCurrentRun[i].resize(signalCursorPos + Input.Elements());
-            for (int j = 0; j < Input.Elements(); ++j)
-                mSignalOfCurrentRun[i][signalCursorPos + j] = Input(mChannelIndices[i], j);
+            GenericSignal::ValueType *out = pAverage + average.LinearIndex(target, 0);
+            const double *sums = Sums(target, static_cast<int>(channel)), *counts = Counts(target);
+            // Each sample up to the shortest trial length has been counted at least once.
+#pragma omp simd
+            for (int sample = 0; sample < numSamples; ++sample)
+                out[sample] = sums[sample] / counts[sample];
         }
-#ifdef SET_BASELINE
-        if (OptionalState("BaselineInterval") || OptionalState("Baseline"))
+        if (mTargetsChanged)
+            mVisualizations[channel].Send(CfgID::ChannelLabels, labels);
+        mVisualizations[channel].Send(average);
+    }
+    mTargetsChanged = false;
+}
+
+void AverageDisplay::Allocate(int inTargets, int inCapacity)
+{
+    // Move existing accumulators into a layout with the requested number of targets and capacity.
+    size_t numChannels = mChannelIndices.size();
+    std::vector<double> sums(inTargets * numChannels * inCapacity, 0), counts(inTargets * inCapacity, 0);
+    int oldTargets = std::min<int>(inTargets, static_cast<int>(mTargetCodes.size())),
+        copy = std::min(mCapacity, inCapacity);
+    for (int target = 0; target < oldTargets; ++target)
+    {
+        for (size_t channel = 0; channel < numChannels; ++channel)
         {
-            for (size_t i = 0; i < mChannelIndices.size(); ++i)
-            {
-                mBaselineSamples[i] += Input.Elements();
-                for (int j = 0; j < Input.Elements(); ++j)
-                    mBaselines[i] += Input(mChannelIndices[i], j);
-            }
+            const double *p = Sums(target, static_cast<int>(channel));
+            std::copy(p, p + copy, sums.begin() + (target * numChannels + channel) * inCapacity);
         }
-#endif // SET_BASELINE
+        std::copy(Counts(target), Counts(target) + copy, counts.begin() + size_t(target) * inCapacity);
     }
-    mLastTargetCode = targetCode;
-    Output = Input;
+    mSums.swap(sums);
+    mCounts.swap(counts);
+    mCapacity = inCapacity;
 }
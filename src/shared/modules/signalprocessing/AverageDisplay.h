@@ -35,11 +35,6 @@
 
 class AverageDisplay : public GenericFilter
 {
-    enum
-    {
-        maxPower = 1
-    };
-
   public:
     AverageDisplay();
     void Preflight(const SignalProperties &, SignalProperties &) const;
@@ -51,17 +46,39 @@ class AverageDisplay : public GenericFilter
     }
 
   private:
+    void BeginTrial(int targetCode);
+    void AddBlock(const GenericSignal &);
+    void EndTrial();
+    void SendAverages();
+    void Allocate(int targets, int capacity);
+    double *Sums(int target, int channel)
+    {
+        return mSums.data() + (size_t(target) * mChannelIndices.size() + channel) * mCapacity;
+    }
+    double *Counts(int target)
+    {
+        return mCounts.data() + size_t(target) * mCapacity;
+    }
+
     std::vector<GenericVisualization> mVisualizations;
     std::vector<int> mChannelIndices;
     std::vector<int> mTargetCodes;
 
-    // Indices are [ channel ][ sample ].
-    std::vector<std::vector<double>> mSignalOfCurrentRun;
-
-    // Indices are [ power ][ channel ][ targetCode ][ sample ].
-    std::vector<std::vector<std::vector<std::vector<double>>>> mPowerSums;
+    // Accumulators have room for mCapacity samples, and are allocated when a
+    // target code occurs for the first time. Samples are added as blocks arrive.
+    // Indices are [ target ][ channel ][ sample ] for sums,
+    // and [ target ][ sample ] for counts.
+    std::vector<double> mSums, mCounts;
+    // Length of the longest trial for each target.
+    std::vector<int> mTrialLengths;
+    int mCapacity;
 
+    int mTrialTarget, mTrialSamples;
     int mLastTargetCode;
+    bool mTargetsChanged;
+
+    // Averages are computed into a snapshot, with one signal per display channel.
+    std::vector<GenericSignal> mAverages;
 
 #ifdef SET_BASELINE
     // Baseline stuff that should really be factored out.
@@ -29,7 +29,8 @@
 #include "ComplexDemodulator.h"
 
 #include "Numeric.h"
-#include <numeric>
+#include <algorithm>
+#include <cmath>
 
 RegisterFilter(ComplexDemodulator, 2.F); // Place it last in signal processing.
 
@@ -39,6 +40,8 @@ ComplexDemodulator::ComplexDemodulator(){
             "// frequencies at which to perform demodulation (corresponds to output signal elements)",
         "ComplexDemodulator int FrequencyResolution= 10Hz % % % "
             "// width of frequency bands",
+        "ComplexDemodulator int DemodulatorResync= 1 1 0 1 "
+            "// periodically recompute sums to avoid accumulation of rounding errors (boolean)",
     END_PARAMETER_DEFINITIONS}
 
 ComplexDemodulator::~ComplexDemodulator()
@@ -61,6 +64,7 @@ void ComplexDemodulator::Preflight(const SignalProperties &Input, SignalProperti
                << "(currently " << Input.SamplingRate() << "Hz)";
     double FrequencyResolution = Parameter("FrequencyResolution").InHertz() / Input.SamplingRate();
     PreflightCondition(FrequencyResolution > 0);
+    Parameter("DemodulatorResync");
 
     // Request output signal properties:
     Output = SignalProperties(Input.Channels(), DemodulatorFrequencies->NumValues(), SignalType::float32);
@@ -69,34 +73,91 @@ void ComplexDemodulator::Preflight(const SignalProperties &Input, SignalProperti
 void ComplexDemodulator::Initialize(const SignalProperties &Input, const SignalProperties &Output)
 {
     double FrequencyResolution = Parameter("FrequencyResolution").InHertz() / Input.SamplingRate();
-    size_t numCoefficients = static_cast<size_t>(::floor(1.0 / FrequencyResolution) + 1);
+    mWindowLength = static_cast<size_t>(::floor(1.0 / FrequencyResolution) + 1);
     ParamRef DemodulatorFrequencies = Parameter("DemodulatorFrequencies");
-    mCoefficients.clear();
-    mCoefficients.resize(DemodulatorFrequencies->NumValues(), std::vector<std::complex<double>>(numCoefficients));
-    for (int i = 0; i < DemodulatorFrequencies->NumValues(); ++i)
+    size_t numBands = DemodulatorFrequencies->NumValues();
+    mFrequencies.resize(numBands);
+    mRotations.resize(numBands);
+    mExpiringRotations.resize(numBands);
+    mPhasors.resize(numBands);
+    for (size_t band = 0; band < numBands; ++band)
     {
-        double freq = DemodulatorFrequencies(i).InHertz() / Input.SamplingRate();
-        for (size_t j = 0; j < numCoefficients; ++j)
-            mCoefficients[i][j] = std::polar(0.5 / numCoefficients, freq * j * 2.0 * Pi());
+        mFrequencies[band] = DemodulatorFrequencies(band).InHertz() / Input.SamplingRate();
+        mRotations[band] = std::polar(1.0, 2.0 * Pi() * mFrequencies[band]);
+        mExpiringRotations[band] = std::polar(1.0, -2.0 * Pi() * ::fmod(mFrequencies[band] * mWindowLength, 1.0));
     }
-    mSignalBuffer.clear();
-    mSignalBuffer.resize(Input.Channels(), std::vector<double>(numCoefficients));
+    mChannels = Input.Channels();
+    mSumsRe.assign(numBands * mChannels, 0.0);
+    mSumsIm.assign(numBands * mChannels, 0.0);
+    mRingBuffer.assign(mWindowLength * mChannels, 0.0);
+    mNewSamples.resize(mChannels);
+    mRingPosition = 0;
+    mSampleCount = 0;
+    mResync = (Parameter("DemodulatorResync") != 0);
+    mNextResyncBand = 0;
 }
 
 void ComplexDemodulator::Process(const GenericSignal &Input, GenericSignal &Output)
 {
-    for (int channel = 0; channel < Input.Channels(); ++channel)
+    const size_t numBands = mFrequencies.size();
+    // Oscillators are set from the absolute sample position at the beginning of each block.
+    for (size_t band = 0; band < numBands; ++band)
+        mPhasors[band] = std::polar(1.0, 2.0 * Pi() * ::fmod(mFrequencies[band] * mSampleCount, 1.0));
+
+    for (int sample = 0; sample < Input.Elements(); ++sample)
     {
-        for (int sample = 0; sample < Input.Elements(); ++sample)
+        for (size_t channel = 0; channel < mChannels; ++channel)
+            mNewSamples[channel] = Input(channel, sample);
+        const double *pNew = mNewSamples.data(), *pOld = &mRingBuffer[mRingPosition * mChannels];
+        for (size_t band = 0; band < numBands; ++band)
+        {
+            const std::complex<double> p = mPhasors[band], q = p * mExpiringRotations[band];
+            const double pRe = p.real(), pIm = p.imag(), qRe = q.real(), qIm = q.imag();
+            double *pSumRe = &mSumsRe[band * mChannels], *pSumIm = &mSumsIm[band * mChannels];
+            for (size_t channel = 0; channel < mChannels; ++channel)
+            {
+                pSumRe[channel] += pNew[channel] * pRe - pOld[channel] * qRe;
+                pSumIm[channel] += pNew[channel] * pIm - pOld[channel] * qIm;
+            }
+            mPhasors[band] *= mRotations[band];
+        }
+        std::copy(pNew, pNew + mChannels, &mRingBuffer[mRingPosition * mChannels]);
+        mSampleCount += 1;
+        if (++mRingPosition == mWindowLength)
+        {
+            mRingPosition = 0;
+            if (mResync && numBands > 0)
+            {
+                Resync(mNextResyncBand);
+                mNextResyncBand = (mNextResyncBand + 1) % numBands;
+            }
+        }
+    }
+
+    const double scale = 0.25 / (mWindowLength * mWindowLength);
+    for (size_t channel = 0; channel < mChannels; ++channel)
+        for (size_t band = 0; band < numBands; ++band)
         {
-            mSignalBuffer[channel].push_back(Input(channel, sample));
-            mSignalBuffer[channel].erase(mSignalBuffer[channel].begin());
+            double re = mSumsRe[band * mChannels + channel], im = mSumsIm[band * mChannels + channel];
+            Output(channel, band) = (re * re + im * im) * scale;
         }
-        for (size_t band = 0; band < mCoefficients.size(); ++band)
+}
+
+void ComplexDemodulator::Resync(size_t inBand)
+{
+    // The ring buffer has just wrapped around, so its first entry holds the oldest sample.
+    double *pSumRe = &mSumsRe[inBand * mChannels], *pSumIm = &mSumsIm[inBand * mChannels];
+    std::fill(pSumRe, pSumRe + mChannels, 0.0);
+    std::fill(pSumIm, pSumIm + mChannels, 0.0);
+    double firstSample = mSampleCount - mWindowLength;
+    for (size_t i = 0; i < mWindowLength; ++i)
+    {
+        std::complex<double> p = std::polar(1.0, 2.0 * Pi() * ::fmod(mFrequencies[inBand] * (firstSample + i), 1.0));
+        const double pRe = p.real(), pIm = p.imag(), *pData = &mRingBuffer[i * mChannels];
+        for (size_t channel = 0; channel < mChannels; ++channel)
         {
-            Output(channel, band) =
-                std::norm(std::inner_product(mSignalBuffer[channel].begin(), mSignalBuffer[channel].end(),
-                                             mCoefficients[band].begin(), std::complex<double>(0.0, 0.0)));
+            pSumRe[channel] += pData[channel] * pRe;
+            pSumIm[channel] += pData[channel] * pIm;
         }
     }
 }
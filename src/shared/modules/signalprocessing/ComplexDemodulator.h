@@ -45,7 +45,24 @@ class ComplexDemodulator : public GenericFilter
     void Process(const GenericSignal &, GenericSignal &);
 
   private:
-    std::vector<std::vector<std::complex<double>>> mCoefficients;
-    std::vector<std::vector<double>> mSignalBuffer;
+    void Resync(size_t band);
+
+    // Demodulation is done by a sliding DFT: For each band, input samples are multiplied
+    // with an oscillator, and summed over a moving window. The sums are updated with
+    // each sample by adding the newest, and subtracting the expiring product.
+    size_t mWindowLength;
+    std::vector<double> mFrequencies;
+    std::vector<std::complex<double>> mRotations, mExpiringRotations, mPhasors;
+    // Sums are stored band by band, with real and imaginary parts in separate arrays
+    // such that the loop over channels may be vectorized.
+    std::vector<double> mSumsRe, mSumsIm;
+    // Input samples of the current window, stored sample by sample.
+    std::vector<double> mRingBuffer, mNewSamples;
+    size_t mRingPosition, mChannels;
+    double mSampleCount;
+    // Sums are recomputed from the ring buffer to avoid accumulation of rounding errors,
+    // one band each time the ring buffer wraps around.
+    bool mResync;
+    size_t mNextResyncBand;
 };
 #endif // COMPLEX_DEMODULATOR_H
@@ -28,9 +28,103 @@
 
 #include "Debugging.h"
 #include "Numeric.h"
+#include "UnitTest.h"
+
+#include <cstdint>
 
 RegisterFilter(FrequencyEstimator, 2.B0.1);
 
+namespace
+{
+// Advances all bins of a channel by one input sample, writes bin power into
+// outPower, and returns the maximum power.
+double UpdateBins(size_t numBins, const double *shiftRe, const double *shiftIm, const double *frequencies,
+                  double input, double *re, double *im, double *outPower)
+{
+    double max = -Inf<double>();
+#pragma omp simd reduction(max : max)
+    for (size_t i = 0; i < numBins; ++i)
+    {
+        double r = re[i] * shiftRe[i] - im[i] * shiftIm[i] + input, j = re[i] * shiftIm[i] + im[i] * shiftRe[i];
+        re[i] = r;
+        im[i] = j;
+        double p = (r * r + j * j) * frequencies[i];
+        outPower[i] = p;
+        max = p > max ? p : max;
+    }
+    return max;
+}
+
+// Returns the centroid of the first maximum and its neighbors, in units of bins.
+double MaxPosition(size_t numBins, const double *power, double max)
+{
+    size_t idx = 0;
+    while (idx < numBins && !(power[idx] == max))
+        ++idx;
+    if (idx == numBins)
+        idx = 0;
+
+    double sum = idx * power[idx], mass = power[idx];
+    if (idx > 0)
+    {
+        sum += (idx - 1) * power[idx - 1];
+        mass += power[idx - 1];
+    }
+    if (idx + 1 < numBins)
+    {
+        sum += (idx + 1) * power[idx + 1];
+        mass += power[idx + 1];
+    }
+    return sum / mass;
+}
+} // namespace
+
+UnitTest(FrequencyEstimatorTest)
+{
+    // Compare against straightforward complex arithmetic.
+    const size_t numBins = 101;
+    const double h = 1e-2;
+    std::vector<std::complex<double>> shift(numBins), bins(numBins);
+    std::vector<double> shiftRe(numBins), shiftIm(numBins), frequencies(numBins), re(numBins, 0), im(numBins, 0),
+        power(numBins), refPower(numBins);
+    for (size_t i = 0; i < numBins; ++i)
+    {
+        frequencies[i] = ::exp(::log(0.002) + i * h);
+        shift[i] = exp(-frequencies[i] * std::complex<double>(h, 2 * Pi()));
+        shiftRe[i] = shift[i].real();
+        shiftIm[i] = shift[i].imag();
+    }
+    uint32_t seed = 1;
+    for (int sample = 0; sample < 5000; ++sample)
+    {
+        seed = seed * 1664525 + 1013904223;
+        double input = ::sin(sample * 0.05) + (seed >> 8) * 1.0 / (1 << 24) - 0.5;
+
+        int idx = 0;
+        double refMax = -Inf<double>();
+        for (size_t i = 0; i < numBins; ++i)
+        {
+            bins[i] = bins[i] * shift[i] + input;
+            refPower[i] = norm(bins[i]) * frequencies[i];
+            if (refPower[i] > refMax)
+                refMax = refPower[i], idx = i;
+        }
+        double sum = idx * refPower[idx], mass = refPower[idx];
+        if (idx > 0)
+            sum += (idx - 1) * refPower[idx - 1], mass += refPower[idx - 1];
+        if (idx < int(numBins) - 1)
+            sum += (idx + 1) * refPower[idx + 1], mass += refPower[idx + 1];
+        double refPos = sum / mass;
+
+        double max = UpdateBins(numBins, shiftRe.data(), shiftIm.data(), frequencies.data(), input, re.data(),
+                                im.data(), power.data());
+        double pos = MaxPosition(numBins, power.data(), max);
+        for (size_t i = 0; i < numBins; ++i)
+            TestRequire(::fabs(power[i] - refPower[i]) <= 1e-9 * refMax);
+        TestFail_if(::fabs(pos - refPos) > 1e-6, "sample " << sample << ": " << pos << " instead of " << refPos);
+    }
+}
+
 FrequencyEstimator::FrequencyEstimator()
     : mBinVisualization("FEBN")
 {
@@ -63,7 +157,6 @@ void FrequencyEstimator::Preflight(const SignalProperties &Input, SignalProperti
 void FrequencyEstimator::Initialize(const SignalProperties &Input, const SignalProperties & /*Output*/)
 {
     Configure(Input, mData);
-    mBuffer.resize(mData.Power.Elements());
 
     if ((mVisualizeBins = (Parameter("FEVisualizeSpectrum") > 0)))
         mBinVisualization.Send(mData.Power.Properties()).Send(mData.Power);
@@ -72,15 +165,18 @@ void FrequencyEstimator::Initialize(const SignalProperties &Input, const SignalP
 
 void FrequencyEstimator::Process(const GenericSignal &Input, GenericSignal &Output)
 {
+    const size_t numBins = mData.NumBins;
+    const Real *shiftRe = mData.ShiftRe.data(), *shiftIm = mData.ShiftIm.data(),
+               *frequencies = mData.Frequencies.data();
+    GenericSignal::ValueType *power = mData.Power.MutableData();
     for (int ch = 0; ch < Input.Channels(); ++ch)
     {
+        Real *re = &mData.BinsRe[ch * numBins], *im = &mData.BinsIm[ch * numBins];
+        GenericSignal::ValueType *chPower = power + mData.Power.LinearIndex(ch, 0);
         for (int el = 0; el < Input.Elements(); ++el)
         {
-            mData.Bins[ch] *= mData.TimeshiftOperator;
-            mData.Bins[ch] += Input(ch, el);
-            for (int bin = 0; bin < mData.Power.Elements(); ++bin)
-                mData.Power(ch, bin) = norm(mData.Bins[ch][bin]) * mData.Frequencies[bin];
-            Output(ch, el) = GetMaxPosition(ch);
+            Real max = UpdateBins(numBins, shiftRe, shiftIm, frequencies, Input(ch, el), re, im, chPower);
+            Output(ch, el) = MaxPosition(numBins, chPower, max);
         }
     }
     if (mVisualizeBins)
@@ -104,44 +200,25 @@ void FrequencyEstimator::Configure(const SignalProperties &Input, Data &outData)
     u.SetOffset(-u.PhysicalToRawValue(binMin));
     s.ElementUnit() = u;
 
+    outData.NumBins = numBins;
     outData.Frequencies.resize(numBins);
-    outData.TimeshiftOperator.resize(numBins);
+    outData.ShiftRe.resize(numBins);
+    outData.ShiftIm.resize(numBins);
     Real h = Parameter("FEResolution");
     Complex dp = Complex(h, 2 * Pi());
     for (size_t i = 0; i < numBins; ++i)
     {
         double f = ::exp(s.ElementUnit().RawToPhysicalValue(i));
         outData.Frequencies[i] = f;
-        outData.TimeshiftOperator[i] = exp(-f * dp);
+        Complex shift = exp(-f * dp);
+        outData.ShiftRe[i] = shift.real();
+        outData.ShiftIm[i] = shift.imag();
     }
 
     s.ValueUnit() = Input.ValueUnit() * Input.ValueUnit();
     s.ValueUnit().SetRawMin(0);
     s.ValueUnit().SetRawMax(s.ValueUnit().RawMax() * h);
     outData.Power = GenericSignal(s, NaN<GenericSignal::ValueType>());
-    outData.Bins.resize(0);
-    outData.Bins.resize(Input.Channels(), ComplexVector(numBins));
-}
-
-double FrequencyEstimator::GetMaxPosition(int ch) const
-{
-    const GenericSignal &s = mData.Power;
-    int idx = 0;
-    double max = -Inf(max);
-    for (int i = 0; i < s.Elements(); ++i)
-        if (s(ch, i) > max)
-            max = s(ch, i), idx = i;
-
-    double sum = idx * s(ch, idx), mass = s(ch, idx);
-    if (idx > 0)
-    {
-        sum += (idx - 1) * s(ch, idx - 1);
-        mass += s(ch, idx - 1);
-    }
-    if (idx < s.Elements() - 1)
-    {
-        sum += (idx + 1) * s(ch, idx + 1);
-        mass += s(ch, idx + 1);
-    }
-    return sum / mass;
+    outData.BinsRe.assign(Input.Channels() * numBins, 0);
+    outData.BinsIm.assign(Input.Channels() * numBins, 0);
 }
@@ -29,7 +29,6 @@
 
 #include "GenericFilter.h"
 #include <complex>
-#include <valarray>
 #include <vector>
 
 class FrequencyEstimator : public GenericFilter
@@ -45,19 +44,19 @@ class FrequencyEstimator : public GenericFilter
   private:
     typedef double Real;
     typedef std::complex<Real> Complex;
-    typedef std::valarray<Complex> ComplexVector;
     typedef std::vector<Real> RealVector;
 
+    // Complex quantities are kept as separate arrays of real and imaginary
+    // parts, and bins are stored channel by channel, so the update of all bins
+    // of a channel may be vectorized.
     struct Data
     {
-        ComplexVector TimeshiftOperator;
-        std::vector<ComplexVector> Bins;
-        RealVector Frequencies;
+        size_t NumBins;
+        RealVector ShiftRe, ShiftIm, Frequencies;
+        RealVector BinsRe, BinsIm;
         GenericSignal Power;
     } mData;
-    RealVector mBuffer;
     void Configure(const SignalProperties &, Data &) const;
-    double GetMaxPosition(int) const;
 
     bool mVisualizeBins;
     GenericVisualization mBinVisualization;
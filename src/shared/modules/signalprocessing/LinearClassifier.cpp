@@ -39,9 +39,25 @@
 #include "LinearClassifier.h"
 
 #include <algorithm>
+#include <map>
 
 RegisterFilter(LinearClassifier, 2.D);
 
+namespace
+{
+// Gaps of up to this many zero weights are included in a run rather than starting a new one.
+const size_t cMaxGap = 8;
+
+GenericSignal::ValueType Dot(const GenericSignal::ValueType *x, const GenericSignal::ValueType *w, size_t n)
+{
+    GenericSignal::ValueType sum = 0;
+#pragma omp simd reduction(+ : sum)
+    for (size_t i = 0; i < n; ++i)
+        sum += x[i] * w[i];
+    return sum;
+}
+} // namespace
+
 LinearClassifier::LinearClassifier()
 {
     BEGIN_PARAMETER_DEFINITIONS
@@ -128,31 +144,63 @@ void LinearClassifier::Preflight(const SignalProperties &Input, SignalProperties
     }
 }
 
-void LinearClassifier::Initialize(const SignalProperties &Input, const SignalProperties & /*Output*/)
+void LinearClassifier::Initialize(const SignalProperties &Input, const SignalProperties &Output)
 {
+    // Collect weights by output channel and linear input index, adding up duplicate entries.
+    std::map<size_t, std::map<size_t, GenericSignal::ValueType>> weights;
     const ParamRef &Classifier = Parameter("Classifier");
-    size_t numEntries = Classifier->NumRows();
-    mInputChannels.resize(numEntries);
-    mInputElements.resize(numEntries);
-    mOutputChannels.resize(numEntries);
-    mWeights.resize(numEntries);
-    for (size_t entry = 0; entry < numEntries; ++entry)
+    for (int entry = 0; entry < Classifier->NumRows(); ++entry)
     {
-        mInputChannels[entry] = Round(Input.ChannelIndex(Classifier(entry, 0)));
-        mInputElements[entry] = Round(Input.ElementIndex(Classifier(entry, 1)));
-        mOutputChannels[entry] = static_cast<size_t>(Classifier(entry, 2) - 1);
-        mWeights[entry] = Classifier(entry, 3);
+        size_t inputChannel = Round(Input.ChannelIndex(Classifier(entry, 0))),
+               inputElement = Round(Input.ElementIndex(Classifier(entry, 1))),
+               outputChannel = static_cast<size_t>(Classifier(entry, 2) - 1);
+        weights[Output.LinearIndex(outputChannel, 0)][Input.LinearIndex(inputChannel, inputElement)] +=
+            Classifier(entry, 3);
     }
+
+    mRows.clear();
+    mRuns.clear();
+    mWeights.clear();
+    for (const auto &row : weights)
+    {
+        Row r = {row.first, mRuns.size(), mRuns.size()};
+        for (const auto &entry : row.second)
+        {
+            if (r.endRun > r.beginRun)
+            {
+                Run &run = mRuns.back();
+                size_t end = run.input + run.length;
+                if (entry.first - end <= cMaxGap)
+                {
+                    mWeights.resize(mWeights.size() + entry.first - end, 0);
+                    mWeights.push_back(entry.second);
+                    run.length = entry.first - run.input + 1;
+                    continue;
+                }
+            }
+            Run run = {entry.first, mWeights.size(), 1};
+            mRuns.push_back(run);
+            mWeights.push_back(entry.second);
+            ++r.endRun;
+        }
+        mRows.push_back(r);
+    }
+    bcidbg << "Compiled " << Classifier->NumRows() << " classifier entries into " << mRuns.size() << " runs of "
+           << mWeights.size() << " weights";
 }
 
 void LinearClassifier::Process(const GenericSignal &Input, GenericSignal &Output)
 {
-    for (int ch = 0; ch < Output.Channels(); ++ch)
-        for (int el = 0; el < Output.Elements(); ++el)
-            Output(ch, el) = 0.0;
-
-    for (size_t i = 0; i < mWeights.size(); ++i)
-        Output(mOutputChannels[i], 0) += Input(mInputChannels[i], mInputElements[i]) * mWeights[i];
+    Output.SetAllValues(0);
+    const GenericSignal::ValueType *pInput = Input.ConstData(), *pWeights = mWeights.data();
+    GenericSignal::ValueType *pOutput = Output.MutableData();
+    for (const auto &row : mRows)
+    {
+        GenericSignal::ValueType sum = 0;
+        for (size_t i = row.beginRun; i < row.endRun; ++i)
+            sum += Dot(pInput + mRuns[i].input, pWeights + mRuns[i].weight, mRuns[i].length);
+        pOutput[row.output] = sum;
+    }
 }
 
 std::string LinearClassifier::DescribeEntry(int inRow, int inCol) const
@@ -54,8 +54,20 @@ class LinearClassifier : public GenericFilter
     std::string DescribeEntry(int row, int col) const;
     static int Round(double);
 
-    std::vector<size_t> mInputChannels, mInputElements, mOutputChannels;
-    std::vector<double> mWeights;
+    // At Initialize(), classifier weights are compiled into runs of consecutive
+    // weights over the input signal's linear (channel x element) index, such that
+    // each output value is a sum of dot products over contiguous memory.
+    struct Run
+    {
+        size_t input, weight, length;
+    };
+    struct Row
+    {
+        size_t output, beginRun, endRun;
+    };
+    std::vector<Row> mRows;
+    std::vector<Run> mRuns;
+    std::vector<GenericSignal::ValueType> mWeights;
 };
 
 #endif // LINEAR_CLASSIFIER_H
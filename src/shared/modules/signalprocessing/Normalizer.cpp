@@ -31,8 +31,11 @@
 ////////////////////////////////////////////////////////////////////////////////
 #include "Normalizer.h"
 
+#include <algorithm>
+#include <cmath>
 #include <ctime>
 #include <fstream>
+#include <map>
 #include <numeric>
 
 RegisterFilter(Normalizer, 2.E1);
@@ -57,6 +60,10 @@ Normalizer::Normalizer() : mpUpdateTrigger(NULL), mPreviousTrigger(true), mDoAda
         " multiple buffers)",
     "Filtering float BufferLength= 9s 9s % % "
         "0 0 % // time window of past data per buffer that enters into statistic",
+    "Filtering int BufferMode= 0 0 0 1 "
+        "// 0: sliding window of BufferLength, "
+        "1: exponential forgetting with time constant BufferLength "
+        "(enumeration)",
     "Filtering string UpdateTrigger= (Feedback==0) "
         "% % % // expression to trigger offset/gain update when changing from 0 "
         "(use empty string for continuous update)",
@@ -118,6 +125,7 @@ void Normalizer::Preflight(const SignalProperties &Input, SignalProperties &Outp
         double bufferSize = Parameter("BufferLength").InSampleBlocks();
         if (bufferSize < 1)
             bciout << "The BufferLength parameter specifies a zero-sized buffer";
+        Parameter("BufferMode");
     }
     // Request output signal properties:
     Output = Input;
@@ -134,6 +142,8 @@ void Normalizer::Initialize(const SignalProperties &Input, const SignalPropertie
     delete mpUpdateTrigger;
     mpUpdateTrigger = NULL;
 
+    mConditions.clear();
+    mConditionValues.clear();
     mBufferConditions.clear();
     mDataBuffers.clear();
 
@@ -155,16 +165,35 @@ void Normalizer::Initialize(const SignalProperties &Input, const SignalPropertie
         if (!UpdateTrigger.empty())
             mpUpdateTrigger = new Expression(UpdateTrigger);
 
-        size_t bufferSize = static_cast<size_t>(Parameter("BufferLength").InSampleBlocks() * Input.Elements());
+        double bufferLength = Parameter("BufferLength").InSampleBlocks();
+        size_t windowBlocks = 0;
+        double sampleDecay = 1;
+        if (Parameter("BufferMode") == exponentialForgetting)
+            sampleDecay = (bufferLength > 0) ? ::exp(-1.0 / (bufferLength * Input.Elements())) : 0;
+        else
+            windowBlocks = static_cast<size_t>(bufferLength);
+
         ParamRef BufferConditions = Parameter("BufferConditions");
+        std::map<std::string, size_t> conditionIndices;
         mBufferConditions.resize(BufferConditions->NumColumns());
         for (int col = 0; col < BufferConditions->NumColumns(); ++col)
             for (int row = 0; row < BufferConditions->NumRows(); ++row)
-                mBufferConditions[col].push_back(Expression(BufferConditions(row, col)));
+            {
+                std::string condition = BufferConditions(row, col);
+                auto i = conditionIndices.find(condition);
+                if (i == conditionIndices.end())
+                {
+                    i = conditionIndices.insert(std::make_pair(condition, mConditions.size())).first;
+                    mConditions.push_back(Expression(condition));
+                }
+                mBufferConditions[col].push_back(i->second);
+            }
+        mConditionValues.resize(mConditions.size());
         mDataBuffers.resize(BufferConditions->NumColumns(),
-                            std::vector<RingBuffer>(BufferConditions->NumRows(), RingBuffer(bufferSize)));
+                            std::vector<RunningStatistics>(BufferConditions->NumRows(),
+                                                           RunningStatistics(windowBlocks, sampleDecay)));
         bcidbg << "Allocated " << mDataBuffers.size() << "x" << (mDataBuffers.empty() ? 0 : mDataBuffers[0].size())
-               << " data buffers of size " << bufferSize << ".";
+               << " data buffers using " << mConditions.size() << " distinct conditions.";
     }
 }
 
@@ -172,15 +201,13 @@ void Normalizer::Process(const GenericSignal &Input, GenericSignal &Output)
 {
     if (mDoAdapt)
     {
+        for (size_t i = 0; i < mConditions.size(); ++i)
+            mConditionValues[i] = mConditions[i].Evaluate(&Input);
+        const GenericSignal::ValueType *pData = Input.ConstData();
         for (size_t channel = 0; channel < mBufferConditions.size(); ++channel)
             for (size_t buffer = 0; buffer < mBufferConditions[channel].size(); ++buffer)
-            {
-                double label = mBufferConditions[channel][buffer].Evaluate(&Input);
-                if (label != 0)
-                    for (int sample = 0; sample < Input.Elements(); ++sample)
-                        if (!IsNaN(Input(channel, sample)))
-                            mDataBuffers[channel][buffer].Put(Input(channel, sample));
-            }
+                if (mConditionValues[mBufferConditions[channel][buffer]] != 0)
+                    mDataBuffers[channel][buffer].Put(pData + channel * Input.Elements(), Input.Elements());
         if (mpUpdateTrigger != NULL)
         {
             bool currentTrigger = mpUpdateTrigger->Evaluate(&Input);
@@ -245,25 +272,18 @@ void Normalizer::Update()
 {
     for (size_t channel = 0; channel < mDataBuffers.size(); ++channel)
         if (mAdaptation[channel] != none)
-        { // Compute raw moments for all buffers.
-            size_t numValues = 0;
+        { // Collect raw moments from all buffers.
+            double numValues = 0;
             std::vector<double> bufferMeans;
             std::vector<double> bufferSqMeans;
             for (size_t i = 0; i < mDataBuffers[channel].size(); ++i)
             {
-                const RingBuffer &buffer = mDataBuffers[channel][i];
-                const RingBuffer::DataVector &data = buffer.Data();
-                double bufferSum = 0, bufferSqSum = 0;
-                for (size_t j = 0; j < buffer.Fill(); ++j)
-                {
-                    bufferSum += data[j];
-                    bufferSqSum += data[j] * data[j];
-                }
-                numValues += buffer.Fill();
-                if (buffer.Fill() > 0)
+                const RunningStatistics &buffer = mDataBuffers[channel][i];
+                numValues += buffer.Count();
+                if (buffer.Count() > 0)
                 {
-                    bufferMeans.push_back(bufferSum / buffer.Fill());
-                    bufferSqMeans.push_back(bufferSqSum / buffer.Fill());
+                    bufferMeans.push_back(buffer.Mean());
+                    bufferSqMeans.push_back(buffer.SqMean());
                 }
             }
             // Compute total mean and variance from raw moments.
@@ -299,3 +319,73 @@ void Normalizer::Update()
             }
         }
 }
+
+Normalizer::RunningStatistics::RunningStatistics(size_t inWindowBlocks, double inSampleDecay)
+    : mBlocks(inSampleDecay < 1 ? 0 : inWindowBlocks), mCursor(0), mSampleDecay(inSampleDecay)
+{
+    mTotal.count = 0;
+    mTotal.mean = 0;
+    mTotal.m2 = 0;
+}
+
+void Normalizer::RunningStatistics::Put(const double *inData, size_t inCount)
+{
+    // Moments of the block's valid values, computed in two passes for accuracy.
+    Moments block = {0, 0, 0};
+    for (size_t i = 0; i < inCount; ++i)
+        if (!IsNaN(inData[i]))
+        {
+            block.count += 1;
+            block.mean += inData[i];
+        }
+    if (block.count == 0)
+        return;
+    block.mean /= block.count;
+    for (size_t i = 0; i < inCount; ++i)
+        if (!IsNaN(inData[i]))
+            block.m2 += (inData[i] - block.mean) * (inData[i] - block.mean);
+
+    if (mSampleDecay < 1)
+    {
+        Add(mTotal, block, ::pow(mSampleDecay, block.count));
+    }
+    else if (!mBlocks.empty())
+    {
+        Remove(mTotal, mBlocks[mCursor]);
+        mBlocks[mCursor] = block;
+        Add(mTotal, block);
+        mCursor = (mCursor + 1) % mBlocks.size();
+    }
+}
+
+// Combination of moments as given by Chan et al., with previous data weighted by a decay factor.
+void Normalizer::RunningStatistics::Add(Moments &ioTotal, const Moments &inBlock, double inDecay)
+{
+    double count = ioTotal.count * inDecay, newCount = count + inBlock.count;
+    if (newCount <= 0)
+        return;
+    double delta = inBlock.mean - ioTotal.mean;
+    ioTotal.mean += delta * inBlock.count / newCount;
+    ioTotal.m2 = ioTotal.m2 * inDecay + inBlock.m2 + delta * delta * count * inBlock.count / newCount;
+    ioTotal.count = newCount;
+}
+
+// Inverse of Add(), removing an expiring block's contribution.
+void Normalizer::RunningStatistics::Remove(Moments &ioTotal, const Moments &inBlock)
+{
+    double newCount = ioTotal.count - inBlock.count;
+    if (inBlock.count <= 0)
+        return;
+    if (newCount <= 0.5)
+    { // Avoid accumulation of rounding errors when the window runs empty.
+        ioTotal.count = 0;
+        ioTotal.mean = 0;
+        ioTotal.m2 = 0;
+        return;
+    }
+    double newMean = (ioTotal.mean * ioTotal.count - inBlock.mean * inBlock.count) / newCount,
+           delta = inBlock.mean - newMean;
+    ioTotal.m2 = std::max(0.0, ioTotal.m2 - inBlock.m2 - delta * delta * newCount * inBlock.count / ioTotal.count);
+    ioTotal.mean = newMean;
+    ioTotal.count = newCount;
+}
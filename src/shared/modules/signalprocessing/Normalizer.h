@@ -34,7 +34,6 @@
 
 #include "Expression.h"
 #include "GenericFilter.h"
-#include <valarray>
 #include <vector>
 
 class Normalizer : public GenericFilter
@@ -66,46 +65,56 @@ class Normalizer : public GenericFilter
         zeroMean,
         zeroMeanUnitVariance,
     };
+    enum BufferModes
+    {
+        slidingWindow = 0,
+        exponentialForgetting,
+    };
 
     void Update();
 
-    class RingBuffer
+    // Running mean and variance of the data that entered a buffer, computed from
+    // per-block statistics. Data are either kept for a window of blocks, with
+    // statistics of expiring blocks subtracted, or forgotten exponentially.
+    // The cost of an update does not depend on the length of the window.
+    class RunningStatistics
     {
       public:
-        typedef std::valarray<double> DataVector;
+        RunningStatistics(size_t inWindowBlocks, double inSampleDecay);
 
-        explicit RingBuffer(size_t inSize) : mData(0.0, inSize), mCursor(0), mWrapped(false)
+        void Put(const double *inData, size_t inCount);
+        double Count() const
         {
+            return mTotal.count;
         }
-
-        const size_t Fill() const
+        double Mean() const
         {
-            return mWrapped ? mData.size() : mCursor;
+            return mTotal.mean;
         }
-        const DataVector &Data() const
+        double SqMean() const
         {
-            return mData;
+            return mTotal.count > 0 ? mTotal.m2 / mTotal.count + mTotal.mean * mTotal.mean : 0;
         }
 
-        void Put(double inData)
+      private:
+        struct Moments
         {
-            if (++mCursor == mData.size())
-            {
-                mWrapped = true;
-                mCursor = 0;
-            }
-            if (mData.size() > 0)
-                mData[mCursor] = inData;
-        }
+            double count, mean, m2;
+        };
+        static void Add(Moments &, const Moments &, double inDecay = 1);
+        static void Remove(Moments &, const Moments &);
 
-      private:
-        DataVector mData;
+        std::vector<Moments> mBlocks;
         size_t mCursor;
-        bool mWrapped;
+        double mSampleDecay;
+        Moments mTotal;
     };
 
-    std::vector<std::vector<RingBuffer>> mDataBuffers;
-    std::vector<std::vector<Expression>> mBufferConditions;
+    std::vector<std::vector<RunningStatistics>> mDataBuffers;
+    // Each distinct condition expression is evaluated once per block.
+    std::vector<Expression> mConditions;
+    std::vector<double> mConditionValues;
+    std::vector<std::vector<size_t>> mBufferConditions;
 
     Expression *mpUpdateTrigger;
     bool mPreviousTrigger;
@@ -38,20 +38,40 @@ void SourceDecimationFilter::Publish()
         "Source:Decimation float LowPassCorner=   auto   0Hz  % % // Low pass corner frequency",
         "Source:Decimation int   LowPassOrder=    auto    4    0 % // Low pass order",
         "Source:Decimation int   Downsample=      1      1    1 % // Decimation order",
+        "Source:Decimation int   DecimationFilter= 0     0    0 1 "
+            "// Anti-aliasing filter: 0: IIR lowpass, 1: linear-phase FIR (enumeration)",
+        "Source:Decimation float FIRAttenuation=  60     60   20 % "
+            "// Stopband attenuation of the FIR filter in dB",
     END_PARAMETER_DEFINITIONS
 }
 
+void SourceDecimationFilter::Preflight(const SignalProperties &Input, SignalProperties &Output) const
+{
+    if (Parameter("DecimationFilter") == FIR)
+    {
+        Output = Input;
+        std::vector<Real> coefficients;
+        DesignFIR(Output, coefficients);
+    }
+    else
+    {
+        Super::Preflight(Input, Output);
+    }
+}
+
 void SourceDecimationFilter::Initialize(const SignalProperties &Input, const SignalProperties &Output)
 {
+    mFilterType = Parameter("DecimationFilter");
     if (Parameter("Downsample").ToString() == "auto")
     {
         Parameter("Downsample") = 1;
     }
-    if (Parameter("LowPassCorner").ToString() == "auto")
+    // The FIR design does not use LowPassOrder, and does not check it during preflight.
+    if (mFilterType == IIR && Parameter("LowPassCorner").ToString() == "auto")
     {
         Parameter("LowPassCorner") = (Input.SamplingRate() / ((int)Parameter("Downsample"))) * 4;
     }
-    if (Parameter("LowPassOrder").ToString() == "auto")
+    if (mFilterType == IIR && Parameter("LowPassOrder").ToString() == "auto")
     {
         Parameter("LowPassOrder") = 4;
     }
@@ -60,15 +80,38 @@ void SourceDecimationFilter::Initialize(const SignalProperties &Input, const Sig
     {
         bciout << "Downsampling is set to 1, no Downsampling or filtering will be performed" << std::endl;
     }
-    Super::Initialize(Input, Output);
+    if (mFilterType == FIR)
+    {
+        SignalProperties sp(Input);
+        std::vector<Real> coefficients;
+        DesignFIR(sp, coefficients);
+        mDecimator.SetCoefficients(coefficients).SetDecimation(mDownsampling).Initialize(Input.Channels());
+        if (mDownsampling > 1)
+            bciout << "Downsampling from " << Input.SamplingRate() << "Hz to " << Output.SamplingRate()
+                   << "Hz using an FIR filter of length " << coefficients.size();
+    }
+    else
+    {
+        Super::Initialize(Input, Output);
+    }
 }
 
-void SourceDecimationFilter::Process(const GenericSignal &Input, GenericSignal &Output)
+void SourceDecimationFilter::StartRun()
 {
-    if (mDownsampling > 1)
-        Super::Process(Input, Output);
+    if (mFilterType == FIR)
+        mDecimator.Initialize();
     else
+        Super::StartRun();
+}
+
+void SourceDecimationFilter::Process(const GenericSignal &Input, GenericSignal &Output)
+{
+    if (mDownsampling <= 1)
         Output = Input;
+    else if (mFilterType == FIR)
+        mDecimator.Process(Input, Output);
+    else
+        Super::Process(Input, Output);
 }
 
 void SourceDecimationFilter::DesignFilter(SignalProperties &Signal, Real &outGain, ComplexVector &outZeros,
@@ -107,3 +150,46 @@ void SourceDecimationFilter::DesignFilter(SignalProperties &Signal, Real &outGai
     outZeros = tf.Numerator().Roots();
     outPoles = tf.Denominator().Roots();
 }
+
+void SourceDecimationFilter::DesignFIR(SignalProperties &Signal, std::vector<Real> &outCoefficients) const
+{
+    outCoefficients.assign(1, 1.0);
+    int f = Parameter("Downsample").ToString() == "auto" ? 1 : (int)Parameter("Downsample");
+    if (f <= 1)
+        return;
+    if (Signal.Elements() % f)
+    {
+        bcierr << "When using the FIR decimation filter, Downsample (now " << f << ") "
+               << "must be a divider of the sample block size (now " << Signal.Elements() << ")";
+        return;
+    }
+    // Frequencies in terms of the input sampling rate. The stopband begins at
+    // the output Nyquist frequency, so no component will alias into the
+    // passband or transition band.
+    Real nyquist = 0.5 / f, passEdge = 0.8 * nyquist;
+    if (Parameter("LowPassCorner").ToString() != "auto")
+    {
+        Real corner = Parameter("LowPassCorner").InHertz() / Signal.SamplingRate();
+        if (corner <= 0 || corner >= nyquist)
+            bcierr << "When using the FIR decimation filter, LowPassCorner must be > 0 "
+                   << "and below the Nyquist frequency of the decimated signal";
+        else
+            passEdge = corner;
+    }
+    Real attenuation = Parameter("FIRAttenuation");
+    if (attenuation <= 0)
+        bcierr << "FIRAttenuation must be > 0";
+    outCoefficients = FilterDesign::WindowedSinc()
+                          .Lowpass((passEdge + nyquist) / 2)
+                          .TransitionWidth(nyquist - passEdge)
+                          .Attenuation_dB(attenuation)
+                          .Coefficients();
+    Real gain = Parameter("FilterGain");
+    for (auto &c : outCoefficients)
+        c *= gain;
+
+    Signal.SetElements(Signal.Elements() / f);
+    PhysicalUnit &u = Signal.ElementUnit();
+    u.SetGain(u.Gain() * f);
+    u.SetRawMax(u.RawMax() / f);
+}
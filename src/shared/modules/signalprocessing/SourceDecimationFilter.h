@@ -27,6 +27,8 @@
 #define SOURCE_DEC_FILTER_H
 
 #include "IIRFilterBase.h"
+#include "PolyphaseDecimator.h"
+#include <vector>
 
 class SourceDecimationFilter : public IIRFilterBase
 {
@@ -34,13 +36,25 @@ class SourceDecimationFilter : public IIRFilterBase
 
   public:
     void Publish() override;
+    void Preflight(const SignalProperties &, SignalProperties &) const override;
     void Initialize(const SignalProperties &, const SignalProperties &) override;
+    void StartRun() override;
     void Process(const GenericSignal &, GenericSignal &) override;
 
   private:
+    enum
+    {
+        IIR = 0,
+        FIR = 1,
+    };
     void DesignFilter(SignalProperties &, Real &gain, ComplexVector &zeros, ComplexVector &poles) const override;
+    // Linear-phase FIR alternative to DesignFilter(); output samples are only
+    // computed where they are retained after decimation.
+    void DesignFIR(SignalProperties &, std::vector<Real> &coefficients) const;
 
-    int mDownsampling;
+    int mDownsampling, mFilterType;
+    // Single precision doubles SIMD width, and its rounding noise is far below stopband attenuation.
+    PolyphaseDecimator<float> mDecimator;
 };
 
 #endif // IIR_BANDPASS_H
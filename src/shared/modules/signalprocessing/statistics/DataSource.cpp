@@ -28,6 +28,7 @@
 
 #include "BCIStream.h"
 #include "Debugging.h"
+#include "ThreadUtils.h"
 
 #include <algorithm>
 
@@ -254,8 +255,22 @@ void DataSource::Initialize(const Context &inContext)
 
 void DataSource::Process(const Context &inContext)
 {
-    BCIStream::ContextFrame frame(Name());
-    OnProcess(inContext);
+    // Context frames are kept in a global list, so only the main thread may add one.
+    if (ThreadUtils::InMainThread())
+    {
+        BCIStream::ContextFrame frame(Name());
+        OnProcess(inContext);
+    }
+    else
+    {
+        OnProcess(inContext);
+    }
+}
+
+void DataSource::ProcessPart(const Context &inContext, int inPart)
+{
+    Assert(inPart >= 0 && inPart < Parts());
+    OnProcessPart(inContext, inPart);
 }
 
 DataSource::Value DataSource::Data(int inIdx)
@@ -155,6 +155,25 @@ class DataSource
     void Process(const Context &);
     Value Data(const IndexList &);
     Value Data(int);
+    // Sources that compute their data when Data() is called must not be read
+    // from multiple threads at the same time.
+    bool OnDemand() const
+    {
+        return OnIsOnDemand();
+    }
+    // Variables are shared by all expressions, so sources that read or assign
+    // variables must be processed one at a time, and in list order.
+    bool RefersVariables() const
+    {
+        return OnRefersVariables();
+    }
+    // After Process() has been called, a source may provide a number of independent
+    // parts of work, which may then be processed concurrently by calling ProcessPart().
+    int Parts() const
+    {
+        return OnParts();
+    }
+    void ProcessPart(const Context &, int);
     // The abort flag is tested frequently, and synchronization is not critical.
     // It is thus not protected by a mutex.
     static void SetAbortFlag(bool inAbort = true)
@@ -181,6 +200,21 @@ class DataSource
     // Access to data takes a single index, which may be obtained from multiple
     // indices using DataProperties::CalculateIndex().
     virtual Value OnData(int) = 0;
+    virtual bool OnIsOnDemand() const
+    {
+        return false;
+    }
+    virtual bool OnRefersVariables() const
+    {
+        return false;
+    }
+    virtual int OnParts() const
+    {
+        return 0;
+    }
+    virtual void OnProcessPart(const Context &, int)
+    {
+    }
 
   protected:
     DataProperties mProperties;
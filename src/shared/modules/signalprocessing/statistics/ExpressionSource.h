@@ -45,6 +45,14 @@ class ExpressionSource : public DataSource, private Expression
     void OnInitialize(const Context &);
     void OnProcess(const Context &);
     Value OnData(int);
+    bool OnIsOnDemand() const
+    {
+        return true;
+    }
+    bool OnRefersVariables() const
+    {
+        return Expression::RefersVariables();
+    }
 
     // ArithmeticExpression interface
   protected:
@@ -47,6 +47,10 @@ class FunctionSource : public DataSource, public ExpressionParser::Node
     void OnInitialize(const Context &);
     void OnProcess(const Context &);
     Value OnData(int);
+    bool OnIsOnDemand() const
+    {
+        return true;
+    }
 
     // Node interface
   protected:
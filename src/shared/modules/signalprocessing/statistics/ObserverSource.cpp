@@ -28,6 +28,8 @@
 #include "BCIException.h"
 #include "ExpressionSource.h"
 
+#include <algorithm>
+
 double ObserverNode::OnEvaluate()
 {
     throw std_logic_error << "Function should never be called";
@@ -116,25 +118,64 @@ void ObserverSource::OnInitialize(const Context &inContext)
         mObservers[i]->SetWindowLength(mWindow);
         mObservers[i]->Observe(mSampleBuffer, 0);
     }
+    mAgingCounts.clear();
+    mPending.clear();
+    mPending.resize(numObservers);
+    for (auto &pending : mPending)
+        pending.buffer.resize(mSampleBuffer.size());
 }
 
 void ObserverSource::OnProcess(const Context &inContext)
 {
+    mAgingCounts.clear();
+    for (auto &pending : mPending)
+    { // Normally empty, unless processing was aborted.
+        pending.sampleIndices.clear();
+        pending.weights.clear();
+        pending.values.clear();
+    }
     if (mReset.Evaluate(inContext.signal))
         Reset();
     if (!mWhen.Evaluate(inContext.signal))
         return;
 
+    // Reading data from sources is not thread safe, so data is collected here
+    // and passed to observers from OnProcessPart().
     for (mCurSample = 0; mCurSample < mStreamingMax; ++mCurSample)
     {
         int agingCount =
             ((mCurSample + 1) * mSampleBlockSize) / mStreamingMax - (mCurSample * mSampleBlockSize) / mStreamingMax;
-        for (size_t i = 0; i < mObservers.size(); ++i)
-            mObservers[i]->AgeBy(agingCount);
+        mAgingCounts.push_back(agingCount);
         Observe();
     }
 }
 
+int ObserverSource::OnParts() const
+{
+    return mAgingCounts.empty() ? 0 : static_cast<int>(mObservers.size());
+}
+
+void ObserverSource::OnProcessPart(const Context &, int inPart)
+{
+    StatisticalObserver::Observer *pObserver = mObservers[inPart];
+    PendingSamples &pending = mPending[inPart];
+    const size_t sampleSize = pending.buffer.size();
+    size_t k = 0;
+    for (int sample = 0; sample < static_cast<int>(mAgingCounts.size()); ++sample)
+    {
+        pObserver->AgeBy(mAgingCounts[sample]);
+        for (; k < pending.sampleIndices.size() && pending.sampleIndices[k] == sample; ++k)
+        {
+            const StatisticalObserver::Number *pValues = pending.values.data() + k * sampleSize;
+            std::copy(pValues, pValues + sampleSize, std::begin(pending.buffer));
+            pObserver->Observe(pending.buffer, pending.weights[k]);
+        }
+    }
+    pending.sampleIndices.clear();
+    pending.weights.clear();
+    pending.values.clear();
+}
+
 DataSource::Value ObserverSource::OnData(int)
 {
     throw std_logic_error << "Function should never be called";
@@ -151,8 +192,11 @@ void ObserverSource::Observe(size_t inSource, size_t inSourceDim, size_t inSourc
 
     if (inSource >= Sources().size())
     {
-        Assert(inObserverIdx < mObservers.size());
-        mObservers[inObserverIdx]->Observe(mSampleBuffer, inWeight);
+        Assert(inObserverIdx < mPending.size());
+        PendingSamples &pending = mPending[inObserverIdx];
+        pending.sampleIndices.push_back(mCurSample);
+        pending.weights.push_back(inWeight);
+        pending.values.insert(pending.values.end(), std::begin(mSampleBuffer), std::end(mSampleBuffer));
     }
     else
     {
@@ -90,6 +90,14 @@ class ObserverSource : public DataSource
     void OnInitialize(const Context &);
     void OnProcess(const Context &);
     Value OnData(int);
+    // OnProcess() collects samples, which are then passed to observers in parallel,
+    // with one part per observer.
+    int OnParts() const;
+    bool OnRefersVariables() const
+    {
+        return mWhen.RefersVariables() || mReset.RefersVariables();
+    }
+    void OnProcessPart(const Context &, int);
 
   private:
     void Observe(size_t = 0, size_t = 0, size_t = 0, size_t = 0, size_t = 0, double = 1);
@@ -110,6 +118,14 @@ class ObserverSource : public DataSource
     // Processing
     int mCurSample;
     StatisticalObserver::Vector mSampleBuffer;
+    std::vector<int> mAgingCounts;
+    struct PendingSamples
+    {
+        std::vector<int> sampleIndices;
+        std::vector<StatisticalObserver::Number> weights, values;
+        StatisticalObserver::Vector buffer;
+    };
+    std::vector<PendingSamples> mPending;
 };
 
 #endif // OBSERVER_SOURCE_H
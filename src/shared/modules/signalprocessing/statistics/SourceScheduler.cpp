@@ -0,0 +1,449 @@
+////////////////////////////////////////////////////////////////////////////////
+// $Id$
+// Author: BCI2000 team
+// Description: Processes data sources level by level, running independent
+//   sources concurrently.
+//
+// $BEGIN_BCI2000_LICENSE$
+//
+// This file is part of BCI2000, a platform for real-time bio-signal research.
+// [ Copyright (C) 2000-2022: BCI2000 team and many external contributors ]
+//
+// BCI2000 is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// BCI2000 is distributed in the hope that it will be useful, but
+//                         WITHOUT ANY WARRANTY
+// - without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+// A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// $END_BCI2000_LICENSE$
+////////////////////////////////////////////////////////////////////////////////
+#include "SourceScheduler.h"
+
+#include "Exception.h"
+#include "ReusableThread.h"
+#include "Runnable.h"
+#include "ThreadUtils.h"
+#include "TimeUtils.h"
+#include "UnitTest.h"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <map>
+#include <mutex>
+#include <set>
+
+struct SourceScheduler::Private
+{
+    // A task is a list of sources that must be processed in sequence by a single thread.
+    typedef std::vector<size_t> Task;
+    struct Level
+    {
+        std::vector<size_t> sources;
+        std::vector<Task> tasks;
+    };
+    struct Part
+    {
+        size_t source;
+        int index;
+    };
+    // Processes tasks or parts, taking the next unprocessed item until none is left.
+    struct Worker : Runnable
+    {
+        Private *mpParent;
+        std::vector<int64_t> mTime;
+        void OnRun() override;
+    };
+
+    std::vector<DataSource *> mSources;
+    std::vector<int> mLevelOf;
+    std::vector<Level> mLevels;
+    std::vector<int64_t> mTotalTime, mMaxTime;
+    std::vector<double> mLastSeconds;
+    int64_t mBlocks;
+
+    int mThreads;
+    std::vector<ReusableThread *> mPool;
+    std::vector<Worker> mWorkers;
+
+    // State of the current parallel run.
+    const DataSource::Context *mpContext;
+    const Level *mpLevel;
+    std::vector<Part> mParts;
+    bool mRunParts;
+    size_t mCount;
+    std::atomic<size_t> mNext;
+    std::mutex mErrorMutex;
+    std::exception_ptr mError;
+
+    Private() : mBlocks(0), mThreads(1), mpContext(nullptr), mpLevel(nullptr), mRunParts(false), mCount(0), mNext(0)
+    {
+    }
+    ~Private()
+    {
+        DeletePool();
+    }
+    void DeletePool()
+    {
+        for (auto pThread : mPool)
+            delete pThread;
+        mPool.clear();
+    }
+    void RunItems(size_t count);
+    void RunItem(size_t item, std::vector<int64_t> &time);
+};
+
+void SourceScheduler::Private::Worker::OnRun()
+{
+    size_t item;
+    while ((item = mpParent->mNext++) < mpParent->mCount)
+    {
+        try
+        {
+            mpParent->RunItem(item, mTime);
+        }
+        catch (...)
+        {
+            std::lock_guard<std::mutex> lock(mpParent->mErrorMutex);
+            if (!mpParent->mError)
+                mpParent->mError = std::current_exception();
+            mpParent->mNext = mpParent->mCount;
+        }
+    }
+}
+
+void SourceScheduler::Private::RunItem(size_t inItem, std::vector<int64_t> &ioTime)
+{
+    if (mRunParts)
+    {
+        const Part &part = mParts[inItem];
+        Time t0 = TimeUtils::MonotonicTime();
+        mSources[part.source]->ProcessPart(*mpContext, part.index);
+        ioTime[part.source] += (TimeUtils::MonotonicTime() - t0).RawInt();
+    }
+    else
+    {
+        for (size_t source : mpLevel->tasks[inItem])
+        {
+            if (DataSource::AbortFlag())
+                break;
+            Time t0 = TimeUtils::MonotonicTime();
+            mSources[source]->Process(*mpContext);
+            ioTime[source] += (TimeUtils::MonotonicTime() - t0).RawInt();
+        }
+    }
+}
+
+void SourceScheduler::Private::RunItems(size_t inCount)
+{
+    mCount = inCount;
+    mNext = 0;
+    size_t threads = std::min<size_t>(mWorkers.size(), inCount);
+    // The calling thread works along with the pool threads.
+    std::vector<bool> running(threads, false);
+    for (size_t i = 1; i < threads; ++i)
+        running[i] = mPool[i - 1]->Run(mWorkers[i]);
+    mWorkers[0].Run();
+    for (size_t i = 1; i < threads; ++i)
+        if (running[i])
+            mPool[i - 1]->Wait();
+    if (mError)
+    {
+        std::exception_ptr error = mError;
+        mError = nullptr;
+        std::rethrow_exception(error);
+    }
+}
+
+SourceScheduler::SourceScheduler() : p(new Private)
+{
+}
+
+SourceScheduler::~SourceScheduler()
+{
+    delete p;
+}
+
+SourceScheduler &SourceScheduler::Schedule(const DataSource::SourceList &inSources, int inThreads)
+{
+    Clear();
+    p->mSources = inSources;
+    size_t count = inSources.size();
+    std::map<const DataSource *, size_t> index;
+    for (size_t i = 0; i < count; ++i)
+        index[inSources[i]] = i;
+
+    // A source's level is one above the highest level of its dependencies.
+    // Sources computing data on demand are read by the sources depending on them,
+    // so each source is associated with the set of on-demand sources it reads from,
+    // directly or through other on-demand sources.
+    // Variables are treated like an additional on-demand source read by all sources
+    // referring to them. In addition, such a source's level is not below the level
+    // of the previous one, so they keep their relative order.
+    const size_t variables = count;
+    int variablesLevel = 0;
+    std::vector<std::set<size_t>> reads(count);
+    p->mLevelOf.resize(count, 0);
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (inSources[i]->RefersVariables())
+            reads[i].insert(variables);
+        const DataSource::SourceList &dependencies = inSources[i]->Sources();
+        for (auto pDependency : dependencies)
+        {
+            auto j = index.find(pDependency);
+            if (j == index.end() || j->second > i)
+                throw std_logic_error << "Source \"" << pDependency->Name() << "\" not listed before \""
+                                      << inSources[i]->Name() << "\", which depends on it";
+            size_t dep = j->second;
+            p->mLevelOf[i] = std::max(p->mLevelOf[i], p->mLevelOf[dep] + 1);
+            if (pDependency->OnDemand())
+            {
+                reads[i].insert(dep);
+                if (inSources[dep]->OnDemand())
+                    reads[i].insert(reads[dep].begin(), reads[dep].end());
+            }
+        }
+        if (reads[i].count(variables))
+            variablesLevel = p->mLevelOf[i] = std::max(p->mLevelOf[i], variablesLevel);
+    }
+    int levels = count > 0 ? *std::max_element(p->mLevelOf.begin(), p->mLevelOf.end()) + 1 : 0;
+    p->mLevels.resize(levels);
+    for (size_t i = 0; i < count; ++i)
+        p->mLevels[p->mLevelOf[i]].sources.push_back(i);
+
+    // Within a level, sources reading from a common on-demand source end up in the same task,
+    // in list order.
+    for (auto &level : p->mLevels)
+    {
+        std::map<size_t, size_t> taskOfSource, taskOfRead;
+        std::vector<size_t> taskIndex(level.sources.size());
+        for (size_t i = 0; i < level.sources.size(); ++i)
+            taskIndex[i] = i;
+        auto root = [&taskIndex](size_t i) {
+            while (taskIndex[i] != i)
+                i = taskIndex[i] = taskIndex[taskIndex[i]];
+            return i;
+        };
+        for (size_t i = 0; i < level.sources.size(); ++i)
+            for (size_t read : reads[level.sources[i]])
+            {
+                auto j = taskOfRead.find(read);
+                if (j == taskOfRead.end())
+                    taskOfRead[read] = i;
+                else
+                    taskIndex[root(i)] = root(j->second);
+            }
+        for (size_t i = 0; i < level.sources.size(); ++i)
+        {
+            size_t r = root(i);
+            auto j = taskOfSource.find(r);
+            if (j == taskOfSource.end())
+            {
+                taskOfSource[r] = level.tasks.size();
+                level.tasks.push_back(Private::Task());
+                j = taskOfSource.find(r);
+            }
+            level.tasks[j->second].push_back(level.sources[i]);
+        }
+    }
+
+    p->mThreads = inThreads > 0 ? inThreads : ThreadUtils::NumberOfProcessors();
+    p->mThreads = std::max(p->mThreads, 1);
+    p->mWorkers.resize(p->mThreads);
+    for (auto &worker : p->mWorkers)
+    {
+        worker.mpParent = p;
+        worker.mTime.assign(count, 0);
+    }
+    while (p->mPool.size() < p->mWorkers.size() - 1)
+        p->mPool.push_back(new ReusableThread);
+    p->mLastSeconds.assign(count, 0);
+    return ResetCosts();
+}
+
+SourceScheduler &SourceScheduler::Clear()
+{
+    p->DeletePool();
+    p->mWorkers.clear();
+    p->mSources.clear();
+    p->mLevelOf.clear();
+    p->mLevels.clear();
+    p->mLastSeconds.clear();
+    return ResetCosts();
+}
+
+void SourceScheduler::Process(const DataSource::Context &inContext)
+{
+    p->mpContext = &inContext;
+    for (const auto &level : p->mLevels)
+    {
+        if (DataSource::AbortFlag())
+            break;
+        p->mpLevel = &level;
+        p->mRunParts = false;
+        p->RunItems(level.tasks.size());
+
+        p->mParts.clear();
+        for (size_t source : level.sources)
+        {
+            Private::Part part = {source, 0};
+            for (int parts = p->mSources[source]->Parts(); part.index < parts; ++part.index)
+                p->mParts.push_back(part);
+        }
+        if (!p->mParts.empty())
+        {
+            p->mRunParts = true;
+            p->RunItems(p->mParts.size());
+        }
+    }
+    p->mpLevel = nullptr;
+    p->mpContext = nullptr;
+
+    ++p->mBlocks;
+    for (size_t i = 0; i < p->mSources.size(); ++i)
+    {
+        int64_t time = 0;
+        for (auto &worker : p->mWorkers)
+        {
+            time += worker.mTime[i];
+            worker.mTime[i] = 0;
+        }
+        p->mTotalTime[i] += time;
+        p->mMaxTime[i] = std::max(p->mMaxTime[i], time);
+        p->mLastSeconds[i] = Time::Interval::FromRawInt(time).Seconds();
+    }
+}
+
+int SourceScheduler::Threads() const
+{
+    return p->mThreads;
+}
+
+int SourceScheduler::Levels() const
+{
+    return static_cast<int>(p->mLevels.size());
+}
+
+int SourceScheduler::Tasks() const
+{
+    size_t tasks = 0;
+    for (const auto &level : p->mLevels)
+        tasks += level.tasks.size();
+    return static_cast<int>(tasks);
+}
+
+std::vector<SourceScheduler::Cost> SourceScheduler::Costs() const
+{
+    std::vector<Cost> costs;
+    for (size_t i = 0; i < p->mSources.size(); ++i)
+    {
+        Cost cost = {p->mSources[i], p->mLevelOf[i], 0, Time::Interval::FromRawInt(p->mMaxTime[i]).Seconds()};
+        if (p->mBlocks > 0)
+            cost.meanSeconds = Time::Interval::FromRawInt(p->mTotalTime[i]).Seconds() / p->mBlocks;
+        costs.push_back(cost);
+    }
+    return costs;
+}
+
+const std::vector<double> &SourceScheduler::LastSeconds() const
+{
+    return p->mLastSeconds;
+}
+
+SourceScheduler &SourceScheduler::ResetCosts()
+{
+    p->mBlocks = 0;
+    p->mTotalTime.assign(p->mSources.size(), 0);
+    p->mMaxTime.assign(p->mSources.size(), 0);
+    return *this;
+}
+
+namespace
+{
+// A source that records when it is processed.
+struct TestSource : DataSource
+{
+    TestSource(const std::string &name, bool onDemand, bool variables, std::vector<std::string> &log,
+               std::mutex &mutex)
+        : DataSource(name), onDemand(onDemand), variables(variables), log(log), mutex(mutex)
+    {
+    }
+    TestSource &Reads(TestSource &source)
+    {
+        Add(&source);
+        return *this;
+    }
+    void OnInitialize(const Context &) override
+    {
+    }
+    void OnProcess(const Context &) override
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        log.push_back(Name());
+    }
+    Value OnData(int) override
+    {
+        return 0;
+    }
+    bool OnIsOnDemand() const override
+    {
+        return onDemand;
+    }
+    bool OnRefersVariables() const override
+    {
+        return variables;
+    }
+    bool onDemand, variables;
+    std::vector<std::string> &log;
+    std::mutex &mutex;
+};
+} // namespace
+
+UnitTest(SourceSchedulerTest)
+{
+    std::vector<std::string> log;
+    std::mutex mutex;
+    TestSource a("a", false, false, log, mutex), e("e", true, false, log, mutex), b("b", false, false, log, mutex),
+        c("c", false, false, log, mutex), d("d", false, false, log, mutex), v1("v1", false, true, log, mutex),
+        w("w", false, false, log, mutex), v2("v2", false, true, log, mutex), v3("v3", false, true, log, mutex);
+    b.Reads(e);
+    c.Reads(e);
+    d.Reads(a);
+    w.Reads(d);
+    v2.Reads(w);
+    DataSource::SourceList sources;
+    for (TestSource *pSource : {&a, &e, &b, &c, &d, &v1, &w, &v2, &v3})
+        sources.Add(pSource);
+
+    SourceScheduler scheduler;
+    scheduler.Schedule(sources, 4);
+    // b and c read from a common on-demand source, and v3 follows v2 on its level.
+    const int levels[] = {0, 0, 1, 1, 1, 0, 2, 3, 3};
+    std::vector<SourceScheduler::Cost> costs = scheduler.Costs();
+    TestRequire(costs.size() == sources.size());
+    for (size_t i = 0; i < costs.size() && i < sources.size(); ++i)
+        TestFail_if(costs[i].level != levels[i], costs[i].source->Name() << " has level " << costs[i].level);
+    TestFail_if(scheduler.Levels() != 4, "levels: " << scheduler.Levels());
+    TestFail_if(scheduler.Tasks() != 7, "tasks: " << scheduler.Tasks());
+
+    DataSource::Context context = {DataSource::Context::process, nullptr, nullptr, nullptr};
+    for (int block = 0; block < 100; ++block)
+    {
+        log.clear();
+        scheduler.Process(context);
+        std::vector<std::string> order;
+        for (const auto &name : log)
+            if (name.front() == 'v')
+                order.push_back(name);
+        TestFail_if(log.size() != sources.size(), "processed " << log.size() << " sources");
+        TestFail_if(order != std::vector<std::string>({"v1", "v2", "v3"}), "sources referring to variables out of order");
+    }
+}
@@ -0,0 +1,78 @@
+////////////////////////////////////////////////////////////////////////////////
+//  $Id$
+//  Author: BCI2000 team
+//  Description: Processes data sources level by level, such that each source
+//    is processed after the sources it depends on. Within a level, sources
+//    are processed concurrently unless they read data from a common source
+//    that computes its data on demand, or refer to variables. Sources that
+//    refer to variables are processed in list order.
+//
+// $BEGIN_BCI2000_LICENSE$
+//
+// This file is part of BCI2000, a platform for real-time bio-signal research.
+// [ Copyright (C) 2000-2022: BCI2000 team and many external contributors ]
+//
+// BCI2000 is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// BCI2000 is distributed in the hope that it will be useful, but
+//                         WITHOUT ANY WARRANTY
+// - without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+// A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// $END_BCI2000_LICENSE$
+////////////////////////////////////////////////////////////////////////////////
+#ifndef SOURCE_SCHEDULER_H
+#define SOURCE_SCHEDULER_H
+
+#include "DataSource.h"
+#include <vector>
+
+class SourceScheduler
+{
+  public:
+    struct Cost
+    {
+        const DataSource *source;
+        int level;
+        double meanSeconds, maxSeconds;
+    };
+
+    SourceScheduler();
+    ~SourceScheduler();
+
+  private:
+    SourceScheduler(const SourceScheduler &);
+    SourceScheduler &operator=(const SourceScheduler &);
+
+  public:
+    // The list of sources must be ordered such that each source follows its
+    // dependencies, as is the case for lists created by DataSource::Depends().
+    // A number of threads <= 0 means one thread per processor.
+    SourceScheduler &Schedule(const DataSource::SourceList &, int threads = 0);
+    SourceScheduler &Clear();
+    // Calls Process() and ProcessPart() for all sources.
+    void Process(const DataSource::Context &);
+
+    int Threads() const;
+    int Levels() const;
+    int Tasks() const;
+    // Processing time per block for each source, in order of the list of sources.
+    // For sources that read from sources computing their data on demand, processing
+    // time includes the time spent computing that data.
+    std::vector<Cost> Costs() const;
+    // Processing time of each source during the last block.
+    const std::vector<double> &LastSeconds() const;
+    SourceScheduler &ResetCosts();
+
+  private:
+    struct Private;
+    Private *p;
+};
+
+#endif // SOURCE_SCHEDULER_H
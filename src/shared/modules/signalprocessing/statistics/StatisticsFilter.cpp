@@ -36,9 +36,11 @@
 #include "ViewSource.h"
 #include "WildcardMatch.h"
 
+#include <algorithm>
+
 RegisterFilter(StatisticsFilter, 2.C2);
 
-StatisticsFilter::StatisticsFilter()
+StatisticsFilter::StatisticsFilter() : mpOutputView(NULL), mVisualizeCost(false), mCostVisualization("STCOST")
 {
     mContext.type = Context::process;
     mContext.signal = NULL;
@@ -49,6 +51,7 @@ StatisticsFilter::StatisticsFilter()
     mContext.outputView = &mpOutputView;
     mContext.scripts = &mScripts;
     mContext.visualizations = &mVisualizations;
+    mContext.scheduler = &mScheduler;
 
     BEGIN_PARAMETER_DEFINITIONS
         "Statistics matrix ChannelSets= { AllChannels } 1 "
@@ -89,6 +92,8 @@ StatisticsFilter::StatisticsFilter()
             " Count:=0; % % Count:=Count+1; "
             " % % % //"
             " Specify statements to be executed during StartRun, StopRun, Initialize, or Process.",
+        "Statistics int VisualizeSourceCost= 0 0 0 1 "
+            " // Display processing time of data sources, and report it when a run stops (boolean)",
     END_PARAMETER_DEFINITIONS
 }
 
@@ -117,6 +122,9 @@ void StatisticsFilter::Preflight(const SignalProperties &Input, SignalProperties
     ScriptContainer scripts;
     context.scripts = &scripts;
     context.visualizations = NULL;
+    SourceScheduler scheduler;
+    context.scheduler = &scheduler;
+    Parameter("VisualizeSourceCost");
     Configure(context);
     if (bcierr.Empty())
     {
@@ -146,6 +154,8 @@ void StatisticsFilter::Initialize(const SignalProperties &Input, const SignalPro
     Configure(mContext);
     mScripts[OnInitialize].Execute();
     InitializeVisualizations(mContext);
+    mVisualizeCost = (Parameter("VisualizeSourceCost") != 0);
+    InitializeCostVisualization();
 }
 
 void StatisticsFilter::Process(const GenericSignal &Input, GenericSignal &Output)
@@ -154,6 +164,7 @@ void StatisticsFilter::Process(const GenericSignal &Input, GenericSignal &Output
     mContext.signal = &Input;
     ProcessSources(mContext);
     ProcessVisualizations(mContext);
+    ProcessCostVisualization();
     if (mpOutputView)
         Output = mpOutputView->Signal();
     else
@@ -162,12 +173,15 @@ void StatisticsFilter::Process(const GenericSignal &Input, GenericSignal &Output
 
 void StatisticsFilter::StartRun()
 {
+    mScheduler.ResetCosts();
     mScripts[OnStartRun].Execute();
 }
 
 void StatisticsFilter::StopRun()
 {
     mScripts[OnStopRun].Execute();
+    if (mVisualizeCost)
+        ReportCosts();
 }
 
 // Helper functions
@@ -181,6 +195,7 @@ void StatisticsFilter::Configure(const Context &ioContext) const
         LoadScripts(ioContext);
         DependSources(ioContext);
         InitializeSources(ioContext);
+        ScheduleSources(ioContext);
     }
     catch (const std::bad_alloc &)
     {
@@ -365,6 +380,14 @@ void StatisticsFilter::InitializeSources(const Context &ioContext) const
         (*ioContext.dependencies)[i]->Initialize(ioContext);
 }
 
+void StatisticsFilter::ScheduleSources(const Context &ioContext) const
+{
+    // Sources are processed concurrently where dependencies allow.
+    ioContext.scheduler->Clear();
+    if (bcierr.Empty())
+        ioContext.scheduler->Schedule(*ioContext.dependencies, OptionalParameter("NumberOfThreads", -1));
+}
+
 void StatisticsFilter::InitializeVisualizations(const Context &ioContext) const
 {
     for (size_t i = 0; i < ioContext.visualizations->size(); ++i)
@@ -389,8 +412,7 @@ void StatisticsFilter::InitializeVisualizations(const Context &ioContext) const
 
 void StatisticsFilter::ProcessSources(const Context &ioContext) const
 {
-    for (size_t i = 0; i < ioContext.dependencies->size(); ++i)
-        (*ioContext.dependencies)[i]->Process(ioContext);
+    ioContext.scheduler->Process(ioContext);
 }
 
 void StatisticsFilter::ProcessVisualizations(const Context &inContext) const
@@ -399,8 +421,58 @@ void StatisticsFilter::ProcessVisualizations(const Context &inContext) const
         (*inContext.visualizations)[i].Send((*inContext.views)[i]->Signal());
 }
 
+void StatisticsFilter::InitializeCostVisualization()
+{
+    mCostVisualization.Send(CfgID::Visible, mVisualizeCost);
+    if (!mVisualizeCost)
+        return;
+    // One channel per source, displaying processing time per block.
+    SignalProperties properties(static_cast<int>(mDependencies.size()), 1);
+    properties.SetName("Statistics Source Cost");
+    for (size_t i = 0; i < mDependencies.size(); ++i)
+        properties.ChannelLabels()[i] = mDependencies[i]->Name();
+    properties.ValueUnit().SetOffset(0).SetGain(1e-3).SetSymbol("s").SetRawMin(0).SetRawMax(
+        1e3 * MeasurementUnits::SampleBlockDuration());
+    properties.ElementUnit()
+        .SetGain(MeasurementUnits::SampleBlockDuration())
+        .SetOffset(0)
+        .SetSymbol("s")
+        .SetRawMin(0)
+        .SetRawMax(MeasurementUnits::TimeInSampleBlocks("10s") - 1);
+    properties.SetIsStream(true);
+    mCostSignal.SetProperties(properties);
+    mCostVisualization.Send(CfgID::WindowTitle, "Statistics Source Cost")
+        .Send(CfgID::GraphType, CfgID::Polyline)
+        .Send(properties)
+        .Send(mCostSignal);
+}
+
+void StatisticsFilter::ProcessCostVisualization()
+{
+    if (!mVisualizeCost)
+        return;
+    const std::vector<double> &seconds = mScheduler.LastSeconds();
+    for (int ch = 0; ch < mCostSignal.Channels() && ch < static_cast<int>(seconds.size()); ++ch)
+        mCostSignal(ch, 0) = 1e3 * seconds[ch];
+    mCostVisualization.Send(mCostSignal);
+}
+
+void StatisticsFilter::ReportCosts() const
+{
+    std::vector<SourceScheduler::Cost> costs = mScheduler.Costs();
+    std::sort(costs.begin(), costs.end(), [](const SourceScheduler::Cost &a, const SourceScheduler::Cost &b) {
+        return a.meanSeconds > b.meanSeconds;
+    });
+    bciout << "Processing time of data sources per block, using " << mScheduler.Threads() << " threads to process "
+           << mScheduler.Tasks() << " tasks in " << mScheduler.Levels() << " levels:";
+    for (const auto &cost : costs)
+        bciout << cost.source->Name() << " (level " << cost.level << "): " << 1e3 * cost.meanSeconds << "ms mean, "
+               << 1e3 * cost.maxSeconds << "ms max";
+}
+
 void StatisticsFilter::Clear(const Context &ioContext) const
 {
+    ioContext.scheduler->Clear();
     for (size_t i = 0; i < ioContext.sources->size(); ++i)
         delete (*ioContext.sources)[i];
     ioContext.sources->clear();
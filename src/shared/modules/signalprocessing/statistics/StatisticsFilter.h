@@ -30,6 +30,7 @@
 #include "DataSource.h"
 #include "Expression.h"
 #include "GenericFilter.h"
+#include "SourceScheduler.h"
 #include "Thread.h"
 #include <vector>
 
@@ -58,6 +59,7 @@ class StatisticsFilter : public GenericFilter
         ViewSource **outputView;
         VisContainer *visualizations;
         ScriptContainer *scripts;
+        SourceScheduler *scheduler;
     };
 
     void Configure(const Context &) const;
@@ -68,9 +70,13 @@ class StatisticsFilter : public GenericFilter
     void LoadScripts(const Context &) const;
     void DependSources(const Context &) const;
     void InitializeSources(const Context &) const;
+    void ScheduleSources(const Context &) const;
     void InitializeVisualizations(const Context &) const;
     void ProcessSources(const Context &) const;
     void ProcessVisualizations(const Context &) const;
+    void InitializeCostVisualization();
+    void ProcessCostVisualization();
+    void ReportCosts() const;
     void Clear(const Context &) const;
 
   private:
@@ -80,6 +86,11 @@ class StatisticsFilter : public GenericFilter
     ViewContainer mViews;
     ViewSource *mpOutputView;
     VisContainer mVisualizations;
+    SourceScheduler mScheduler;
+
+    bool mVisualizeCost;
+    GenericVisualization mCostVisualization;
+    GenericSignal mCostSignal;
 
     enum
     {
@@ -2,7 +2,8 @@
 // $Id: AlignmentFilter.cpp 6627 2022-03-18 14:44:20Z mellinger $
 // Author: schalk@wadsworth.org, juergen.mellinger@uni-tuebingen.de
 // Description: A BCI2000 filter performing temporal alignment of its input
-//   data using linear interpolation between subsequent samples.
+//   data using linear interpolation between subsequent samples, or a
+//   windowed-sinc fractional delay filter.
 //
 // $BEGIN_BCI2000_LICENSE$
 //
@@ -25,9 +26,56 @@
 // $END_BCI2000_LICENSE$
 ////////////////////////////////////////////////////////////////////////////////
 #include "AlignmentFilter.h"
+#include "Numeric.h"
+#include "UnitTest.h"
+
+#include <algorithm>
+#include <cmath>
 
 RegisterFilter(AlignmentFilter, 1.1);
 
+namespace
+{
+// The kernel for a channel is a sinc function centered at the channel's total delay,
+// tapered with a Blackman window, and normalized to unit gain at DC.
+void SincKernel(double inOffset, int inHalfLength, double *outKernel)
+{
+    double sum = 0;
+    for (int k = 0; k < 2 * inHalfLength; ++k)
+    {
+        double t = k - (inHalfLength - 1) - inOffset, sinc = (::fabs(t) < 1e-12) ? 1.0 : ::sin(Pi() * t) / (Pi() * t),
+               window = (::fabs(t) >= inHalfLength)
+                            ? 0.0
+                            : 0.42 + 0.5 * ::cos(Pi() * t / inHalfLength) + 0.08 * ::cos(2 * Pi() * t / inHalfLength);
+        outKernel[k] = sinc * window;
+        sum += outKernel[k];
+    }
+    for (int k = 0; k < 2 * inHalfLength; ++k)
+        outKernel[k] /= sum;
+}
+
+// A channel's history is followed by its input samples in a contiguous buffer,
+// and the kernel is applied one tap at a time to the entire block, such that the
+// inner loop runs over consecutive samples, and is vectorized by the compiler.
+void ApplyKernel(const double *inKernel, int inTaps, double *ioHistory, const double *inInput, int inElements,
+                 std::vector<double> &ioBuffer, double *outOutput)
+{
+    const int history = inTaps - 1;
+    ioBuffer.resize(history + inElements);
+    double *pBuffer = ioBuffer.data();
+    std::copy(ioHistory, ioHistory + history, pBuffer);
+    std::copy(inInput, inInput + inElements, pBuffer + history);
+    std::fill(outOutput, outOutput + inElements, 0.0);
+    for (int k = 0; k < inTaps; ++k)
+    {
+        const double h = inKernel[k], *pIn = pBuffer + history - k;
+        for (int el = 0; el < inElements; ++el)
+            outOutput[el] += h * pIn[el];
+    }
+    std::copy(pBuffer + inElements, pBuffer + inElements + history, ioHistory);
+}
+} // namespace
+
 AlignmentFilter::AlignmentFilter()
     : mAlign(false)
 {
@@ -39,6 +87,11 @@ AlignmentFilter::AlignmentFilter()
     "Source:Alignment floatlist SourceChTimeOffset= 0 0 % % "
     "// time offsets for all source channels (may be empty)",
 
+    "Source:Alignment int AlignmentMethod= 0 0 0 1 "
+    "// 0: linear interpolation, "
+    "1: windowed-sinc fractional delay, accurate up to high frequencies "
+    "but adding a delay of 7 samples (enumeration)",
+
   END_PARAMETER_DEFINITIONS
 }
 
@@ -60,6 +113,7 @@ void AlignmentFilter::Preflight(const SignalProperties &Input, SignalProperties
             if (Parameter("SourceChTimeOffset")(i) < 0 || Parameter("SourceChTimeOffset")(i) > 1)
                 bcierr << "Values in SourceChTimeOffset must be between 0 and 1." << std::endl;
     }
+    Parameter("AlignmentMethod");
     // Requested output signal properties.
     Output = Input;
 }
@@ -69,47 +123,114 @@ void AlignmentFilter::Initialize(const SignalProperties &Input, const SignalProp
     mPrevSample.clear();
     mWeightPrev.clear();
     mWeightCur.clear();
+    mKernels.clear();
+    mHistory.clear();
+    mBuffer.clear();
 
     // Do we want to align the samples in time ?
     mAlign = (Parameter("AlignChannels") == 1);
+    mMethod = Parameter("AlignmentMethod");
     if (mAlign)
     {
-        mPrevSample.resize(Input.Channels(), 0.0);
-        mWeightPrev.resize(Input.Channels(), 0.0);
-        mWeightCur.resize(Input.Channels(), 1.0);
-
-        // Calculate weight values for linear interpolation if we do not use the default value.
+        // Time offsets of channels, in units of the sampling interval.
+        std::vector<double> offsets(Input.Channels());
         if (Parameter("SourceChTimeOffset")->NumValues() > 0)
         {
-            for (int i = 0; i < Input.Channels(); ++i) // get original channel position
-            {
-                mWeightPrev[i] = Parameter("SourceChTimeOffset")(i);
-                mWeightCur[i] = 1.0 - mWeightPrev[i];
-            }
+            for (int i = 0; i < Input.Channels(); ++i)
+                offsets[i] = Parameter("SourceChTimeOffset")(i);
         }
         // If we do use the default value, assume that all sampled channels are evenly distributed in time.
         else
         {
             double delta = 1.0 / Input.Channels();
-            for (int i = 0; i < Input.Channels(); ++i) // get original channel position
-            {
-                mWeightPrev[i] = delta * i;
-                mWeightCur[i] = 1.0 - mWeightPrev[i];
-            }
+            for (int i = 0; i < Input.Channels(); ++i)
+                offsets[i] = delta * i;
         }
+        if (mMethod == windowedSinc)
+            InitializeSinc(offsets);
+        else
+            InitializeLinear(offsets);
     }
 }
 
+void AlignmentFilter::InitializeLinear(const std::vector<double> &inOffsets)
+{
+    // Weight values for linear interpolation.
+    mPrevSample.resize(inOffsets.size(), 0.0);
+    mWeightPrev = inOffsets;
+    mWeightCur.resize(inOffsets.size());
+    for (size_t i = 0; i < inOffsets.size(); ++i)
+        mWeightCur[i] = 1.0 - mWeightPrev[i];
+}
+
+void AlignmentFilter::InitializeSinc(const std::vector<double> &inOffsets)
+{
+    const int taps = 2 * cSincHalfLength;
+    mKernels.resize(inOffsets.size() * taps);
+    for (size_t ch = 0; ch < inOffsets.size(); ++ch)
+        SincKernel(inOffsets[ch], cSincHalfLength, &mKernels[ch * taps]);
+    mHistory.resize(inOffsets.size() * (taps - 1), 0.0);
+}
+
 void AlignmentFilter::Process(const GenericSignal &Input, GenericSignal &Output)
 {
-    if (mAlign) // Perform the alignment on the input and write it into the output signal.
-        for (int channel = 0; channel < Input.Channels(); ++channel)
-            for (int sample = 0; sample < Input.Elements(); ++sample)
-            {
-                Output(channel, sample) =
-                    Input(channel, sample) * mWeightCur[channel] + mWeightPrev[channel] * mPrevSample[channel];
-                mPrevSample[channel] = Input(channel, sample);
-            }
-    else // No alignment.
+    if (!mAlign) // No alignment.
         Output = Input;
+    else if (mMethod == windowedSinc)
+        ProcessSinc(Input, Output);
+    else
+        ProcessLinear(Input, Output);
+}
+
+void AlignmentFilter::ProcessLinear(const GenericSignal &Input, GenericSignal &Output)
+{
+    for (int channel = 0; channel < Input.Channels(); ++channel)
+        for (int sample = 0; sample < Input.Elements(); ++sample)
+        {
+            Output(channel, sample) =
+                Input(channel, sample) * mWeightCur[channel] + mWeightPrev[channel] * mPrevSample[channel];
+            mPrevSample[channel] = Input(channel, sample);
+        }
+}
+
+void AlignmentFilter::ProcessSinc(const GenericSignal &Input, GenericSignal &Output)
+{
+    // A channel's elements are stored contiguously, starting at the linear index of
+    // its first element.
+    const int taps = 2 * cSincHalfLength, history = taps - 1, elements = Input.Elements();
+    if (elements == 0)
+        return;
+    const GenericSignal::ValueType *pInput = Input.ConstData();
+    GenericSignal::ValueType *pOutput = Output.MutableData();
+    for (int ch = 0; ch < Input.Channels(); ++ch)
+        ApplyKernel(&mKernels[ch * taps], taps, &mHistory[ch * history], pInput + Input.LinearIndex(ch, 0), elements,
+                    mBuffer, pOutput + Output.LinearIndex(ch, 0));
+}
+
+UnitTest(AlignmentFilterSincTest)
+{
+    // A channel sampled with a time offset is resampled at the time of channel 0,
+    // cSincHalfLength - 1 samples earlier, independently of block boundaries.
+    const int halfLength = 8, taps = 2 * halfLength, delay = halfLength - 1;
+    const double omega = 0.3, offsets[] = {0, 0.25, 0.5, 0.9};
+    const int blockSizes[] = {1, 5, 16, 3, 40};
+    for (double offset : offsets)
+    {
+        std::vector<double> kernel(taps), history(taps - 1, 0.0), buffer, input, output;
+        SincKernel(offset, halfLength, kernel.data());
+        int pos = 0;
+        for (int block = 0; block < 20; ++block)
+        {
+            int elements = blockSizes[block % (sizeof(blockSizes) / sizeof(*blockSizes))];
+            input.resize(elements);
+            output.resize(elements);
+            for (int el = 0; el < elements; ++el)
+                input[el] = ::sin(omega * (pos + el + offset));
+            ApplyKernel(kernel.data(), taps, history.data(), input.data(), elements, buffer, output.data());
+            for (int el = 0; el < elements; ++el, ++pos)
+                if (pos >= taps)
+                    TestFail_if(::fabs(output[el] - ::sin(omega * (pos - delay))) > 1e-2,
+                                "offset " << offset << ", sample " << pos << ": " << output[el]);
+        }
+    }
 }
@@ -40,8 +40,25 @@ class AlignmentFilter : public GenericFilter
     void Process(const GenericSignal &, GenericSignal &) override;
 
   private:
+    void InitializeLinear(const std::vector<double> &offsets);
+    void InitializeSinc(const std::vector<double> &offsets);
+    void ProcessLinear(const GenericSignal &, GenericSignal &);
+    void ProcessSinc(const GenericSignal &, GenericSignal &);
+
+    enum
+    {
+        linearInterpolation = 0,
+        windowedSinc = 1,
+    };
+    // Windowed-sinc kernels have 2*cSincHalfLength taps, and delay the signal
+    // by cSincHalfLength - 1 samples in addition to the channel's time offset.
+    static const int cSincHalfLength = 8;
+
     bool mAlign;
+    int mMethod;
     std::vector<double> mWeightPrev, mWeightCur, mPrevSample;
+    // Per-channel kernels and sample histories, stored channel by channel.
+    std::vector<double> mKernels, mHistory, mBuffer;
 };
 
 #endif // ALIGNMENT_FILTER_H
@@ -30,6 +30,7 @@
 #include "BCIException.h"
 #include "BCIStream.h"
 #include "ClassName.h"
+#include "FilterDesign.h"
 #include "GenericADC.h"
 #include "GenericFileWriter.h"
 #include "MeasurementUnits.h"
@@ -96,13 +97,25 @@ int32_t SignedDiff(uint32_t a, uint32_t b, int bits)
     return diff;
 }
 
+// Interpret the most significant of a state value's bits as a sign bit.
+int32_t SignExtend(uint32_t value, int bits)
+{
+    if (bits > 0 && bits < 32 && (value & (uint32_t(1) << (bits - 1))))
+        value |= ~((uint32_t(1) << bits) - 1);
+    return value;
+}
+
 } // namespace
 
 struct DataIOFilter::Private
 {
     TimingObserver mTimingObserver;
     int mLastAudioPresentationTime;
-    Private() : mLastAudioPresentationTime(-1)
+    // PresentationRequested, PresentationDisplayed, and PresentationTime, read per block.
+    StateVector::ColumnPlan mPresentationStates;
+    std::vector<State::ValueType> mPresentationValues;
+    int mRequestedBits, mDisplayedBits;
+    Private() : mLastAudioPresentationTime(-1), mRequestedBits(0), mDisplayedBits(0)
     {
     }
 };
@@ -479,6 +492,9 @@ void DataIOFilter::Preflight(const SignalProperties &Input, SignalProperties &Ou
 void DataIOFilter::Initialize(const SignalProperties & /*Input*/, const SignalProperties &Output)
 {
     mBCIEvents.SetMaxCount(Output.Elements() * 1000);
+    mBCIEvents.SetStateList(*States);
+    mDeferredBCIEvents.clear();
+    mDeferredBCIEvents.reserve(Output.Elements());
     mOutputBuffer.SetProperties(Output);
     const SignalProperties &adcOutput = mADCOutput.Properties();
     mSampleBlockSize = adcOutput.Elements();
@@ -538,6 +554,16 @@ void DataIOFilter::Initialize(const SignalProperties & /*Input*/, const SignalPr
         .SetGain(Output.ElementUnit().Gain() * trueDecimation)
         .SetRawMax(Output.ElementUnit().RawMax() / trueDecimation);
     mDecimatedSignal.SetProperties(d);
+    // Anti-aliasing for display: passband up to half the decimated signal's Nyquist frequency.
+    std::vector<double> visFilter(1, 1.0);
+    int visDecimation = static_cast<int>(trueDecimation);
+    if (visDecimation > 1)
+        visFilter = FilterDesign::WindowedSinc()
+                        .Lowpass(0.375 / visDecimation)
+                        .TransitionWidth(0.25 / visDecimation)
+                        .Attenuation_dB(40)
+                        .Coefficients();
+    mVisDecimator.SetCoefficients(visFilter).SetDecimation(visDecimation).Initialize(Output.Channels());
     if (mVisualizeSource)
         mSourceVis.Send(mDecimatedSignal.Properties());
     mSourceVis.Send(CfgID::Visible, mVisualizeSource);
@@ -586,6 +612,16 @@ void DataIOFilter::Initialize(const SignalProperties & /*Input*/, const SignalPr
     mTimingSignal = GenericSignal(s, GenericSignal::NaN);
     mTimingSignal(BlockNom, 0) = mBlockDuration;
 
+    p->mPresentationStates.Clear();
+    if (displayPresentation)
+    {
+        const class State &requested = States->ByName("PresentationRequested"),
+                          &displayed = States->ByName("PresentationDisplayed");
+        p->mPresentationStates.Add(requested).Add(displayed).Add(States->ByName("PresentationTime"));
+        p->mRequestedBits = requested.Length();
+        p->mDisplayedBits = displayed.Length();
+    }
+
     p->mTimingObserver.SetWindowLength(MeasurementUnits::TimeInSampleBlocks("10s"), 30);
     p->mTimingObserver.Reset(mBlockDuration);
     p->mTimingObserver.SetEnabled(mpADC->IsRealTimeSource() || (OptionalParameter("EvaluateTiming", 1) != 0));
@@ -627,6 +663,7 @@ void DataIOFilter::StartRun()
 {
     mpADC->CallStartRun();
     mpFileWriter->CallStartRun();
+    mVisDecimator.Initialize();
 
     mStatevectorBuffer = *Statevector;
     mStatevectorBuffer.SetStateValue("Recording", 0);
@@ -684,12 +721,22 @@ void DataIOFilter::DoProcess(GenericSignal &Output, bool inResting)
         PrecisionTime prevSourceTime = PrecisionTime(State("SourceTime")),
                       stimulusTime = PrecisionTime(State("StimulusTime"));
         mTimingSignal(Roundtrip, 0) = SignedDiff(functionEntry, prevSourceTime, timeStampBits);
+        int samples = Statevector->Samples() - 1;
+        const State::ValueType *pRequested = nullptr, *pDisplayed = nullptr, *pPresentationTime = nullptr;
+        if (p->mPresentationStates.Columns() > 0)
+        {
+            p->mPresentationValues.resize(p->mPresentationStates.Columns() * samples);
+            Statevector->ExtractColumns(p->mPresentationStates, 0, samples, p->mPresentationValues.data());
+            pRequested = p->mPresentationValues.data();
+            pDisplayed = pRequested + samples;
+            pPresentationTime = pDisplayed + samples;
+        }
         if (mTimingSignal.Channels() > StimTrig)
         {
             auto s = mTimingSignal.NaN;
-            for (int sample = 0; sample < Statevector->Samples() - 1; ++sample)
+            for (int sample = 0; sample < samples; ++sample)
             {
-                int32_t id = State("PresentationRequested")(sample).AsSigned();
+                int32_t id = SignExtend(pRequested[sample], p->mRequestedBits);
                 if (id >= 0)
                 {
                     int diff = id & 0xff;
@@ -702,13 +749,13 @@ void DataIOFilter::DoProcess(GenericSignal &Output, bool inResting)
         if (mTimingSignal.Channels() > StimDisp)
         {
             auto s = mTimingSignal.NaN;
-            for (int sample = 0; sample < Statevector->Samples() - 1; ++sample)
+            for (int sample = 0; sample < samples; ++sample)
             {
-                int32_t id = State("PresentationDisplayed")(sample).AsSigned();
+                int32_t id = SignExtend(pDisplayed[sample], p->mDisplayedBits);
                 if (id >= 0)
                 {
                     PrecisionTime sourceTime = id >> 8, reqDiff = id & 0xff,
-                                  dispTime = PrecisionTime(State("PresentationTime")(sample));
+                                  dispTime = PrecisionTime(pPresentationTime[sample]);
                     int disp = SignedDiff(dispTime, sourceTime, timeStampBits - 1);
                     if (disp > 0)
                     {
@@ -831,7 +878,7 @@ void DataIOFilter::DoVisualize()
     mBlockCount %= mVisualizeSourceBufferSize;
     if (mVisualizeSource && sendCount > 0)
     {
-        Downsample(mVisSourceBuffer, mDecimatedSignal);
+        mVisDecimator.Process(mVisSourceBuffer, mDecimatedSignal);
         if (sendCount > 4)
             sendCount = 1; // If we have been stalled for so long, it makes no sense to try to keep up.
         while (--sendCount >= 0)
@@ -841,19 +888,6 @@ void DataIOFilter::DoVisualize()
         mTimingVis.Send(mTimingSignal);
 }
 
-void DataIOFilter::Downsample(const GenericSignal &Input, GenericSignal &Output)
-{
-    int decimationFactor = Input.Elements() / Output.Elements();
-    for (int ch = 0; ch < Output.Channels(); ++ch)
-        for (int outsample = 0; outsample < Output.Elements(); ++outsample)
-        {
-            GenericSignal::ValueType value = 0.0;
-            for (int insample = outsample * decimationFactor; insample < (outsample + 1) * decimationFactor; ++insample)
-                value += Input(ch, insample) / decimationFactor;
-            Output(ch, outsample) = value;
-        }
-}
-
 void DataIOFilter::CopyBlock(const GenericSignal &Input, GenericSignal &Output, int inBlock)
 {
     int blockSize = Input.Elements();
@@ -868,57 +902,53 @@ void DataIOFilter::ProcessBCIEvents()
     // source time stamp to match the subsequent block's first sample.
     PrecisionTime sourceTime = static_cast<PrecisionTime::NumType>(Statevector->StateValue("SourceTime"));
 
-    while (!mBCIEvents.IsEmpty() && PrecisionTime::SignedDiff(mBCIEvents.FrontTimeStamp(), sourceTime) < 0)
+    // Zero-duration events that could not be placed in the previous block go first.
+    size_t numDeferred = mDeferredBCIEvents.size();
+    for (size_t i = 0; i < numDeferred; ++i)
     {
+        EventQueue::Event event = mDeferredBCIEvents[i];
+        ApplyBCIEvent(event, 0);
+    }
+    mDeferredBCIEvents.erase(mDeferredBCIEvents.begin(), mDeferredBCIEvents.begin() + numDeferred);
+
+    while (!mBCIEvents.IsEmpty() && PrecisionTime::SignedDiff(mBCIEvents.Front().timestamp, sourceTime) < 0)
+    {
+        const EventQueue::Event &event = mBCIEvents.Front();
         int offset = std::round(
-            ((mBlockDuration - PrecisionTime::UnsignedDiff(sourceTime, mBCIEvents.FrontTimeStamp())) *
-             mSampleBlockSize) /
+            ((mBlockDuration - PrecisionTime::UnsignedDiff(sourceTime, event.timestamp)) * mSampleBlockSize) /
             mBlockDuration);
-        std::istringstream iss(mBCIEvents.FrontDescriptor());
-        std::string name;
-        iss >> name;
-        State::ValueType value;
-        iss >> value;
-        int duration;
-        if (!(iss >> duration))
-            duration = -1;
-
-        const class State &state = States->ByName(name);
-        int kind = state.Kind();
-        if (kind != State::EventKind)
-            throw std_invalid_argument << "Trying to set state \"" << name
-                                       << "\" from an event. "
-                                          "This state was not defined as an event state. "
-                                          "Use BEGIN_EVENT_DEFINITIONS/END_EVENT_DEFINITIONS to define states "
-                                          "as event states.";
-
-        offset = std::max(offset, 0);
-        if (duration < 0)
-        { // No duration given -- set the state at the current and following positions.
-            Statevector->SetStateValue(state.Location(), state.Length(), offset, value);
-        }
-        else if (duration == 0)
-        { // Set the state at a single position only.
-            // For zero duration events, avoid overwriting a previous event by
-            // moving the current one if possible, and reposting if not.
-            State::ValueType val = Statevector->CarryoverValue(state.Location(), state.Length());
-            while (offset < mSampleBlockSize &&
-                   Statevector->StateValue(state.Location(), state.Length(), offset) != val)
-                ++offset;
-            if (offset == mSampleBlockSize) // Re-post the event to be processed in the next block
-                mBCIEvents.PushBack(mBCIEvents.FrontDescriptor(), mBCIEvents.FrontTimeStamp());
-            else
-                Statevector->SetSampleValue(state.Location(), state.Length(), offset, value);
-        }
-        else
-        {
-            bcierr__ << "Event durations > 0 are currently unsupported "
-                     << "(" << iss.str() << ")";
-        }
+        ApplyBCIEvent(event, std::max(offset, 0));
         mBCIEvents.PopFront();
     }
 }
 
+void DataIOFilter::ApplyBCIEvent(const EventQueue::Event &inEvent, int inOffset)
+{
+    int offset = inOffset;
+    if (inEvent.duration < 0)
+    { // No duration given -- set the state at the current and following positions.
+        Statevector->SetStateValue(inEvent.location, inEvent.length, offset, inEvent.value);
+    }
+    else if (inEvent.duration == 0)
+    { // Set the state at a single position only.
+        // For zero duration events, avoid overwriting a previous event by
+        // moving the current one if possible, and deferring it to the next block if not.
+        State::ValueType val = Statevector->CarryoverValue(inEvent.location, inEvent.length);
+        while (offset < mSampleBlockSize &&
+               Statevector->StateValue(inEvent.location, inEvent.length, offset) != val)
+            ++offset;
+        if (offset == mSampleBlockSize)
+            mDeferredBCIEvents.push_back(inEvent);
+        else
+            Statevector->SetSampleValue(inEvent.location, inEvent.length, offset, inEvent.value);
+    }
+    else
+    {
+        bcierr__ << "Event durations > 0 are currently unsupported "
+                 << "(state at bit location " << inEvent.location << ", duration " << inEvent.duration << ")";
+    }
+}
+
 namespace
 {
 // TimingObserver
@@ -30,6 +30,7 @@
 #include "EventQueue.h"
 #include "GenericFilter.h"
 #include "GenericVisualization.h"
+#include "PolyphaseDecimator.h"
 #include "TimeUtils.h"
 
 #include <queue>
@@ -68,9 +69,9 @@ class DataIOFilter : public GenericFilter
     void DoProcess(GenericSignal &, bool);
     void AdjustProperties(SignalProperties &) const;
     void AcquireData();
-    static void Downsample(const GenericSignal &Input, GenericSignal &Output);
     static void CopyBlock(const GenericSignal &Input, GenericSignal &Output, int block);
     void ProcessBCIEvents();
+    void ApplyBCIEvent(const EventQueue::Event &, int offset);
     void DoVisualize();
 
     GenericADC *mpADC;
@@ -83,12 +84,14 @@ class DataIOFilter : public GenericFilter
     int mVisualizeSourceDecimation, mVisualizeSourceBufferSize;
     GenericVisualization mSourceVis, mTimingVis;
     GenericSignal mDecimatedSignal, mTimingSignal;
+    PolyphaseDecimator<float> mVisDecimator;
     mutable GenericSignal mADCOutput, mSourceFilterOutput, *mpFileWriterInput, mVisSourceBuffer;
     int mBlockCount;
     double mBlockDuration;
     int mSampleBlockSize;
     int mPrevStimulusTime;
     EventQueue mBCIEvents;
+    std::vector<EventQueue::Event> mDeferredBCIEvents;
     Time mAcquired;
     bool mWasResting;
 
@@ -29,7 +29,9 @@
 #include "BitmapImage.h"
 
 #include "Exception.h"
+#include <algorithm>
 #include <cstring>
+#include <vector>
 
 BitmapImage::BitmapImage(int inWidth, int inHeight)
     : mWidth(inWidth), mHeight(inHeight), mpData(new uint16_t[inWidth * inHeight])
@@ -109,39 +111,88 @@ BitmapImage &BitmapImage::SetTransparent()
     return *this;
 }
 
+int BitmapImage::TiledDifference(BitmapImage &ioPrevious, BitmapImage &outDifference, int inTileSize) const
+{
+    DimensionCheck(ioPrevious);
+    if (outDifference.mWidth != mWidth || outDifference.mHeight != mHeight)
+        outDifference = BitmapImage(mWidth, mHeight);
+    int changedTiles = 0;
+    for (int top = 0; top < mHeight; top += inTileSize)
+    {
+        int bottom = std::min(top + inTileSize, mHeight);
+        for (int left = 0; left < mWidth; left += inTileSize)
+        {
+            int right = std::min(left + inTileSize, mWidth);
+            size_t rowBytes = (right - left) * sizeof(*mpData);
+            bool changed = false;
+            for (int y = top; !changed && y < bottom; ++y)
+            {
+                size_t offset = y * mWidth + left;
+                changed = ::memcmp(mpData + offset, ioPrevious.mpData + offset, rowBytes);
+            }
+            if (changed)
+            {
+                ++changedTiles;
+                for (int y = top; y < bottom; ++y)
+                {
+                    size_t offset = y * mWidth + left;
+                    const uint16_t *pCur = mpData + offset;
+                    uint16_t *pPrev = ioPrevious.mpData + offset, *pDiff = outDifference.mpData + offset;
+                    for (int x = left; x < right; ++x)
+                        *pDiff++ = *pCur++ - *pPrev++;
+                    ::memcpy(ioPrevious.mpData + offset, mpData + offset, rowBytes);
+                }
+            }
+            else
+            {
+                for (int y = top; y < bottom; ++y)
+                    ::memset(outDifference.mpData + y * mWidth + left, 0, rowBytes);
+            }
+        }
+    }
+    return changedTiles;
+}
+
 std::ostream &BitmapImage::Serialize(std::ostream &os) const
 {
-    os.put(mWidth & 0xff).put(mWidth >> 8).put(mHeight & 0xff).put(mHeight >> 8);
-    // RLE compression
-    uint16_t *pData = mpData, *pEnd = mpData + mWidth * mHeight;
+    // RLE compression into a local buffer, which is written with a single call
+    const uint16_t *pData = mpData, *pEnd = mpData + mWidth * mHeight;
+    std::vector<char> buffer;
+    buffer.reserve(4 + 3 * ((pEnd - pData) / 16 + 1));
+    char header[] = {char(mWidth & 0xff), char(mWidth >> 8), char(mHeight & 0xff), char(mHeight >> 8)};
+    buffer.insert(buffer.end(), header, header + sizeof(header));
     while (pData < pEnd)
     {
-        int value = *pData, length = 0;
-        while (pData < pEnd && *pData == value && length < 0x100)
-            ++pData, ++length;
-        os.put(--length & 0xff).put(value & 0xff).put(value >> 8);
+        uint16_t value = *pData;
+        const uint16_t *pRunEnd = std::min(pData + 0x100, pEnd), *pRun = pData + 1;
+        while (pRun < pRunEnd && *pRun == value)
+            ++pRun;
+        int length = pRun - pData;
+        pData = pRun;
+        char run[] = {char((length - 1) & 0xff), char(value & 0xff), char(value >> 8)};
+        buffer.insert(buffer.end(), run, run + sizeof(run));
     }
-    return os;
+    return os.write(buffer.data(), buffer.size());
 }
 
 std::istream &BitmapImage::Unserialize(std::istream &is)
 {
-    mWidth = uint8_t(is.get());
-    mWidth |= uint8_t(is.get()) << 8;
-    mHeight = uint8_t(is.get());
-    mHeight |= uint8_t(is.get()) << 8;
+    uint8_t header[4] = {0};
+    is.read(reinterpret_cast<char *>(header), sizeof(header));
+    mWidth = header[0] | header[1] << 8;
+    mHeight = header[2] | header[3] << 8;
 
     delete[] mpData;
     mpData = new uint16_t[mWidth * mHeight];
     // RLE decompression
     uint16_t *pData = mpData, *pEnd = mpData + mWidth * mHeight;
-    while (pData < pEnd)
+    uint8_t run[3];
+    while (pData < pEnd && is.read(reinterpret_cast<char *>(run), sizeof(run)))
     {
-        int length_1 = uint8_t(is.get());
-        int value = uint8_t(is.get());
-        value |= uint8_t(is.get()) << 8;
-        for (int i = 0; i <= length_1 && pData < pEnd; ++i)
-            *pData++ = value;
+        uint16_t value = run[1] | run[2] << 8;
+        uint16_t *pRunEnd = std::min(pData + run[0] + 1, pEnd);
+        std::fill(pData, pRunEnd, value);
+        pData = pRunEnd;
     }
     return is;
 }
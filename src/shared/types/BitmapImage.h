@@ -128,6 +128,11 @@ class BitmapImage
     // region. Input pixels will only replace existing pixels with negative values,
     // i.e. pixels outside the clipping region.
     BitmapImage &SetBackground(const BitmapImage &);
+    // Computes the difference between this image and a previous one in square tiles.
+    // Tiles that did not change are set to zero in the difference without
+    // subtracting, and changed tiles are copied into the previous image.
+    // Returns the number of tiles that changed.
+    int TiledDifference(BitmapImage &ioPrevious, BitmapImage &outDifference, int tileSize = 16) const;
 
     std::ostream &Serialize(std::ostream &) const;
     std::istream &Unserialize(std::istream &);
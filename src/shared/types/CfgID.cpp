@@ -95,6 +95,9 @@ static struct
     CFGID(WindowFrame),
 
     CFGID(ValueUnits),
+
+    CFGID(DisplayRate),
+    CFGID(DisplayResolution),
 };
 
 static const int sCfgListEntries = sizeof(sCfgIDs) / sizeof(*sCfgIDs);
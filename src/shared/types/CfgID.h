@@ -99,6 +99,10 @@ class CfgID
         MinValues,  // allow for different min values in different channels
         MaxValues,  // allow for different max values in different channels
 
+        // Display feedback, sent by the operator to the module that owns a visualization
+        DisplayRate,       // rate at which the display is updated, in Hz
+        DisplayResolution, // number of pixels available for NumSamples samples
+
         // When adding new values, don't forget to add them to the string list in CfgID.cpp as well.
     };
 
@@ -29,12 +29,18 @@
 #include "HierarchicalLabel.h"
 #include "Label.h"
 #include "MessageChannel.h"
+#include "TimeUtils.h"
+#include "UnitTest.h"
 
+#include <algorithm>
 #include <cstdlib>
 #include <iomanip>
 #include <iostream>
+#include <map>
+#include <mutex>
 #include <sstream>
 #include <string>
+#include <vector>
 
 // Common to all visualization messages.
 std::istream &VisBase::Unserialize(std::istream &is)
@@ -254,13 +260,275 @@ void VisBitmap::OnSerialize(std::ostream &os) const
 
 static bci::MessageChannel *spOutputChannel = 0;
 
+// Display-rate coalescing.
+// Signals sent to a visualization are collected until the display is due for
+// an update. Polyline data are concatenated, and reduced to pairs of minimum
+// and maximum values when there are several samples per pixel, such that peaks
+// remain visible. For other graph types, only the most recent signal is kept.
+// When the output channel is congested, data older than a full display are dropped.
+namespace
+{
+enum
+{
+    cMinEnvelopeFactor = 4, // Fewer samples per pixel are sent unchanged.
+    cMaxPendingSignals = 64,
+};
+
+struct DisplayState
+{
+    double rate = 0;     // Display updates per second, as reported by the operator.
+    int resolution = 0;  // Pixels available for NumSamples samples, as reported by the operator.
+    int graphType = CfgID::Polyline;
+    int numSamples = 0;
+    bool haveProperties = false, fixedTiming = false, envelopeValid = false;
+    SignalProperties properties;
+    int envelope = 1; // Number of samples replaced by a min/max pair.
+    std::vector<GenericSignal> pending;
+    int pendingElements = 0;
+    GenericSignal buffer, remainder;
+    Time lastSent;
+
+    // A Polyline display with NumSamples set to 0 shows each signal as a whole,
+    // e.g. an average, rather than a stream of samples.
+    bool Streaming() const
+    {
+        return graphType == CfgID::Polyline && !(fixedTiming && numSamples <= 0);
+    }
+    bool Coalescing() const
+    {
+        return rate > 0 || resolution > 0;
+    }
+    bool Due(const Time &now) const
+    {
+        return rate <= 0 || (now - lastSent).Seconds() * rate >= 1;
+    }
+    void Clear()
+    {
+        pending.clear();
+        pendingElements = 0;
+        remainder = GenericSignal();
+    }
+    void Add(const GenericSignal &);
+    int EnvelopeFactor() const;
+};
+
+struct Displays : std::map<std::string, DisplayState>
+{
+    std::mutex mutex;
+};
+
+Displays &TheDisplays()
+{
+    static Displays displays;
+    return displays;
+}
+
+template <typename T> bool Transmit(const T &inObject)
+{
+    if (spOutputChannel)
+        return spOutputChannel->Send(inObject);
+    bcierr << "No output stream specified.";
+    return false;
+}
+
+SignalProperties EnvelopeProperties(const SignalProperties &inProperties, int inFactor)
+{
+    SignalProperties p = inProperties;
+    if (inFactor > 1)
+    {
+        double ratio = inFactor / 2.0;
+        PhysicalUnit &u = p.ElementUnit();
+        int numSamples = static_cast<int>((u.RawMax() - u.RawMin() + 1) / ratio);
+        p.SetElements(std::max(1, static_cast<int>(p.Elements() / ratio)));
+        u.SetOffset(u.Offset() / ratio).SetGain(u.Gain() * ratio).SetRawMax(u.RawMin() + numSamples - 1);
+    }
+    return p;
+}
+
+void DisplayState::Add(const GenericSignal &s)
+{
+    if (!Streaming() || (!pending.empty() && pending.front().Channels() != s.Channels()) ||
+        (remainder.Elements() > 0 && remainder.Channels() != s.Channels()))
+        Clear();
+    pending.push_back(s);
+    pendingElements += s.Elements();
+    // Data that would be overwritten within the same display update are dropped.
+    bool dropped = false;
+    while (pending.size() > 1 &&
+           ((numSamples > 0 && pendingElements - pending.front().Elements() >= numSamples) ||
+            pending.size() > static_cast<size_t>(cMaxPendingSignals)))
+    {
+        pendingElements -= pending.front().Elements();
+        pending.erase(pending.begin());
+        dropped = true;
+    }
+    if (dropped)
+        remainder = GenericSignal();
+}
+
+int DisplayState::EnvelopeFactor() const
+{
+    if (graphType != CfgID::Polyline || !haveProperties || fixedTiming || resolution < 1)
+        return 1;
+    const PhysicalUnit &u = properties.ElementUnit();
+    if (u.RawMin() < 0 || properties.Elements() >= numSamples)
+        return 1; // Not a continuous stream of samples.
+    int factor = numSamples / resolution;
+    return factor < cMinEnvelopeFactor ? 1 : factor;
+}
+
+bool UpdateEnvelope(const VisID &inVisID, DisplayState &d)
+{
+    bool result = true;
+    if (!d.envelopeValid)
+    {
+        int factor = d.EnvelopeFactor();
+        // Small changes are ignored, as they may result from rounding on the display side.
+        if (factor > 1 && d.envelope > 1 && std::abs(factor - d.envelope) * 8 < d.envelope)
+            factor = d.envelope;
+        if (factor != d.envelope)
+        {
+            d.envelope = factor;
+            d.remainder = GenericSignal();
+            result = Transmit(VisSignalProperties(inVisID, EnvelopeProperties(d.properties, factor)));
+        }
+        d.envelopeValid = true;
+    }
+    return result;
+}
+
+bool Flush(const VisID &inVisID, DisplayState &d, const Time &inNow)
+{
+    d.lastSent = inNow;
+    if (d.pending.empty())
+        return true;
+    bool result = UpdateEnvelope(inVisID, d);
+    if (!d.Streaming())
+    {
+        result = Transmit(VisSignalConst(inVisID, d.pending.back())) && result;
+        d.Clear();
+        return result;
+    }
+    // Concatenate pending data, following any samples left over from the previous envelope.
+    int channels = d.pending.front().Channels(), carry = d.remainder.Elements(),
+        elements = carry + d.pendingElements;
+    SignalProperties p = d.pending.front().Properties();
+    p.SetElements(elements);
+    d.buffer.SetProperties(p);
+    for (int ch = 0; ch < channels; ++ch)
+    {
+        int el = 0;
+        for (int i = 0; i < carry; ++i)
+            d.buffer(ch, el++) = d.remainder(ch, i);
+        for (const auto &s : d.pending)
+            for (int i = 0; i < s.Elements(); ++i)
+                d.buffer(ch, el++) = s(ch, i);
+    }
+    d.pending.clear();
+    d.pendingElements = 0;
+    if (d.envelope <= 1)
+    {
+        d.remainder = GenericSignal();
+        return Transmit(VisSignalConst(inVisID, d.buffer)) && result;
+    }
+    // Each bucket of samples is replaced with its minimum and maximum, in order of occurrence.
+    int factor = d.envelope, buckets = elements / factor, left = elements - buckets * factor;
+    p.SetElements(left);
+    d.remainder.SetProperties(p);
+    for (int ch = 0; ch < channels; ++ch)
+        for (int i = 0; i < left; ++i)
+            d.remainder(ch, i) = d.buffer(ch, buckets * factor + i);
+    if (buckets == 0)
+        return result;
+    p.SetElements(2 * buckets);
+    GenericSignal envelope(p);
+    for (int ch = 0; ch < channels; ++ch)
+        for (int b = 0; b < buckets; ++b)
+        {
+            int begin = b * factor, iMin = begin, iMax = begin;
+            for (int i = begin + 1; i < begin + factor; ++i)
+            {
+                if (d.buffer(ch, i) < d.buffer(ch, iMin))
+                    iMin = i;
+                if (d.buffer(ch, i) > d.buffer(ch, iMax))
+                    iMax = i;
+            }
+            envelope(ch, 2 * b) = d.buffer(ch, std::min(iMin, iMax));
+            envelope(ch, 2 * b + 1) = d.buffer(ch, std::max(iMin, iMax));
+        }
+    return Transmit(VisSignalConst(inVisID, envelope)) && result;
+}
+
+} // namespace
+
 void GenericVisualization::SetOutputChannel(bci::MessageChannel *pChannel)
 {
+    std::lock_guard<std::mutex> lock(TheDisplays().mutex);
+    TheDisplays().clear();
     spOutputChannel = pChannel;
 }
 
+void GenericVisualization::ApplyDisplayFeedback(const VisCfg &inCfg)
+{
+    std::lock_guard<std::mutex> lock(TheDisplays().mutex);
+    DisplayState &d = TheDisplays()[inCfg.VisID()];
+    std::istringstream iss(inCfg.CfgValue());
+    switch (inCfg.CfgID())
+    {
+    case CfgID::DisplayRate: {
+        double rate = 0;
+        d.rate = (iss >> rate && rate > 0) ? rate : 0;
+        break;
+    }
+    case CfgID::DisplayResolution: {
+        int resolution = 0;
+        d.resolution = (iss >> resolution && resolution > 0) ? resolution : 0;
+        d.envelopeValid = false;
+        break;
+    }
+    }
+}
+
+void GenericVisualization::SendPending(bool inAll)
+{
+    std::lock_guard<std::mutex> lock(TheDisplays().mutex);
+    Time now = TimeUtils::MonotonicTime();
+    bool congested = !inAll && spOutputChannel && spOutputChannel->Congested();
+    for (auto &entry : TheDisplays())
+    {
+        DisplayState &d = entry.second;
+        if (!d.pending.empty() && (inAll || (!congested && d.Due(now))))
+            Flush(entry.first, d, now);
+    }
+}
+
 GenericVisualization &GenericVisualization::SendCfgString(CfgID inCfgID, const std::string &inCfgString)
 {
+    std::lock_guard<std::mutex> lock(TheDisplays().mutex);
+    DisplayState &d = TheDisplays()[mVisID];
+    switch (inCfgID)
+    {
+    case CfgID::GraphType:
+        d.graphType = ::atoi(inCfgString.c_str());
+        d.Clear();
+        d.envelopeValid = false;
+        break;
+    case CfgID::NumSamples:
+    case CfgID::SampleUnit:
+    case CfgID::SampleOffset:
+        // Explicit timing information cannot be adapted to min/max envelopes.
+        if (inCfgID == CfgID::NumSamples)
+            d.numSamples = ::atoi(inCfgString.c_str());
+        d.fixedTiming = true;
+        if (d.envelope != 1)
+        {
+            d.envelope = 1;
+            d.Clear();
+            if (!Transmit(VisSignalProperties(mVisID, d.properties)))
+                this->setstate(ios_base::badbit);
+        }
+        break;
+    }
     return SendObject(VisCfg(mVisID, inCfgID, inCfgString));
 }
 
@@ -276,12 +544,35 @@ GenericVisualization &GenericVisualization::Send(const std::string &s)
 
 GenericVisualization &GenericVisualization::Send(const GenericSignal &s)
 {
+    {
+        std::lock_guard<std::mutex> lock(TheDisplays().mutex);
+        auto i = TheDisplays().find(mVisID);
+        if (i != TheDisplays().end() && i->second.Coalescing())
+        {
+            DisplayState &d = i->second;
+            d.Add(s);
+            Time now = TimeUtils::MonotonicTime();
+            if (d.Due(now) && !(spOutputChannel && spOutputChannel->Congested()) && !Flush(mVisID, d, now))
+                this->setstate(ios_base::badbit);
+            return *this;
+        }
+    }
     return SendObject(VisSignalConst(mVisID, s));
 }
 
 GenericVisualization &GenericVisualization::Send(const SignalProperties &s)
 {
-    return SendObject(VisSignalProperties(mVisID, s));
+    std::lock_guard<std::mutex> lock(TheDisplays().mutex);
+    DisplayState &d = TheDisplays()[mVisID];
+    d.Clear();
+    d.properties = s;
+    d.haveProperties = true;
+    d.fixedTiming = false;
+    const PhysicalUnit &u = s.ElementUnit();
+    d.numSamples = u.RawMin() < 0 ? s.Elements() : static_cast<int>(u.RawMax() - u.RawMin() + 1);
+    d.envelope = d.EnvelopeFactor();
+    d.envelopeValid = true;
+    return SendObject(VisSignalProperties(mVisID, EnvelopeProperties(s, d.envelope)));
 }
 
 GenericVisualization &GenericVisualization::Send(const BitmapImage &b)
@@ -324,10 +615,121 @@ void BitmapVisualization::SendDifferenceFrame(const BitmapImage &b)
     {
         SendReferenceFrame(b);
     }
-    else
+    else if (b.TiledDifference(mImageBuffer, mDifferenceBuffer) > 0)
+    {
+        Send(mDifferenceBuffer);
+    }
+}
+
+UnitTest(DisplayCoalescingTest)
+{
+    struct Capture : bci::MessageChannel
+    {
+        std::vector<GenericSignal> signals;
+        Capture(Tiny::Streambuf &buf) : MessageChannel(buf)
+        {
+        }
+        bool OnSend(const VisSignalConst &v) override
+        {
+            signals.push_back(v.Signal());
+            return true;
+        }
+        bool OnSend(const VisSignalProperties &) override
+        {
+            return true;
+        }
+        bool OnMessageBuffered(const Message &) override
+        {
+            return true;
+        }
+    };
+    Tiny::UnbufferedIO io;
+    Capture capture(io);
+    bci::MessageChannel *pPrevious = spOutputChannel;
+    spOutputChannel = &capture;
+
+    SignalProperties p(1, 10, SignalType::float32);
+    p.ElementUnit().SetOffset(0).SetGain(0.001).SetSymbol("s").SetRawMin(0).SetRawMax(999);
+    GenericSignal s(p);
+    auto fill = [&s](int base) {
+        for (int i = 0; i < s.Elements(); ++i)
+            s(0, i) = base + (i % 2 ? i : -i);
+    };
+    auto properties = [&p](DisplayState &d) {
+        d.properties = p;
+        d.haveProperties = true;
+        d.numSamples = 1000;
+        d.envelope = d.EnvelopeFactor();
+        d.envelopeValid = true;
+    };
+
+    // Envelope factor is the number of samples per pixel, or 1 when too small to matter.
+    DisplayState d;
+    properties(d);
+    TestFail_if(d.envelope != 1, "envelope without resolution is " << d.envelope);
+    d.resolution = 125;
+    TestFail_if(d.EnvelopeFactor() != 8, "envelope factor is " << d.EnvelopeFactor() << ", expected 8");
+    d.resolution = 500;
+    TestFail_if(d.EnvelopeFactor() != 1, "envelope factor below minimum is " << d.EnvelopeFactor());
+    d.resolution = 125;
+    d.fixedTiming = true;
+    TestFail_if(d.EnvelopeFactor() != 1, "envelope applied to explicit timing");
+    d.fixedTiming = false;
+
+    // 30 samples in buckets of 8 give 3 min/max pairs, and 6 samples carried over.
+    properties(d);
+    TestRequire(d.envelope == 8 && d.Streaming());
+    for (int i = 0; i < 3; ++i)
+    {
+        fill(100 * i);
+        d.Add(s);
+    }
+    TestRequire(d.pending.size() == 3 && d.pendingElements == 30);
+    TestRequire(Flush("vis", d, Time()));
+    TestFail_if(capture.signals.size() != 1 || capture.signals.back().Elements() != 6, "wrong envelope size");
+    TestFail_if(d.remainder.Elements() != 6, "remainder has " << d.remainder.Elements() << " samples, expected 6");
+    const GenericSignal &e = capture.signals.back();
+    // First bucket holds 0, 1, -2, 3, -4, 5, -6, 7: minimum -6 precedes maximum 7.
+    TestFail_if(e(0, 0) != -6 || e(0, 1) != 7, "first bucket is " << e(0, 0) << ", " << e(0, 1));
+    // Second bucket holds -8, 9, 100, 101, 98, 103, 96, 105: minimum -8 precedes maximum 105.
+    TestFail_if(e(0, 2) != -8 || e(0, 3) != 105, "second bucket is " << e(0, 2) << ", " << e(0, 3));
+    // The carried-over samples are completed by the next signal.
+    fill(300);
+    d.Add(s);
+    TestRequire(Flush("vis", d, Time()));
+    TestFail_if(capture.signals.size() != 2 || capture.signals.back().Elements() != 4, "wrong envelope size");
+    TestFail_if(d.remainder.Elements() != 0, "remainder left after full buckets");
+
+    // Data that would be overwritten before the next display update are dropped.
+    d.numSamples = 25;
+    for (int i = 0; i < 5; ++i)
     {
-        BitmapImage curImage = b;
-        Send(curImage - mImageBuffer);
-        mImageBuffer = curImage;
+        fill(1000 * i);
+        d.Add(s);
     }
+    TestFail_if(d.pending.size() != 3, d.pending.size() << " signals pending, expected 3");
+    TestFail_if(d.pending.front()(0, 0) != 2000, "oldest signal kept instead of newest");
+    d.numSamples = 1000;
+    for (int i = 0; i < 2 * cMaxPendingSignals; ++i)
+        d.Add(s);
+    TestFail_if(d.pending.size() != cMaxPendingSignals, d.pending.size() << " signals pending");
+    d.Clear();
+
+    // With NumSamples set to 0, signals are shown as a whole, so only the latest one is sent, unchanged.
+    d.fixedTiming = true;
+    d.numSamples = 0;
+    d.envelopeValid = false;
+    TestRequire(!d.Streaming());
+    capture.signals.clear();
+    fill(1);
+    d.Add(s);
+    fill(3);
+    d.Add(s);
+    TestFail_if(d.pending.size() != 1, "non-streaming display keeps " << d.pending.size() << " signals");
+    TestRequire(Flush("vis", d, Time()));
+    TestFail_if(capture.signals.size() != 1 || capture.signals.back().Elements() != 10 ||
+                    capture.signals.back()(0, 0) != 3,
+                "non-streaming signal not sent unchanged");
+
+    spOutputChannel = pPrevious;
 }
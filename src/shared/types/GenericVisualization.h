@@ -305,6 +305,12 @@ class GenericVisualization : public std::ostream
     GenericVisualization &Send(const BitmapImage &);
 
     static void SetOutputChannel(bci::MessageChannel *);
+    // Once the operator reports the update rate and resolution of a visualization's
+    // display, signals sent to that visualization are coalesced, and sent at most
+    // at the display's update rate.
+    static void ApplyDisplayFeedback(const VisCfg &);
+    // Sends coalesced signals that are due, or all coalesced signals.
+    static void SendPending(bool all = false);
 
   private:
     GenericVisualization &SendCfgString(CfgID, const std::string &);
@@ -347,7 +353,7 @@ class BitmapVisualization : public GenericVisualization
     void SendDifferenceFrame(const BitmapImage &);
 
   private:
-    BitmapImage mImageBuffer;
+    BitmapImage mImageBuffer, mDifferenceBuffer;
 };
 
 template <typename T> GenericVisualization &GenericVisualization::Send(CfgID cfgID, const T &cfgValue)
@@ -28,6 +28,9 @@
 #include "BCIException.h"
 #include "Brackets.h"
 #include "Debugging.h"
+#include "LengthField.h"
+#include "ParamList.h"
+#include "UnitTest.h"
 
 #include <cstdio>
 #include <sstream>
@@ -36,6 +39,9 @@ static const char *sDefaultValue = "";
 static const std::string sCommentSeparator = "//";
 static const std::string sReadonlyTag = "(readonly)";
 static const std::string sAllowOverrideTag = "(allow_override)";
+// Packed parameter messages begin with a null character, which cannot appear
+// at the beginning of a parameter line.
+static const char cPackedMarker = '\0', cPackedVersion = 1;
 static const std::string cEmptyString = "";
 
 const std::ctype<char> &Param::ct()
@@ -442,6 +448,13 @@ std::ostream &Param::InsertInto(std::ostream &os) const
 // **************************************************************************
 std::istream &Param::Unserialize(std::istream &is)
 {
+    if (is.peek() == cPackedMarker)
+    {
+        is.get();
+        if (is.get() != cPackedVersion)
+            is.setstate(std::ios::failbit);
+        return ReadPacked(is);
+    }
     ExtractFrom(is);
     // Some old modules out there don't send CRLF after binary Param messages.
     if (!is.eof() && (is.get() != '\r'))
@@ -463,6 +476,169 @@ std::ostream &Param::Serialize(std::ostream &os) const
     return InsertInto(os).write("\r\n", 2);
 }
 
+// **************************************************************************
+// Function:   SerializePacked
+// Purpose:    Member function for output of a single parameter into a
+//             binary stream, in packed form. Avoids escaping and tokenizing
+//             of values, which dominates transmission time for large
+//             matrix parameters.
+// Parameters: Output stream to write into.
+// Returns:    Output stream written into.
+// **************************************************************************
+namespace
+{
+void PutString(std::ostream &os, const std::string &s)
+{
+    LengthField<1>(s.length()).Serialize(os);
+    os.write(s.data(), s.length());
+}
+
+bool GetString(std::istream &is, std::string &s)
+{
+    LengthField<1> length;
+    if (length.Unserialize(is))
+    {
+        s.resize(length);
+        is.read(&s[0], s.length());
+    }
+    return !!is;
+}
+
+void PutLabels(std::ostream &os, const LabelIndex &labels)
+{
+    bool trivial = labels.IsTrivial();
+    os.put(trivial ? 't' : 'l');
+    LengthField<2>(labels.Size()).Serialize(os);
+    if (!trivial)
+        for (int i = 0; i < labels.Size(); ++i)
+            PutString(os, labels[i]);
+}
+
+bool GetLabels(std::istream &is, LabelIndex &labels)
+{
+    int kind = is.get();
+    LengthField<2> size;
+    if (!size.Unserialize(is))
+        return false;
+    // Start from a trivial index, as LabelIndex::ExtractFrom() does.
+    labels = LabelIndex();
+    labels.Resize(size);
+    std::string label;
+    if (kind == 'l')
+        for (size_t i = 0; i < size && GetString(is, label); ++i)
+            labels[i] = label;
+    else if (kind != 't')
+        is.setstate(std::ios::failbit);
+    return !!is;
+}
+} // namespace
+
+std::ostream &Param::SerializePacked(std::ostream &os) const
+{
+    os.put(cPackedMarker).put(cPackedVersion);
+    return WritePacked(os);
+}
+
+std::ostream &Param::WritePacked(std::ostream &os) const
+{
+    LengthField<1>(mSections.size()).Serialize(os);
+    for (const auto &section : mSections)
+        PutString(os, section);
+    PutString(os, mType);
+    PutString(os, mParentPath);
+    PutString(os, mName);
+    PutLabels(os, mDim1Index);
+    PutLabels(os, mDim2Index);
+    LengthField<2>(mValues.size()).Serialize(os);
+    for (const auto &value : mValues)
+    {
+        if (value.mNative == ParamValue::parameter)
+            value.mpParam->WritePacked(os.put('p'));
+        else
+            PutString(os.put('s'), value.mNative == ParamValue::string ? *value.mpString : std::string());
+    }
+    PutString(os, mDefaultValue);
+    PutString(os, mLowRange);
+    PutString(os, mHighRange);
+    PutString(os, mComment);
+    return os;
+}
+
+std::istream &Param::ReadPacked(std::istream &is)
+{
+    mChanged = true;
+    mSections.clear();
+    mValues.clear();
+    std::string s;
+    LengthField<1> sections;
+    if (sections.Unserialize(is))
+        for (size_t i = 0; i < sections && GetString(is, s); ++i)
+            mSections.push_back(s);
+    GetString(is, mType);
+    GetString(is, mParentPath);
+    GetString(is, mName);
+    GetLabels(is, mDim1Index);
+    GetLabels(is, mDim2Index);
+    LengthField<2> values;
+    if (values.Unserialize(is))
+        mValues.resize(values);
+    for (auto i = mValues.begin(); is && i != mValues.end(); ++i)
+    {
+        switch (is.get())
+        {
+        case 'p': {
+            Param p;
+            p.ReadPacked(is);
+            i->Assign(p);
+        }
+        break;
+        case 's':
+            GetString(is, s);
+            i->Assign(s);
+            break;
+        default:
+            is.setstate(std::ios::failbit);
+        }
+    }
+    GetString(is, mDefaultValue);
+    GetString(is, mLowRange);
+    GetString(is, mHighRange);
+    GetString(is, s);
+    SetComment(s);
+    if (mValues.size() != static_cast<size_t>(mDim1Index.Size() * mDim2Index.Size()))
+        is.setstate(std::ios::failbit);
+    return is;
+}
+
+// **************************************************************************
+// Function:   operator==
+// Purpose:    Compares parameters, including values and subparameters.
+// Parameters: Param instance to compare to.
+// Returns:    true if parameters are equal.
+// **************************************************************************
+bool Param::operator==(const Param &p) const
+{
+    if (this == &p)
+        return true;
+    if (mName != p.mName || mParentPath != p.mParentPath || mType != p.mType || mSections != p.mSections)
+        return false;
+    if (mDefaultValue != p.mDefaultValue || mLowRange != p.mLowRange || mHighRange != p.mHighRange ||
+        mComment != p.mComment)
+        return false;
+    if (!(mDim1Index == p.mDim1Index) || !(mDim2Index == p.mDim2Index) || mValues.size() != p.mValues.size())
+        return false;
+    for (size_t i = 0; i < mValues.size(); ++i)
+    {
+        const ParamValue &a = mValues[i], &b = p.mValues[i];
+        bool aIsParam = (a.mNative == ParamValue::parameter), bIsParam = (b.mNative == ParamValue::parameter);
+        if (aIsParam != bIsParam)
+            return false;
+        if (aIsParam ? *a.mpParam != *b.mpParam : a.AsString() != b.AsString())
+            return false;
+    }
+    return true;
+}
+
 // **************************************************************************
 // Function:   operator=
 // Purpose:    Assignment from one parameter instance to another.
@@ -728,3 +904,79 @@ std::istream &Param::ParamValue::ExtractFrom(std::istream &is)
     }
     return is;
 }
+
+UnitTest(ParamPackedTest)
+{
+    const char *definitions[] = {
+        "Source:Spatial%20Filter matrix M= { r1 r2 } 3 1 two%20words % 4 5 6 0 % % // labeled rows",
+        "Application:Sequence matrix Stimuli= 1 2 { matrix 2 1 a b } %20x 0 % % // nested matrix",
+        "Source intlist TransmitChList= 3 1 2 3 1 1 % // a list",
+        "Visualize list EmptyList= 0 % % % // empty list",
+        "Source int Count= 4 0 0 % // a scalar",
+    };
+    for (const char *def : definitions)
+    {
+        Param param(def);
+        std::ostringstream text, packed;
+        param.Serialize(text);
+        param.SerializePacked(packed);
+        Param fromText, fromPacked;
+        std::istringstream textIn(text.str()), packedIn(packed.str());
+        fromText.Unserialize(textIn);
+        fromPacked.Unserialize(packedIn);
+        TestRequire(textIn && packedIn);
+        TestFail_if(fromPacked != param, "packed round trip differs for " << def);
+        TestFail_if(fromText != fromPacked, "packed and text forms differ for " << def);
+        std::ostringstream a, b;
+        a << fromText;
+        b << fromPacked;
+        TestFail_if(a.str() != b.str(), a.str() << " != " << b.str());
+
+        std::string s = packed.str();
+        for (size_t length = 2; length < s.length(); length += 3)
+        {
+            Param truncated;
+            std::istringstream in(s.substr(0, length));
+            truncated.Unserialize(in);
+            TestFail_if(in, "truncated input accepted for " << def << " at length " << length);
+        }
+    }
+
+    // A delta holds the parameters that changed since the previous broadcast.
+    // Applying it to the previous broadcast must reproduce the current parameters,
+    // also when a parameter shrinks.
+    ParamList previous, current;
+    for (const char *def : definitions)
+        previous.Add(def);
+    current = previous;
+    current.ByPath("M") = Param("Source:Spatial%20Filter matrix M= 1 1 7 0 % % // shrunk");
+    current.ByPath("Count").Value() = "5";
+    current.Add("Source int NewParam= 1 0 % % // added");
+    ParamList delta;
+    for (int i = 0; i < current.Size(); ++i)
+    {
+        const Param &p = current.ByIndex(i);
+        if (!previous.Exists(p.Path()) || previous.ByPath(p.Path()) != p)
+            delta.Add(p);
+    }
+    TestFail_if(delta.Size() != 3, "delta has " << delta.Size() << " parameters, expected 3");
+    ParamList applied = previous;
+    for (int i = 0; i < delta.Size(); ++i)
+    {
+        // Read into the previous version of the parameter, so stale content would show.
+        const std::string &path = delta.ByIndex(i).Path();
+        std::ostringstream packed;
+        delta.ByIndex(i).SerializePacked(packed);
+        std::istringstream in(packed.str());
+        Param p = previous.Exists(path) ? previous.ByPath(path) : Param();
+        p.Unserialize(in);
+        TestRequire(!!in);
+        applied.ByPath(p.Path()) = p;
+    }
+    TestFail_if(applied.Size() != current.Size(), "parameter count differs after applying delta");
+    for (int i = 0; i < current.Size(); ++i)
+    {
+        const Param &p = current.ByIndex(i);
+        TestFail_if(!applied.Exists(p.Path()) || applied.ByPath(p.Path()) != p, p.Path() << " differs after applying delta");
+    }
+}
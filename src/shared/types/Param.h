@@ -385,6 +385,20 @@ class Param
     std::istream &ExtractFrom(std::istream &);
     std::ostream &Serialize(std::ostream &) const;
     std::istream &Unserialize(std::istream &);
+    // Binary packed output, understood by Unserialize(). Values are written
+    // without escaping, and are prefixed with their lengths.
+    std::ostream &SerializePacked(std::ostream &) const;
+
+    // Parameters are equal when their definition lines are equal.
+    bool operator==(const Param &) const;
+    bool operator!=(const Param &p) const
+    {
+        return !operator==(p);
+    }
+
+  private:
+    std::ostream &WritePacked(std::ostream &) const;
+    std::istream &ReadPacked(std::istream &);
 
   private:
     HierarchicalLabel mSections;
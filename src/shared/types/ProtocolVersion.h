@@ -42,6 +42,8 @@ class ProtocolVersion
     static const Version *History()
     {
         static const Version v[] = {
+            {2, 5, "State vector deltas"},
+            {2, 4, "Packed parameters and parameter deltas"},
             {2, 3, "ListeningAddress parameter"},
             {2, 2, "Shared signal storage"},
             {2, 1, "NextModuleInfo from Operator"},
@@ -59,6 +61,9 @@ class ProtocolVersion
         NextModuleInfo,
         SharedSignalStorage,
         ListeningAddressParameter,
+        PackedParameters,
+        ParameterDeltas,
+        StateVectorDeltas,
     };
 
     ProtocolVersion() : mMajor(0), mMinor(0)
@@ -137,6 +142,11 @@ inline bool ProtocolVersion::Provides(int feature) const
         return AtLeast(ProtocolVersion(2, 2));
     case ListeningAddressParameter:
         return AtLeast(ProtocolVersion(2, 3));
+    case PackedParameters:
+    case ParameterDeltas:
+        return AtLeast(ProtocolVersion(2, 4));
+    case StateVectorDeltas:
+        return AtLeast(ProtocolVersion(2, 5));
     }
     return false;
 }
@@ -29,10 +29,50 @@
 #include "Debugging.h"
 #include "Exception.h"
 #include "StateList.h"
+#include "UnitTest.h"
 
+#include <algorithm>
 #include <cstring>
 #include <iomanip>
 #include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+// A delta encoded state vector begins with a null byte, which cannot begin an
+// ordinary state vector message.
+const char cDeltaMarker = '\0', cKeyframe = 'K', cDelta = 'D';
+
+void PutVarint(std::string &s, size_t value)
+{
+    while (value >= 0x80)
+    {
+        s += char((value & 0x7f) | 0x80);
+        value >>= 7;
+    }
+    s += char(value);
+}
+
+size_t GetVarint(std::istream &is)
+{
+    size_t value = 0;
+    int shift = 0, c = 0;
+    do
+    {
+        c = is.get();
+        if (c == EOF || shift >= int(8 * sizeof(size_t)))
+        {
+            is.setstate(std::ios::failbit);
+            return 0;
+        }
+        value |= size_t(c & 0x7f) << shift;
+        shift += 7;
+    } while (c & 0x80);
+    return value;
+}
+
+} // namespace
 
 StateVector::StateVector(size_t inByteLength, size_t inSamples)
     : mpStateList(nullptr), mpData(nullptr), mSamples(0), mByteLength(0), mCreatorThreadId(std::this_thread::get_id())
@@ -159,11 +199,7 @@ void StateVector::SetSampleValue(size_t inLocation, size_t inLength, size_t inSa
 // **************************************************************************
 void StateVector::SetStateValue(size_t inLocation, size_t inLength, size_t inSample, State::ValueType inValue)
 {
-    if (std::this_thread::get_id() != mCreatorThreadId)
-        throw std_runtime_error
-            << "Trying to set a state value from a secondary thread.\n"
-            << "NB: BufferedADC provides special means to deal with additional synchronous channels.\n"
-            << "    Also, the bcievent accessor allows to asynchronously write to streams.";
+    CheckWriteAccess();
     State::ValueType valueMask = (~State::ValueType(0) >> (8 * sizeof(State::ValueType) - inLength));
     if (inValue < 0 || (inValue & valueMask) != inValue)
         throw std_range_error << "Illegal value " << inValue << " was passed to " << inLength
@@ -175,14 +211,101 @@ void StateVector::SetStateValue(size_t inLocation, size_t inLength, size_t inSam
     if (inSample >= mSamples)
         throw std_range_error << "Accessing non-existent state vector data, sample: " << inSample;
 
-    for (int i = inSample; i < Samples(); ++i)
-        SetSampleValue(inLocation, inLength, i, inValue);
+    ColumnPlan::Column column = ColumnPlan::MakeColumn(inLocation, inLength);
+    ColumnPlan::InsertColumn(column, Data(inSample), mByteLength, mSamples - inSample, &inValue, 0);
 }
 
 void StateVector::SetStateValue(size_t inLocation, size_t inLength, State::ValueType inValue)
 {
     SetStateValue(inLocation, inLength, 0, inValue);
 }
+
+// **************************************************************************
+// Function:   ExtractColumns
+// Purpose:    Reads the values of all states in a ColumnPlan for a range of
+//             samples.
+// Parameters: plan     ... precompiled column plan
+//             sample   ... first sample
+//             count    ... number of samples
+//             values   ... output array of plan.Columns() * count values,
+//                          arranged by column
+// Returns:    N/A
+// **************************************************************************
+void StateVector::ExtractColumns(const ColumnPlan &inPlan, size_t inSample, size_t inCount,
+                                 State::ValueType *outValues) const
+{
+    CheckBlockAccess(inPlan, inSample, inCount);
+    if (inCount > 0)
+        inPlan.Extract(Data(inSample), mByteLength, inCount, outValues);
+}
+
+// **************************************************************************
+// Function:   InsertColumns
+// Purpose:    Writes the values of all states in a ColumnPlan for a range of
+//             samples. Values are not propagated beyond the range.
+// Parameters: plan     ... precompiled column plan
+//             sample   ... first sample
+//             count    ... number of samples
+//             values   ... array of plan.Columns() * count values,
+//                          arranged by column
+// Returns:    N/A
+// **************************************************************************
+void StateVector::InsertColumns(const ColumnPlan &inPlan, size_t inSample, size_t inCount,
+                                const State::ValueType *inValues)
+{
+    CheckWriteAccess();
+    CheckBlockAccess(inPlan, inSample, inCount);
+    if (inCount > 0)
+        inPlan.Insert(Data(inSample), mByteLength, inCount, inValues);
+}
+
+void StateVector::StateValues(size_t inLocation, size_t inLength, size_t inSample, size_t inCount,
+                              State::ValueType *outValues) const
+{
+    if (inLocation + inLength > 8 * mByteLength)
+        throw std_range_error << "Accessing non-existent state vector data, location: " << inLocation;
+    if (inSample + inCount > mSamples)
+        throw std_range_error << "Accessing non-existent state vector data, sample: " << inSample + inCount - 1;
+    ColumnPlan::Column column = ColumnPlan::MakeColumn(inLocation, inLength);
+    if (inCount > 0)
+        ColumnPlan::ExtractColumn(column, Data(inSample), mByteLength, inCount, outValues);
+}
+
+void StateVector::SetSampleValues(size_t inLocation, size_t inLength, size_t inSample, size_t inCount,
+                                  const State::ValueType *inValues)
+{
+    CheckWriteAccess();
+    if (inLocation + inLength > 8 * mByteLength)
+        throw std_range_error << "Accessing non-existent state vector data, location: " << inLocation;
+    if (inSample + inCount > mSamples)
+        throw std_range_error << "Accessing non-existent state vector data, sample: " << inSample + inCount - 1;
+    ColumnPlan::Column column = ColumnPlan::MakeColumn(inLocation, inLength);
+    if (inCount > 0)
+        ColumnPlan::InsertColumn(column, Data(inSample), mByteLength, inCount, inValues, 1);
+}
+
+State::ValueType StateVector::StateValue(const ColumnPlan &inPlan, int inColumn, size_t inSample) const
+{
+    CheckBlockAccess(inPlan, inSample, 1);
+    return inPlan.Value(Data(inSample), inColumn);
+}
+
+void StateVector::CheckBlockAccess(const ColumnPlan &inPlan, size_t inSample, size_t inCount) const
+{
+    if (inPlan.ByteLength() > mByteLength)
+        throw std_range_error << "Accessing non-existent state vector data, byte: " << inPlan.ByteLength() - 1;
+    if (inSample + inCount > mSamples)
+        throw std_range_error << "Accessing non-existent state vector data, sample: " << inSample + inCount - 1;
+}
+
+void StateVector::CheckWriteAccess() const
+{
+    if (std::this_thread::get_id() != mCreatorThreadId)
+        throw std_runtime_error
+            << "Trying to set a state value from a secondary thread.\n"
+            << "NB: BufferedADC provides special means to deal with additional synchronous channels.\n"
+            << "    Also, the bcievent accessor allows to asynchronously write to streams.";
+}
 // **************************************************************************
 // Function:   PostStateChange
 // Purpose:    Have a state changed upon the next call to CommitStateChanges().
@@ -231,11 +354,13 @@ std::ostream &StateVector::InsertInto(std::ostream &os) const
     }
     else
     {
+        std::vector<State::ValueType> values(Samples());
         for (const auto &state : *mpStateList)
         {
             os << '\n' << std::setw(indent) << "" << state.Name() << ":";
-            for (int j = 0; j < Samples(); ++j)
-                os << " " << StateValue(state.Location(), state.Length(), j);
+            StateValues(state.Location(), state.Length(), 0, values.size(), values.data());
+            for (auto value : values)
+                os << " " << value;
         }
     }
     return os;
@@ -273,6 +398,112 @@ std::ostream &StateVector::Serialize(std::ostream &os) const
     return os;
 }
 
+// **************************************************************************
+// Function:   IsDelta
+// Purpose:    Determines whether a stream contains a delta encoded state vector.
+// Parameters: Input stream.
+// Returns:    True if the stream's next byte is a delta marker.
+// **************************************************************************
+bool StateVector::IsDelta(std::istream &is)
+{
+    return is.peek() == cDeltaMarker;
+}
+
+// **************************************************************************
+// Function:   SerializeDelta
+// Purpose:    Member function for output of a state vector block into a
+//             binary stream, encoded relative to a reference state vector.
+//             Each sample is predicted by its preceding sample, and the first
+//             sample by the reference's last one. Of the difference, only
+//             runs of changed bytes are written, preceded by the number of
+//             unchanged bytes skipped.
+//             Without a matching reference, all data are written as a keyframe.
+// Parameters: Output stream to write into, pointer to reference or null.
+// Returns:    Output stream.
+// **************************************************************************
+std::ostream &StateVector::SerializeDelta(std::ostream &os, const StateVector *pReference) const
+{
+    bool keyframe = !pReference || pReference->mByteLength != mByteLength || pReference->mSamples < 1;
+    os.put(cDeltaMarker).put(keyframe ? cKeyframe : cDelta);
+    (os << mByteLength).put('\0');
+    (os << mSamples).put('\0');
+    size_t length = mByteLength, size = length * mSamples;
+    if (keyframe)
+        return os.write(mpData, size);
+
+    const char *pPrevious = pReference->mpData + (pReference->mSamples - 1) * length;
+    auto residual = [=](size_t i) { return char(mpData[i] ^ (i < length ? pPrevious[i] : mpData[i - length])); };
+    std::string encoded;
+    size_t i = 0;
+    while (i < size)
+    {
+        size_t begin = i;
+        while (i < size && !residual(i))
+            ++i;
+        PutVarint(encoded, i - begin);
+        begin = i;
+        // A single unchanged byte does not end a run of changed bytes.
+        while (i < size && (residual(i) || (i + 1 < size && residual(i + 1))))
+            ++i;
+        PutVarint(encoded, i - begin);
+        for (size_t j = begin; j < i; ++j)
+            encoded += residual(j);
+    }
+    return os.write(encoded.data(), encoded.size());
+}
+
+// **************************************************************************
+// Function:   UnserializeDelta
+// Purpose:    Member function for input of a state vector block from a
+//             binary stream, encoded by SerializeDelta() relative to the
+//             current content.
+//             On malformed input, or when a delta does not match the current
+//             content, the stream's failbit is set, and the current content
+//             is left unchanged unless input was truncated.
+// Parameters: Input stream to read from.
+// Returns:    Input stream.
+// **************************************************************************
+std::istream &StateVector::UnserializeDelta(std::istream &is)
+{
+    int byteLength = -1, samples = -1;
+    if (is.get() != cDeltaMarker)
+        is.setstate(std::ios::failbit);
+    int kind = is.get();
+    (is >> byteLength).get();
+    (is >> samples).get();
+    bool keyframe = kind == cKeyframe, delta = kind == cDelta && byteLength == mByteLength && mSamples > 0;
+    if (!is || byteLength < 0 || samples < 0 || !(keyframe || delta))
+    {
+        is.setstate(std::ios::failbit);
+        return is;
+    }
+    if (keyframe)
+    {
+        Allocate(byteLength, samples);
+        return is.read(mpData, byteLength * samples);
+    }
+
+    size_t length = mByteLength;
+    std::vector<char> previous(mpData + (mSamples - 1) * length, mpData + mSamples * length);
+    Allocate(byteLength, samples);
+    size_t size = length * samples, i = 0;
+    auto predicted = [&](size_t i) { return i < length ? previous[i] : mpData[i - length]; };
+    while (i < size && is)
+    {
+        size_t skip = GetVarint(is), count = GetVarint(is);
+        if (!is || skip > size - i || count > size - i - skip)
+        {
+            is.setstate(std::ios::failbit);
+            break;
+        }
+        for (size_t end = i + skip; i < end; ++i)
+            mpData[i] = predicted(i);
+        for (size_t end = i + count; i < end; ++i)
+            mpData[i] = char(is.get()) ^ predicted(i);
+    }
+    return is;
+}
+
 char *StateVector::Data(size_t inSample)
 {
     Assert(inSample < mSamples);
@@ -390,3 +621,190 @@ bool StateVector::Aligned() const
 {
     return mpStateList && mpStateList->Alignment() == sizeof(State::ValueType);
 }
+
+// **************************************************************************
+// ColumnPlan
+// **************************************************************************
+StateVector::ColumnPlan &StateVector::ColumnPlan::Clear()
+{
+    mColumns.clear();
+    mByteLength = 0;
+    return *this;
+}
+
+StateVector::ColumnPlan &StateVector::ColumnPlan::Add(const State &inState)
+{
+    return Add(inState.Location(), inState.Length());
+}
+
+StateVector::ColumnPlan &StateVector::ColumnPlan::Add(size_t inLocation, size_t inLength)
+{
+    Column column = MakeColumn(inLocation, inLength);
+    mColumns.push_back(column);
+    mByteLength = std::max(mByteLength, column.byteOffset + column.byteCount);
+    return *this;
+}
+
+void StateVector::ColumnPlan::Extract(const char *inData, size_t inStride, size_t inSamples,
+                                      State::ValueType *outValues) const
+{
+    for (const auto &column : mColumns)
+    {
+        ExtractColumn(column, inData, inStride, inSamples, outValues);
+        outValues += inSamples;
+    }
+}
+
+void StateVector::ColumnPlan::Insert(char *ioData, size_t inStride, size_t inSamples,
+                                     const State::ValueType *inValues) const
+{
+    for (const auto &column : mColumns)
+    {
+        InsertColumn(column, ioData, inStride, inSamples, inValues, 1);
+        inValues += inSamples;
+    }
+}
+
+State::ValueType StateVector::ColumnPlan::Value(const char *inSampleData, int inColumn) const
+{
+    State::ValueType value;
+    ExtractColumn(mColumns[inColumn], inSampleData, 0, 1, &value);
+    return value;
+}
+
+// State data is stored with bit i of the state vector at bit i % 8 of byte i / 8.
+// A state of up to 32 bits thus covers at most 5 bytes, which we assemble into a
+// single 64-bit word, independently of machine byte order.
+static uint64_t LoadBytes(const unsigned char *p, int count)
+{
+    uint64_t value = 0;
+    for (int i = count - 1; i >= 0; --i)
+        value = (value << 8) | p[i];
+    return value;
+}
+
+static void StoreBytes(unsigned char *p, int count, uint64_t value)
+{
+    for (int i = 0; i < count; ++i, value >>= 8)
+        p[i] = static_cast<unsigned char>(value);
+}
+
+StateVector::ColumnPlan::Column StateVector::ColumnPlan::MakeColumn(size_t inLocation, size_t inLength)
+{
+    if (inLength > 8 * sizeof(State::ValueType))
+        throw std_range_error << "Invalid state length: " << inLength;
+    Column column;
+    column.byteOffset = static_cast<int>(inLocation / 8);
+    column.shift = inLocation % 8;
+    column.byteCount = static_cast<int>((column.shift + inLength + 7) / 8);
+    column.mask = (uint64_t(1) << inLength) - 1;
+    return column;
+}
+
+void StateVector::ColumnPlan::ExtractColumn(const Column &inColumn, const char *inData, size_t inStride,
+                                            size_t inSamples, State::ValueType *outValues)
+{
+    const unsigned char *p = reinterpret_cast<const unsigned char *>(inData) + inColumn.byteOffset;
+    const int shift = inColumn.shift;
+    const uint64_t mask = inColumn.mask;
+    switch (inColumn.byteCount)
+    {
+    case 1: // flags and small counters
+        for (size_t i = 0; i < inSamples; ++i, p += inStride)
+            outValues[i] = static_cast<State::ValueType>((*p >> shift) & mask);
+        break;
+    case 2:
+        for (size_t i = 0; i < inSamples; ++i, p += inStride)
+            outValues[i] = static_cast<State::ValueType>(((p[0] | p[1] << 8) >> shift) & mask);
+        break;
+    default:
+        for (size_t i = 0; i < inSamples; ++i, p += inStride)
+            outValues[i] = static_cast<State::ValueType>((LoadBytes(p, inColumn.byteCount) >> shift) & mask);
+    }
+}
+
+void StateVector::ColumnPlan::InsertColumn(const Column &inColumn, char *ioData, size_t inStride, size_t inSamples,
+                                           const State::ValueType *inValues, size_t inValueStride)
+{
+    unsigned char *p = reinterpret_cast<unsigned char *>(ioData) + inColumn.byteOffset;
+    const int shift = inColumn.shift, count = inColumn.byteCount;
+    const uint64_t mask = inColumn.mask, keep = ~(mask << shift);
+    for (size_t i = 0; i < inSamples; ++i, p += inStride, inValues += inValueStride)
+    {
+        uint64_t value = *inValues;
+        if (value & ~mask)
+            throw std_range_error << "Illegal value " << *inValues << " was passed to state at address "
+                                  << 8 * inColumn.byteOffset + shift;
+        StoreBytes(p, count, (LoadBytes(p, count) & keep) | value << shift);
+    }
+}
+
+UnitTest(StateVectorDeltaTest)
+{
+    auto full = [](const StateVector &s) {
+        std::ostringstream oss;
+        s.Serialize(oss);
+        return oss.str();
+    };
+    auto encode = [](const StateVector &s, const StateVector *pReference) {
+        std::ostringstream oss;
+        s.SerializeDelta(oss, pReference);
+        return oss.str();
+    };
+
+    StateVector sent(16, 4), received;
+    for (int i = 0; i < 16 * 4; ++i)
+        sent.Data()[i] = char(i % 16 / 5);
+
+    // Without a reference, a keyframe is sent.
+    std::string s = encode(sent, nullptr);
+    std::istringstream keyframe(s);
+    TestRequire(StateVector::IsDelta(keyframe));
+    TestRequire(!!received.UnserializeDelta(keyframe));
+    TestFail_if(full(received) != full(sent), "keyframe round trip differs");
+
+    // A delta holds changed bytes only, with single unchanged bytes inside a run.
+    StateVector previous = sent;
+    sent.Data(0)[3] = 'a';
+    sent.Data(1)[5] = 'b';
+    sent.Data(1)[7] = 'c';
+    sent.Data(3)[15] = 'd';
+    s = encode(sent, &previous);
+    TestFail_if(s.length() >= encode(sent, nullptr).length() / 2, "delta has " << s.length() << " bytes");
+    std::istringstream delta(s);
+    TestRequire(!!received.UnserializeDelta(delta));
+    TestFail_if(full(received) != full(sent), "delta round trip differs");
+
+    // A delta may change the number of samples.
+    previous = sent;
+    StateVector longer(16, 6);
+    for (int i = 0; i < 16 * 6; ++i)
+        longer.Data()[i] = char(i % 16 == 2 ? i : 0);
+    std::istringstream samples(encode(longer, &previous));
+    TestRequire(!!received.UnserializeDelta(samples));
+    TestFail_if(full(received) != full(longer), "delta with more samples differs");
+
+    // A change in state vector length results in a keyframe.
+    StateVector wider(20, 2);
+    for (int i = 0; i < 20 * 2; ++i)
+        wider.Data()[i] = char(i);
+    s = encode(wider, &longer);
+    TestFail_if(s != encode(wider, nullptr), "length change did not result in a keyframe");
+    std::istringstream resized(s);
+    TestRequire(!!received.UnserializeDelta(resized));
+    TestFail_if(full(received) != full(wider), "keyframe after length change differs");
+
+    // A delta that does not match the current content is rejected, leaving it unchanged.
+    std::istringstream mismatch(encode(sent, &previous));
+    TestFail_if(received.UnserializeDelta(mismatch), "mismatching delta accepted");
+    TestFail_if(full(received) != full(wider), "mismatching delta modified content");
+
+    // Truncated input is rejected.
+    for (const std::string &encoded : {encode(sent, nullptr), encode(sent, &previous)})
+        for (size_t length = 0; length < encoded.length(); ++length)
+        {
+            StateVector target = previous;
+            std::istringstream truncated(encoded.substr(0, length));
+            TestFail_if(target.UnserializeDelta(truncated), "truncated input accepted at length " << length);
+        }
+}
@@ -30,10 +30,51 @@
 #include "State.h"
 #include <iostream>
 #include <thread>
+#include <vector>
 
 class StateVector
 {
   public:
+    // A ColumnPlan holds precomputed bit extraction parameters for a number of states
+    // ("columns"), and transfers their values for entire sample ranges at once.
+    // Value arrays are arranged by column, i.e. all samples of the first column,
+    // followed by all samples of the second column, and so on.
+    class ColumnPlan
+    {
+      public:
+        ColumnPlan &Clear();
+        ColumnPlan &Add(const State &);
+        ColumnPlan &Add(size_t location, size_t length);
+        int Columns() const
+        {
+            return static_cast<int>(mColumns.size());
+        }
+        // The minimum number of bytes per sample that a state vector must have.
+        int ByteLength() const
+        {
+            return mByteLength;
+        }
+        // Raw access to state vector data of consecutive samples that are
+        // inStride bytes apart, e.g. inside a data file buffer.
+        void Extract(const char *inData, size_t inStride, size_t inSamples, State::ValueType *outValues) const;
+        void Insert(char *ioData, size_t inStride, size_t inSamples, const State::ValueType *inValues) const;
+        State::ValueType Value(const char *inSampleData, int inColumn) const;
+
+      private:
+        friend class StateVector;
+        struct Column
+        {
+            int byteOffset, byteCount, shift;
+            uint64_t mask;
+        };
+        static Column MakeColumn(size_t location, size_t length);
+        static void ExtractColumn(const Column &, const char *, size_t stride, size_t samples, State::ValueType *);
+        static void InsertColumn(const Column &, char *, size_t stride, size_t samples, const State::ValueType *,
+                                 size_t valueStride);
+        std::vector<Column> mColumns;
+        int mByteLength = 0;
+    };
+
     explicit StateVector(size_t length = 0, size_t numSamples = 1);
     explicit StateVector(class StateList &list, size_t numSamples = 1);
     StateVector(const StateVector &);
@@ -71,14 +112,29 @@ class StateVector
 
     void SetSampleValue(size_t location, size_t length, size_t sample, State::ValueType value);
 
+    // Block access. Unlike SetStateValue(), writing does not propagate values to subsequent samples.
+    void ExtractColumns(const ColumnPlan &, size_t sample, size_t count, State::ValueType *outValues) const;
+    void InsertColumns(const ColumnPlan &, size_t sample, size_t count, const State::ValueType *inValues);
+    void StateValues(size_t location, size_t length, size_t sample, size_t count, State::ValueType *outValues) const;
+    void SetSampleValues(size_t location, size_t length, size_t sample, size_t count, const State::ValueType *inValues);
+    State::ValueType StateValue(const ColumnPlan &, int column, size_t sample = 0) const;
+
     std::ostream &InsertInto(std::ostream &) const;
     std::istream &ExtractFrom(std::istream &);
     std::ostream &Serialize(std::ostream &) const;
     std::istream &Unserialize(std::istream &);
+    // Delta encoding relative to a reference state vector, typically the one sent
+    // before. A null reference, or one that differs in length, results in a keyframe.
+    // When unserializing, the current content serves as the reference.
+    std::ostream &SerializeDelta(std::ostream &, const StateVector *pReference) const;
+    std::istream &UnserializeDelta(std::istream &);
+    static bool IsDelta(std::istream &);
 
   private:
     void Allocate(int byteLength, int samples);
     bool Aligned() const;
+    void CheckBlockAccess(const ColumnPlan &, size_t sample, size_t count) const;
+    void CheckWriteAccess() const;
     static State::ValueType GetValueUnaligned(const char *, int location, int length);
     static void SetValueUnaligned(char *, int location, int length, State::ValueType);
     static State::ValueType GetValueAligned(const char *, int location, int length);
@@ -28,7 +28,9 @@
 #include "AVUtils.h"
 #include "Debugging.h"
 #include "Lockable.h"
+#include "MediaCache.h"
 
+#include <sstream>
 #include <vector>
 
 namespace
@@ -172,6 +174,7 @@ struct AVDecoder::Data
     String mError;
     MediaType mMediaType;
     FrameCache mFrameCache;
+    std::string mMediaCacheKey;
 
     enum
     {
@@ -289,6 +292,7 @@ void AVDecoder::Data::Close()
         mResamplingRatio = Ratio(0, 0);
         mFrameDimensions.clear();
         mFrameCache.Realloc(0);
+        mMediaCacheKey.clear();
         delete mpFrameProcessor.exchange(nullptr);
     }
 }
@@ -783,6 +787,7 @@ AVDecoder &AVDecoder::Open(const std::string &inFile, MediaType inType, int inWh
         d->mInputFrameRate = d->mBofPos.rate / r;
         d->mResamplingRatio = Ratio(1, 1);
         d->mMediaType = inType;
+        d->mMediaCacheKey = MediaCache::Key(inFile, "stream " + std::to_string(d->mAV.streamIndex));
         d->mState = Data::Open;
         d->ConfigChanged();
     }
@@ -1012,6 +1017,33 @@ bool AVDecoder::DecodeAllIntoMemory()
     {
         AVUtils::FrameProcessor *p = d->mpFrameProcessor;
         int bytesPerFrame = p->BytesPerFrame();
+
+        // Decoded data is shared between decoders that use the same file and output format.
+        std::string key;
+        if (!d->mMediaCacheKey.empty())
+        {
+            const Ratio &r = d->mResamplingRatio;
+            std::ostringstream oss;
+            oss << d->mMediaCacheKey << " ratio " << int(r.Sign()) << ':' << r.Numerator() << '/' << r.Denominator()
+                << " quality " << d->mResamplingQuality << " frame " << bytesPerFrame;
+            for (int dim : d->mFrameDimensions)
+                oss << ' ' << dim;
+            key = oss.str();
+        }
+        auto pCached = MediaCache::Instance().Get<MediaCache::Buffer>(key);
+        if (pCached)
+        {
+            if (!d->mFrameCache.Realloc(pCached->data.size()))
+                return false;
+            d->mFrameCache.SetData(pCached->data.data(), pCached->data.data() + pCached->data.size());
+            d->mFrameCache.SetFrameSize(bytesPerFrame);
+            d->mState = Data::Open;
+
+            d->mpFrameProcessor = nullptr;
+            delete p;
+            return true;
+        }
+
         size_t size = Ceil((d->mEofPos.count - d->mBofPos.count) * d->mResamplingRatio * bytesPerFrame);
         size += 1024;
         char *pBegin = d->mFrameCache.Realloc(size);
@@ -1042,6 +1074,16 @@ bool AVDecoder::DecodeAllIntoMemory()
         } while (remaining > 0 && frames > 0);
         if (!d->mFrameCache.Realloc(size - remaining * bytesPerFrame))
             return false;
+        if (!key.empty())
+        {
+            auto pBuffer = std::make_shared<MediaCache::Buffer>();
+            d->mFrameCache.SetFramePosition(0);
+            void *p1, *p2;
+            d->mFrameCache.LockData(d->mFrameCache.FrameCount(), p1, p2);
+            pBuffer->data.assign(static_cast<const char *>(p1), static_cast<const char *>(p2));
+            d->mFrameCache.ReleaseData(p1, p2);
+            MediaCache::Instance().Put(key, pBuffer);
+        }
         d->mState = Data::Open;
 
         d->mpFrameProcessor = nullptr;
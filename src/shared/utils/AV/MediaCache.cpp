@@ -0,0 +1,215 @@
+////////////////////////////////////////////////////////////////////////////////
+// $Id$
+// Author: BCI2000 team
+// Description: A process-wide cache for decoded media data.
+//
+// $BEGIN_BCI2000_LICENSE$
+//
+// This file is part of BCI2000, a platform for real-time bio-signal research.
+// [ Copyright (C) 2000-2022: BCI2000 team and many external contributors ]
+//
+// BCI2000 is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// BCI2000 is distributed in the hope that it will be useful, but
+//                         WITHOUT ANY WARRANTY
+// - without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+// A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// $END_BCI2000_LICENSE$
+////////////////////////////////////////////////////////////////////////////////
+#include "MediaCache.h"
+
+#include "FileUtils.h"
+#include "Lockable.h"
+#include "ReusableThread.h"
+#include "Runnable.h"
+#include "ThreadUtils.h"
+
+#include <atomic>
+#include <exception>
+#include <list>
+#include <map>
+#include <mutex>
+#include <sstream>
+
+struct MediaCache::Private : Lockable<std::mutex>
+{
+    // Most recently used entries first.
+    typedef std::list<std::pair<std::string, EntryPtr>> List;
+    List mList;
+    std::map<std::string, List::iterator> mIndex;
+    int64_t mBudget, mSize;
+
+    Private() : mBudget(int64_t(512) << 20), mSize(0)
+    {
+    }
+    void Evict();
+};
+
+void MediaCache::Private::Evict()
+{
+    while (mSize > mBudget && !mList.empty())
+    {
+        mSize -= mList.back().second->Bytes();
+        mIndex.erase(mList.back().first);
+        mList.pop_back();
+    }
+}
+
+MediaCache &MediaCache::Instance()
+{
+    static MediaCache instance;
+    return instance;
+}
+
+MediaCache::MediaCache() : p(new Private)
+{
+}
+
+MediaCache::~MediaCache()
+{
+    delete p;
+}
+
+std::string MediaCache::Key(const std::string &inFile, const std::string &inFormat)
+{
+    std::string file = FileUtils::AbsolutePath(inFile);
+    if (!FileUtils::IsFile(file))
+        return "";
+    std::ostringstream oss;
+    oss << file << '|' << FileUtils::Length(file) << '|' << FileUtils::ModificationTime(file).RawUInt() << '|'
+        << inFormat;
+    return oss.str();
+}
+
+MediaCache::EntryPtr MediaCache::Get(const std::string &inKey)
+{
+    ScopedLock(p);
+    auto i = p->mIndex.find(inKey);
+    if (i == p->mIndex.end())
+        return nullptr;
+    p->mList.splice(p->mList.begin(), p->mList, i->second);
+    return i->second->second;
+}
+
+MediaCache &MediaCache::Put(const std::string &inKey, const EntryPtr &inEntry)
+{
+    if (inKey.empty() || !inEntry)
+        return *this;
+    ScopedLock(p);
+    auto i = p->mIndex.find(inKey);
+    if (i != p->mIndex.end())
+    {
+        p->mSize -= i->second->second->Bytes();
+        p->mList.erase(i->second);
+        p->mIndex.erase(i);
+    }
+    if (inEntry->Bytes() <= p->mBudget)
+    {
+        p->mList.push_front(std::make_pair(inKey, inEntry));
+        p->mIndex[inKey] = p->mList.begin();
+        p->mSize += inEntry->Bytes();
+        p->Evict();
+    }
+    return *this;
+}
+
+MediaCache &MediaCache::Clear()
+{
+    ScopedLock(p);
+    p->mIndex.clear();
+    p->mList.clear();
+    p->mSize = 0;
+    return *this;
+}
+
+MediaCache &MediaCache::SetBudget(int64_t inBytes)
+{
+    ScopedLock(p);
+    p->mBudget = inBytes;
+    p->Evict();
+    return *this;
+}
+
+int64_t MediaCache::Budget() const
+{
+    ScopedLock(p);
+    return p->mBudget;
+}
+
+int64_t MediaCache::Size() const
+{
+    ScopedLock(p);
+    return p->mSize;
+}
+
+namespace
+{
+// Each worker takes the next index until all indices have been processed.
+// The first exception thrown ends processing, and is kept for the caller.
+struct Errors
+{
+    std::mutex mutex;
+    std::exception_ptr first;
+};
+
+struct Worker : Runnable
+{
+    const std::function<void(size_t)> *mpFunction;
+    std::atomic<size_t> *mpNext;
+    size_t mCount;
+    Errors *mpErrors;
+
+    void OnRun() override
+    {
+        for (size_t i = (*mpNext)++; i < mCount; i = (*mpNext)++)
+        {
+            try
+            {
+                (*mpFunction)(i);
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(mpErrors->mutex);
+                if (!mpErrors->first)
+                    mpErrors->first = std::current_exception();
+                *mpNext = mCount;
+            }
+        }
+    }
+};
+} // namespace
+
+void MediaCache::ForEach(size_t inCount, const std::function<void(size_t)> &inFunction)
+{
+    size_t threads = std::min<size_t>(ThreadUtils::NumberOfProcessors(), inCount);
+    if (threads < 1)
+        threads = 1;
+    std::atomic<size_t> next(0);
+    Errors errors;
+    std::vector<Worker> workers(threads);
+    for (auto &worker : workers)
+    {
+        worker.mpFunction = &inFunction;
+        worker.mpNext = &next;
+        worker.mCount = inCount;
+        worker.mpErrors = &errors;
+    }
+    // The calling thread works along with the worker threads.
+    std::vector<ReusableThread> pool(threads - 1);
+    std::vector<bool> running(threads, false);
+    for (size_t i = 1; i < threads; ++i)
+        running[i] = pool[i - 1].Run(workers[i]);
+    workers[0].Run();
+    for (size_t i = 1; i < threads; ++i)
+        if (running[i])
+            pool[i - 1].Wait();
+    if (errors.first)
+        std::rethrow_exception(errors.first);
+}
@@ -0,0 +1,98 @@
+////////////////////////////////////////////////////////////////////////////////
+// $Id$
+// Author: BCI2000 team
+// Description: A process-wide cache for decoded media data, such as images
+//   and audio clips. Entries are keyed by the identity of a file's content,
+//   i.e. its absolute path, length, and modification time, together with a
+//   description of the decoded format, so changed files are decoded anew.
+//   When entries exceed a memory budget, least recently used entries are
+//   evicted. Evicted entries stay valid for as long as they are referenced.
+//
+// $BEGIN_BCI2000_LICENSE$
+//
+// This file is part of BCI2000, a platform for real-time bio-signal research.
+// [ Copyright (C) 2000-2022: BCI2000 team and many external contributors ]
+//
+// BCI2000 is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// BCI2000 is distributed in the hope that it will be useful, but
+//                         WITHOUT ANY WARRANTY
+// - without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+// A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// $END_BCI2000_LICENSE$
+////////////////////////////////////////////////////////////////////////////////
+#ifndef MEDIA_CACHE_H
+#define MEDIA_CACHE_H
+
+#include "Uncopyable.h"
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+class MediaCache : private Uncopyable
+{
+  public:
+    struct Entry
+    {
+        virtual ~Entry()
+        {
+        }
+        virtual int64_t Bytes() const = 0;
+    };
+    typedef std::shared_ptr<const Entry> EntryPtr;
+
+    // An entry holding raw data, such as PCM audio.
+    struct Buffer : Entry
+    {
+        std::vector<char> data;
+        int64_t Bytes() const override
+        {
+            return data.size();
+        }
+    };
+
+    static MediaCache &Instance();
+
+    // A key for a file's content, decoded into the given format.
+    // Returns an empty string if the file does not exist.
+    static std::string Key(const std::string &file, const std::string &format = "");
+
+    // Returns null if there is no entry for the key.
+    EntryPtr Get(const std::string &key);
+    template <class T> std::shared_ptr<const T> Get(const std::string &key)
+    {
+        return std::dynamic_pointer_cast<const T>(Get(key));
+    }
+    // Entries larger than the budget are not stored, and empty keys are ignored.
+    MediaCache &Put(const std::string &key, const EntryPtr &);
+    MediaCache &Clear();
+
+    // The memory budget in bytes, defaults to 512 MiB.
+    MediaCache &SetBudget(int64_t);
+    int64_t Budget() const;
+    int64_t Size() const;
+
+    // Calls a function for each index in [0, count), distributed over one thread
+    // per processor, and returns when all calls have returned. Used to fill the
+    // cache from a list of files in parallel. If a call throws, remaining indices
+    // are skipped, and the first exception is rethrown in the calling thread.
+    static void ForEach(size_t count, const std::function<void(size_t)> &);
+
+  private:
+    MediaCache();
+    ~MediaCache();
+    struct Private;
+    Private *p;
+};
+
+#endif // MEDIA_CACHE_H
@@ -1,8 +1,10 @@
 //////////////////////////////////////////////////////////////////////
 // $Id: EventQueue.cpp 6503 2022-01-21 19:16:23Z mellinger $
 // Author: juergen.mellinger@uni-tuebingen.de
-// Description: A thread-safe event queue.
-//   An event is defined by a string description, and a time stamp.
+// Description: A thread-safe, lock-free event queue.
+//   An event is a fixed-size binary record that specifies a state's
+//   location and length, its new value, an optional duration, and a
+//   time stamp.
 //
 // $BEGIN_BCI2000_LICENSE$
 //
@@ -27,81 +29,79 @@
 #include "EventQueue.h"
 
 #include "Exception.h"
+#include "StateList.h"
 
-#if 0
-void EventQueue::PushBack(const std::string &inDescriptor, PrecisionTime inTimeStamp)
-{
-    if (!mEventsAllowed)
-        throw std_runtime_error << "No events allowed when receiving \"" << inDescriptor
-                                << "\" event "
-                                   "-- trying to record events outside the \"running\" state?";
-    if (mCount++ == mMaxCount)
-        throw std_runtime_error << "Event queue length reached safety maximum of " << mMaxCount;
-    if (mCount < mMaxCount)
-        mQueue.Produce(make_pair(inDescriptor, inTimeStamp));
-}
+#include <sstream>
 
-void EventQueue::PopFront()
+EventQueue::EventQueue(int maxCount)
 {
-    if (mFront)
-        --mCount;
-    mFront = mQueue.Consume();
+    SetMaxCount(maxCount);
 }
 
-bool EventQueue::IsEmpty()
+void EventQueue::SetMaxCount(int maxCount)
 {
-    if (!mFront)
-        PopFront();
-    return !mFront;
+    if (mQueue.Capacity() < static_cast<size_t>(maxCount))
+        mQueue.Reserve(maxCount);
 }
 
-const std::string &EventQueue::FrontDescriptor() const
+void EventQueue::SetStateList(const StateList &inStates)
 {
-    return mFront->first;
+    std::atomic_store(&mpStateList, std::shared_ptr<const StateList>(new StateList(inStates)));
 }
 
-PrecisionTime EventQueue::FrontTimeStamp() const
+void EventQueue::PushBack(const Event &inEvent)
 {
-    return mFront->second;
+    if (!mEventsAllowed)
+        throw std_runtime_error << "No events allowed when receiving event for state at bit location "
+                                << inEvent.location << " -- trying to record events outside the \"running\" state?";
+    if (!mQueue.Produce(inEvent))
+        throw std_runtime_error << "Event queue length reached safety maximum of " << mQueue.Capacity();
 }
 
-#else
-
-void EventQueue::PushBack(const std::string& inDescriptor, PrecisionTime inTimeStamp)
+bool EventQueue::Translate(const std::string &inDescriptor, PrecisionTime inTimeStamp, Event &outEvent,
+                           std::string &outError) const
 {
-  if (!mEventsAllowed)
-    throw std_runtime_error << "No events allowed when receiving \"" << inDescriptor
-    << "\" event "
-    "-- trying to record events outside the \"running\" state?";
-  std::lock_guard<std::mutex> lock(mMutex);
-  if (mQueue.size() == mMaxCount - 1)
-    throw std_runtime_error << "Event queue length reached safety maximum of " << mMaxCount;
-  if (mQueue.size() < mMaxCount - 1)
-    mQueue.push(make_pair(inDescriptor, inTimeStamp));
-}
+    std::shared_ptr<const StateList> pStates = std::atomic_load(&mpStateList);
+    std::istringstream iss(inDescriptor);
+    std::string name;
+    iss >> name;
+    std::ostringstream error;
+    if (!pStates)
+        error << "No state list available when receiving \"" << inDescriptor << "\" event";
+    else if (!pStates->Exists(name))
+        error << "Trying to set state \"" << name << "\" from an event. This state does not exist.";
+    else if (pStates->ByName(name).Kind() != State::EventKind)
+        error << "Trying to set state \"" << name
+              << "\" from an event. "
+                 "This state was not defined as an event state. "
+                 "Use BEGIN_EVENT_DEFINITIONS/END_EVENT_DEFINITIONS to define states "
+                 "as event states.";
+    outError = error.str();
+    if (!outError.empty())
+        return false;
 
-void EventQueue::PopFront()
-{
-  std::lock_guard<std::mutex> lock(mMutex);
-  mQueue.pop();
+    const State &state = pStates->ByName(name);
+    outEvent.location = state.Location();
+    outEvent.length = state.Length();
+    outEvent.value = 0;
+    iss >> outEvent.value;
+    if (!(iss >> outEvent.duration))
+        outEvent.duration = -1;
+    outEvent.timestamp = inTimeStamp;
+    return true;
 }
 
-bool EventQueue::IsEmpty()
+bool EventQueue::IsEmpty() const
 {
-  std::lock_guard<std::mutex> lock(mMutex);
-  return mQueue.empty();
+    return !mQueue.Front();
 }
 
-const std::string& EventQueue::FrontDescriptor() const
+const EventQueue::Event &EventQueue::Front() const
 {
-  std::lock_guard<std::mutex> lock(mMutex);
-  return mQueue.front().first;
+    return *mQueue.Front();
 }
 
-PrecisionTime EventQueue::FrontTimeStamp() const
+void EventQueue::PopFront()
 {
-  std::lock_guard<std::mutex> lock(mMutex);
-  return mQueue.front().second;
+    mQueue.PopFront();
 }
-
-#endif
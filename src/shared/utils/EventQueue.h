@@ -1,8 +1,14 @@
 //////////////////////////////////////////////////////////////////////
 // $Id: EventQueue.h 6503 2022-01-21 19:16:23Z mellinger $
 // Author: juergen.mellinger@uni-tuebingen.de
-// Description: A thread-safe event queue.
-//   An event is defined by a string description, and a time stamp.
+// Description: A thread-safe, lock-free event queue.
+//   An event is a fixed-size binary record that specifies a state's
+//   location and length, its new value, an optional duration, and a
+//   time stamp.
+//   For convenience, events may also be given as string descriptors
+//   of the form "<state name> <value> [<duration>]". These are
+//   translated into binary records when they are pushed, using the
+//   state list most recently specified with SetStateList().
 //
 // $BEGIN_BCI2000_LICENSE$
 //
@@ -27,24 +33,31 @@
 #ifndef EVENT_QUEUE_H
 #define EVENT_QUEUE_H
 
+#include "LockFreeQueue.h"
 #include "PrecisionTime.h"
-#include <queue>
-#include <mutex>
+#include "State.h"
 
-#if 0
+#include <atomic>
+#include <memory>
+#include <string>
+
+class StateList;
 
 class EventQueue
 {
-    typedef SynchronizedQueue<std::pair<std::string, PrecisionTime>> Queue;
-
   public:
-    EventQueue(int maxCount) : mEventsAllowed(false), mCount(0), mMaxCount(maxCount)
-    {
-    }
-    void SetMaxCount(int maxCount)
+    struct Event
     {
-        mMaxCount = maxCount;
-    }
+        int location, length;
+        State::ValueType value;
+        int duration; // -1 if no duration was given
+        PrecisionTime timestamp;
+    };
+
+    EventQueue(int maxCount);
+    // SetMaxCount() and SetStateList() must not be called while events are allowed.
+    void SetMaxCount(int maxCount);
+    void SetStateList(const StateList &);
     void AllowEvents()
     {
         mEventsAllowed = true;
@@ -53,54 +66,20 @@ class EventQueue
     {
         mEventsAllowed = false;
     }
-    bool IsEmpty();
-    void PushBack(const std::string &inDescriptor, PrecisionTime);
+    // Producer interface, may be called from any thread.
+    void PushBack(const Event &);
+    // Translates a descriptor string into an event, returns false and an error message
+    // if the descriptor does not refer to an event state.
+    bool Translate(const std::string &inDescriptor, PrecisionTime, Event &, std::string &outError) const;
+    // Consumer interface, must be called from a single thread only.
+    bool IsEmpty() const;
+    const Event &Front() const;
     void PopFront();
-    const std::string &FrontDescriptor() const;
-    PrecisionTime FrontTimeStamp() const;
 
   private:
-    Queue mQueue;
-    mutable Queue::Consumable mFront;
+    LockFreeQueue<Event> mQueue;
+    std::shared_ptr<const StateList> mpStateList;
     std::atomic<bool> mEventsAllowed = false;
-    std::atomic<int> mCount = 0, mMaxCount = 0;
-};
-
-#else
-
-class EventQueue
-{
-  typedef std::queue<std::pair<std::string, PrecisionTime>> Queue;
-
-public:
-  EventQueue(int maxCount) : mEventsAllowed(false), mMaxCount(maxCount)
-  {
-  }
-  void SetMaxCount(int maxCount)
-  {
-    mMaxCount = maxCount;
-  }
-  void AllowEvents()
-  {
-    mEventsAllowed = true;
-  }
-  void DenyEvents()
-  {
-    mEventsAllowed = false;
-  }
-  bool IsEmpty();
-  void PushBack(const std::string& inDescriptor, PrecisionTime);
-  void PopFront();
-  const std::string& FrontDescriptor() const;
-  PrecisionTime FrontTimeStamp() const;
-
-private:
-  Queue mQueue;
-  mutable std::mutex mMutex;
-  std::atomic<bool> mEventsAllowed = false;
-  std::atomic<int> mMaxCount = 0;
 };
 
-#endif
-
 #endif // EVENT_QUEUE_H
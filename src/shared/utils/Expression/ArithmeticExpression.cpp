@@ -107,6 +107,11 @@ bool ArithmeticExpression::IsValid(const Context &inContext)
     return result;
 }
 
+bool ArithmeticExpression::RefersVariables() const
+{
+    return ContainsNode<VariableNode>() || ContainsNode<AssignmentNode>();
+}
+
 double ArithmeticExpression::Evaluate()
 {
     double result = 0;
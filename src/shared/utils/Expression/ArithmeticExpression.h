@@ -105,6 +105,8 @@ class ArithmeticExpression
     bool IsValid(const Context & = Context());
     bool Compile(const Context & = Context());
     double Evaluate();
+    // True if the compiled expression reads or assigns variables.
+    bool RefersVariables() const;
     double Execute()
     {
         return Evaluate();
@@ -200,10 +200,16 @@ double Expression::SignalNode::OnEvaluate()
 // StateNode
 Expression::StateNode::StateNode(const StateRef &state, const int &sample) : mStateRef(state), mrSample(sample)
 {
+    const class State *pState = mStateRef.operator->();
+    if (pState)
+        mColumn.Add(*pState);
 }
 
 double Expression::StateNode::OnEvaluate()
 {
+    const StateVector *pStatevector = mStateRef.Vector();
+    if (pStatevector && mColumn.Columns() > 0)
+        return pStatevector->StateValue(mColumn, 0, mrSample);
     return mStateRef(mrSample);
 }
 
@@ -50,6 +50,7 @@
 #include "ArithmeticExpression.h"
 #include "Environment.h"
 #include "GenericSignal.h"
+#include "StateVector.h"
 
 #include "ExpressionParser.hpp"
 
@@ -134,6 +135,7 @@ class Expression : public ArithmeticExpression, private Environment
 
       private:
         StateRef mStateRef;
+        StateVector::ColumnPlan mColumn;
         const int &mrSample;
     };
 
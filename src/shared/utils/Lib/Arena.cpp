@@ -0,0 +1,157 @@
+//////////////////////////////////////////////////////////////////////
+// $Id$
+// Author: BCI2000 team
+// Description: A bump allocator for short-lived temporaries.
+//
+// $BEGIN_BCI2000_LICENSE$
+//
+// This file is part of BCI2000, a platform for real-time bio-signal research.
+// [ Copyright (C) 2000-2022: BCI2000 team and many external contributors ]
+//
+// BCI2000 is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// BCI2000 is distributed in the hope that it will be useful, but
+//                         WITHOUT ANY WARRANTY
+// - without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+// A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// $END_BCI2000_LICENSE$
+///////////////////////////////////////////////////////////////////////
+#include "Arena.h"
+#include "Exception.h"
+#include "UnitTest.h"
+
+#include <algorithm>
+#include <cstdint>
+
+namespace
+{
+const size_t cMinChunkSize = 4096;
+thread_local Tiny::Arena *stpCurrent = nullptr;
+} // namespace
+
+UnitTest(Tiny_Arena)
+{
+    Tiny::Arena arena(64);
+    double *p = arena.New<double>(3);
+    TestRequire(p[0] == 0 && p[1] == 0 && p[2] == 0);
+    TestRequire(reinterpret_cast<uintptr_t>(arena.Allocate(1, 64)) % 64 == 0);
+    for (int i = 0; i < 100; ++i)
+        arena.New<int>(100);
+    TestRequire(arena.Used() >= 100 * 100 * sizeof(int));
+    int heap = arena.HeapAllocations();
+    arena.Reset();
+    TestRequire(arena.Used() == 0);
+    heap = arena.HeapAllocations() - heap;
+    TestRequire(heap == 1); // overflow chunks coalesced into one
+    heap = arena.HeapAllocations();
+    for (int i = 0; i < 100; ++i)
+        arena.New<int>(100);
+    arena.Reset();
+    TestRequire(arena.HeapAllocations() == heap);
+    TestRequire(Tiny::Arena::Current() == nullptr);
+    {
+        Tiny::Arena::Scope scope(arena);
+        TestRequire(Tiny::Arena::Current() == &arena);
+        arena.New<char>(10);
+    }
+    TestRequire(Tiny::Arena::Current() == nullptr);
+    TestRequire(arena.Used() == 0);
+}
+
+namespace Tiny
+{
+
+Arena::Arena(size_t initialCapacity)
+    : mpBegin(nullptr), mpPos(nullptr), mpEnd(nullptr), mUsedInFullChunks(0), mHeapAllocations(0)
+{
+    if (initialCapacity > 0)
+        AddChunk(initialCapacity);
+}
+
+Arena::~Arena()
+{
+    for (auto &chunk : mChunks)
+        ::operator delete(chunk.data);
+}
+
+void *Arena::Allocate(size_t inBytes, size_t inAlignment)
+{
+    if (inAlignment == 0 || (inAlignment & (inAlignment - 1)))
+        throw std_invalid_argument << "Alignment must be a power of two, is " << inAlignment;
+    uintptr_t pos = reinterpret_cast<uintptr_t>(mpPos), end = reinterpret_cast<uintptr_t>(mpEnd);
+    uintptr_t aligned = (pos + inAlignment - 1) & ~(inAlignment - 1);
+    if (!mpPos || aligned > end || end - aligned < inBytes)
+    {
+        size_t size = mChunks.empty() ? 0 : 2 * mChunks.back().size;
+        AddChunk(std::max(size, inBytes + inAlignment));
+        pos = reinterpret_cast<uintptr_t>(mpPos);
+        aligned = (pos + inAlignment - 1) & ~(inAlignment - 1);
+    }
+    mpPos = reinterpret_cast<char *>(aligned + inBytes);
+    return reinterpret_cast<void *>(aligned);
+}
+
+void Arena::Reset()
+{
+    if (mChunks.size() > 1)
+    {
+        size_t total = Capacity();
+        for (auto &chunk : mChunks)
+            ::operator delete(chunk.data);
+        mChunks.clear();
+        mpBegin = nullptr;
+        AddChunk(total);
+    }
+    mpPos = mpBegin;
+    mUsedInFullChunks = 0;
+}
+
+size_t Arena::Capacity() const
+{
+    size_t total = 0;
+    for (const auto &chunk : mChunks)
+        total += chunk.size;
+    return total;
+}
+
+size_t Arena::Used() const
+{
+    return mUsedInFullChunks + (mpPos - mpBegin);
+}
+
+void Arena::AddChunk(size_t inSize)
+{
+    Chunk chunk = {nullptr, std::max(inSize, cMinChunkSize)};
+    chunk.data = static_cast<char *>(::operator new(chunk.size));
+    ++mHeapAllocations;
+    mUsedInFullChunks += mpPos - mpBegin;
+    mChunks.push_back(chunk);
+    mpBegin = chunk.data;
+    mpPos = mpBegin;
+    mpEnd = mpBegin + chunk.size;
+}
+
+Arena *Arena::Current()
+{
+    return stpCurrent;
+}
+
+Arena::Scope::Scope(Arena &arena) : mArena(arena), mpPrevious(stpCurrent)
+{
+    stpCurrent = &mArena;
+}
+
+Arena::Scope::~Scope()
+{
+    stpCurrent = mpPrevious;
+    mArena.Reset();
+}
+
+} // namespace Tiny
@@ -0,0 +1,137 @@
+//////////////////////////////////////////////////////////////////////
+// $Id$
+// Author: BCI2000 team
+// Description: A bump allocator for short-lived temporaries.
+//   Allocation advances a pointer inside a chunk of memory; all
+//   allocations are released at once by Reset(). When a chunk is
+//   exhausted, a further chunk is obtained from the heap. On Reset(),
+//   these chunks are coalesced into a single chunk of their total size,
+//   so an arena that is reset after each unit of work stops touching
+//   the heap once it has grown to that work's peak requirement.
+//   Destructors of objects placed into an arena are not called, so
+//   only trivially destructible types may be allocated with New().
+//   An arena is not thread-safe; each thread should use its own arena.
+//   Arena::Scope makes an arena the current thread's arena for the
+//   scope's lifetime, and resets it at the end of the scope.
+//
+// $BEGIN_BCI2000_LICENSE$
+//
+// This file is part of BCI2000, a platform for real-time bio-signal research.
+// [ Copyright (C) 2000-2022: BCI2000 team and many external contributors ]
+//
+// BCI2000 is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// BCI2000 is distributed in the hope that it will be useful, but
+//                         WITHOUT ANY WARRANTY
+// - without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+// A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// $END_BCI2000_LICENSE$
+///////////////////////////////////////////////////////////////////////
+#ifndef TINY_ARENA_H
+#define TINY_ARENA_H
+
+#include "Uncopyable.h"
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+namespace Tiny
+{
+
+class Arena : Uncopyable
+{
+  public:
+    explicit Arena(size_t initialCapacity = 0);
+    ~Arena();
+
+    void *Allocate(size_t bytes, size_t alignment = alignof(std::max_align_t));
+    // Returns an array of value-initialized objects.
+    template <class T> T *New(size_t count = 1)
+    {
+        static_assert(std::is_trivially_destructible<T>::value, "Arena objects are never destructed");
+        T *p = static_cast<T *>(Allocate(count * sizeof(T), alignof(T)));
+        for (size_t i = 0; i < count; ++i)
+            new (p + i) T();
+        return p;
+    }
+    // Releases all allocations.
+    void Reset();
+
+    size_t Capacity() const;
+    size_t Used() const;
+    // Number of chunks obtained from the heap since construction.
+    int HeapAllocations() const
+    {
+        return mHeapAllocations;
+    }
+
+    // The arena made current by the innermost Arena::Scope in the calling thread, or null.
+    static Arena *Current();
+
+    class Scope : Uncopyable
+    {
+      public:
+        explicit Scope(Arena &);
+        ~Scope();
+
+      private:
+        Arena &mArena;
+        Arena *mpPrevious;
+    };
+
+    // A standard allocator drawing from an arena, for containers that are
+    // local to the arena's unit of work. Deallocation is a no-op.
+    template <class T> struct Allocator
+    {
+        typedef T value_type;
+        explicit Allocator(Arena &arena) : pArena(&arena)
+        {
+        }
+        template <class U> Allocator(const Allocator<U> &other) : pArena(other.pArena)
+        {
+        }
+        T *allocate(size_t n)
+        {
+            return static_cast<T *>(pArena->Allocate(n * sizeof(T), alignof(T)));
+        }
+        void deallocate(T *, size_t)
+        {
+        }
+        template <class U> bool operator==(const Allocator<U> &other) const
+        {
+            return pArena == other.pArena;
+        }
+        template <class U> bool operator!=(const Allocator<U> &other) const
+        {
+            return pArena != other.pArena;
+        }
+        Arena *pArena;
+    };
+
+  private:
+    void AddChunk(size_t);
+
+    struct Chunk
+    {
+        char *data;
+        size_t size;
+    };
+    std::vector<Chunk> mChunks;
+    char *mpBegin, *mpPos, *mpEnd;
+    size_t mUsedInFullChunks;
+    int mHeapAllocations;
+};
+
+} // namespace Tiny
+
+using Tiny::Arena;
+
+#endif // TINY_ARENA_H
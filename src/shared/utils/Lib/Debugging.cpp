@@ -40,6 +40,7 @@
 #include <unistd.h>
 #endif
 #include <cstdio>
+#include <cstdlib>
 #include <cstring>
 #include <map>
 #include <new>
@@ -1561,8 +1562,11 @@ inline void free_(void *p)
 }
 #endif // TINY_GUARDED_MALLOC
 
+thread_local int stHeapAllocations = 0;
+
 void *Block::Malloc(size_t n, bool isArray, void *returnAddress) throw()
 {
+    ++stHeapAllocations;
     void *p = 0;
     if (Initialized())
         p = malloc_(n + Block::Size());
@@ -1724,8 +1728,76 @@ void Tiny::MemoryDebugging::SetReadonly(void *p, bool b)
 #endif
 }
 
+int Tiny::MemoryDebugging::HeapAllocations()
+{
+    return stHeapAllocations;
+}
+
 #else // TINY_DEBUG_MEMORY
 
+#ifndef TINY_COUNT_ALLOCATIONS
+#define TINY_COUNT_ALLOCATIONS 0
+#endif
+
+#if TINY_COUNT_ALLOCATIONS
+// Count allocations per thread, without any further debugging overhead.
+namespace
+{
+thread_local int stHeapAllocations = 0;
+
+void *CountedMalloc(size_t n)
+{
+    ++stHeapAllocations;
+    void *p = ::malloc(n ? n : 1);
+    if (!p)
+        throw std::bad_alloc();
+    return p;
+}
+} // namespace
+
+void *operator new(size_t n)
+{
+    return CountedMalloc(n);
+}
+
+void *operator new[](size_t n)
+{
+    return CountedMalloc(n);
+}
+
+void *operator new(size_t n, const std::nothrow_t &) noexcept
+{
+    ++stHeapAllocations;
+    return ::malloc(n ? n : 1);
+}
+
+void *operator new[](size_t n, const std::nothrow_t &) noexcept
+{
+    ++stHeapAllocations;
+    return ::malloc(n ? n : 1);
+}
+
+void operator delete(void *p) noexcept
+{
+    ::free(p);
+}
+
+void operator delete[](void *p) noexcept
+{
+    ::free(p);
+}
+
+void operator delete(void *p, const std::nothrow_t &) noexcept
+{
+    ::free(p);
+}
+
+void operator delete[](void *p, const std::nothrow_t &) noexcept
+{
+    ::free(p);
+}
+#endif // TINY_COUNT_ALLOCATIONS
+
 namespace Tiny
 {
 namespace MemoryDebugging
@@ -1760,6 +1832,14 @@ void NewlyShared(void *)
 void SetReadonly(void *, bool)
 {
 }
+int HeapAllocations()
+{
+#if TINY_COUNT_ALLOCATIONS
+    return stHeapAllocations;
+#else
+    return -1;
+#endif
+}
 } // namespace MemoryDebugging
 } // namespace Tiny
 
@@ -164,6 +164,9 @@ class Data
 void NewlyShared(void *);
 // Use with TINY_GUARDED_MALLOC
 void SetReadonly(void *, bool);
+// Number of heap allocations made by the calling thread so far, or -1 if allocations
+// are not counted (compile with TINY_COUNT_ALLOCATIONS or TINY_DEBUG_MEMORY).
+int HeapAllocations();
 
 } // namespace MemoryDebugging
 
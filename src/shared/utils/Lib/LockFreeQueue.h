@@ -0,0 +1,166 @@
+//////////////////////////////////////////////////////////////////////
+// $Id$
+// Author: BCI2000 team
+// Description: A bounded, lock-free queue of fixed-size elements.
+//   Any number of threads may produce into the queue, and any number
+//   of threads may consume from it. Elements are stored in a ring of
+//   preallocated slots, so neither producing nor consuming allocates
+//   memory or takes a lock.
+//   When there is only a single consumer, it may inspect the front
+//   element with Front() before deciding whether to consume it.
+//
+// $BEGIN_BCI2000_LICENSE$
+//
+// This file is part of BCI2000, a platform for real-time bio-signal research.
+// [ Copyright (C) 2000-2022: BCI2000 team and many external contributors ]
+//
+// BCI2000 is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// BCI2000 is distributed in the hope that it will be useful, but
+//                         WITHOUT ANY WARRANTY
+// - without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+// A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// $END_BCI2000_LICENSE$
+///////////////////////////////////////////////////////////////////////
+#ifndef TINY_LOCK_FREE_QUEUE_H
+#define TINY_LOCK_FREE_QUEUE_H
+
+#include "Uncopyable.h"
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+namespace Tiny
+{
+
+template <class T> class LockFreeQueue : Uncopyable
+{
+  public:
+    typedef T ValueType;
+    // Capacity is rounded up to the next power of two.
+    explicit LockFreeQueue(size_t capacity = 0)
+    {
+        Reserve(capacity);
+    }
+    // Reserve() must not be called while other threads access the queue.
+    void Reserve(size_t capacity)
+    {
+        size_t size = 2;
+        while (size < capacity)
+            size <<= 1;
+        std::vector<Slot> slots(size);
+        for (size_t i = 0; i < size; ++i)
+            slots[i].sequence.store(i, std::memory_order_relaxed);
+        mSlots.swap(slots);
+        mMask = size - 1;
+        mHead.store(0, std::memory_order_relaxed);
+        mTail.store(0, std::memory_order_relaxed);
+    }
+    size_t Capacity() const
+    {
+        return mSlots.size();
+    }
+    bool Empty() const
+    {
+        return mHead.load(std::memory_order_acquire) == mTail.load(std::memory_order_acquire);
+    }
+    // Returns false if the queue is full.
+    bool Produce(const T &t)
+    {
+        size_t pos = mTail.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            Slot &slot = mSlots[pos & mMask];
+            size_t seq = slot.sequence.load(std::memory_order_acquire);
+            ptrdiff_t diff = static_cast<ptrdiff_t>(seq) - static_cast<ptrdiff_t>(pos);
+            if (diff == 0)
+            {
+                if (mTail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    slot.data = t;
+                    slot.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (diff < 0)
+                return false;
+            else
+                pos = mTail.load(std::memory_order_relaxed);
+        }
+    }
+    // Returns false if the queue is empty.
+    bool Consume(T &t)
+    {
+        size_t pos = mHead.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            Slot &slot = mSlots[pos & mMask];
+            size_t seq = slot.sequence.load(std::memory_order_acquire);
+            ptrdiff_t diff = static_cast<ptrdiff_t>(seq) - static_cast<ptrdiff_t>(pos + 1);
+            if (diff == 0)
+            {
+                if (mHead.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    t = slot.data;
+                    slot.sequence.store(pos + mMask + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (diff < 0)
+                return false;
+            else
+                pos = mHead.load(std::memory_order_relaxed);
+        }
+    }
+    // Single consumer only: returns the front element without consuming it,
+    // or a null pointer if the queue is empty.
+    const T *Front() const
+    {
+        size_t pos = mHead.load(std::memory_order_relaxed);
+        const Slot &slot = mSlots[pos & mMask];
+        if (slot.sequence.load(std::memory_order_acquire) != pos + 1)
+            return nullptr;
+        return &slot.data;
+    }
+    // Single consumer only: discards the front element after inspection with Front().
+    void PopFront()
+    {
+        size_t pos = mHead.load(std::memory_order_relaxed);
+        Slot &slot = mSlots[pos & mMask];
+        if (slot.sequence.load(std::memory_order_acquire) == pos + 1)
+        {
+            mHead.store(pos + 1, std::memory_order_relaxed);
+            slot.sequence.store(pos + mMask + 1, std::memory_order_release);
+        }
+    }
+
+  private:
+    struct Slot
+    {
+        Slot() : sequence(0), data()
+        {
+        }
+        Slot(const Slot &other) : sequence(other.sequence.load()), data(other.data)
+        {
+        }
+        std::atomic<size_t> sequence;
+        T data;
+    };
+    std::vector<Slot> mSlots;
+    size_t mMask = 0;
+    alignas(64) std::atomic<size_t> mHead{0};
+    alignas(64) std::atomic<size_t> mTail{0};
+};
+
+} // namespace Tiny
+
+using Tiny::LockFreeQueue;
+
+#endif // TINY_LOCK_FREE_QUEUE_H
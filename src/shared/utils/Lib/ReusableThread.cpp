@@ -61,7 +61,9 @@ ReusableThread::ReusableThread() : p(new Private)
 
 ReusableThread::~ReusableThread()
 {
-    p->mStartEvent.AbortWaiting();
+    // Starting the thread without a runnable makes it exit. As opposed to aborting
+    // its wait, this also works when the thread has not yet begun to wait.
+    p->mStartEvent.Set();
     delete p;
 }
 
@@ -87,9 +89,12 @@ int ReusableThread::Private::OnExecute()
     while (mStartEvent.Wait())
     {
         mStartEvent.Reset();
+        Runnable *pRunnable = mpRunnable.load();
+        if (!pRunnable)
+            break;
         try
         {
-            mpRunnable.load()->Run();
+            pRunnable->Run();
         }
         catch (...)
         {
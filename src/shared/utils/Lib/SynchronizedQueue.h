@@ -71,6 +71,12 @@ template <class T> class SynchronizedQueue : public Waitable, Uncopyable
     {
         return AwaitConsumption(0);
     }
+    // Ends a consumer's wait without producing an element, such that the
+    // consumer obtains an empty Consumable.
+    void Wake()
+    {
+        mMayConsume.Increase();
+    }
     Ref AwaitConsumption(const Time::Interval & = Time::Forever);
 
   private: